@@ -1,7 +1,16 @@
 #ifndef CONVERTERXTF_H
 #define CONVERTERXTF_H
 
+#include <functional>
+#include <utility>
+#include <QBuffer>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
 #include "XTFConf.h"
+#include "epoch_snapshot.h"
 #include "plotcash.h"
 #include "vector"
 
@@ -9,12 +18,35 @@ class ConverterXTF {
 public:
     ConverterXTF() {}
 
-    QByteArray _lastData;
+    static constexpr int exportFlushSize = 4 * 1024 * 1024; // bytes collected before a write to the sink
 
     XTFFILEHEADER header;
 
     QByteArray toXTF(Dataset* dataset, int channel1, int channel2 = CHANNEL_NONE) {
         QByteArray xtfdata;
+        QBuffer buffer(&xtfdata);
+        buffer.open(QIODevice::WriteOnly);
+        EpochSnapshot epochs(dataset);
+        writeXTF(&buffer, epochs, channel1, channel2);
+
+        return xtfdata;
+    }
+
+    // streams the file to dev, one ping at a time through a bounded buffer; progress(percent) is called on every
+    // percent step and stops the export when it returns false. The closed epochs are read from the snapshot,
+    // so the export may run on another thread than the dataset
+    bool writeXTF(QIODevice* dev, EpochSnapshot& epochs, int channel1, int channel2 = CHANNEL_NONE, const std::function<bool(int)>& progress = nullptr) {
+        QByteArray xtfdata;
+        xtfdata.reserve(exportFlushSize + exportFlushSize / 4);
+
+        auto flush = [&]() -> bool {
+            if(xtfdata.size() > 0 && dev->write(xtfdata) != xtfdata.size()) {
+                return false;
+            }
+            xtfdata.resize(0);
+            return true;
+        };
+
         XTFFILEHEADER fileheader;
 
         fileheader.ThisFileName[0] = 'k';
@@ -43,13 +75,24 @@ public:
 
         xtfdata.append((char*)&fileheader, sizeof (XTFFILEHEADER));
 
-        int dataset_size = dataset->size();
+        int dataset_size = epochs.size();
         int ping_numb = 0;
+        int last_percent = -1;
 
         int fix_h = 0, fix_m = 0, fix_s = 0, fix_hs = 0;
         int64_t fix_timetag_ms = 0;
         for(int i = 0; i < dataset_size; i++) {
-            Epoch* epoch = dataset->fromIndex(i);
+            if(progress) {
+                int percent = (100ll * i) / dataset_size;
+                if(percent != last_percent) {
+                    last_percent = percent;
+                    if(!progress(percent)) {
+                        return false;
+                    }
+                }
+            }
+
+            Epoch* epoch = epochs.epoch(i);
 
             if(epoch != NULL) {
                 XTFPINGHEADER pingheader;
@@ -114,8 +157,8 @@ public:
                 pingheader.SensorYcoordinate = pingheader.ShipYcoordinate;
                 pingheader.SensorXcoordinate = pingheader.ShipXcoordinate;
 
-                Epoch::Echogram* chart1 = epoch->chart(channel1);
-                Epoch::Echogram* chart2 = epoch->chart(channel2);
+                const Epoch::Echogram* chart1 = std::as_const(*epoch).chart(channel1); // the const lookup does not detach the charts
+                const Epoch::Echogram* chart2 = std::as_const(*epoch).chart(channel2);
                 QVector<uint8_t> raw1;
                 QVector<uint8_t> raw2;
 
@@ -126,7 +169,7 @@ public:
                 pingch2.ChannelNumber = 1;
 
                 if(chart1 != NULL) {
-                    QVector<uint8_t> raw = chart1->amplitude;
+                    QVector<uint8_t> raw = chart1->amplitude.toVector();
                     int constr_size = raw.size();
                     raw1.resize(constr_size);
                     for(int ri = 0; ri < constr_size; ri++) {
@@ -135,7 +178,7 @@ public:
                 }
 
                 if(chart2 != NULL && channel2 != CHANNEL_NONE) {
-                    QVector<uint8_t> raw = chart2->amplitude;
+                    QVector<uint8_t> raw = chart2->amplitude.toVector();
                     int constr_size = raw.size();
                     raw2.resize(constr_size);
                     for(int ri = 0; ri < constr_size; ri++) {
@@ -183,111 +226,290 @@ public:
                     //                    }
                 }
 
+                if(xtfdata.size() >= exportFlushSize && !flush()) {
+                    return false;
+                }
             }
         }
 
-        return xtfdata;
+        if(!flush()) {
+            return false;
+        }
+
+        if(progress) {
+            progress(100);
+        }
+
+        return true;
     }
 
+    typedef struct {
+        int channel = 0;
+        QVector<uint8_t> data;
+        float resolution = 0;
+    } PingChart;
+
+    typedef struct {
+        double lat = 0;
+        double lon = 0;
+        QVector<PingChart> charts;
+    } Ping;
+
+    static constexpr quint32 pingIndexMagic = 0x58494458; // XIDX
+    static constexpr quint32 pingIndexVersion = 1;
+
+    // file offsets of the sonar pings, lets a file seen before be read without walking every record;
+    // saved next to the file as <file>.xidx, an index of another size or modification time of the file is ignored
+    typedef struct {
+        QString fileName;
+        qint64 fileSize = -1;
+        QDateTime lastModified;
+        QVector<qint64> pingOffsets;
+
+        bool matches(const QFileInfo& info) const {
+            return !pingOffsets.isEmpty() && fileName == info.absoluteFilePath() && fileSize == info.size() && lastModified == info.lastModified();
+        }
+
+        static QString indexPath(const QFileInfo& info) {
+            return info.absoluteFilePath() + QStringLiteral(".xidx");
+        }
+
+        bool load(const QFileInfo& info) {
+            QFile file(indexPath(info));
+            if(!file.open(QIODevice::ReadOnly)) {
+                return false;
+            }
+
+            QDataStream in(&file);
+            quint32 magic = 0, version = 0;
+            qint64 size = -1, modifiedMs = 0;
+            QVector<qint64> offsets;
+            in >> magic >> version >> size >> modifiedMs >> offsets;
+
+            if(in.status() != QDataStream::Ok || magic != pingIndexMagic || version != pingIndexVersion ||
+               size != info.size() || modifiedMs != info.lastModified().toMSecsSinceEpoch() || offsets.isEmpty()) {
+                return false;
+            }
+
+            fileName = info.absoluteFilePath();
+            fileSize = size;
+            lastModified = info.lastModified();
+            pingOffsets = offsets;
+            return true;
+        }
+
+        // the index only speeds up the next opening, a directory without write access just goes without it
+        bool save() const {
+            QSaveFile file(indexPath(QFileInfo(fileName)));
+            if(!file.open(QIODevice::WriteOnly)) {
+                return false;
+            }
+
+            QDataStream out(&file);
+            out << pingIndexMagic << pingIndexVersion << fileSize << lastModified.toMSecsSinceEpoch() << pingOffsets;
+
+            return out.status() == QDataStream::Ok && file.commit();
+        }
+    } PingIndex;
+
+    static constexpr int pingBatchSize = 256;
+
     bool toDataset(QByteArray data, Dataset* dataset) {
-//        if(xtf_data == NULL || dataset == NULL) {
-//            return false;
-//        }
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+
+        return readXTF(&buffer, [dataset](QVector<Ping>&& pings) -> bool {
+            for(const Ping& ping : pings) {
+                applyPing(ping, dataset);
+            }
+            return true;
+        });
+    }
 
-        _lastData = data;
+    static void applyPing(const Ping& ping, Dataset* dataset) {
+        if(ping.lat != 0 || ping.lon != 0) {
+            dataset->addPosition(ping.lat, ping.lon);
+        }
 
-        uint8_t* cdata = (uint8_t*)data.constData();
-        uint8_t* cdata_end = cdata + data.size();
+        for(const PingChart& chart : ping.charts) {
+            dataset->addChart(chart.channel, chart.data, chart.resolution, 0);
+        }
+    }
 
-        XTFFILEHEADER* fileheader = (XTFFILEHEADER*)cdata;
-        if(fileheader->FileFormat != 123) {
+    // reads the file record by record, memory holds one record and one batch of pings; pings go to onPings in
+    // batches of pingBatchSize, returning false from onPings or progress(percent) stops the reading.
+    // With pingOffsets given, non-empty offsets are used to seek ping to ping, empty ones are filled while reading
+    bool readXTF(QIODevice* dev, const std::function<bool(QVector<Ping>&&)>& onPings,
+                 const std::function<bool(int)>& progress = nullptr, QVector<qint64>* pingOffsets = nullptr) {
+        if(dev->read((char*)&header, sizeof (XTFFILEHEADER)) != sizeof (XTFFILEHEADER) || header.FileFormat != 123) {
 //            consoleInfo("XTF is not valid");
             return false;
         }
 
-        header = *fileheader;
+        const bool useOffsets = pingOffsets != nullptr && !pingOffsets->isEmpty();
+        const qint64 dev_size = dev->size();
+        qint64 offset = sizeof (XTFFILEHEADER);
+        int ping_indx = 0;
+        int last_percent = -1;
+
+        QByteArray record;
+        QVector<Ping> pings;
+        pings.reserve(pingBatchSize);
+        bool is_valid = true;
+
+        while(is_valid) {
+            if(useOffsets) {
+                if(ping_indx >= pingOffsets->size()) {
+                    break;
+                }
+                offset = pingOffsets->at(ping_indx);
+                if(!dev->seek(offset)) {
+                    is_valid = false;
+                    break;
+                }
+            } else if(offset >= dev_size) {
+                break;
+            }
 
-        volatile char* record_prog = fileheader->RecordingProgramName;
-        Q_UNUSED(record_prog);
+            if(progress && dev_size > 0) {
+                int percent = useOffsets ? (100ll * ping_indx) / pingOffsets->size() : (100ll * offset) / dev_size;
+                if(percent != last_percent) {
+                    last_percent = percent;
+                    if(!progress(percent)) {
+                        return false;
+                    }
+                }
+            }
 
-        cdata += sizeof (XTFFILEHEADER);
+            record.resize(sizeof (XTFPINGHEADER));
+            if(dev->read(record.data(), record.size()) != record.size()) {
+                is_valid = false;
+                break;
+            }
 
-        while(cdata < cdata_end) {
-            XTFPINGHEADER* pingheader = (XTFPINGHEADER*)(cdata);
-            if(pingheader->MagicNumber != 0xFACE) {
+            const XTFPINGHEADER* pingheader = (const XTFPINGHEADER*)record.constData();
+            const qint64 record_size = pingheader->NumBytesThisRecord;
+            if(pingheader->MagicNumber != 0xFACE || record_size < (qint64)sizeof (XTFPINGHEADER)) {
 //                consoleInfo("XTF packet is not valid");
-                return false;
+                is_valid = false;
+                break;
             }
 
-            cdata += sizeof (XTFPINGHEADER);
-
             if(pingheader->HeaderType == 0) {
-                uint16_t ch_count = pingheader->NumChansToFollow;
-                double lat = pingheader->SensorYcoordinate;
-                double lon = pingheader->SensorXcoordinate;
-                if(lat != 0 || lat != 0) {
-                    dataset->addPosition(lat, lon);
+                record.resize(record_size);
+                const qint64 rest_size = record_size - sizeof (XTFPINGHEADER);
+                if(dev->read(record.data() + sizeof (XTFPINGHEADER), rest_size) != rest_size) {
+                    is_valid = false;
+                    break;
                 }
 
-                for(uint16_t chi = 0; chi < ch_count; chi++) {
-                    XTFPINGCHANHEADER* pingch = (XTFPINGCHANHEADER*)(cdata);
+                pings.append(Ping());
+                is_valid = parsePing((const uint8_t*)record.constData(), record.size(), pings.last());
 
+                if(!useOffsets && pingOffsets != nullptr) {
+                    pingOffsets->append(offset);
+                }
+            } else if(!useOffsets && !dev->seek(offset + record_size)) {
+//                consoleInfo("XTF header type is unknown");
+                is_valid = false;
+                break;
+            }
 
-                    const float range = pingch->SlantRange;
-                    const uint16_t sample_count = pingch->NumSamples;
-                    const uint16_t sample_bytes = fileheader->ChanInfo[chi].BytesPerSample;
-                    const uint16_t sample_format = fileheader->ChanInfo[chi].SampleFormat;
+            offset += record_size;
+            ping_indx += useOffsets ? 1 : 0;
 
-                    if(sample_count == 0 || sample_bytes == 0) {
-//                        consoleInfo("XTF samples count is zero");
-                        return false;
-                    }
+            if(pings.size() >= pingBatchSize) {
+                if(!onPings(std::move(pings))) {
+                    return false;
+                }
+                pings = QVector<Ping>();
+                pings.reserve(pingBatchSize);
+            }
+        }
 
-                    cdata += sizeof (XTFPINGCHANHEADER);
-                    QVector<uint8_t> data;
-                    data.resize(sample_count);
-
-                    if((sample_format == 0 && sample_bytes == 1) || sample_format == 8) {
-                        if(pingch->ChannelNumber == 0 || pingch->ChannelNumber == 2) {
-                            for(uint16_t i = 0; i < sample_count; i++) {
-                                data[sample_count-i-1] = *((uint8_t*)cdata);
-                                cdata += sample_bytes;
-                            }
-                        } else {
-                            for(uint16_t i = 0; i < sample_count; i++) {
-                                data[i] = *((uint8_t*)cdata);
-                                cdata += sample_bytes;
-                            }
-                        }
-                    } else if((sample_format == 0 && sample_bytes == 2) || sample_format == 2) {
-                        if(pingch->ChannelNumber == 0 || pingch->ChannelNumber == 2) {
-                            for(uint16_t i = 0; i < sample_count; i++) {
-                                data[sample_count-i-1] = *((uint16_t*)cdata) / 128;
-                                cdata += sample_bytes;
-                            }
-                        } else {
-                            for(uint16_t i = 0; i < sample_count; i++) {
-                                data[i] = *((uint16_t*)cdata) / 128;
-                                cdata += sample_bytes;
-                            }
-                        }
-                    }
+        if(!pings.isEmpty() && !onPings(std::move(pings))) {
+            return false;
+        }
 
+        if(is_valid && progress) {
+            progress(100);
+        }
 
-                    dataset->addChart(pingch->ChannelNumber, data, range/sample_count, 0);
-                }
+        return is_valid;
+    }
 
-            } else  if(pingheader->HeaderType == 3) {
-                cdata += 64;
-            } else {
-//                consoleInfo("XTF header type is unknown");
-                cdata += pingheader->NumBytesThisRecord - sizeof (XTFPINGHEADER);
+private:
+    // sonar ping record with its header, channels parsed before an error stay in ping
+    bool parsePing(const uint8_t* cdata, qint64 size, Ping& ping) const {
+        const uint8_t* cdata_end = cdata + size;
+        const XTFPINGHEADER* pingheader = (const XTFPINGHEADER*)cdata;
+
+        cdata += sizeof (XTFPINGHEADER);
+
+        uint16_t ch_count = pingheader->NumChansToFollow;
+        ping.lat = pingheader->SensorYcoordinate;
+        ping.lon = pingheader->SensorXcoordinate;
+
+        for(uint16_t chi = 0; chi < ch_count; chi++) {
+            if(cdata + sizeof (XTFPINGCHANHEADER) > cdata_end || chi >= 6) {
+                return false;
+            }
+
+            const XTFPINGCHANHEADER* pingch = (const XTFPINGCHANHEADER*)(cdata);
+
+            const float range = pingch->SlantRange;
+            const uint16_t sample_count = pingch->NumSamples;
+            const uint16_t sample_bytes = header.ChanInfo[chi].BytesPerSample;
+            const uint16_t sample_format = header.ChanInfo[chi].SampleFormat;
+
+            if(sample_count == 0 || sample_bytes == 0) {
+//                consoleInfo("XTF samples count is zero");
+                return false;
             }
 
-            if((uint8_t*)pingheader + pingheader->NumBytesThisRecord != cdata) {
-//                consoleInfo("XTF pingchannel offset error");
+            cdata += sizeof (XTFPINGCHANHEADER);
+            if(cdata + sample_count*sample_bytes > cdata_end) {
                 return false;
             }
+
+            QVector<uint8_t> data;
+            data.resize(sample_count);
+
+            if((sample_format == 0 && sample_bytes == 1) || sample_format == 8) {
+                if(pingch->ChannelNumber == 0 || pingch->ChannelNumber == 2) {
+                    for(uint16_t i = 0; i < sample_count; i++) {
+                        data[sample_count-i-1] = *((uint8_t*)cdata);
+                        cdata += sample_bytes;
+                    }
+                } else {
+                    for(uint16_t i = 0; i < sample_count; i++) {
+                        data[i] = *((uint8_t*)cdata);
+                        cdata += sample_bytes;
+                    }
+                }
+            } else if((sample_format == 0 && sample_bytes == 2) || sample_format == 2) {
+                if(pingch->ChannelNumber == 0 || pingch->ChannelNumber == 2) {
+                    for(uint16_t i = 0; i < sample_count; i++) {
+                        data[sample_count-i-1] = *((uint16_t*)cdata) / 128;
+                        cdata += sample_bytes;
+                    }
+                } else {
+                    for(uint16_t i = 0; i < sample_count; i++) {
+                        data[i] = *((uint16_t*)cdata) / 128;
+                        cdata += sample_bytes;
+                    }
+                }
+            } else {
+                cdata += sample_count*sample_bytes; // unsupported sample format
+                continue;
+            }
+
+            ping.charts.append({ pingch->ChannelNumber, data, range/sample_count });
+        }
+
+        if(cdata != cdata_end) {
+//            consoleInfo("XTF pingchannel offset error");
+            return false;
         }
 
         return true;
@@ -1,6 +1,9 @@
 #include "DeviceManager.h"
 
+#include <QCoreApplication>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include "klf_reader.h"
 #include "core.h"
 extern Core core;
 
@@ -27,6 +30,7 @@ DeviceManager::DeviceManager() :
     qRegisterMetaType<IDBinDVL::DVLSolution>("IDBinDVL::DVLSolution");
     qRegisterMetaType<uint32_t>("uint32_t");
     qRegisterMetaType<FrameParser>("FrameParser");
+    qRegisterMetaType<FrameHandle>("FrameHandle");
 }
 
 DeviceManager::~DeviceManager()
@@ -99,7 +103,23 @@ bool DeviceManager::isMotorControlCreated() const
 }
 #endif
 
-void DeviceManager::frameInput(QUuid uuid, Link* link, FrameParser frame)
+void DeviceManager::frameInput(QUuid uuid, Link* link, FrameHandle frame)
+{
+    if (frame.isNull() || frame.isNested()) {
+        return; // nested frames are parsed again below together with their proxy frame
+    }
+
+    FrameParser parser; // starts synchronized, the handle holds exactly one outer frame
+    parser.setContext(const_cast<uint8_t*>(frame.data()), frame.size());
+    while (parser.availContext() > 0) {
+        parser.process();
+        if (parser.isComplete()) {
+            processFrame(uuid, link, parser);
+        }
+    }
+}
+
+void DeviceManager::processFrame(QUuid uuid, Link* link, FrameParser& frame)
 {
     if (frame.isComplete()) {
 
@@ -333,53 +353,50 @@ void DeviceManager::openFile(QString filePath)
     break_ = false;
 #endif
 
-    QFile file;
+    KlfReader reader;
     const QUrl url(filePath);
-    url.isLocalFile() ? file.setFileName(url.toLocalFile()) : file.setFileName(url.toString());
 
-    if (!file.open(QIODevice::ReadOnly)) {
+    if (!reader.open(url.isLocalFile() ? url.toLocalFile() : url.toString())) {
         emit fileStopsOpening();
         return;
     }
 
-    const qint64 totalSize = file.size();
-    qint64 bytesRead = 0;
-    Parsers::FrameParser frameParser;
+    const qint64 totalSize = reader.size();
     const QUuid someUuid;
     delAllDev();
 
 #ifdef SEPARATE_READING
     emit fileStartOpening();
     bool fileReadEnough{false};
+    const qint64 readEnoughSize = 1024 * 1024;
+    int eventsCnt = 0;
+#else
+    // the dataset is drawn as it fills: the epochs decoded so far are rendered while the rest of the log is decoded
+    const qint64 partialRenderIntervalMs = 100;
+    QElapsedTimer partialRenderTimer;
+    partialRenderTimer.start();
 #endif
 
-    while (true) {
-
+    // framing runs on a thread pool, frames arrive here in file order and are decoded on this thread
+    reader.ingestFrames([&](FrameParser& frame, qint64 endOffset) -> bool {
 #ifdef SEPARATE_READING
-        QCoreApplication::processEvents();
-        if (break_) {
-            emit fileBreaked(onOpen_);
-            onOpen_ = false;
-            file.close();
-            emit fileStopsOpening();
-            return;
+        if (++eventsCnt >= 500) {
+            QCoreApplication::processEvents();
+            eventsCnt = 0;
         }
 #else
-        if (break_) {
-            file.close();
-            return;
+        if (partialRenderTimer.elapsed() >= partialRenderIntervalMs) {
+            QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+            partialRenderTimer.restart();
         }
 #endif
+        if (break_) {
+            return false;
+        }
 
-        QByteArray chunk = file.read(1024 * 1024);
-        const qint64 chunkSize = chunk.size();
-
-        if (chunkSize == 0)
-            break;
-
-        bytesRead += chunkSize;
+        processFrame(someUuid, NULL, frame);
 
-        auto currProgress = static_cast<int>((static_cast<float>(bytesRead) / static_cast<float>(totalSize)) * 100.0f);
+        auto currProgress = static_cast<int>((static_cast<float>(endOffset) / static_cast<float>(totalSize)) * 100.0f);
         currProgress = std::max(0, currProgress);
         currProgress = std::min(100, currProgress);
 
@@ -387,44 +404,33 @@ void DeviceManager::openFile(QString filePath)
             progress_ = currProgress;
         }
 
-        frameParser.setContext((uint8_t*)chunk.data(), chunk.size());
-
-#ifdef SEPARATE_READING
-        int sleepCnt = 0;
-#endif
-
-        while (frameParser.availContext() > 0) {
-
-#ifdef SEPARATE_READING
-            QCoreApplication::processEvents();
-            if (break_) {
-                emit fileBreaked(onOpen_);
-                onOpen_ = false;
-                file.close();
-                return;
-            }
-            if (sleepCnt > 500) {
-                QThread::msleep(50);
-                sleepCnt = 0;
-            }
-            ++sleepCnt;
-#endif
-            frameParser.process();
-            if (frameParser.isComplete()) {
-                frameInput(someUuid, NULL, frameParser);
-            }
-        }
-
 #ifdef SEPARATE_READING
-        if (!fileReadEnough) { // it's really that?
+        if (!fileReadEnough && endOffset >= readEnoughSize) { // it's really that?
             emit onFileReadEnough();
             fileReadEnough = true;
         }
 #endif
 
-        chunk.clear();
+        return true;
+    });
+
+#ifdef SEPARATE_READING
+    if (!fileReadEnough && !break_) {
+        emit onFileReadEnough();
+    }
+    if (break_) {
+        emit fileBreaked(onOpen_);
+        onOpen_ = false;
+        emit fileStopsOpening();
+        return;
     }
-    file.close();
+#else
+    if (break_) {
+        return;
+    }
+#endif
+
+    reader.close();
 
     vru_.cleanVru();
     delAllDev();
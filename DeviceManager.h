@@ -10,6 +10,7 @@
 #include "streamlist.h"
 #include "DevQProperty.h"
 #include "ProtoBinnary.h"
+#include "frame_pool.h"
 #include "IDBinnary.h"
 
 #ifdef MOTOR
@@ -42,7 +43,7 @@ public slots:
     Q_INVOKABLE bool isCreatedId(int id);
     Q_INVOKABLE StreamListModel* streamsList();
 
-    void frameInput(QUuid uuid, Link* link, FrameParser frame);
+    void frameInput(QUuid uuid, Link* link, FrameHandle frame);
     void openFile(QString filePath);
 #ifdef SEPARATE_READING
     void closeFile(bool onOpen = false);
@@ -115,6 +116,7 @@ signals:
 
 private:
     /*methods*/
+    void processFrame(QUuid uuid, Link* link, FrameParser& frame);
     DevQProperty* getDevice(QUuid uuid, Link* link, uint8_t addr);
     void delAllDev();
     void deleteDevicesByLink(QUuid uuid);
@@ -52,11 +52,21 @@ DEFINES += QT_DEPRECATED_WARNINGS
 ### SOURCES
 SOURCES += \
     3Plot.cpp \
+    bottom_track_kernel.cpp \
+    csv_export.cpp \
     DevDriver.cpp \
     DeviceManager.cpp \
     DeviceManagerWrapper.cpp \
+    echogram_pyramid.cpp \
+    echogram_transpose.cpp \
     EchogramProcessing.cpp \
+    epoch_snapshot.cpp \
+    epoch_store.cpp \
+    frame_pool.cpp \
     IDBinnary.cpp \
+    klf_ingest.cpp \
+    klf_reader.cpp \
+    klf_writer.cpp \
     Link.cpp \
     LinkManager.cpp \
     LinkManagerWrapper.cpp \
@@ -78,7 +88,9 @@ SOURCES += \
     flasher.cpp \
     maxpointsfilter.cpp \
     nearestpointfilter.cpp \
+    plot_columns.cpp \
     plotcash.cpp \
+    range_mipmaps.cpp \
     ray.cpp \
     raycaster.cpp \
     streamlist.cpp \
@@ -133,14 +145,24 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 ### HEADERS
 HEADERS += \
     3Plot.h \
+    bottom_track_kernel.h \
     ConverterXTF.h \
+    csv_export.h \
     DSP.h \
     DevDriver.h \
     DeviceManager.h \
     DeviceManagerWrapper.h \
     DevQProperty.h \
+    echogram_pyramid.h \
+    echogram_transpose.h \
     EchogramProcessing.h \
+    epoch_snapshot.h \
+    epoch_store.h \
+    frame_pool.h \
     IDBinnary.h \
+    klf_ingest.h \
+    klf_reader.h \
+    klf_writer.h \
     Link.h \
     LinkManager.h \
     LinkManagerWrapper.h \
@@ -163,7 +185,10 @@ HEADERS += \
     logger.h \
     maxpointsfilter.h \
     nearestpointfilter.h \
+    plot_columns.h \
     plotcash.h \
+    range_mipmaps.h \
+    range_window_max.h \
     ray.h \
     raycaster.h \
     streamlist.h \
@@ -425,7 +425,7 @@ void Link::toParser(const QByteArray data)
     while (frame_.availContext() > 0) {
         frame_.process();
         if (frame_.isComplete()) {
-            emit frameReady(uuid_, this, frame_);
+            emit frameReady(uuid_, this, FrameHandle(frame_)); // the only copy of the frame, receivers share it
         }
     }
 }
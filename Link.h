@@ -16,6 +16,7 @@
 #include <QSerialPortInfo>
 #endif
 #include "ProtoBinnary.h"
+#include "frame_pool.h"
 
 using namespace Parsers;
 
@@ -101,7 +102,7 @@ public slots:
 signals:
     void readyParse(Link* link);
     void connectionStatusChanged(QUuid uuid);
-    void frameReady(QUuid uuid, Link* link, FrameParser frame);
+    void frameReady(QUuid uuid, Link* link, FrameHandle frame);
     void opened(QUuid uuid, Link* linkPtr);
     void closed(QUuid uuid, Link* link);
 
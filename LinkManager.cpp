@@ -14,6 +14,7 @@ LinkManager::LinkManager(QObject *parent) :
     qRegisterMetaType<ControlType>("ControlType");
     qRegisterMetaType<LinkType>("LinkType");
     qRegisterMetaType<FrameParser>("FrameParser");
+    qRegisterMetaType<FrameHandle>("FrameHandle");
 }
 
 QList<QSerialPortInfo> LinkManager::getCurrentSerialList() const
@@ -61,7 +61,7 @@ signals:
     void appendModifyModel(QUuid uuid, bool connectionStatus, ControlType controlType, QString portName, int baudrate, bool parity,
                            LinkType linkType, QString address, int sourcePort, int destinationPort, bool isPinned, bool isHided, bool isNotAvailable);
     void deleteModel(QUuid uuid);
-    void frameReady(QUuid uuid, Link* link, FrameParser frame);
+    void frameReady(QUuid uuid, Link* link, FrameHandle frame);
     void linkClosed(QUuid uuid, Link* link);
     void linkOpened(QUuid uuid, Link* link);
     void linkDeleted(QUuid uuid, Link* link);
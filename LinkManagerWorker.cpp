@@ -146,6 +146,6 @@ void LinkManagerWorker::stateChanged(Link *linkPtr, bool state)
     emit dataUpdated();
 }
 
-void LinkManagerWorker::frameInput(Link *link, FrameParser frame) {
+void LinkManagerWorker::frameInput(Link *link, FrameHandle frame) {
 
 }
@@ -37,11 +37,11 @@ private:
 
 signals:
     void dataUpdated();
-    void frameReady(Link* link, FrameParser frame);
+    void frameReady(QUuid uuid, Link* link, FrameHandle frame);
 
 public slots:
     void onExpiredTimer();
     void stateChanged(Link* linkPtr, bool state);
-    void frameInput(Link* link, FrameParser frame);
+    void frameInput(Link* link, FrameHandle frame);
 };
 
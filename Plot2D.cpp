@@ -15,6 +15,13 @@ Plot2D::Plot2D()
     _grid.setVisible(true);
     _aim.setVisible(true);
     _quadrature.setVisible(false);
+
+    PlotLayer* layers[] = { &_echogram, &_attitude, &_encoder, &_DVLBeamVelocity, &_DVLSolution, &_usblSolution,
+                            &_rangeFinder, &_bottomProcessing, &_GNSS, &_quadrature, &_grid, &_aim };
+    for(PlotLayer* layer : layers) {
+        layer->setSnapshot(&_columns);
+    }
+
     setDataChannel(CHANNEL_FIRST);
    _cursor.attitude.from = -180;
    _cursor.attitude.to = 180;
@@ -34,6 +41,7 @@ bool Plot2D::getImage(int width, int height, QPainter* painter, bool is_horizont
 
     reindexingCursor();
     reRangeDistance();
+    gatherColumns();
 
 //    painter->setCompositionMode(QPainter::RasterOp_SourceXorDestination);
     _echogram.draw(_canvas, _dataset, _cursor);
@@ -93,13 +101,13 @@ void Plot2D::setTimelinePositionSec(float position)
 }
 
 void Plot2D::setTimelinePositionByEpoch(int epochIndx) {
-    float pos = epochIndx == -1 ? _cursor.position : static_cast<float>(epochIndx + _cursor.indexes.size() / 2) / static_cast<float>(_dataset->size());
+    float pos = epochIndx == -1 ? _cursor.position : static_cast<float>(epochIndx + (_cursor.indexes.size() / 2 << _cursor.zoomLevel)) / static_cast<float>(_dataset->size());
     _cursor.selectEpochIndx = epochIndx;
     setTimelinePositionSec(pos);
 }
 
 void Plot2D::scrollPosition(int columns) {
-    float new_position = timelinePosition() + (1.0f/_dataset->size())*columns;
+    float new_position = timelinePosition() + (1.0f/_dataset->size())*columns*(1 << _cursor.zoomLevel);
     setTimelinePosition(new_position);
 }
 
@@ -149,6 +157,24 @@ void Plot2D::setEchogramCompensation(int compensation_id) {
     plotUpdate();
 }
 
+void Plot2D::setEchogramAggregation(int stat) {
+    _echogram.setAggregation(static_cast<EchogramPyramid::Stat>(stat));
+    plotUpdate();
+}
+
+void Plot2D::setHorizontalZoom(int level) {
+    if(level < 0) {
+        level = 0;
+    }
+    if(level > EchogramPyramid::maxLevel) {
+        level = EchogramPyramid::maxLevel;
+    }
+    if(_cursor.zoomLevel != level) {
+        _cursor.zoomLevel = level;
+        plotUpdate();
+    }
+}
+
 void Plot2D::setBottomTrackVisible(bool visible) {
     _bottomProcessing.setVisible(visible);
     plotUpdate();
@@ -400,12 +426,14 @@ void Plot2D::setMousePosition(int x, int y) {
                 } else if(_cursor.tool() == MouseToolDistance) {
                     epoch->setDistProcessing(channel1, dist);
                     epoch->setDistProcessing(channel2, dist);
+                    _dataset->markSpatialDirty(epoch_index, epoch_index + 1);
                 } else if(_cursor.tool()== MouseToolDistanceMax) {
                     epoch->setMaxDistProc(channel1, dist);
                     epoch->setMaxDistProc(channel2, dist);
                 } else if(_cursor.tool() == MouseToolDistanceErase) {
                     epoch->clearDistProcessing(channel1);
                     epoch->clearDistProcessing(channel2);
+                    _dataset->markSpatialDirty(epoch_index, epoch_index + 1);
                 }
             }
         }
@@ -432,6 +460,7 @@ void Plot2D::setMouseTool(MouseTool tool) {
 
 void Plot2D::resetCash() {
     _echogram.resetCash();
+    _rangeWindow.reset();
 }
 
 void Plot2D::reindexingCursor() {
@@ -458,14 +487,17 @@ void Plot2D::reindexingCursor() {
     }
     _cursor.last_dataset_size = data_width;
 
-    float hor_ratio = 1.0f;
+    const int epochs_per_column = 1 << _cursor.zoomLevel;
 
     float position = timelinePosition();
 
     int head_data_index = round(position*float(data_width));
 
     for(int i = 0; i < image_width; i++) {
-        int data_index = head_data_index + round((i - image_width)/hor_ratio) - 1;
+        int data_index = head_data_index - 2 + (i + 1 - image_width)*epochs_per_column;
+        if(data_index >= 0) {
+            data_index &= ~(epochs_per_column - 1); // the first epoch of the pyramid row
+        }
         if(data_index >= 0 && data_index < data_width) {
              _cursor.indexes[i] = data_index;
         } else {
@@ -503,15 +535,9 @@ void Plot2D::reRangeDistance() {
     }
 
     if(_cursor.distance.mode == AutoRangeMaxOnScreen) {
-        for(unsigned int i = 0; i < _cursor.indexes.size(); i++) {
-            Epoch* epoch = _dataset->fromIndex(_cursor.getIndex(i));
-            if(epoch != NULL) {
-                float epoch_range = epoch->getMaxRnage(_cursor.channel1);
-                if(!isfinite(max_range) || max_range < epoch_range) {
-                    max_range = epoch_range;
-                }
-            }
-        }
+        max_range = _rangeWindow.update(*_dataset, _cursor.indexes, _cursor.channel1, _cursor.zoomLevel);
+    } else {
+        _rangeWindow.reset();
     }
 
     if(isfinite(max_range)) {
@@ -524,12 +550,34 @@ void Plot2D::reRangeDistance() {
     }
 }
 
-bool Plot2DAim::draw(Canvas &canvas, Dataset *dataset, DatasetCursor cursor) 
+void Plot2D::gatherColumns() {
+    int groups = 0;
+    if(_attitude.isVisible()) { groups |= PlotColumns::GroupAttitude; }
+    if(_encoder.isVisible()) { groups |= PlotColumns::GroupEncoder; }
+    if(_DVLBeamVelocity.isVisible()) { groups |= PlotColumns::GroupDVLBeam; }
+    if(_DVLSolution.isVisible()) { groups |= PlotColumns::GroupDVLSolution; }
+    if(_usblSolution.isVisible()) { groups |= PlotColumns::GroupUsbl; }
+    if(_GNSS.isVisible()) { groups |= PlotColumns::GroupGnss; }
+    if(_bottomProcessing.isVisible()) { groups |= PlotColumns::GroupBottom; }
+    if(_rangeFinder.isVisible()) { groups |= PlotColumns::GroupRangeFinder; }
+
+    if(_dataset == NULL) {
+        _columns.begin(_canvas.width(), groups);
+        return;
+    }
+
+    _columns.gather(*_dataset, _cursor.indexes, _canvas.width(), groups, _cursor.channel1, _cursor.channel2, _cursor.channel2 != CHANNEL_NONE);
+}
+
+bool Plot2DAim::draw(Canvas &canvas, Dataset *dataset, const DatasetCursor& cursor) 
 {
     if((cursor.mouseX < 0 || cursor.mouseY < 0) && (cursor.selectEpochIndx == -1) ) {
         return false;
     }
 
+    int mouseX = cursor.mouseX;
+    int mouseY = cursor.mouseY;
+
     if (cursor.selectEpochIndx != -1) {
         auto selectedEpoch = dataset->fromIndex(cursor.selectEpochIndx);
         int offsetX = 0;
@@ -542,7 +590,8 @@ bool Plot2DAim::draw(Canvas &canvas, Dataset *dataset, DatasetCursor cursor)
                 const int x = canvas.width() / 2 + offsetX;
                 const int y = keys.size() == 2 ? canvas.height() / 2 - canvas.height() * (chartPtr->bottomProcessing.distance / cursor.distance.range()) :
                                   canvas.height() * (chartPtr->bottomProcessing.distance / cursor.distance.range());
-                cursor.setMouse(x, y);
+                mouseX = x;
+                mouseY = y;
             }
         }
     }
@@ -561,13 +610,13 @@ bool Plot2DAim::draw(Canvas &canvas, Dataset *dataset, DatasetCursor cursor)
     const int image_width = canvas.width();
 
     if (cursor._tool == MouseToolNothing || beenEpochEvent_) {
-        p->drawLine(0, cursor.mouseY, image_width, cursor.mouseY);
-        p->drawLine(cursor.mouseX, 0, cursor.mouseX, image_height);
+        p->drawLine(0, mouseY, image_width, mouseY);
+        p->drawLine(mouseX, 0, mouseX, image_height);
     }
 
     const float canvas_height = canvas.height();
     float value_range = cursor.distance.to - cursor.distance.from;
-    float value_scale = float(cursor.mouseY)/canvas_height;
+    float value_scale = float(mouseY)/canvas_height;
     float cursor_distance = value_scale*value_range + cursor.distance.from;
 
     // text & back
@@ -576,14 +625,14 @@ bool Plot2DAim::draw(Canvas &canvas, Dataset *dataset, DatasetCursor cursor)
     QString distanceText = QString("%1 m").arg(cursor_distance, 0, 'g', 4);
     QRect textRect = p->fontMetrics().boundingRect(distanceText);
 
-    bool onTheRight = (p->window().width() - cursor.mouseX - 65) < textRect.width();
+    bool onTheRight = (p->window().width() - mouseX - 65) < textRect.width();
 
     QPoint shiftedPoint;
-    if (cursor.mouseY > 60) {
-        shiftedPoint = onTheRight ? QPoint(cursor.mouseX - 50 - textRect.width(), cursor.mouseY - 20) : QPoint(cursor.mouseX + 50, cursor.mouseY - 20);
+    if (mouseY > 60) {
+        shiftedPoint = onTheRight ? QPoint(mouseX - 50 - textRect.width(), mouseY - 20) : QPoint(mouseX + 50, mouseY - 20);
     }
     else {
-        shiftedPoint = onTheRight ? QPoint(cursor.mouseX - 50 - textRect.width(), cursor.mouseY + 40) : QPoint(cursor.mouseX + 50, cursor.mouseY + 40);
+        shiftedPoint = onTheRight ? QPoint(mouseX - 50 - textRect.width(), mouseY + 40) : QPoint(mouseX + 50, mouseY + 40);
     }
 
     textRect.moveTopLeft(shiftedPoint);
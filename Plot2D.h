@@ -10,6 +10,10 @@
 #include <QPainter>
 
 #include "plotcash.h"
+#include "echogram_transpose.h"
+#include "plot_columns.h"
+#include "range_mipmaps.h"
+#include "range_window_max.h"
 
 #include <vector>
 
@@ -34,13 +38,13 @@ typedef struct DatasetCursor {
     int channel1 = CHANNEL_FIRST;
     int channel2 = CHANNEL_NONE;
 
-    bool isChannelDoubled() {
+    bool isChannelDoubled() const {
         return (CHANNEL_NONE != channel1 && CHANNEL_NONE != channel2);
     }
 
     std::vector<int> indexes;
 
-    inline int getIndex(int col) {
+    inline int getIndex(int col) const {
         if(col < (int)indexes.size() && col >= 0) {
             return indexes[col];
         }
@@ -49,6 +53,7 @@ typedef struct DatasetCursor {
 
     float position = 1;
     int last_dataset_size = 0;
+    int zoomLevel = 0; // a column holds 2^zoomLevel epochs, indexes point to the first of them
 
     int mouseX = -1, mouseY = -1;
     MouseTool _tool = MouseToolNothing;
@@ -61,9 +66,9 @@ typedef struct DatasetCursor {
 
         void set(float f, float t) {from = f; to = t;}
 
-        float range() { return to - from;}
+        float range() const { return to - from;}
 
-        bool isValid() {
+        bool isValid() const {
             return isfinite(from) && isfinite(to);
         }
     } distance;
@@ -74,7 +79,7 @@ typedef struct DatasetCursor {
 
         void set(float f, float t) {from = f; to = t;}
 
-        bool isValid() {
+        bool isValid() const {
             return isfinite(from) && isfinite(to);
         }
     } attitude;
@@ -85,27 +90,30 @@ typedef struct DatasetCursor {
 
         void set(float f, float t) {from = f; to = t;}
 
-        bool isValid() {
+        bool isValid() const {
             return isfinite(from) && isfinite(to);
         }
     } velocity;
 
-    bool isDistanceEqual(DatasetCursor cursor) {
+    bool isDistanceEqual(const DatasetCursor& cursor) const {
         return (cursor.distance.from == distance.from && cursor.distance.to == distance.to);
     }
 
-    bool isChannelsEqual(DatasetCursor cursor) {
+    bool isChannelsEqual(const DatasetCursor& cursor) const {
         return (cursor.channel1 == channel1 && cursor.channel2 == channel2);
     }
 
+    bool isZoomEqual(const DatasetCursor& cursor) const {
+        return cursor.zoomLevel == zoomLevel;
+    }
+
     void setMouse(int x, int y) { mouseX = x; mouseY = y;  }
     void setTool(MouseTool tool) { _tool = tool; }
-    MouseTool tool() { return _tool; }
+    MouseTool tool() const { return _tool; }
 
 } DatasetCursor;
 
 
-
 typedef struct  PlotColor{
     uint8_t r = 0;
     uint8_t g = 0;
@@ -163,7 +171,7 @@ public:
     int width() { return _width; }
     int height() { return _height; }
 
-    void drawY(QVector<float> y, PlotPen pen) {
+    void drawY(const QVector<float>& y, PlotPen pen) {
         if(_painter == NULL) { return; }
         QPen qpen;
         qpen.setWidth(pen.width);
@@ -174,25 +182,23 @@ public:
         _painter->setPen(qpen);
 
         if(pen.lineStyle == PlotPen::LineStyleSolid) {
-            QVector<QLineF> lines(y.size()-1);
-            for(int i = 0; i < lines.size(); i++) {
-
-                lines[i] = QLineF(i, y[i], i+1, y[i+1]);
+            _lines.resize(y.isEmpty() ? 0 : y.size()-1);
+            for(int i = 0; i < _lines.size(); i++) {
                 if(isfinite(y[i+1])) {
-                    lines[i] = QLineF(i, y[i], i+1, y[i+1]);
+                    _lines[i] = QLineF(i, y[i], i+1, y[i+1]);
                 } else {
-                    lines[i] = QLineF(i, y[i], i+pen.width, y[i]);
+                    _lines[i] = QLineF(i, y[i], i+pen.width, y[i]);
                 }
             }
-           _painter->drawLines(lines);
+           _painter->drawLines(_lines);
         }
 
         if(pen.lineStyle == PlotPen::LineStylePoint) {
-            QVector<QPointF> lines(y.size());
-            for(int i = 0; i < lines.size(); i++) {
-                lines[i] = QPointF(i, y[i]);
+            _points.resize(y.size());
+            for(int i = 0; i < _points.size(); i++) {
+                _points[i] = QPointF(i, y[i]);
             }
-           _painter->drawPoints(lines);
+           _painter->drawPoints(_points);
         }
 
     }
@@ -206,6 +212,9 @@ protected:
     int _height = 0;
 
     QPainter* _painter = NULL;
+
+    QVector<QLineF> _lines; // kept between calls
+    QVector<QPointF> _points;
 };
 
 class PlotLayer {
@@ -215,8 +224,9 @@ public:
     bool isFillWidth() {return fillWidth_; }
     void setVisible(bool visible) { _isVisible = visible; }
     void setFillWidth(bool state) { fillWidth_ = state; }
+    void setSnapshot(const PlotColumns* snapshot) { _snapshot = snapshot; } // the columns of the frame, filled before draw
 
-    virtual bool draw(Canvas& canvas, Dataset* dataset, DatasetCursor cursor)
+    virtual bool draw(Canvas& canvas, Dataset* dataset, const DatasetCursor& cursor)
     {
         Q_UNUSED(canvas);
         Q_UNUSED(dataset);
@@ -226,6 +236,9 @@ public:
 
 protected:
     bool _isVisible = false;
+    const PlotColumns* _snapshot = NULL;
+
+    bool isSnapshotFilled(int groups) { return _snapshot != NULL && _snapshot->isFilled(groups); }
 
 private:
     bool fillWidth_;
@@ -242,7 +255,7 @@ public:
     };
 
     Plot2DEchogram();
-    bool draw(Canvas& canvas, Dataset* dataset, DatasetCursor cursor);
+    bool draw(Canvas& canvas, Dataset* dataset, const DatasetCursor& cursor);
 
     void setLowLevel(float low);
     void setHightLevel(float high);
@@ -251,10 +264,11 @@ public:
     void setColorScheme(QVector<QColor> coloros, QVector<int> levels);
     void setThemeId(int theme_id);
     void setCompensation(int compensation_id);
+    void setAggregation(EchogramPyramid::Stat stat);
 
     void updateColors();
 
-    int updateCash(Dataset* dataset, DatasetCursor cursor, int width, int height);
+    int updateCash(Dataset* dataset, const DatasetCursor& cursor, int width, int height);
     void resetCash();
 
 protected:
@@ -270,14 +284,15 @@ protected:
         CashState state = CashStateNotValid;
         bool isNeedUpdate = true;
 
-        QVector<int16_t> data;
-
 //        CashState stateColor = CashStateNotValid;
 //        QVector<uint16_t> color;
     } CashLine;
 
     uint16_t _colorHashMap[256];
     QVector<CashLine> _cash;
+    QVector<int16_t> _columns; // column-major back buffer of the image, _columnsHeight values per column
+    int _columnsHeight = 0;
+    EchogramTranspose _transpose;
 
     QVector<QRgb> _colorTable;
     QVector<QRgb> _colorLevels;
@@ -286,6 +301,9 @@ protected:
     bool _flagColorChanged = true;
 
     int _compensation_id = 0;
+    EchogramPyramid::Stat _aggregation = EchogramPyramid::Stat::Max;
+    QVector<uint8_t> _compensatedRow;
+    RangeMipmaps _rangeMipmaps; // of the rows drawn zoomed out in range
 
     struct {
         bool resetCash = true;
@@ -302,6 +320,11 @@ protected:
     DatasetCursor _lastCursor;
     int _lastWidth = -1;
     int _lastHeight = -1;
+    int _lastDatasetSize = 0;
+
+    void eraseColumn(int column);
+    // the column of the epoch, aggregated from the pyramid when zoomed out, resampled from a range mipmap of the row
+    bool columnTo(Dataset* dataset, Epoch* epoch, int epochIndx, int zoomLevel, int channel, float start, float end, int16_t* dst, int len, bool reverse = false);
 
     bool getTriggerCashReset() {
         bool reset_cash = _cashFlags.resetCash;
@@ -316,26 +339,16 @@ public:
     Plot2DLine() {}
 
 protected:
-    bool drawY(Canvas& canvas, QVector<float> data, float value_from, float value_to, PlotPen pen) {
+    bool drawY(Canvas& canvas, const QVector<float>& data, float value_from, float value_to, PlotPen pen) {
         if(canvas.width() != data.size()) { return false; }
 
-        QVector<float> data_maped(data.size());
-
-        const float canvas_height = canvas.height();
-        float value_range = value_to - value_from;
-        float value_scale = canvas_height/value_range;
-
-        for(int i = 0; i < data_maped.size(); i++) {
-            float y = (data[i] - value_from)*value_scale;
-            if(y < 0) { y = 0; }
-            else if(y > canvas_height) { y = canvas_height; }
-            data_maped[i] = y;
-        }
-
-        canvas.drawY(data_maped, pen);
+        PlotColumns::mapY(data, value_from, value_to, canvas.height(), _dataMaped);
+        canvas.drawY(_dataMaped, pen);
 
         return true;
     }
+
+    QVector<float> _dataMaped; // kept between calls
 };
 
 class Plot2DDVLBeamVelocity : public Plot2DLine {
@@ -343,43 +356,21 @@ public:
     Plot2DDVLBeamVelocity() {}
 
 
-    bool draw(Canvas& canvas, Dataset* dataset, DatasetCursor cursor) {
-        if(!isVisible() || !cursor.velocity.isValid()) { return false; }
+    bool draw(Canvas& canvas, Dataset* dataset, const DatasetCursor& cursor) {
+        Q_UNUSED(dataset);
 
-        QVector<float> beam_velocity(canvas.width());
-        beam_velocity.fill(NAN);
-        QVector<float> beam_amp(canvas.width());
-        beam_amp.fill(NAN);
-        QVector<float> beam_mode(canvas.width());
-        beam_mode.fill(NAN);
-        QVector<float> beam_coh(canvas.width());
-        beam_coh.fill(NAN);
-        QVector<float> beam_dist(canvas.width());
-        beam_dist.fill(NAN);
+        if(!isVisible() || !cursor.velocity.isValid() || !isSnapshotFilled(PlotColumns::GroupDVLBeam)) { return false; }
 
         for(int ibeam = 0; ibeam < 4; ibeam++) {
             if(((_beamFilter >> ibeam)&1) == 0) { continue; }
 
-            for(int i = 0; i < canvas.width(); i++) {
-                int pool_index = cursor.getIndex(i);
-                Epoch* data = dataset->fromIndex(pool_index);
-
-                if(data != NULL &&  data->isDopplerBeamAvail(ibeam)) {
-                    IDBinDVL::BeamSolution beam = data->dopplerBeam(ibeam);
-                    beam_velocity[i] = beam.velocity;
-                    beam_amp[i] = beam.amplitude*0.1f;
-                    beam_mode[i] = (beam.mode*6+ibeam)*2;
-                    beam_coh[i] = beam.coherence[0];
-                    beam_dist[i] = beam.distance;
-                }
-            }
-
+            const PlotColumns::Field beam_velocity = PlotColumns::Field(PlotColumns::BeamVelocity + ibeam);
+            const PlotColumns::Field beam_mode = PlotColumns::Field(PlotColumns::BeamMode + ibeam);
+            const PlotColumns::Field beam_dist = PlotColumns::Field(PlotColumns::BeamDistance + ibeam);
 
-            drawY(canvas, beam_velocity, cursor.velocity.from, cursor.velocity.to, _penBeam[ibeam]);
-//            drawY(canvas, beam_amp, 0, 100, _penAmp[ibeam]);
-//            drawY(canvas, beam_coh, 0, 1000, _penAmp[ibeam]);
-            drawY(canvas, beam_mode, canvas.height(), 0, _penMode[ibeam]);
-            drawY(canvas, beam_dist, cursor.distance.from, cursor.distance.to, _penAmp[ibeam]);
+            drawY(canvas, _snapshot->at(beam_velocity), cursor.velocity.from, cursor.velocity.to, _penBeam[ibeam]);
+            drawY(canvas, _snapshot->at(beam_mode), canvas.height(), 0, _penMode[ibeam]);
+            drawY(canvas, _snapshot->at(beam_dist), cursor.distance.from, cursor.distance.to, _penAmp[ibeam]);
         }
 
 
@@ -414,44 +405,16 @@ public:
     Plot2DDVLSolution() {}
 
 
-    bool draw(Canvas& canvas, Dataset* dataset, DatasetCursor cursor) {
-        if(!isVisible() || !cursor.velocity.isValid()) { return false; }
-
-        QVector<float> velocityX(canvas.width());
-        velocityX.fill(NAN);
-
-        QVector<float> velocityY(canvas.width());
-        velocityY.fill(NAN);
-
-        QVector<float> velocityZ(canvas.width());
-        velocityZ.fill(NAN);
-
-        QVector<float> velocityA(canvas.width());
-        velocityA.fill(NAN);
-
-        QVector<float> distance(canvas.width());
-        distance.fill(NAN);
-
-        for(int i = 0; i < canvas.width(); i++) {
-            int pool_index = cursor.getIndex(i);
-            Epoch* data = dataset->fromIndex(pool_index);
-
-            if(data != NULL &&  data->isDVLSolutionAvail()) {
-                IDBinDVL::DVLSolution sol = data->dvlSolution();
-                velocityX[i] = sol.velocity.x;
-                velocityY[i] = sol.velocity.y;
-                velocityZ[i] = sol.velocity.z;
-                velocityA[i] = sqrt(sol.velocity.x*sol.velocity.x + sol.velocity.y*sol.velocity.y + sol.velocity.z*sol.velocity.z);
-                distance[i] = sol.distance.z;
-            }
-        }
+    bool draw(Canvas& canvas, Dataset* dataset, const DatasetCursor& cursor) {
+        Q_UNUSED(dataset);
 
+        if(!isVisible() || !cursor.velocity.isValid() || !isSnapshotFilled(PlotColumns::GroupDVLSolution)) { return false; }
 
-        drawY(canvas, velocityX, cursor.velocity.from, cursor.velocity.to, _penVelocity[0]);
-        drawY(canvas, velocityY, cursor.velocity.from, cursor.velocity.to, _penVelocity[1]);
-        drawY(canvas, velocityZ, cursor.velocity.from, cursor.velocity.to, _penVelocity[2]);
-        drawY(canvas, velocityA, cursor.velocity.from, cursor.velocity.to, _penVelocity[3]);
-        drawY(canvas, distance, cursor.distance.from, cursor.distance.to, _penDist);
+        drawY(canvas, _snapshot->at(PlotColumns::VelocityX), cursor.velocity.from, cursor.velocity.to, _penVelocity[0]);
+        drawY(canvas, _snapshot->at(PlotColumns::VelocityY), cursor.velocity.from, cursor.velocity.to, _penVelocity[1]);
+        drawY(canvas, _snapshot->at(PlotColumns::VelocityZ), cursor.velocity.from, cursor.velocity.to, _penVelocity[2]);
+        drawY(canvas, _snapshot->at(PlotColumns::VelocityAbs), cursor.velocity.from, cursor.velocity.to, _penVelocity[3]);
+        drawY(canvas, _snapshot->at(PlotColumns::DVLDistance), cursor.distance.from, cursor.distance.to, _penDist);
 
         return true;
     }
@@ -485,34 +448,14 @@ public:
     Plot2DUSBLSolution() {}
 
 
-    bool draw(Canvas& canvas, Dataset* dataset, DatasetCursor cursor) {
-        if(!isVisible() || !cursor.distance.isValid()) { return false; }
-
-        QVector<float> azimuth(canvas.width());
-        azimuth.fill(NAN);
-
-        QVector<float> elevation(canvas.width());
-        elevation.fill(NAN);
-
-        QVector<float> distance(canvas.width());
-        distance.fill(NAN);
-
-        for(int i = 0; i < canvas.width(); i++) {
-            int pool_index = cursor.getIndex(i);
-            Epoch* data = dataset->fromIndex(pool_index);
-
-            if(data != NULL &&  data->isUsblSolutionAvailable()) {
-                IDBinUsblSolution::UsblSolution sol = data->usblSolution();
+    bool draw(Canvas& canvas, Dataset* dataset, const DatasetCursor& cursor) {
+        Q_UNUSED(dataset);
 
-                azimuth[i] = sol.azimuth_deg;
-                elevation[i] = sol.elevation_deg;
-                distance[i] = sol.distance_m;
-            }
-        }
+        if(!isVisible() || !cursor.distance.isValid() || !isSnapshotFilled(PlotColumns::GroupUsbl)) { return false; }
 
-        drawY(canvas, azimuth, cursor.attitude.from, cursor.attitude.to, _penAngle[0]);
-        drawY(canvas, elevation, cursor.attitude.from, cursor.attitude.to, _penAngle[1]);
-        drawY(canvas, distance, cursor.distance.from, cursor.distance.to, _penDist);
+        drawY(canvas, _snapshot->at(PlotColumns::UsblAzimuth), cursor.attitude.from, cursor.attitude.to, _penAngle[0]);
+        drawY(canvas, _snapshot->at(PlotColumns::UsblElevation), cursor.attitude.from, cursor.attitude.to, _penAngle[1]);
+        drawY(canvas, _snapshot->at(PlotColumns::UsblDistance), cursor.distance.from, cursor.distance.to, _penDist);
 
         return true;
     }
@@ -534,31 +477,14 @@ public:
     Plot2DAttitude() {}
 
 
-    bool draw(Canvas& canvas, Dataset* dataset, DatasetCursor cursor) {
-        if(!isVisible() || !cursor.attitude.isValid()) { return false; }
-
-        QVector<float> yaw(canvas.width());
-        QVector<float> pitch(canvas.width());
-        QVector<float> roll(canvas.width());
-
-        for(int i = 0; i < canvas.width(); i++) {
-            int pool_index = cursor.getIndex(i);
-            Epoch* data = dataset->fromIndex(pool_index);
+    bool draw(Canvas& canvas, Dataset* dataset, const DatasetCursor& cursor) {
+        Q_UNUSED(dataset);
 
-            if(data != NULL && data->isAttAvail()) {
-                yaw[i] = data->yaw();
-                pitch[i] = data->pitch();
-                roll[i] = data->roll();
-            } else {
-                yaw[i] = NAN;
-                pitch[i] = NAN;
-                roll[i] = NAN;
-            }
-        }
+        if(!isVisible() || !cursor.attitude.isValid() || !isSnapshotFilled(PlotColumns::GroupAttitude)) { return false; }
 
-        drawY(canvas, yaw, cursor.attitude.from, cursor.attitude.to, _penYaw);
-        drawY(canvas, pitch, cursor.attitude.from, cursor.attitude.to, _penPitch);
-        drawY(canvas, roll, cursor.attitude.from, cursor.attitude.to, _penRoll);
+        drawY(canvas, _snapshot->at(PlotColumns::Yaw), cursor.attitude.from, cursor.attitude.to, _penYaw);
+        drawY(canvas, _snapshot->at(PlotColumns::Pitch), cursor.attitude.from, cursor.attitude.to, _penPitch);
+        drawY(canvas, _snapshot->at(PlotColumns::Roll), cursor.attitude.from, cursor.attitude.to, _penRoll);
 
         return true;
     }
@@ -574,30 +500,13 @@ public:
     Plot2DEncoder() {}
 
 
-    bool draw(Canvas& canvas, Dataset* dataset, DatasetCursor cursor) {
-        if(!isVisible() || !cursor.attitude.isValid()) { return false; }
-
-        QVector<float> yaw(canvas.width());
-        QVector<float> pitch(canvas.width());
-        QVector<float> roll(canvas.width());
-
-        for(int i = 0; i < canvas.width(); i++) {
-            int pool_index = cursor.getIndex(i);
-            Epoch* data = dataset->fromIndex(pool_index);
+    bool draw(Canvas& canvas, Dataset* dataset, const DatasetCursor& cursor) {
+        Q_UNUSED(dataset);
 
-            if(data != NULL && data->isEncodersSeted()) {
-                yaw[i] = data->encoder1();
-                pitch[i] = data->encoder2();
-                roll[i] = data->encoder3();
-            } else {
-                yaw[i] = NAN;
-                pitch[i] = NAN;
-                roll[i] = NAN;
-            }
-        }
+        if(!isVisible() || !cursor.attitude.isValid() || !isSnapshotFilled(PlotColumns::GroupEncoder)) { return false; }
 
-        drawY(canvas, yaw, cursor.attitude.from, cursor.attitude.to, _penYaw);
-        drawY(canvas, pitch, cursor.attitude.from, cursor.attitude.to, _penPitch);
+        drawY(canvas, _snapshot->at(PlotColumns::Encoder1), cursor.attitude.from, cursor.attitude.to, _penYaw);
+        drawY(canvas, _snapshot->at(PlotColumns::Encoder2), cursor.attitude.from, cursor.attitude.to, _penPitch);
 
         return true;
     }
@@ -612,22 +521,12 @@ public:
     Plot2DGNSS() {}
 
 
-    bool draw(Canvas& canvas, Dataset* dataset, DatasetCursor cursor) {
-        if(!isVisible() || !cursor.velocity.isValid()) { return false; }
+    bool draw(Canvas& canvas, Dataset* dataset, const DatasetCursor& cursor) {
+        Q_UNUSED(dataset);
 
-        QVector<float> h_speed(canvas.width());
-        h_speed.fill(NAN);
+        if(!isVisible() || !cursor.velocity.isValid() || !isSnapshotFilled(PlotColumns::GroupGnss)) { return false; }
 
-        for(int i = 0; i < canvas.width(); i++) {
-            int pool_index = cursor.getIndex(i);
-            Epoch* data = dataset->fromIndex(pool_index);
-
-            if(data != NULL) {
-                h_speed[i] = data->gnssHSpeed();
-            }
-        }
-
-        drawY(canvas, h_speed, cursor.velocity.from, cursor.velocity.to, _penHSpeed);
+        drawY(canvas, _snapshot->at(PlotColumns::GnssHSpeed), cursor.velocity.from, cursor.velocity.to, _penHSpeed);
 
         return true;
     }
@@ -641,37 +540,14 @@ public:
     Plot2DBottomProcessing() {}
 
 
-    bool draw(Canvas& canvas, Dataset* dataset, DatasetCursor cursor) {
-        if(!isVisible() || !cursor.distance.isValid()) { return false; }
-
-        QVector<float> distance1(canvas.width());
-        QVector<float> distance2(canvas.width());
-
-        distance1.fill(NAN);
-        distance2.fill(NAN);
+    bool draw(Canvas& canvas, Dataset* dataset, const DatasetCursor& cursor) {
+        Q_UNUSED(dataset);
 
-        if(cursor.channel2 == CHANNEL_NONE) {
-            for(int i = 0; i < canvas.width(); i++) {
-                int pool_index = cursor.getIndex(i);
-                Epoch* data = dataset->fromIndex(pool_index);
-                if(data != NULL) {
-                    distance1[i] = data->distProccesing(cursor.channel1);
-                }
-            }
-        } else {
-            for(int i = 0; i < canvas.width(); i++) {
-                int pool_index = cursor.getIndex(i);
-                Epoch* data = dataset->fromIndex(pool_index);
-                if(data != NULL) {
-                    distance1[i] = -data->distProccesing(cursor.channel1);
-                    distance2[i] = data->distProccesing(cursor.channel2);
-                }
-            }
-        }
+        if(!isVisible() || !cursor.distance.isValid() || !isSnapshotFilled(PlotColumns::GroupBottom)) { return false; }
 
-        drawY(canvas, distance1, cursor.distance.from, cursor.distance.to, _penLine);
+        drawY(canvas, _snapshot->at(PlotColumns::BottomDistance1), cursor.distance.from, cursor.distance.to, _penLine);
         if(cursor.channel2 != CHANNEL_NONE) {
-            drawY(canvas, distance2, cursor.distance.from, cursor.distance.to, _penLine2);
+            drawY(canvas, _snapshot->at(PlotColumns::BottomDistance2), cursor.distance.from, cursor.distance.to, _penLine2);
         }
 
         return true;
@@ -688,29 +564,19 @@ public:
     Plot2DRangefinder() {}
 
 
-    bool draw(Canvas& canvas, Dataset* dataset, DatasetCursor cursor) {
-        if(!isVisible() || !cursor.distance.isValid()) { return false; }
-
-        if(_themeId < 1) { return true;}
-
-        QVector<float> distance(canvas.width());
+    bool draw(Canvas& canvas, Dataset* dataset, const DatasetCursor& cursor) {
+        Q_UNUSED(dataset);
 
-        distance.fill(NAN);
+        if(!isVisible() || !cursor.distance.isValid() || !isSnapshotFilled(PlotColumns::GroupRangeFinder)) { return false; }
 
-        for(int i = 0; i < canvas.width(); i++) {
-            int pool_index = cursor.getIndex(i);
-            Epoch* data = dataset->fromIndex(pool_index);
-            if(data != NULL) {
-                distance[i] = data->rangeFinder();
-            }
-        }
+        if(_themeId < 1) { return true;}
 
         if(_themeId == 1) {
-            drawY(canvas, distance, cursor.distance.from, cursor.distance.to, _penLine);
+            drawY(canvas, _snapshot->at(PlotColumns::RangeFinder), cursor.distance.from, cursor.distance.to, _penLine);
         }
 
         if(_themeId == 2) {
-            drawY(canvas, distance, cursor.distance.from, cursor.distance.to, _penPoint);
+            drawY(canvas, _snapshot->at(PlotColumns::RangeFinder), cursor.distance.from, cursor.distance.to, _penPoint);
         }
 
 
@@ -730,68 +596,13 @@ public:
     Plot2DQuadrature() {}
 
 
-    bool draw(Canvas& canvas, Dataset* dataset, DatasetCursor cursor)
+    bool draw(Canvas& canvas, Dataset* dataset, const DatasetCursor& cursor)
     {
+        Q_UNUSED(canvas);
         Q_UNUSED(dataset);
 
         if(!isVisible() || !cursor.distance.isValid()) { return false; }
 
-        QVector<float> real1(canvas.width());
-        QVector<float> imag1(canvas.width());
-        real1.fill(NAN);
-        imag1.fill(NAN);
-
-        QVector<float> real2(canvas.width());
-        QVector<float> imag2(canvas.width());
-        real2.fill(NAN);
-        imag2.fill(NAN);
-
-        QVector<float> real3(canvas.width());
-        QVector<float> imag3(canvas.width());
-        real3.fill(NAN);
-        imag3.fill(NAN);
-
-        QVector<float> real4(canvas.width());
-        QVector<float> imag4(canvas.width());
-        real4.fill(NAN);
-        imag4.fill(NAN);
-
-
-        // for(int i = 0; i < canvas.width(); i++) {
-        //     int pool_index = cursor.getIndex(i);
-        //     Epoch* data = dataset->fromIndex(pool_index);
-        //     if(data != NULL) {
-        //         QByteArray raw = data->complexSignalData();
-        //         if(raw.size() > 0) {
-        //             const int16_t* data = (int16_t*)raw.data();
-        //             real1[i] = data[0+50];
-        //             imag1[i] = data[1+50];
-
-        //             real2[i] = data[2+50];
-        //             imag2[i] = data[3+50];
-
-        //             real3[i] = data[4+50];
-        //             imag3[i] = data[5+50];
-
-        //             real4[i] = data[6+50];
-        //             imag4[i] = data[7+50];
-        //         }
-        //     }
-        // }
-
-        // drawY(canvas, real1, -3200+1500, 3200+1500, _penReal);
-        // drawY(canvas, imag1, -3200+1500, 3200+1500, _penImag);
-
-        // drawY(canvas, real2, -3200+768, 3200+768, _penReal);
-        // drawY(canvas, imag2, -3200+768, 3200+768, _penImag);
-
-        // drawY(canvas, real3, -3200-768, 3200-768, _penReal);
-        // drawY(canvas, imag3, -3200-768, 3200-768, _penImag);
-
-        // drawY(canvas, real4, -3200-1500, 3200-1500, _penReal);
-        // drawY(canvas, imag4, -3200-1500, 3200-1500, _penImag);
-
-
         return true;
     }
 
@@ -804,7 +615,7 @@ protected:
 class Plot2DGrid : public PlotLayer {
 public:
     Plot2DGrid();
-    bool draw(Canvas& canvas, Dataset* dataset, DatasetCursor cursor);
+    bool draw(Canvas& canvas, Dataset* dataset, const DatasetCursor& cursor);
 
     void setAngleVisibility(bool state);
     void setVetricalNumber(int grids) { _lines = grids; }
@@ -823,7 +634,7 @@ protected:
 class Plot2DAim : public PlotLayer {
 public:
     Plot2DAim() {}
-    bool draw(Canvas& canvas, Dataset* dataset, DatasetCursor cursor);
+    bool draw(Canvas& canvas, Dataset* dataset, const DatasetCursor& cursor);
 
     void setEpochEventState(bool state) {
         beenEpochEvent_ = state;
@@ -872,6 +683,10 @@ public:
     void setEchogramVisible(bool visible);
     void setEchogramTheme(int theme_id);
     void setEchogramCompensation(int compensation_id);
+    void setEchogramAggregation(int stat);
+
+    void setHorizontalZoom(int level);
+    int horizontalZoom() { return _cursor.zoomLevel; }
 
     void setBottomTrackVisible(bool visible);
     void setBottomTrackTheme(int theme_id);
@@ -937,10 +752,15 @@ protected:
     Plot2DGrid _grid;
     Plot2DAim _aim;
 
+    PlotColumns _columns;
+
     Canvas image(int width, int height);
 
     void reindexingCursor();
     void reRangeDistance();
+    void gatherColumns();
+
+    RangeWindowMax _rangeWindow;
 
     std::function<void()> pendingBtpLambda_ = nullptr;
 };
@@ -1,5 +1,7 @@
 #include "Plot2D.h"
 
+#include <algorithm>
+
 
 Plot2DEchogram::Plot2DEchogram() {
     setThemeId(ClassicTheme);
@@ -83,6 +85,13 @@ void Plot2DEchogram::setCompensation(int compensation_id) {
     _compensation_id = compensation_id;
 }
 
+void Plot2DEchogram::setAggregation(EchogramPyramid::Stat stat) {
+    if(_aggregation != stat) {
+        _aggregation = stat;
+        resetCash();
+    }
+}
+
 void Plot2DEchogram::updateColors() {
     float low = _levels.low;
     float high = _levels.high;
@@ -111,7 +120,7 @@ void Plot2DEchogram::resetCash() {
     _cashFlags.resetCash = true;
 }
 
-int Plot2DEchogram::updateCash(Dataset* dataset, DatasetCursor cursor, int width, int height) {
+int Plot2DEchogram::updateCash(Dataset* dataset, const DatasetCursor& cursor, int width, int height) {
     if(_cash.size() != width) {
         _cash.resize(width);
         resetCash();
@@ -124,6 +133,7 @@ int Plot2DEchogram::updateCash(Dataset* dataset, DatasetCursor cursor, int width
     bool is_cash_notvalid = getTriggerCashReset();
     is_cash_notvalid |= !_lastCursor.isChannelsEqual(cursor);
     is_cash_notvalid |= !_lastCursor.isDistanceEqual(cursor);
+    is_cash_notvalid |= !_lastCursor.isZoomEqual(cursor);
     is_cash_notvalid |=  _lastWidth != width;
     is_cash_notvalid |=  _lastHeight != height;
 
@@ -155,36 +165,40 @@ int Plot2DEchogram::updateCash(Dataset* dataset, DatasetCursor cursor, int width
 
     int cash_validate = 0;
 
-    int wrap_start_pos = qAbs(cursor.getIndex(0) % width);
+    const int zoom_level = cursor.zoomLevel;
+    int wrap_start_pos = qAbs((cursor.getIndex(0) >> zoom_level) % width);
 
     for(unsigned int i = 0; i < cursor.indexes.size(); i++) {
         if(cursor.indexes[i] > 0) {
-            wrap_start_pos = qAbs((cursor.indexes[i] + (width - i)) % width);
+            wrap_start_pos = qAbs(((cursor.indexes[i] >> zoom_level) + (width - i)) % width);
             break;
         }
     }
 
+    // rows of the pyramid that got epochs since the last update have to be drawn again
+    const int dataset_size = dataset->size();
+    const int open_rows_from = qMin(_lastDatasetSize, dataset_size) - 1;
 
-//    _cashPosition = wrap_start_pos;
-    for(int column = 0; column < width; column++) {
-        if(_cash[column].data.size() != height) {
-//            _cash[column].stateColor = CashLine::CashStateNotValid;
-            _cash[column].state = CashLine::CashStateNotValid;
-            _cash[column].data.resize(height);
-//            _cash[column].data.fill(0);
+    if(dataset_size < _lastDatasetSize) { // a new dataset reuses the memory the stamps point to
+        _rangeMipmaps.clear();
+    }
+
+
+    if(_columnsHeight != height || _columns.size() != width*height) {
+        _columnsHeight = height;
+        _columns.resize(width*height);
+        _columns.fill(0);
+
+        for(int column = 0; column < width; column++) {
             _cash[column].poolIndex = -1;
             _cash[column].state = CashLine::CashStateEraced;
             _cash[column].isNeedUpdate = true;
-
-            int16_t cash_data_size = _cash[column].data.size();
-            int16_t* cash_data = _cash[column].data.data();
-            uint8_t * img_data = image_data + column;
-            for (int image_row = 0; image_row < cash_data_size; image_row++) {
-                *img_data = *cash_data;
-                img_data += b_scanline;
-                cash_data++;
-            }
         }
+    }
+
+//    _cashPosition = wrap_start_pos;
+    for(int column = 0; column < width; column++) {
+        int16_t* cash_data = _columns.data() + column*height;
 
         int cursor_pos = column - wrap_start_pos;
         if(column < wrap_start_pos) {
@@ -195,22 +209,22 @@ int Plot2DEchogram::updateCash(Dataset* dataset, DatasetCursor cursor, int width
         int pool_index_safe = dataset->validIndex(pool_index);
         if(pool_index_safe >= 0) {
             const int cash_index = _cash[column].poolIndex;
-            if(is_cash_notvalid || pool_index_safe != cash_index) {
+            const bool is_row_open = zoom_level > 0 && pool_index_safe + (1 << zoom_level) > open_rows_from;
+            if(is_cash_notvalid || pool_index_safe != cash_index || is_row_open) {
                 _cash[column].poolIndex = pool_index_safe;
 
                 Epoch* datasource = dataset->fromIndex(pool_index_safe);
                 if(datasource != NULL) {
                     _cash[column].state = CashLine::CashStateNotValid;
-                    int16_t* cash_data = _cash[column].data.data();
-                    int16_t cash_data_size = _cash[column].data.size();
+                    const int cash_data_size = height;
 
                     if(cursor.channel2 == CHANNEL_NONE) {
-                        datasource->chartTo(cursor.channel1, from, to, cash_data, cash_data_size, _compensation_id);
+                        columnTo(dataset, datasource, pool_index_safe, zoom_level, cursor.channel1, from, to, cash_data, cash_data_size);
                     } else {
                         int cash_data_size_part1 = cash_data_size*(range1/fullrange);
 
                         if(cash_data_size_part1 > 0) {
-                            datasource->chartTo(cursor.channel1, from1, to1, cash_data, cash_data_size_part1, _compensation_id, true);
+                            columnTo(dataset, datasource, pool_index_safe, zoom_level, cursor.channel1, from1, to1, cash_data, cash_data_size_part1, true);
                         }
 
                         if(cash_data_size_part1 < 0) {
@@ -219,7 +233,7 @@ int Plot2DEchogram::updateCash(Dataset* dataset, DatasetCursor cursor, int width
 
                         const int cash_data_size_part2 = cash_data_size - cash_data_size_part1;
                         if(cash_data_size_part2 > 0) {
-                            datasource->chartTo(cursor.channel2, from2, to2, &cash_data[cash_data_size_part1], cash_data_size_part2, _compensation_id, false);
+                            columnTo(dataset, datasource, pool_index_safe, zoom_level, cursor.channel2, from2, to2, &cash_data[cash_data_size_part1], cash_data_size_part2, false);
                         }
                     }
 
@@ -227,52 +241,24 @@ int Plot2DEchogram::updateCash(Dataset* dataset, DatasetCursor cursor, int width
 
                     _cash[column].state = CashLine::CashStateValid;
                     _cash[column].isNeedUpdate = true;
-                    uint8_t * img_data = image_data + column;
-                    for (int image_row = 0; image_row < cash_data_size; image_row++) {
-                        *img_data = *cash_data;
-                        img_data += b_scanline;
-                        cash_data++;
-                    }
-//                    _cash[column].stateColor = CashLine::CashStateNotValid;
                 } else {
-                    if(_cash[column].state != CashLine::CashStateEraced) {
-//                        _cash[column].stateColor = CashLine::CashStateNotValid;
-                        _cash[column].state = CashLine::CashStateNotValid;
-                        _cash[column].data.fill(0);
-                        _cash[column].poolIndex = -1;
-                        _cash[column].state = CashLine::CashStateEraced;
-                        _cash[column].isNeedUpdate = true;
-
-                        int16_t cash_data_size = _cash[column].data.size();
-                        int16_t* cash_data = _cash[column].data.data();
-                        uint8_t * img_data = image_data + column;
-                        for (int image_row = 0; image_row < cash_data_size; image_row++) {
-                            *img_data = *cash_data;
-                            img_data += b_scanline;
-                            cash_data++;
-                        }
-                    }
+                    eraseColumn(column);
                 }
             }
         } else {
-            if(_cash[column].state != CashLine::CashStateEraced) {
-//                _cash[column].stateColor = CashLine::CashStateNotValid;
-                _cash[column].state = CashLine::CashStateNotValid;
-                _cash[column].data.fill(0);
-                _cash[column].poolIndex = -1;
-                _cash[column].state = CashLine::CashStateEraced;
-                _cash[column].isNeedUpdate = true;
-
-                int16_t* cash_data = _cash[column].data.data();
-                int16_t cash_data_size = _cash[column].data.size();
-                uint8_t * img_data = image_data + column;
-                for (int image_row = 0; image_row < cash_data_size; image_row++) {
-                    *img_data = *cash_data;
-                    img_data += b_scanline;
-                    cash_data++;
-                }
-            }
+            eraseColumn(column);
+        }
+    }
 
+    // the changed columns go into the image together, row segments at a time
+    int update_from = -1;
+    for(int column = 0; column <= width; column++) {
+        const bool is_need_update = column < width && _cash[column].isNeedUpdate;
+        if(is_need_update && update_from < 0) {
+            update_from = column;
+        } else if(!is_need_update && update_from >= 0) {
+            _transpose.write(_columns.constData(), height, update_from, column, image_data, b_scanline);
+            update_from = -1;
         }
     }
 
@@ -281,11 +267,109 @@ int Plot2DEchogram::updateCash(Dataset* dataset, DatasetCursor cursor, int width
     _lastCursor = cursor;
     _lastWidth = width;
     _lastHeight = height;
+    _lastDatasetSize = dataset_size;
 
     return wrap_start_pos;
 }
 
-bool Plot2DEchogram::draw(Canvas& canvas, Dataset* dataset, DatasetCursor cursor) {
+void Plot2DEchogram::eraseColumn(int column) {
+    if(_cash[column].state != CashLine::CashStateEraced) {
+        std::fill_n(_columns.data() + column*_columnsHeight, _columnsHeight, 0);
+        _cash[column].poolIndex = -1;
+        _cash[column].state = CashLine::CashStateEraced;
+        _cash[column].isNeedUpdate = true;
+    }
+}
+
+bool Plot2DEchogram::columnTo(Dataset* dataset, Epoch* epoch, int epochIndx, int zoomLevel, int channel, float start, float end, int16_t* dst, int len, bool reverse) {
+    const bool is_compensated = _compensation_id == 1;
+    const uint8_t* src = NULL;
+    int raw_size = 0;
+    float resolution = 0;
+    float offset = 0;
+    quint64 stamp = 0;
+
+    if(zoomLevel == 0) {
+        if(channel == CHANNEL_FIRST) {
+            const QList<int16_t> channels = epoch->chartChannels();
+            channel = channels.isEmpty() ? CHANNEL_NONE : channels.first();
+        }
+
+        Epoch::Echogram* chart = epoch->chart(channel);
+        if(chart == NULL || chart->resolution == 0 || chart->amplitude.size() == 0) {
+            memset(dst, 0, len*2);
+            return false;
+        }
+
+        src = chart->amplitude.constData();
+        raw_size = chart->amplitude.size();
+        resolution = chart->resolution;
+        offset = chart->offset;
+        stamp = reinterpret_cast<quintptr>(src); // a chart set again gets new samples in the slab
+
+        if(is_compensated) {
+            if(!chart->compensatedView.isEmpty()) {
+                src = chart->compensatedView.constData();
+            } else {
+                if(chart->compensated.size() == 0) {
+                    chart->updateCompesated();
+                }
+                src = chart->compensated.constData();
+            }
+        }
+    } else {
+        EchogramPyramid* pyramid = dataset->echogramPyramid();
+
+        if(channel == CHANNEL_FIRST) {
+            const QList<int16_t> channels = epoch->chartChannels();
+            channel = channels.isEmpty() ? pyramid->firstChannel() : channels.first();
+        }
+
+        pyramid->setStat(_aggregation); // the pyramid keeps one statistic, a new one drops its rows
+        const EchogramPyramid::Row* row = pyramid->row(channel, zoomLevel, epochIndx);
+        if(row == nullptr || row->resolution == 0) {
+            memset(dst, 0, len*2);
+            return false;
+        }
+
+        src = row->data.constData();
+        raw_size = row->data.size();
+        resolution = row->resolution;
+        offset = row->offset;
+        stamp = row->stamp;
+    }
+
+    // a range mipmap level keeps it under two samples per cell
+    int level = 0;
+    for(float scale = (end - start)/(len*resolution); scale >= 2.0f && (raw_size >> (level + 1)) > 0; scale *= 0.5f) {
+        level++;
+    }
+
+    const quint64 key = (quint64(epochIndx >> zoomLevel) << 32) | (quint64(quint16(channel)) << 16) | quint64(zoomLevel << 1) | quint64(is_compensated);
+    const QVector<uint8_t>* mip = level > 0 ? _rangeMipmaps.find(key, stamp, level) : nullptr;
+
+    if(mip == nullptr && zoomLevel > 0 && is_compensated) {
+        _compensatedRow.resize(raw_size);
+        Epoch::Echogram::compensate(src, _compensatedRow.data(), raw_size, resolution);
+        src = _compensatedRow.constData();
+    }
+
+    if(mip == nullptr && level > 0) {
+        mip = &_rangeMipmaps.build(key, stamp, level, src, raw_size);
+    }
+
+    if(mip != nullptr) {
+        src = mip->constData();
+        raw_size = mip->size();
+        resolution *= (1 << level);
+    }
+
+    Epoch::Echogram::sampleTo(src, raw_size, resolution, offset, start, end, dst, len, reverse);
+
+    return true;
+}
+
+bool Plot2DEchogram::draw(Canvas& canvas, Dataset* dataset, const DatasetCursor& cursor) {
     if(isVisible() && dataset != nullptr && cursor.distance.isValid()) {
         const int image_width = canvas.width();
         const int image_height = canvas.height();
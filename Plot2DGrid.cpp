@@ -6,7 +6,7 @@ Plot2DGrid::Plot2DGrid() : angleVisibility_(false)
 {}
 
 
-bool Plot2DGrid::draw(Canvas& canvas, Dataset* dataset, DatasetCursor cursor)
+bool Plot2DGrid::draw(Canvas& canvas, Dataset* dataset, const DatasetCursor& cursor)
 {
     if (!isVisible())
         return false;
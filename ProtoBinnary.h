@@ -320,6 +320,17 @@ public:
         return _contextLen;
     }
 
+    // bytes left in the context set by setContext(), also while a proxy payload is being parsed
+    int32_t outerContextLen() {
+        return _savedContextData != NULL ? _savedContextLen : _contextLen;
+    }
+
+    // no frame is being assembled and no proxy payload is pending, so the following bytes parse
+    // the same way as with a freshly created parser
+    bool isSynchronized() {
+        return _protoState == StateSync && _proxyState == ProxyNone && _savedContextData == NULL;
+    }
+
     int16_t readAvailable() { return _readMaxPosition - _readPosition; }
 
     ProtoID proto() { return _proto; }
@@ -531,6 +531,15 @@ GridLayout {
             groupName: qsTr("Bottom-Track processing")
 
             property bool autoApplyChange: false
+            property int progress: -1
+
+            Connections {
+                target: dataset
+
+                function onBottomTrackProgressChanged(progress) {
+                    bottomTrackProcessingGroup.progress = progress
+                }
+            }
 
             Component.onCompleted: {
                 targetPlot.refreshDistParams(bottomTrackList.currentIndex,
@@ -961,8 +970,23 @@ GridLayout {
                 CButton {
                     text: qsTr("Processing")
                     Layout.fillWidth: true
+                    enabled: bottomTrackProcessingGroup.progress < 0
                     onClicked: bottomTrackProcessingGroup.updateProcessing()
                 }
+
+                CButton {
+                    text: qsTr("Cancel")
+                    visible: bottomTrackProcessingGroup.progress >= 0
+                    onClicked: dataset.cancelBottomTrackProcessing()
+                }
+            }
+
+            CProgress {
+                Layout.fillWidth: true
+                visible: bottomTrackProcessingGroup.progress >= 0
+                from: 0
+                to: 100
+                value: bottomTrackProcessingGroup.progress
             }
         }
 
@@ -1037,7 +1061,8 @@ GridLayout {
                     CButton {
                         text: qsTr("Export to CSV")
                         Layout.fillWidth: true
-                        onClicked: core.exportPlotAsCVS(exportPathText.text, targetPlot.plotDatasetChannel(), exportDecimation.checked ? exportDecimationValue.value : 0);
+                        enabled: core.exportProgress < 0
+                        onClicked: core.exportPlotAsCVS(exportPathText.text, targetPlot.plotDatasetChannel(), exportDecimation.checked ? exportDecimationValue.value : 0, true);
                     }
                 }
 
@@ -1045,7 +1070,8 @@ GridLayout {
                     CButton {
                         text: qsTr("Export to XTF")
                         Layout.fillWidth: true
-                        onClicked: core.exportPlotAsXTF(exportPathText.text);
+                        enabled: core.exportProgress < 0
+                        onClicked: core.exportPlotAsXTF(exportPathText.text, true);
                     }
                 }
 
@@ -1053,7 +1079,8 @@ GridLayout {
                     CButton {
                         text: qsTr("Complex signal to CSV")
                         Layout.fillWidth: true
-                        onClicked: core.exportComplexToCSV(exportPathText.text);
+                        enabled: core.exportProgress < 0
+                        onClicked: core.exportComplexToCSV(exportPathText.text, true);
                     }
                 }
 
@@ -1061,7 +1088,18 @@ GridLayout {
                     CButton {
                         text: qsTr("USBL to CSV")
                         Layout.fillWidth: true
-                        onClicked: core.exportUSBLToCSV(exportPathText.text);
+                        enabled: core.exportProgress < 0
+                        onClicked: core.exportUSBLToCSV(exportPathText.text, true);
+                    }
+                }
+
+                RowLayout {
+                    visible: core.exportProgress >= 0
+
+                    CButton {
+                        text: qsTr("Cancel export") + " (" + core.exportProgress + "%)"
+                        Layout.fillWidth: true
+                        onClicked: core.cancelExport();
                     }
                 }
 
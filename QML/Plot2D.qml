@@ -177,6 +177,9 @@ WaterFall {
                 else if (wheel.modifiers & Qt.ShiftModifier) {
                     plot.verScrollEvent(-wheel.angleDelta.y)
                 }
+                else if (wheel.modifiers & Qt.AltModifier) {
+                    plot.horZoomEvent(-(wheel.angleDelta.y !== 0 ? wheel.angleDelta.y : wheel.angleDelta.x))
+                }
                 else {
                     plot.horScrollEvent(wheel.angleDelta.y)
                 }
@@ -133,6 +133,12 @@ ColumnLayout {
                     checked: true
                     ButtonGroup.group: surfaceTypeGroup
 
+                    onCheckedChanged: {
+                        if (!checked) {
+                            liveUpdateCheckButton.checked = false
+                        }
+                    }
+
                     onFocusChanged: {
                         surfaceSettings.focus = true
                     }
@@ -153,6 +159,21 @@ ColumnLayout {
                 }
             }
 
+            CheckButton {
+                id: liveUpdateCheckButton
+                visible: triangleTypeCheck.checked
+                text: qsTr("Live update")
+                Layout.fillWidth: true
+
+                onCheckedChanged: {
+                    SurfaceControlMenuController.onLiveUpdateCheckButtonCheckedChanged(checked, triangleEdgeLengthLimitSpinBox.value)
+                }
+
+                onFocusChanged: {
+                    surfaceSettings.focus = true
+                }
+            }
+
             ParamSetup {
                 visible: gridTypeCheck.checked
                 paramName: qsTr("Grid step, m:")
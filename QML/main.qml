@@ -638,22 +638,31 @@ Window  {
         opacity: 0.8
         radius: 10
         anchors.centerIn: parent
-        visible: core.isFileOpening && !core.isSeparateReading
-        implicitWidth: textItem.implicitWidth + 40
-        implicitHeight: textItem.implicitHeight + 40
+        visible: (core.isFileOpening && !core.isSeparateReading) || core.xtfImportProgress >= 0
+        implicitWidth: fileOpeningColumn.implicitWidth + 40
+        implicitHeight: fileOpeningColumn.implicitHeight + 40
 
         Column {
+            id: fileOpeningColumn
             anchors.centerIn: parent
             spacing: 10
 
             Text {
                 id: textItem
-                text: qsTr("Please wait, the file is opening")
+                text: core.xtfImportProgress >= 0 ? qsTr("Please wait, the file is opening") + " (" + core.xtfImportProgress + "%)"
+                                                  : qsTr("Please wait, the file is opening")
                 color: "white"
                 font.pixelSize: 20
                 horizontalAlignment: Text.AlignHCenter
                 wrapMode: Text.Wrap
             }
+
+            CButton {
+                text: qsTr("Cancel")
+                visible: core.xtfImportProgress >= 0
+                anchors.horizontalCenter: parent.horizontalCenter
+                onClicked: core.cancelXtfImport()
+            }
         }
     }
 }
@@ -0,0 +1,466 @@
+#include "bottom_track_kernel.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BOTTOM_TRACK_X86
+#include <immintrin.h>
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__aarch64__)
+#define BOTTOM_TRACK_NEON
+#include <arm_neon.h>
+#endif
+
+
+namespace {
+
+int argmaxScalar(const int32_t* data, int from, int to, int32_t floor)
+{
+    int32_t maxVal = floor;
+    int maxInd = -1;
+    for (int i = from; i < to; ++i) {
+        if (maxVal < data[i]) {
+            maxVal = data[i];
+            maxInd = i;
+        }
+    }
+    return maxInd;
+}
+
+int firstEqualScalar(const int32_t* data, int from, int to, int32_t val)
+{
+    for (int i = from; i < to; ++i) {
+        if (data[i] == val) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#ifdef BOTTOM_TRACK_X86
+TARGET_SSE2 void addSse2(int32_t* dst, const int32_t* src, int from, int to)
+{
+    int i = from;
+    for (; i + 4 <= to; i += 4) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_add_epi32(d, s));
+    }
+    for (; i < to; ++i) {
+        dst[i] += src[i];
+    }
+}
+
+TARGET_SSE2 void subtractSse2(int32_t* dst, const int32_t* src, int from, int to)
+{
+    int i = from;
+    for (; i + 4 <= to; i += 4) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_sub_epi32(d, s));
+    }
+    for (; i < to; ++i) {
+        dst[i] -= src[i];
+    }
+}
+
+TARGET_SSE2 int argmaxSse2(const int32_t* data, int from, int to, int32_t floor)
+{
+    int32_t maxVal = floor;
+    int i = from;
+    if (to - from >= 4) {
+        __m128i vmax = _mm_set1_epi32(floor);
+        for (; i + 4 <= to; i += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i gt = _mm_cmpgt_epi32(v, vmax);
+            vmax = _mm_or_si128(_mm_and_si128(gt, v), _mm_andnot_si128(gt, vmax));
+        }
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), vmax);
+        maxVal = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    }
+    for (; i < to; ++i) {
+        maxVal = std::max(maxVal, data[i]);
+    }
+    if (maxVal == floor) {
+        return -1;
+    }
+
+    const __m128i vval = _mm_set1_epi32(maxVal);
+    for (i = from; i + 4 <= to; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, vval)));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return firstEqualScalar(data, i, to, maxVal);
+}
+
+TARGET_AVX2 void addAvx2(int32_t* dst, const int32_t* src, int from, int to)
+{
+    int i = from;
+    for (; i + 8 <= to; i += 8) {
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_add_epi32(d, s));
+    }
+    for (; i < to; ++i) {
+        dst[i] += src[i];
+    }
+}
+
+TARGET_AVX2 void subtractAvx2(int32_t* dst, const int32_t* src, int from, int to)
+{
+    int i = from;
+    for (; i + 8 <= to; i += 8) {
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_sub_epi32(d, s));
+    }
+    for (; i < to; ++i) {
+        dst[i] -= src[i];
+    }
+}
+
+TARGET_AVX2 int argmaxAvx2(const int32_t* data, int from, int to, int32_t floor)
+{
+    int32_t maxVal = floor;
+    int i = from;
+    if (to - from >= 8) {
+        __m256i vmax = _mm256_set1_epi32(floor);
+        for (; i + 8 <= to; i += 8) {
+            vmax = _mm256_max_epi32(vmax, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+        }
+        __m128i half = _mm_max_epi32(_mm256_castsi256_si128(vmax), _mm256_extracti128_si256(vmax, 1));
+        half = _mm_max_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+        half = _mm_max_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+        maxVal = _mm_cvtsi128_si32(half);
+    }
+    for (; i < to; ++i) {
+        maxVal = std::max(maxVal, data[i]);
+    }
+    if (maxVal == floor) {
+        return -1;
+    }
+
+    const __m256i vval = _mm256_set1_epi32(maxVal);
+    for (i = from; i + 8 <= to; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, vval)));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return firstEqualScalar(data, i, to, maxVal);
+}
+
+// 10 * sum / len through doubles, exact here: the quotient is at most 2550 and len is far below 2^26
+TARGET_AVX2 int smoothAvx2(const int32_t* prefix, const int32_t* winLen, int from, int to, int32_t* column)
+{
+    const __m128i ten = _mm_set1_epi32(10);
+    int i = from;
+    for (; i + 4 <= to; i += 4) {
+        __m128i len = _mm_loadu_si128(reinterpret_cast<const __m128i*>(winLen + i));
+        __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prefix + i + 1));
+        __m128i tailIdx = _mm_add_epi32(_mm_setr_epi32(i + 1, i + 2, i + 3, i + 4), len);
+        __m128i tail = _mm_i32gather_epi32(reinterpret_cast<const int*>(prefix), tailIdx, 4);
+        __m128i num = _mm_mullo_epi32(_mm_sub_epi32(tail, head), ten);
+        __m256d quot = _mm256_div_pd(_mm256_cvtepi32_pd(num), _mm256_cvtepi32_pd(len));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(column + i), _mm256_cvttpd_epi32(quot));
+    }
+    return i;
+}
+
+TARGET_AVX2 int correlateAvx2(const BottomTrackKernel::Params& p, const int32_t* tap2, const int32_t* tap3,
+                              const int32_t* tap4, const int32_t* tap5, int from, int to, int32_t* column)
+{
+    const int* base = reinterpret_cast<const int*>(column);
+    const __m256i c1 = _mm256_set1_epi32(p.c1);
+    const __m256i c2 = _mm256_set1_epi32(p.c2);
+    const __m256i c3 = _mm256_set1_epi32(p.c3);
+    const __m256i c4 = _mm256_set1_epi32(p.c4);
+    const __m256i c5 = _mm256_set1_epi32(p.c5);
+    const __m256i gain = _mm256_set1_epi32(p.gainSlopeInv);
+    const __m256i step = _mm256_set1_epi32(8);
+    __m256i indx = _mm256_setr_epi32(from, from + 1, from + 2, from + 3, from + 4, from + 5, from + 6, from + 7);
+
+    // taps lie ahead of the current sample, so every lane reads values not yet overwritten
+    int i = from;
+    for (; i + 8 <= to; i += 8) {
+        __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + i));
+        __m256i v2 = _mm256_i32gather_epi32(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tap2 + i)), 4);
+        __m256i v3 = _mm256_i32gather_epi32(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tap3 + i)), 4);
+        __m256i v4 = _mm256_i32gather_epi32(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tap4 + i)), 4);
+        __m256i v5 = _mm256_i32gather_epi32(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tap5 + i)), 4);
+
+        __m256i calc = _mm256_mullo_epi32(c1, v1);
+        calc = _mm256_add_epi32(calc, _mm256_mullo_epi32(c2, v2));
+        calc = _mm256_add_epi32(calc, _mm256_mullo_epi32(c3, v3));
+        calc = _mm256_add_epi32(calc, _mm256_mullo_epi32(c4, v4));
+        calc = _mm256_add_epi32(calc, _mm256_mullo_epi32(c5, v5));
+        calc = _mm256_add_epi32(_mm256_mullo_epi32(calc, gain), _mm256_mullo_epi32(calc, indx));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(column + i), calc);
+        indx = _mm256_add_epi32(indx, step);
+    }
+    return i;
+}
+#endif
+
+#ifdef BOTTOM_TRACK_NEON
+void addNeon(int32_t* dst, const int32_t* src, int from, int to)
+{
+    int i = from;
+    for (; i + 4 <= to; i += 4) {
+        vst1q_s32(dst + i, vaddq_s32(vld1q_s32(dst + i), vld1q_s32(src + i)));
+    }
+    for (; i < to; ++i) {
+        dst[i] += src[i];
+    }
+}
+
+void subtractNeon(int32_t* dst, const int32_t* src, int from, int to)
+{
+    int i = from;
+    for (; i + 4 <= to; i += 4) {
+        vst1q_s32(dst + i, vsubq_s32(vld1q_s32(dst + i), vld1q_s32(src + i)));
+    }
+    for (; i < to; ++i) {
+        dst[i] -= src[i];
+    }
+}
+
+int argmaxNeon(const int32_t* data, int from, int to, int32_t floor)
+{
+    int32_t maxVal = floor;
+    int i = from;
+    if (to - from >= 4) {
+        int32x4_t vmax = vdupq_n_s32(floor);
+        for (; i + 4 <= to; i += 4) {
+            vmax = vmaxq_s32(vmax, vld1q_s32(data + i));
+        }
+        maxVal = vmaxvq_s32(vmax);
+    }
+    for (; i < to; ++i) {
+        maxVal = std::max(maxVal, data[i]);
+    }
+    if (maxVal == floor) {
+        return -1;
+    }
+
+    return firstEqualScalar(data, from, to, maxVal);
+}
+#endif
+
+} // namespace
+
+
+BottomTrackKernel::BottomTrackKernel(const Params& params) :
+    params_(params),
+    isa_(bestIsa())
+{
+
+}
+
+BottomTrackKernel::Isa BottomTrackKernel::bestIsa()
+{
+#if defined(BOTTOM_TRACK_X86)
+    if (__builtin_cpu_supports("avx2")) {
+        return Isa::Avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return Isa::Sse2;
+    }
+#elif defined(BOTTOM_TRACK_NEON)
+    return Isa::Neon;
+#endif
+    return Isa::Scalar;
+}
+
+void BottomTrackKernel::setIsa(Isa isa)
+{
+    bool isSupported = isa == Isa::Scalar;
+
+#if defined(BOTTOM_TRACK_X86)
+    isSupported |= isa == Isa::Sse2 && __builtin_cpu_supports("sse2");
+    isSupported |= isa == Isa::Avx2 && __builtin_cpu_supports("avx2");
+#elif defined(BOTTOM_TRACK_NEON)
+    isSupported |= isa == Isa::Neon;
+#endif
+
+    isa_ = isSupported ? isa : bestIsa();
+}
+
+BottomTrackKernel::Isa BottomTrackKernel::isa() const
+{
+    return isa_;
+}
+
+void BottomTrackKernel::filterColumn(const uint8_t* data, int size, int32_t* column)
+{
+    const int istart = params_.istart;
+    if (size <= istart + params_.initWin) {
+        std::fill(column + std::min(istart, size), column + size, 0);
+        return;
+    }
+
+    ensureTables(size);
+
+    // the sliding loop this replaces stops once the previous window reaches the column end
+    int avrgRange = params_.initWin;
+    int smoothTo = istart;
+    while (smoothTo + avrgRange < size) {
+        avrgRange = winLen_[smoothTo];
+        ++smoothTo;
+    }
+
+    // samples the window never reaches are cleared, a reused column must not keep values of an earlier one
+    std::fill(column + smoothTo, column + size, 0);
+
+    if (smoothTo > istart) {
+        // the last window may end one sample past the column, that sample counts as zero
+        prefix_.resize(size + 2);
+        prefix_[0] = 0;
+        for (int i = 0; i < size; ++i) {
+            prefix_[i + 1] = prefix_[i] + data[i];
+        }
+        prefix_[size + 1] = prefix_[size];
+
+        smooth(istart, smoothTo, column);
+    }
+
+    // correlation runs while the farthest tap stays inside the smoothed part
+    const int convSize = size - avrgRange;
+    const int correlateTo = static_cast<int>(std::lower_bound(tap5_.cbegin() + istart, tap5_.cbegin() + size, convSize) - tap5_.cbegin());
+
+    correlate(istart, correlateTo, column);
+}
+
+void BottomTrackKernel::add(int32_t* dst, const int32_t* src, int from, int to) const
+{
+    switch (isa_) {
+#if defined(BOTTOM_TRACK_X86)
+    case Isa::Avx2: addAvx2(dst, src, from, to); return;
+    case Isa::Sse2: addSse2(dst, src, from, to); return;
+#elif defined(BOTTOM_TRACK_NEON)
+    case Isa::Neon: addNeon(dst, src, from, to); return;
+#endif
+    default: break;
+    }
+
+    for (int i = from; i < to; ++i) {
+        dst[i] += src[i];
+    }
+}
+
+void BottomTrackKernel::subtract(int32_t* dst, const int32_t* src, int from, int to) const
+{
+    switch (isa_) {
+#if defined(BOTTOM_TRACK_X86)
+    case Isa::Avx2: subtractAvx2(dst, src, from, to); return;
+    case Isa::Sse2: subtractSse2(dst, src, from, to); return;
+#elif defined(BOTTOM_TRACK_NEON)
+    case Isa::Neon: subtractNeon(dst, src, from, to); return;
+#endif
+    default: break;
+    }
+
+    for (int i = from; i < to; ++i) {
+        dst[i] -= src[i];
+    }
+}
+
+int BottomTrackKernel::argmax(const int32_t* data, int from, int to, int32_t floor) const
+{
+    if (from >= to) {
+        return -1;
+    }
+
+    switch (isa_) {
+#if defined(BOTTOM_TRACK_X86)
+    case Isa::Avx2: return argmaxAvx2(data, from, to, floor);
+    case Isa::Sse2: return argmaxSse2(data, from, to, floor);
+#elif defined(BOTTOM_TRACK_NEON)
+    case Isa::Neon: return argmaxNeon(data, from, to, floor);
+#endif
+    default: break;
+    }
+
+    return argmaxScalar(data, from, to, floor);
+}
+
+void BottomTrackKernel::ensureTables(int size)
+{
+    if (static_cast<int>(winLen_.size()) >= size) {
+        return;
+    }
+
+    const int count = std::max(size, 2 * static_cast<int>(winLen_.size()));
+    winLen_.assign(count, 0);
+    tap2_.assign(count, 0);
+    tap3_.assign(count, 0);
+    tap4_.assign(count, 0);
+    tap5_.assign(count, 0);
+
+    // replays the window bounds and tap positions of the original loops, they never look at the samples
+    const int istart = params_.istart;
+    const int initWin = params_.initWin;
+    const int scaleWin = params_.scaleWin;
+    int from = istart;
+    int to = istart + initWin;
+
+    for (int i = istart; i < count; ++i) {
+        ++from;
+        ++to;
+        int len = 0;
+        while ((i + initWin * scaleWin) >= ((len = to - from) * scaleWin)) {
+            ++to;
+        }
+        winLen_[i] = len;
+
+        const float fi = i + initWin + 1;
+        tap2_[i] = fi * params_.s2;
+        tap3_[i] = fi * params_.s3;
+        tap4_[i] = fi * params_.s4;
+        tap5_[i] = fi * params_.s5;
+    }
+}
+
+void BottomTrackKernel::smooth(int from, int to, int32_t* column) const
+{
+    const int32_t* prefix = prefix_.data();
+    const int32_t* winLen = winLen_.data();
+    int i = from;
+
+#if defined(BOTTOM_TRACK_X86)
+    if (isa_ == Isa::Avx2) {
+        i = smoothAvx2(prefix, winLen, from, to, column);
+    }
+#endif
+
+    for (; i < to; ++i) {
+        const int len = winLen[i];
+        column[i] = 10 * (prefix[i + 1 + len] - prefix[i + 1]) / len;
+    }
+}
+
+void BottomTrackKernel::correlate(int from, int to, int32_t* column) const
+{
+    int i = from;
+
+#if defined(BOTTOM_TRACK_X86)
+    if (isa_ == Isa::Avx2) {
+        i = correlateAvx2(params_, tap2_.data(), tap3_.data(), tap4_.data(), tap5_.data(), from, to, column);
+    }
+#endif
+
+    const Params& p = params_;
+    for (; i < to; ++i) {
+        int calc = p.c1 * column[i] + p.c2 * column[tap2_[i]] + p.c3 * column[tap3_[i]] + p.c4 * column[tap4_[i]] + p.c5 * column[tap5_[i]];
+        calc = calc * p.gainSlopeInv + calc * i;
+        column[i] = calc;
+    }
+}
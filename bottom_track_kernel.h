@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+
+/*
+ * Per-column stages of Dataset::bottomTrackProcessing: adaptive-window smoothing, multi-scale correlation,
+ * accumulation over the epoch window and the maximum search. Positions of the smoothing window and of the
+ * correlation taps depend only on the sample index, so they are tabulated once and shared by all columns.
+ * Vector paths (SSE2, AVX2, NEON) are picked at runtime and give the same integers as the scalar one.
+ */
+class BottomTrackKernel
+{
+public:
+    /*structures*/
+    enum class Isa {
+        Scalar,
+        Sse2,
+        Avx2,
+        Neon
+    };
+
+    struct Params {
+        int istart = 4;
+        int initWin = 6;
+        int scaleWin = 20;
+        int32_t c1 = -6, c2 = 6, c3 = 4, c4 = 2, c5 = 0;
+        float s2 = 1.04f, s3 = 1.06f, s4 = 1.10f, s5 = 1.15f;
+        int gainSlopeInv = 1000;
+    };
+
+    /*methods*/
+    explicit BottomTrackKernel(const Params& params);
+
+    static Isa bestIsa();
+    void setIsa(Isa isa); // an unsupported set falls back to bestIsa()
+    Isa isa() const;
+
+    // smoothing and correlation of one echogram column, column holds at least size values;
+    // the tail the smoothing window does not reach is set to zero
+    void filterColumn(const uint8_t* data, int size, int32_t* column);
+    void add(int32_t* dst, const int32_t* src, int from, int to) const;
+    void subtract(int32_t* dst, const int32_t* src, int from, int to) const;
+    // first index of the maximum in [from, to) if the maximum is above floor, otherwise -1
+    int argmax(const int32_t* data, int from, int to, int32_t floor) const;
+
+private:
+    /*methods*/
+    void ensureTables(int size);
+    void smooth(int from, int to, int32_t* column) const;
+    void correlate(int from, int to, int32_t* column) const;
+
+    /*data*/
+    Params params_;
+    Isa isa_;
+    std::vector<int32_t> winLen_; // smoothing window of sample i is [i + 1, i + 1 + winLen_[i])
+    std::vector<int32_t> tap2_;
+    std::vector<int32_t> tap3_;
+    std::vector<int32_t> tap4_;
+    std::vector<int32_t> tap5_;
+    std::vector<int32_t> prefix_; // prefix sums of the current column samples
+};
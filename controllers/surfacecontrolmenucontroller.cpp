@@ -21,18 +21,27 @@ SurfaceControlMenuController::SurfaceControlMenuController(QObject *parent)
                                               //for(const auto& v : qAsConst(result.data))
                                               //    data.append({v.x(), v.z(), v.y()});
 
-                                              QMetaObject::invokeMethod(m_graphicsSceneView->surface().get(),
-                                                                        "setData",
-                                                                        Qt::QueuedConnection,
-                                                                        Q_ARG(QVector<QVector3D>, result.data),
-                                                                        Q_ARG(int, result.primitiveType));
+                                              if (result.incremental) {
+                                                  m_graphicsSceneView->surface()->updateTiles(result.tiles, result.resetTiles);
+                                              }
+                                              else {
+                                                  QMetaObject::invokeMethod(m_graphicsSceneView->surface().get(),
+                                                                            "setData",
+                                                                            Qt::QueuedConnection,
+                                                                            Q_ARG(QVector<QVector3D>, result.data),
+                                                                            Q_ARG(int, result.primitiveType));
+                                              }
 
                                               m_graphicsSceneView->surface()->setProcessingTask(m_surfaceProcessor.ctask());
 
-                                              if (!result.data.empty()) {
+                                              if (!result.data.empty() || !result.tiles.empty()) {
                                                   m_graphicsSceneView->bottomTrack()->surfaceUpdated();
                                               }
                                               Q_EMIT surfaceProcessorTaskFinished();
+
+                                              if (m_liveUpdatePending) {
+                                                  startLiveUpdate();
+                                              }
                                           });
 }
 
@@ -124,6 +133,54 @@ void SurfaceControlMenuController::onFilterTypeComboBoxIndexChanged(int index)
         return;
 }
 
+void SurfaceControlMenuController::onLiveUpdateCheckButtonCheckedChanged(bool checked, int triangleEdgeLengthLimitSpinBox)
+{
+    if (!m_graphicsSceneView)
+        return;
+
+    QObject::disconnect(m_liveUpdateConnection);
+
+    m_liveUpdate = checked;
+    m_liveUpdatePending = false;
+    m_liveEdgeLengthLimit = triangleEdgeLengthLimitSpinBox;
+
+    if (!checked)
+        return;
+
+    m_liveUpdateConnection = QObject::connect(m_graphicsSceneView->bottomTrack().get(), &BottomTrack::epochListChanged,
+                                              this,                                     &SurfaceControlMenuController::startLiveUpdate);
+
+    startLiveUpdate();
+}
+
+void SurfaceControlMenuController::startLiveUpdate()
+{
+    if (!m_liveUpdate || !m_graphicsSceneView)
+        return;
+
+    // bottom track changes coming while the processor works are picked up by one run after it
+    if (m_surfaceProcessor.isBusy()) {
+        m_liveUpdatePending = true;
+        return;
+    }
+
+    m_liveUpdatePending = false;
+
+    // new points go into the triangulation of the previous run, without decimation and grid interpolation
+    // the vertices are shared with the bottom track, it detaches on its next change
+    auto bottomTrack = m_graphicsSceneView->bottomTrack();
+    SurfaceProcessorTask task;
+    task.setBottomTrack(bottomTrack);
+    task.setBottomTrackData(bottomTrack->cdata(), bottomTrack->rewrittenFrom());
+    task.setEdgeLengthLimit(m_liveEdgeLengthLimit);
+    task.setIncremental(true);
+
+    if (m_surfaceProcessor.startInThread(task))
+        bottomTrack->resetRewrittenFrom();
+    else
+        m_liveUpdatePending = true;
+}
+
 void SurfaceControlMenuController::onUpdateSurfaceButtonClicked(int triangleEdgeLengthLimitSpinBox,
                                                                 int gridCellSizeSpinBox,
                                                                 int decimationCountSpinBox,
@@ -45,6 +45,8 @@ public:
 
     Q_INVOKABLE void onFilterTypeComboBoxIndexChanged(int index);
 
+    Q_INVOKABLE void onLiveUpdateCheckButtonCheckedChanged(bool checked, int triangleEdgeLengthLimitSpinBox);
+
 
 
 Q_SIGNALS:
@@ -57,12 +59,17 @@ protected:
 private:
     Surface* surface() const;
     AbstractEntityDataFilter* inputDataFilter() const;
+    void startLiveUpdate();
 
 private:
     std::shared_ptr<AbstractEntityDataFilter> m_inputDataFilter;
     GraphicsScene3dView* m_graphicsSceneView = nullptr;
     SurfaceProcessor m_surfaceProcessor;
     QThread m_thread;
+    QMetaObject::Connection m_liveUpdateConnection;
+    bool m_liveUpdate = false;
+    bool m_liveUpdatePending = false;
+    int m_liveEdgeLengthLimit = -1;
 
 };
 
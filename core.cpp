@@ -1,7 +1,9 @@
 #include "core.h"
 
 #include <ctime>
+#include <QtConcurrent/QtConcurrent>
 #include "bottomtrack.h"
+#include "csv_export.h"
 #ifdef Q_OS_WINDOWS
 #include <Windows.h>
 #endif
@@ -21,9 +23,16 @@ Core::Core() :
     filePath_(),
     isFileOpening_(false),
     isMosaicUpdatingInThread_(false),
-    isSideScanPerformanceMode_(false)
+    isSideScanPerformanceMode_(false),
+    exportCancel_(false),
+    exportProgress_(-1),
+    xtfImportCancel_(false),
+    xtfImportProgress_(-1),
+    xtfImportId_(0)
 {
     logger_.setDatasetPtr(datasetPtr_);
+    klfStatsTimer_.setInterval(klfStatsIntervalMs_);
+    QObject::connect(&klfStatsTimer_, &QTimer::timeout, this, &Core::klfStatsChanged);
     createDeviceManagerConnections();
     createLinkManagerConnections();
     createControllers();
@@ -31,6 +40,9 @@ Core::Core() :
 
 Core::~Core()
 {
+    stopExport();
+    cancelXtfImport();
+
     removeLinkManagerConnections();
 #ifdef SEPARATE_READING
     removeDeviceManagerConnections();
@@ -166,6 +178,7 @@ void Core::openLogFile(const QString &filePath, bool isAppend, bool onCustomEven
     removeLinkManagerConnections();
 
     QCoreApplication::processEvents(QEventLoop::AllEvents);
+    stopExport();
 
     if (!isAppend)
         datasetPtr_->resetDataset();
@@ -182,12 +195,8 @@ void Core::openLogFile(const QString &filePath, bool isAppend, bool onCustomEven
     if (splitname.size() > 1) {
         QString format = splitname.last();
         if (format.contains("xtf", Qt::CaseInsensitive)) {
-            QFile file;
             QUrl url(localfilePath);
-            url.isLocalFile() ? file.setFileName(url.toLocalFile()) : file.setFileName(url.toString());
-            if (file.open(QIODevice::ReadOnly)) {
-                openXTF(file.readAll());
-            }
+            openXTFFile(url.isLocalFile() ? url.toLocalFile() : url.toString());
             return;
         }
     }
@@ -209,6 +218,9 @@ void Core::openLogFile(const QString &filePath, bool isAppend, bool onCustomEven
 
 bool Core::closeLogFile(bool onOpen)
 {
+    cancelXtfImport();
+    stopExport();
+
     if (isOpenedFile()) {
         emit sendCloseLogFile(onOpen ? !tryOpenedfilePath_.isEmpty() : false);
         openedfilePath_.clear();
@@ -280,6 +292,7 @@ void Core::onFileReadEnough()
 void Core::onFileOpenBreaked(bool onOpen)
 {
     fileIsCompleteOpened_ = false;
+    stopExport();
     if (datasetPtr_) {
         datasetPtr_->resetDataset();
     }
@@ -311,6 +324,7 @@ void Core::openLogFile(const QString& filePath, bool isAppend, bool onCustomEven
         removeLinkManagerConnections();
 
         QCoreApplication::processEvents(QEventLoop::AllEvents);
+        stopExport();
 
         if (!isAppend)
             datasetPtr_->resetDataset();
@@ -327,15 +341,14 @@ void Core::openLogFile(const QString& filePath, bool isAppend, bool onCustomEven
         if (splitname.size() > 1) {
             QString format = splitname.last();
             if (format.contains("xtf", Qt::CaseInsensitive)) {
-                QFile file;
                 QUrl url(localfilePath);
-                url.isLocalFile() ? file.setFileName(url.toLocalFile()) : file.setFileName(url.toString());
-                    if (file.open(QIODevice::ReadOnly)) {
-                        openXTF(file.readAll());
-                    }
-                    return;
+                if (!openXTFFile(url.isLocalFile() ? url.toLocalFile() : url.toString())) {
+                    isFileOpening_ = false;
+                    emit sendIsFileOpening();
                 }
+                return;
             }
+        }
 
         emit deviceManagerWrapperPtr_->sendOpenFile(localfilePath);
 
@@ -368,6 +381,9 @@ void Core::openLogFile(const QString& filePath, bool isAppend, bool onCustomEven
 
 bool Core::closeLogFile()
 {
+    cancelXtfImport();
+    stopExport();
+
     if (!isOpenedFile())
         return false;
 
@@ -403,9 +419,112 @@ void Core::onFileOpened()
 
 bool Core::openXTF(QByteArray data)
 {
+    cancelXtfImport();
+    stopExport();
+
     datasetPtr_->resetDataset();
     converterXtf_.toDataset(data, getDatasetPtr());
 
+    finishXtfOpening();
+
+    return true;
+}
+
+bool Core::openXTFFile(const QString& fileName)
+{
+    cancelXtfImport();
+
+    auto file = std::make_shared<QFile>(fileName);
+    if (!file->open(QIODevice::ReadOnly)) {
+        consoleInfo("XTF can't open file: " + fileName);
+        return false;
+    }
+
+    stopExport();
+    datasetPtr_->resetDataset();
+
+    const QFileInfo fileInfo(fileName);
+    if (!xtfPingIndex_.matches(fileInfo)) {
+        xtfPingIndex_ = ConverterXTF::PingIndex();
+        xtfPingIndex_.load(fileInfo);
+    }
+    QVector<qint64> pingOffsets = xtfPingIndex_.pingOffsets;
+    const int importId = ++xtfImportId_;
+
+    xtfImportCancel_ = false;
+    xtfImportProgress_ = 0;
+    emit xtfImportProgressChanged();
+
+    // pings are read on the pool and added to the dataset here, a few batches at most are in flight
+    auto batchSlots = std::make_shared<QSemaphore>(xtfImportBatchesInFlight_);
+
+    xtfImportFuture_ = QtConcurrent::run([this, file, fileInfo, pingOffsets, importId, batchSlots]() mutable -> void {
+        ConverterXTF converter;
+
+        auto onPings = [this, importId, batchSlots](QVector<ConverterXTF::Ping>&& pings) -> bool {
+            while (!batchSlots->tryAcquire(1, 100)) {
+                if (xtfImportCancel_) {
+                    return false;
+                }
+            }
+
+            QMetaObject::invokeMethod(this, [this, importId, batchSlots, pings]() -> void {
+                if (!xtfImportCancel_ && importId == xtfImportId_) {
+                    for (const auto& ping : pings) {
+                        ConverterXTF::applyPing(ping, datasetPtr_);
+                    }
+                }
+                batchSlots->release();
+            }, Qt::QueuedConnection);
+
+            return !xtfImportCancel_;
+        };
+
+        auto onProgress = [this](int percent) -> bool {
+            if (percent != xtfImportProgress_.exchange(percent)) {
+                emit xtfImportProgressChanged();
+            }
+            return !xtfImportCancel_;
+        };
+
+        const bool hadIndex = !pingOffsets.isEmpty();
+        const bool success = converter.readXTF(file.get(), onPings, onProgress, &pingOffsets);
+        const auto header = converter.header;
+
+        QMetaObject::invokeMethod(this, [this, importId, success, hadIndex, header, fileInfo, pingOffsets]() -> void {
+            if (importId != xtfImportId_) {
+                return;
+            }
+
+            if (success && !hadIndex) {
+                xtfPingIndex_ = { fileInfo.absoluteFilePath(), fileInfo.size(), fileInfo.lastModified(), pingOffsets };
+                xtfPingIndex_.save();
+            }
+            else if (!success) {
+                consoleInfo(xtfImportCancel_ ? "XTF reading canceled" : "XTF is not valid");
+            }
+
+            converterXtf_.header = header;
+            finishXtfOpening();
+
+            xtfImportProgress_ = -1;
+            emit xtfImportProgressChanged();
+            isFileOpening_ = false;
+            emit sendIsFileOpening();
+        }, Qt::QueuedConnection);
+    });
+
+    return true;
+}
+
+void Core::cancelXtfImport()
+{
+    xtfImportCancel_ = true;
+    xtfImportFuture_.waitForFinished();
+}
+
+void Core::finishXtfOpening()
+{
     consoleInfo("XTF note:" + QString(converterXtf_.header.NoteString));
     consoleInfo("XTF programm name:" + QString(converterXtf_.header.RecordingProgramName));
     consoleInfo("XTF sonar name:" + QString(converterXtf_.header.SonarName));
@@ -419,8 +538,6 @@ bool Core::openXTF(QByteArray data)
             }
         }
     }
-
-    return true;
 }
 
 bool Core::openCSV(QString name, int separatorType, int firstRow, int colTime, bool isUtcTime, int colLat, int colLon, int colAltitude, int colNorth, int colEast, int colUp)
@@ -568,6 +685,9 @@ void Core::setKlfLogging(bool isLogging)
         return;
     this->getIsKlfLogging() ? logger_.stopKlfLogging() : logger_.startNewKlfLog();
     isLoggingKlf_ = isLogging;
+
+    isLogging ? klfStatsTimer_.start() : klfStatsTimer_.stop();
+    emit klfStatsChanged();
 }
 
 bool Core::getIsKlfLogging()
@@ -575,338 +695,187 @@ bool Core::getIsKlfLogging()
     return isLoggingKlf_;
 }
 
-void Core::setCsvLogging(bool isLogging)
+void Core::setKlfFlushIntervalMs(int intervalMs)
 {
-    if (isLogging == this->getIsCsvLogging())
+    KlfWriter::Policy policy = logger_.getKlfWritePolicy();
+    intervalMs = std::max(intervalMs, 1);
+    if (policy.flushIntervalMs == intervalMs)
         return;
-    this->getIsCsvLogging() ? logger_.stopCsvLogging() : logger_.startNewCsvLog();
-    isLoggingCsv_ = isLogging;
+    policy.flushIntervalMs = intervalMs;
+    logger_.setKlfWritePolicy(policy);
+    emit klfWritePolicyChanged();
 }
 
-bool Core::getIsCsvLogging()
+void Core::setKlfSyncIntervalMs(int intervalMs)
 {
-    return isLoggingCsv_;
+    KlfWriter::Policy policy = logger_.getKlfWritePolicy();
+    intervalMs = std::max(intervalMs, 0);
+    if (policy.syncIntervalMs == intervalMs)
+        return;
+    policy.syncIntervalMs = intervalMs;
+    logger_.setKlfWritePolicy(policy);
+    emit klfWritePolicyChanged();
 }
 
-bool Core::exportComplexToCSV(QString file_path) {
-    QString export_file_name = isOpenedFile() ? openedfilePath_.section('/', -1).section('.', 0, 0) : QDateTime::currentDateTime().toString("yyyy.MM.dd_hh:mm:ss").replace(':', '.');
-    logger_.creatExportStream(file_path + "/" + export_file_name + ".csv");
-
-    //QMap<int, DatasetChannel> ch_list = datasetPtr_->channelsList();
-    // _dataset->setRefPosition(1518);
-
-    for(int i = 0; i < datasetPtr_->size(); i++) {
-        Epoch* epoch = datasetPtr_->fromIndex(i);
-
-        if(epoch == NULL) { continue; }
-
-        if(epoch->isComplexSignalAvail()) {
-            ComplexSignals sigs = epoch->complexSignals();
-
-            for (auto ch = sigs.cbegin(), end = sigs.cend(); ch != end; ++ch) {
-                ComplexSignal signal = ch.value();
-
-                ComplexF* data = signal.data.data();
-                int data_size = signal.data.size();
-
-                QString row_data;
-                row_data.append(QString("%1,%2").arg(i).arg(ch.key()));
-                row_data.append(QString(",%1").arg(signal.globalOffset));
-                row_data.append(QString(",%1").arg(signal.sampleRate));
-
-                if(data != NULL && data_size > 0) {
-                    for(int ci = 0; ci < data_size; ci++) {
-                        row_data.append(QString(",%1,%2").arg(data[ci].real).arg(data[ci].imag));
-                    }
-                }
-
-                row_data.append("\n");
-                logger_.dataExport(row_data);
-            }
-        }
-    }
-
-    logger_.endExportStream();
-
-    return true;
+int Core::getKlfFlushIntervalMs() const
+{
+    return logger_.getKlfWritePolicy().flushIntervalMs;
 }
 
-bool Core::exportUSBLToCSV(QString filePath)
+int Core::getKlfSyncIntervalMs() const
 {
-    QString export_file_name = isOpenedFile() ? openedfilePath_.section('/', -1).section('.', 0, 0) : QDateTime::currentDateTime().toString("yyyy.MM.dd_hh:mm:ss").replace(':', '.');
-
-    logger_.creatExportStream(filePath + "/" + export_file_name + ".csv");
-    QMap<int, DatasetChannel> ch_list = datasetPtr_->channelsList();
-    Q_UNUSED(ch_list);
-    // _dataset->setRefPosition(1518);
+    return logger_.getKlfWritePolicy().syncIntervalMs;
+}
 
-    logger_.dataExport("epoch,yaw,pitch,roll,north,east,ping_counter,carrier_counter,snr,azimuth_deg,elevation_deg,distance_m\n");
+qint64 Core::getKlfQueuedBytes() const
+{
+    return logger_.getKlfStats().queuedBytes;
+}
 
-    for (int i = 0; i < datasetPtr_->size(); i += 1) {
-        Epoch* epoch = datasetPtr_->fromIndex(i);
+qint64 Core::getKlfDroppedFrames() const
+{
+    return logger_.getKlfStats().droppedFrames;
+}
 
-        if (epoch == NULL)
-            continue;
+qint64 Core::getKlfWriteLatencyUs() const
+{
+    return logger_.getKlfStats().lastWriteUs;
+}
 
-        Position pos = epoch->getPositionGNSS();
+qint64 Core::getKlfMaxWriteLatencyUs() const
+{
+    return logger_.getKlfStats().maxWriteUs;
+}
 
-        // pos.ned.isCoordinatesValid() && epoch->isAttAvail() &&
-        if( epoch->isUsblSolutionAvailable()) {
-            QString row_data;
+bool Core::getKlfWriteFailed() const
+{
+    return logger_.getKlfStats().writeFailed;
+}
 
-            row_data.append(QString("%1").arg(i));
-            row_data.append(QString(",%1,%2,%3").arg(epoch->yaw()).arg(epoch->pitch()).arg(epoch->roll()));
-            row_data.append(QString(",%1,%2").arg(pos.ned.n).arg(pos.ned.e));
-            row_data.append(QString(",%1,%2,%3").arg(epoch->usblSolution().ping_counter).arg(epoch->usblSolution().carrier_counter).arg(epoch->usblSolution().snr));
-            row_data.append(QString(",%1,%2,%3").arg(epoch->usblSolution().azimuth_deg).arg(epoch->usblSolution().elevation_deg).arg(epoch->usblSolution().distance_m));
+void Core::setCsvLogging(bool isLogging)
+{
+    if (isLogging == this->getIsCsvLogging())
+        return;
+    this->getIsCsvLogging() ? logger_.stopCsvLogging() : logger_.startNewCsvLog();
+    isLoggingCsv_ = isLogging;
+}
 
-            row_data.append("\n");
-            logger_.dataExport(row_data);
-        }
-    }
+bool Core::getIsCsvLogging()
+{
+    return isLoggingCsv_;
+}
 
-    logger_.endExportStream();
+bool Core::exportComplexToCSV(QString filePath, bool inThread)
+{
+    CsvExport csvExport(datasetPtr_, &exportCancel_);
 
-    return true;
+    return startExport(filePath + "/" + exportFileName() + ".csv", [csvExport](QIODevice* dev, const std::function<bool(int)>& progress) -> bool {
+        return csvExport.writeComplex(dev, progress);
+    }, inThread);
 }
 
-bool Core::exportPlotAsCVS(QString filePath, int channel, float decimation)
+bool Core::exportUSBLToCSV(QString filePath, bool inThread)
 {
-    QString export_file_name = isOpenedFile() ? openedfilePath_.section('/', -1).section('.', 0, 0) : QDateTime::currentDateTime().toString("yyyy.MM.dd_hh:mm:ss").replace(':', '.');
-    logger_.creatExportStream(filePath + "/" + export_file_name + ".csv");
+    CsvExport csvExport(datasetPtr_, &exportCancel_);
 
-    bool meas_nbr = true;
-    bool event_id = true;
-    bool rangefinder = false;
-    bool bottom_depth = true;
-    bool pos_lat_lon = true;
-    bool pos_time = true;
+    return startExport(filePath + "/" + exportFileName() + ".csv", [csvExport](QIODevice* dev, const std::function<bool(int)>& progress) -> bool {
+        return csvExport.writeUsbl(dev, progress);
+    }, inThread);
+}
 
-    bool external_pos_lla = true;
-    bool external_pos_neu = true;
-    bool sonar_height = true;
-    bool bottom_height = true;
+bool Core::exportPlotAsCVS(QString filePath, int channel, float decimation, bool inThread)
+{
+    if (exportProgress_ >= 0) {
+        return false;
+    }
 
-    bool ext_pos_lla_find = false;
-    bool ext_pos_ned_find = false;
+    datasetPtr_->spatialProcessing(); // heights of the sonar and the bottom, only the dirty epochs are recomputed
 
-    int row_cnt = datasetPtr_->size();
-    datasetPtr_->spatialProcessing();
+    CsvExport csvExport(datasetPtr_, &exportCancel_);
+    const CsvExport::PlotColumns columns = csvExport.plotColumns();
 
-    for (int i = 0; i < row_cnt; i++) {
-        Epoch* epoch = datasetPtr_->fromIndex(i);
+    return startExport(filePath + "/" + exportFileName() + ".csv", [csvExport, columns, channel, decimation](QIODevice* dev, const std::function<bool(int)>& progress) -> bool {
+        return csvExport.writePlot(dev, columns, channel, decimation, progress);
+    }, inThread);
+}
 
-        Position position = epoch->getExternalPosition();
-        ext_pos_lla_find |= position.lla.isValid();
-        ext_pos_ned_find |= position.ned.isValid();
+bool Core::exportPlotAsXTF(QString filePath, bool inThread)
+{
+    if (plot2dList_.isEmpty()) {
+        return false;
     }
 
-    if (meas_nbr)
-        logger_.dataExport("Number,");
+    const int channel1 = plot2dList_[0]->plotDatasetChannel();
+    const int channel2 = plot2dList_[0]->plotDatasetChannel2();
+    auto epochs = std::make_shared<EpochSnapshot>(datasetPtr_, &exportCancel_); // closed epochs, copied on this thread chunk by chunk
 
-    if (event_id) {
-        logger_.dataExport("Event UNIX,");
-        logger_.dataExport("Event timestamp,");
-        logger_.dataExport("Event ID,");
-    }
-
-    if (rangefinder)
-        logger_.dataExport("Rangefinder,");
+    // pings are streamed straight to the file
+    return startExport(filePath + "/_" + exportFileName() + ".xtf", [epochs, channel1, channel2](QIODevice* dev, const std::function<bool(int)>& progress) -> bool {
+        ConverterXTF converter;
+        return converter.writeXTF(dev, *epochs, channel1, channel2, progress);
+    }, inThread);
+}
 
-    if (bottom_depth)
-        logger_.dataExport("Beam distance,");
+void Core::cancelExport()
+{
+    exportCancel_ = true;
+}
 
-    if (pos_lat_lon) {
-        logger_.dataExport("Latitude,");
-        logger_.dataExport("Longitude,");
+void Core::stopExport()
+{
+    cancelExport();
+    exportFuture_.waitForFinished(); // the export reads the dataset
+}
 
-        if (pos_time) {
-            logger_.dataExport("GNSS UTC Date,");
-            logger_.dataExport("GNSS UTC Time,");
-        }
-    }
+QString Core::exportFileName() const
+{
+    return isOpenedFile() ? openedfilePath_.section('/', -1).section('.', 0, 0) : QDateTime::currentDateTime().toString("yyyy.MM.dd_hh:mm:ss").replace(':', '.');
+}
 
-    if (external_pos_lla && ext_pos_lla_find) {
-        logger_.dataExport("ExtLatitude,");
-        logger_.dataExport("ExtLongitude,");
-        logger_.dataExport("ExtAltitude,");
+bool Core::startExport(const QString& filePath, const ExportFunc& exportFunc, bool inThread)
+{
+    if (exportProgress_ >= 0) {
+        return false;
     }
 
-    if (external_pos_neu && ext_pos_ned_find) {
-        logger_.dataExport("ExtNorth,");
-        logger_.dataExport("ExtEast,");
-        logger_.dataExport("ExtHeight,");
+    auto file = std::make_shared<QFile>(QUrl(filePath).toLocalFile());
+    if (!file->open(QIODevice::WriteOnly)) {
+        consoleInfo("Export can't make file: " + file->fileName());
+        return false;
     }
+    consoleInfo("Export make file: " + file->fileName());
 
-    if (sonar_height)
-        logger_.dataExport("SonarHeight,");
-
-    if (bottom_height)
-        logger_.dataExport("BottomHeight,");
-
-    logger_.dataExport("\n");
-
-    int prev_timestamp = 0;
-    int prev_unix = 0;
-    int prev_event_id = 0;
-    float prev_dist_proc = 0;
-    double prev_lat = 0, prev_lon = 0;
-
-    float decimation_m = decimation;
-    float decimation_path = 0;
-    LLARef lla_ref;
-    NED last_pos_ned;
-
-    for (int i = 0; i < row_cnt; i++) {
-        Epoch* epoch = datasetPtr_->fromIndex(i);
-
-        if (decimation_m > 0) {
-            if (!epoch->isPosAvail())
-                continue;
-
-            Position pos = epoch->getPositionGNSS();
-
-            if (pos.lla.isCoordinatesValid()) {
-                if (!lla_ref.isInit) {
-                    lla_ref = LLARef(pos.lla);
-                    pos.LLA2NED(&lla_ref);
-                    last_pos_ned = pos.ned;
-                }
-                else {
-                    pos.LLA2NED(&lla_ref);
-                    float dif_n = pos.ned.n - last_pos_ned.n;
-                    float dif_e = pos.ned.e - last_pos_ned.e;
-                    last_pos_ned = pos.ned;
-                    decimation_path += sqrtf(dif_n*dif_n + dif_e*dif_e);
-                    if(decimation_path < decimation_m)
-                        continue;
-                    decimation_path -= decimation_m;
-                }
-            }
-            else {
-                continue;
-            }
-        }
-
-        QString row_data;
+    exportCancel_ = false;
+    exportProgress_ = 0;
+    emit exportProgressChanged();
 
-        if (meas_nbr)
-            row_data.append(QString("%1,").arg(i));
-
-        if (event_id) {
-            if (epoch->eventAvail()) {
-                prev_timestamp = epoch->eventTimestamp();
-                prev_event_id = epoch->eventID();
-                prev_unix = epoch->eventUnix();
+    auto runFunc = [this, file, exportFunc]() -> void {
+        bool success = exportFunc(file.get(), [this](int percent) -> bool {
+            if (percent != exportProgress_.exchange(percent)) {
+                emit exportProgressChanged();
             }
-            row_data.append(QString("%1,%2,%3,").arg(prev_unix).arg(prev_timestamp).arg(prev_event_id));
-        }
-
-        if (rangefinder)
-            epoch->distAvail() ? row_data.append(QString("%1,").arg((float)epoch->rangeFinder())) : row_data.append("0,");
-
-        if (bottom_depth) {
-            prev_dist_proc = epoch->distProccesing(channel);
-            row_data.append(QString("%1,").arg((float)(prev_dist_proc)));
-        }
-
-        if (pos_lat_lon) {
-            if (epoch->isPosAvail()) {
-                prev_lat = epoch->lat();
-                prev_lon = epoch->lon();
+            return !exportCancel_;
+        });
+        file->close();
+
+        QMetaObject::invokeMethod(this, [this, file, success]() -> void {
+            if (!success) {
+                file->remove();
+                consoleInfo(exportCancel_ ? "Export canceled: " + file->fileName() : "Export failed: " + file->fileName());
             }
+            exportProgress_ = -1;
+            emit exportProgressChanged();
+            emit exportFinished(success);
+        }, Qt::QueuedConnection);
+    };
 
-            row_data.append(QString::number(prev_lat, 'f', 8));
-            row_data.append(",");
-            row_data.append(QString::number(prev_lon, 'f', 8));
-            row_data.append(",");
-
-            if (pos_time) {
-                if (epoch->isPosAvail() && epoch->positionTimeUnix() != 0) {
-                    DateTime time_epoch = *epoch->time();
-
-                    DateTime* dt = epoch->time();
-                    if (time_epoch.sec > 0) {
-                        time_epoch.sec -= 18;
-                        dt = &time_epoch;
-                    }
-                    // DateTime* dt = epoch->positionTime();
-                    volatile tm t_sep = dt->getDateTime();
-                    t_sep.tm_year += 1900;
-                    t_sep.tm_mon += 1;
-
-                    row_data.append(QString("%1-%2-%3").arg(t_sep.tm_year).arg(t_sep.tm_mon).arg(t_sep.tm_mday));
-                    row_data.append(",");
-                    row_data.append(QString("%1:%2:%3").arg(t_sep.tm_hour).arg(t_sep.tm_min).arg((double)t_sep.tm_sec+(double)dt->nanoSec/1e9));
-                    row_data.append(",");
-                }
-                else {
-                    row_data.append(",");
-                    row_data.append(",");
-                }
-            }
-        }
-
-        Position position = epoch->getExternalPosition();
-
-        if (external_pos_lla && ext_pos_lla_find) {
-            row_data.append(QString::number(position.lla.latitude, 'f', 10));
-            row_data.append(",");
-            row_data.append(QString::number(position.lla.longitude, 'f', 10));
-            row_data.append(",");
-            row_data.append(QString::number(position.lla.altitude, 'f', 3));
-            row_data.append(",");
-        }
-
-        if (external_pos_neu && ext_pos_ned_find) {
-            row_data.append(QString::number(position.ned.n, 'f', 10));
-            row_data.append(",");
-            row_data.append(QString::number(position.ned.e, 'f', 10));
-            row_data.append(",");
-            row_data.append(QString::number(-position.ned.d, 'f', 3));
-            row_data.append(",");
-        }
-
-        Epoch::Echogram* sensor = epoch->chart(channel);
-
-        if (sonar_height) {
-            if (sensor != NULL && isfinite(sensor->sensorPosition.ned.d)) {
-                row_data.append(QString::number(-sensor->sensorPosition.ned.d, 'f', 3));
-            }
-            else if (sensor != NULL && isfinite(sensor->sensorPosition.lla.altitude)) {
-                row_data.append(QString::number(sensor->sensorPosition.lla.altitude, 'f', 3));
-            }
-            row_data.append(",");
-        }
-
-        if (bottom_height) {
-            if(sensor != NULL && isfinite(sensor->bottomProcessing.bottomPoint.ned.d)) {
-                row_data.append(QString::number(-sensor->bottomProcessing.bottomPoint.ned.d, 'f', 3));
-            }
-            else if (sensor != NULL && isfinite(sensor->bottomProcessing.bottomPoint.lla.altitude)) {
-                row_data.append(QString::number(sensor->bottomProcessing.bottomPoint.lla.altitude, 'f', 3));
-            }
-            row_data.append(",");
-        }
-
-        row_data.append("\n");
-        logger_.dataExport(row_data);
+    if (inThread) {
+        exportFuture_ = QtConcurrent::run(runFunc);
+    }
+    else {
+        runFunc();
     }
 
-    logger_.endExportStream();
-
-    return true;
-}
-
-bool Core::exportPlotAsXTF(QString filePath)
-{
-    QString export_file_name = isOpenedFile() ? openedfilePath_.section('/', -1).section('.', 0, 0) : QDateTime::currentDateTime().toString("yyyy.MM.dd_hh:mm:ss").replace(':', '.');
-    logger_.creatExportStream(filePath + "/_" + export_file_name + ".xtf");
-    QMap<int, DatasetChannel> chs = datasetPtr_->channelsList();
-    Q_UNUSED(chs);
-    QByteArray data_export = converterXtf_.toXTF(getDatasetPtr(), plot2dList_[0]->plotDatasetChannel(), plot2dList_[0]->plotDatasetChannel2());
-    logger_.dataByteExport(data_export);
-    logger_.endExportStream();
     return true;
 }
 
@@ -1071,6 +1040,16 @@ bool Core::getIsSeparateReading() const
 #endif
 }
 
+int Core::getExportProgress() const
+{
+    return exportProgress_;
+}
+
+int Core::getXtfImportProgress() const
+{
+    return xtfImportProgress_;
+}
+
 ConsoleListModel* Core::consoleList()
 {
     return consolePtr_->listModel();
@@ -1160,11 +1139,9 @@ void Core::createLinkManagerConnections()
     linkManagerWrapperConnections_.append(QObject::connect(linkManagerWrapperPtr_->getWorker(), &LinkManager::linkClosed,  deviceManagerWrapperPtr_->getWorker(), &DeviceManager::onLinkClosed,   linkManagerConnection));
     linkManagerWrapperConnections_.append(QObject::connect(linkManagerWrapperPtr_->getWorker(), &LinkManager::linkOpened,  deviceManagerWrapperPtr_->getWorker(), &DeviceManager::onLinkOpened,   linkManagerConnection));
     linkManagerWrapperConnections_.append(QObject::connect(linkManagerWrapperPtr_->getWorker(), &LinkManager::linkDeleted, deviceManagerWrapperPtr_->getWorker(), &DeviceManager::onLinkDeleted,  linkManagerConnection));
-    linkManagerWrapperConnections_.append(QObject::connect(linkManagerWrapperPtr_->getWorker(), &LinkManager::frameReady,  this, [this](QUuid uuid, Link* link, FrameParser frame) {
+    linkManagerWrapperConnections_.append(QObject::connect(linkManagerWrapperPtr_->getWorker(), &LinkManager::frameReady,  this, [this](QUuid uuid, Link* link, FrameHandle frame) {
                                                                                                                                     if (getIsKlfLogging()) {
-                                                                                                                                        QMetaObject::invokeMethod(&logger_, [this, uuid, link, frame]() {
-                                                                                                                                                logger_.onFrameParserReceiveKlf(uuid, link, frame);
-                                                                                                                                            }, Qt::QueuedConnection);
+                                                                                                                                        logger_.onFrameParserReceiveKlf(uuid, link, frame); // only copies the frame into the writer ring
                                                                                                                                     }
                                                                                                                                  }, linkManagerConnection));
 
@@ -6,6 +6,11 @@
 #include <QStandardItemModel>
 #include <QQmlContext>
 #include <QThread>
+#include <QTimer>
+#include <QFuture>
+#include <QSemaphore>
+#include <atomic>
+#include <functional>
 #ifdef FLASHER
 #include "flasher.h"
 #endif
@@ -45,11 +50,20 @@ public:
     Q_PROPERTY(ConsoleListModel* consoleList READ consoleList CONSTANT)
     Q_PROPERTY(bool loggingKlf WRITE setKlfLogging)
     Q_PROPERTY(bool loggingCsv WRITE setCsvLogging)
+    Q_PROPERTY(int klfFlushIntervalMs READ getKlfFlushIntervalMs WRITE setKlfFlushIntervalMs NOTIFY klfWritePolicyChanged)
+    Q_PROPERTY(int klfSyncIntervalMs READ getKlfSyncIntervalMs WRITE setKlfSyncIntervalMs NOTIFY klfWritePolicyChanged)
+    Q_PROPERTY(qint64 klfQueuedBytes READ getKlfQueuedBytes NOTIFY klfStatsChanged)
+    Q_PROPERTY(qint64 klfDroppedFrames READ getKlfDroppedFrames NOTIFY klfStatsChanged)
+    Q_PROPERTY(qint64 klfWriteLatencyUs READ getKlfWriteLatencyUs NOTIFY klfStatsChanged)
+    Q_PROPERTY(qint64 klfMaxWriteLatencyUs READ getKlfMaxWriteLatencyUs NOTIFY klfStatsChanged)
+    Q_PROPERTY(bool klfWriteFailed READ getKlfWriteFailed NOTIFY klfStatsChanged)
     Q_PROPERTY(QString filePath READ getFilePath NOTIFY filePathChanged)
     Q_PROPERTY(bool isFileOpening READ getIsFileOpening NOTIFY sendIsFileOpening)
     Q_PROPERTY(bool isMosaicUpdatingInThread READ getIsMosaicUpdatingInThread NOTIFY isMosaicUpdatingInThreadUpdated)
     Q_PROPERTY(bool isSideScanPerformanceMode READ getIsSideScanPerformanceMode NOTIFY isSideScanPerformanceModeUpdated)
     Q_PROPERTY(bool isSeparateReading READ getIsSeparateReading CONSTANT)
+    Q_PROPERTY(int exportProgress READ getExportProgress NOTIFY exportProgressChanged)
+    Q_PROPERTY(int xtfImportProgress READ getXtfImportProgress NOTIFY xtfImportProgressChanged)
 
     void setEngine(QQmlApplicationEngine *engine);
     Console* getConsolePtr();
@@ -81,6 +95,8 @@ public slots:
 #endif
     void onFileOpened();
     bool openXTF(QByteArray data);    
+    bool openXTFFile(const QString& fileName);
+    void cancelXtfImport();
     bool openCSV(QString name, int separatorType, int row = -1, int colTime = -1, bool isUtcTime = true, int colLat = -1, int colLon = -1, int colAltitude = -1, int colNorth = -1, int colEast = -1, int colUp = -1);
     bool openProxy(const QString& address, const int port, bool isTcp);
     bool closeProxy();
@@ -88,12 +104,22 @@ public slots:
     void upgradeChanged(int progressStatus);
     void setKlfLogging(bool isLogging);
     bool getIsKlfLogging();
+    void setKlfFlushIntervalMs(int intervalMs); // the write policy applies to the next .klf log
+    void setKlfSyncIntervalMs(int intervalMs);  // 0 leaves syncing to the OS
+    int getKlfFlushIntervalMs() const;
+    int getKlfSyncIntervalMs() const;
+    qint64 getKlfQueuedBytes() const;
+    qint64 getKlfDroppedFrames() const;
+    qint64 getKlfWriteLatencyUs() const;
+    qint64 getKlfMaxWriteLatencyUs() const;
+    bool getKlfWriteFailed() const;
     void setCsvLogging(bool isLogging);
     bool getIsCsvLogging();
-    bool exportComplexToCSV(QString filePath);
-    bool exportUSBLToCSV(QString filePath);
-    bool exportPlotAsCVS(QString filePath, int channel, float decimation = 0);
-    bool exportPlotAsXTF(QString filePath);
+    bool exportComplexToCSV(QString filePath, bool inThread = false);
+    bool exportUSBLToCSV(QString filePath, bool inThread = false);
+    bool exportPlotAsCVS(QString filePath, int channel, float decimation = 0, bool inThread = false);
+    bool exportPlotAsXTF(QString filePath, bool inThread = false);
+    void cancelExport();
     void setPlotStartLevel(int level);
     void setPlotStopLevel(int level);
     void setTimelinePosition(double position);
@@ -111,6 +137,8 @@ public slots:
     bool getIsMosaicUpdatingInThread() const;
     bool getIsSideScanPerformanceMode() const;
     bool getIsSeparateReading() const;
+    int getExportProgress() const;
+    int getXtfImportProgress() const;
 
 signals:
     void connectionChanged(bool duplex = false);
@@ -118,6 +146,11 @@ signals:
     void sendIsFileOpening();
     void isMosaicUpdatingInThreadUpdated();
     void isSideScanPerformanceModeUpdated();
+    void exportProgressChanged();
+    void klfWritePolicyChanged();
+    void klfStatsChanged();
+    void exportFinished(bool success);
+    void xtfImportProgressChanged();
 
 #ifdef SEPARATE_READING
     void sendCloseLogFile(bool onOpen = false);
@@ -130,6 +163,10 @@ private slots:
 #endif
 
 private:
+    /*structures*/
+    // writes the export into the device, the progress callback returns false once the export is canceled
+    using ExportFunc = std::function<bool(QIODevice* dev, const std::function<bool(int percent)>& progress)>;
+
     /*methods*/
     ConsoleListModel* consoleList();
     void createControllers();
@@ -142,6 +179,10 @@ private:
     bool isOpenedFile() const;
     bool isFactoryMode() const;
     bool isMotorControlMode() const;
+    void finishXtfOpening();
+    void stopExport();
+    QString exportFileName() const;
+    bool startExport(const QString& filePath, const ExportFunc& exportFunc, bool inThread);
 
     QString getFilePath() const;
     void fixFilePathString(QString& filePath) const;
@@ -180,6 +221,8 @@ private:
     QString openedfilePath_;
     bool isLoggingKlf_;
     bool isLoggingCsv_;
+    static constexpr int klfStatsIntervalMs_ = 1000;
+    QTimer klfStatsTimer_; // klfStatsChanged while a .klf log is written
     QString filePath_;
 #ifdef FLASHER
     Flasher flasher;
@@ -199,4 +242,13 @@ private:
     bool isFileOpening_;
     bool isMosaicUpdatingInThread_;
     bool isSideScanPerformanceMode_;
+    QFuture<void> exportFuture_;
+    std::atomic_bool exportCancel_;
+    std::atomic_int exportProgress_; // percent, -1 when no export is running
+    static constexpr int xtfImportBatchesInFlight_ = 4;
+    QFuture<void> xtfImportFuture_;
+    ConverterXTF::PingIndex xtfPingIndex_; // of the last opened file, loaded from or saved next to it
+    std::atomic_bool xtfImportCancel_;
+    std::atomic_int xtfImportProgress_; // percent, -1 when no import is running
+    int xtfImportId_;
 };
@@ -6,7 +6,9 @@ HEADERS += \
     $$PWD/draw_utils.h \
     $$PWD/koggerglobal.h \
     $$PWD/sceneobject.h \
+    $$PWD/vertex_buffer_manager.h \
 
 SOURCES += \
     $$PWD/sceneobject.cpp \
-    $$PWD/draw_utils.cpp
+    $$PWD/draw_utils.cpp \
+    $$PWD/vertex_buffer_manager.cpp
@@ -1,17 +1,22 @@
 #include "sceneobject.h"
 #include <draw_utils.h>
+#include "vertex_buffer_manager.h"
 
 
 SceneObject::SceneObject(QObject *parent)
 : QObject(parent)
 , m_renderImpl(new RenderImplementation)
-{}
+{
+    trackRenderImplChanges();
+}
 
 SceneObject::SceneObject(RenderImplementation *impl, QObject *parent, QString name)
 : QObject(parent)
 , m_name(name)
 , m_renderImpl(impl)
-{}
+{
+    trackRenderImplChanges();
+}
 
 SceneObject::SceneObject(RenderImplementation *impl, GraphicsScene3dView *view, QObject *parent, QString name)
 : QObject(parent)
@@ -19,6 +24,17 @@ SceneObject::SceneObject(RenderImplementation *impl, GraphicsScene3dView *view,
 , m_view(view)
 {
     Q_UNUSED(name);
+
+    trackRenderImplChanges();
+}
+
+void SceneObject::trackRenderImplChanges()
+{
+    // direct, changed() is also emitted by the worker threads after they filled the implementation
+    QObject::connect(this, &SceneObject::changed, this, [this]() {
+        if (m_renderImpl)
+            m_renderImpl->markChanged();
+    }, Qt::DirectConnection);
 }
 
 void SceneObject::mouseMoveEvent(Qt::MouseButtons buttons, qreal x, qreal y)
@@ -191,8 +207,32 @@ void SceneObject::qmlDeclare()
 
 //-----------------------RenderImplementation-----------------------------//
 SceneObject::RenderImplementation::RenderImplementation()
+: m_version(nextVersion())
 {}
 
+SceneObject::RenderImplementation::RenderImplementation(const RenderImplementation &other)
+: m_data(other.m_data)
+, m_color(other.m_color)
+, m_width(other.m_width)
+, m_isVisible(other.m_isVisible)
+, m_bounds(other.m_bounds)
+, m_primitiveType(other.m_primitiveType)
+, m_version(other.version())
+{}
+
+SceneObject::RenderImplementation &SceneObject::RenderImplementation::operator=(const RenderImplementation &other)
+{
+    m_data = other.m_data;
+    m_color = other.m_color;
+    m_width = other.m_width;
+    m_isVisible = other.m_isVisible;
+    m_bounds = other.m_bounds;
+    m_primitiveType = other.m_primitiveType;
+    m_version.store(other.version(), std::memory_order_release);
+
+    return *this;
+}
+
 SceneObject::RenderImplementation::~RenderImplementation()
 {}
 
@@ -220,7 +260,7 @@ void SceneObject::RenderImplementation::render(QOpenGLFunctions *ctx,
     shaderProgram->setUniformValue(colorLoc, DrawUtils::colorToVector4d(m_color));
     shaderProgram->setUniformValue(matrixLoc, mvp);
     shaderProgram->enableAttributeArray(posLoc);
-    shaderProgram->setAttributeArray(posLoc, m_data.constData());
+    VertexBufferManager::setAttributeArray(shaderProgram.get(), posLoc, &m_data, m_data);
 
     ctx->glLineWidth(m_width);
     ctx->glDrawArrays(m_primitiveType, 0, m_data.size());
@@ -245,6 +285,23 @@ void SceneObject::RenderImplementation::setData(const QVector<QVector3D> &data,
     createBounds();
 }
 
+void SceneObject::RenderImplementation::appendData(const QVector3D* data, int count, int primitiveType)
+{
+    m_primitiveType = primitiveType;
+
+    if (count <= 0) {
+        return;
+    }
+
+    const int from = m_data.size();
+    m_data.reserve(from + count);
+    for (int i = 0; i < count; ++i) {
+        m_data.append(data[i]);
+    }
+
+    growBounds(from);
+}
+
 void SceneObject::RenderImplementation::setColor(QColor color)
 {
     if(m_color != color)
@@ -317,19 +374,35 @@ void SceneObject::RenderImplementation::removeVertex(int index)
 
 void SceneObject::RenderImplementation::createBounds()
 {
-    if (m_data.isEmpty()) {
-        m_bounds = Cube();
+    m_bounds = Cube();
+    growBounds(0);
+}
+
+void SceneObject::RenderImplementation::growBounds(int from)
+{
+    if (from >= m_data.size()) {
         return;
     }
 
-    float z_max{ !std::isfinite(m_data.first().z()) ? 0.f : m_data.first().z() };
+    const QVector3D& first = m_data.at(from);
+    float z_max{ !std::isfinite(first.z()) ? 0.f : first.z() };
     float z_min{ z_max };
-    float x_max{ !std::isfinite(m_data.first().x()) ? 0.f : m_data.first().x() };
+    float x_max{ !std::isfinite(first.x()) ? 0.f : first.x() };
     float x_min{ x_max };
-    float y_max{ !std::isfinite(m_data.first().y()) ? 0.f : m_data.first().y() };
+    float y_max{ !std::isfinite(first.y()) ? 0.f : first.y() };
     float y_min{ y_max };
 
-    for (const auto& itm: qAsConst(m_data)){
+    if (from > 0 && m_bounds.isValid()) {
+        x_min = std::min(x_min, m_bounds.minimumX());
+        x_max = std::max(x_max, m_bounds.maximumX());
+        y_min = std::min(y_min, m_bounds.minimumY());
+        y_max = std::max(y_max, m_bounds.maximumY());
+        z_min = std::min(z_min, m_bounds.minimumZ());
+        z_max = std::max(z_max, m_bounds.maximumZ());
+    }
+
+    for (int i = from; i < m_data.size(); ++i) {
+        const QVector3D& itm = m_data.at(i);
         z_min = std::min(z_min, !std::isfinite(itm.z()) ? 0.f : itm.z());
         z_max = std::max(z_max, !std::isfinite(itm.z()) ? 0.f : itm.z());
         x_min = std::min(x_min, !std::isfinite(itm.x()) ? 0.f : itm.x());
@@ -340,3 +413,20 @@ void SceneObject::RenderImplementation::createBounds()
 
     m_bounds = Cube(x_min, x_max, y_min, y_max, z_min, z_max);
 }
+
+quint64 SceneObject::RenderImplementation::version() const
+{
+    return m_version.load(std::memory_order_acquire);
+}
+
+void SceneObject::RenderImplementation::markChanged()
+{
+    m_version.store(nextVersion(), std::memory_order_release);
+}
+
+quint64 SceneObject::RenderImplementation::nextVersion()
+{
+    // one counter for all implementations, stamps of different objects never match
+    static std::atomic<quint64> counter(0);
+    return ++counter;
+}
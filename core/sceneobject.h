@@ -5,6 +5,8 @@
 #include <raycaster.h>
 #include <abstractentitydatafilter.h>
 
+#include <atomic>
+
 #include <QPair>
 #include <QObject>
 #include <QUuid>
@@ -13,7 +15,10 @@
 #include <QOpenGLFunctions>
 #include <QOpenGLShaderProgram>
 
-#define RENDER_IMPL(Class) ({dynamic_cast<Class##RenderImplementation*>(m_renderImpl);})
+// the implementation is taken for writing, the renderer picks up its copy on the next synchronization
+#define RENDER_IMPL(Class) ({auto markedImpl = dynamic_cast<Class##RenderImplementation*>(m_renderImpl); if (markedImpl) markedImpl->markChanged(); markedImpl;})
+// the implementation is only read, the renderer keeps its copy
+#define RENDER_IMPL_CONST(Class) (dynamic_cast<const Class##RenderImplementation*>(m_renderImpl))
 
 class GraphicsScene3dView;
 class SceneObject : public QObject, public std::enable_shared_from_this<SceneObject>
@@ -31,8 +36,11 @@ public:
     {
     public:
         RenderImplementation();
+        RenderImplementation(const RenderImplementation& other);
         virtual ~RenderImplementation();
 
+        RenderImplementation& operator=(const RenderImplementation& other);
+
         virtual void render(QOpenGLFunctions *ctx,
                             const QMatrix4x4 &mvp,
                             const QMap <QString, std::shared_ptr <QOpenGLShaderProgram>>& shaderProgramMap) const;
@@ -45,6 +53,8 @@ public:
                             const QMap <QString, std::shared_ptr <QOpenGLShaderProgram>>& shaderProgramMap) const;
 
         virtual void setData(const QVector<QVector3D>& data, int primitiveType = GL_POINTS);
+        //! Appends count vertices and grows the bounds by them only
+        void appendData(const QVector3D* data, int count, int primitiveType = GL_POINTS);
         virtual void setColor(QColor color);
         virtual void setWidth(qreal width);
         virtual void setVisible(bool isVisible);
@@ -57,6 +67,9 @@ public:
         Cube bounds() const;
         int primitiveType() const;
         void removeVertex(int index);
+        //! Stamp of the last change, copies keep it, so copies with equal stamps hold the same data
+        quint64 version() const;
+        void markChanged();
 
     protected:
         virtual void createBounds();
@@ -70,6 +83,11 @@ public:
         int m_primitiveType = GL_POINTS;
 
     private:
+        static quint64 nextVersion();
+        void growBounds(int from); // by the vertices [from, size)
+
+        std::atomic<quint64> m_version; // stamped by the writing thread, read by the render thread
+
         friend class SceneObject;
     };
 
@@ -123,6 +141,9 @@ protected:
     virtual void mouseWheelEvent(Qt::MouseButtons buttons, qreal x, qreal y, QPointF angleDelta);
     virtual void keyPressEvent(Qt::Key key);
 
+private:
+    void trackRenderImplChanges();
+
 public Q_SLOTS:
     /**
      * @brief Sets the name of object
@@ -0,0 +1,184 @@
+#include "vertex_buffer_manager.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace {
+
+constexpr int compareBlock = 4096; // vertices compared with one memcmp
+
+int firstDifference(const QVector3D* lhs, const QVector3D* rhs, int count)
+{
+    int i = 0;
+    while (i < count) {
+        const int block = std::min(compareBlock, count - i);
+        if (std::memcmp(lhs + i, rhs + i, block * sizeof(QVector3D)) != 0) {
+            break;
+        }
+        i += block;
+    }
+    while (i < count && std::memcmp(lhs + i, rhs + i, sizeof(QVector3D)) == 0) {
+        ++i;
+    }
+
+    return i;
+}
+
+// end of the differing range, vertices [result, count) are equal
+int lastDifference(const QVector3D* lhs, const QVector3D* rhs, int from, int count)
+{
+    int i = count;
+    while (i > from) {
+        const int block = std::min(compareBlock, i - from);
+        if (std::memcmp(lhs + i - block, rhs + i - block, block * sizeof(QVector3D)) != 0) {
+            break;
+        }
+        i -= block;
+    }
+    while (i > from && std::memcmp(lhs + i - 1, rhs + i - 1, sizeof(QVector3D)) == 0) {
+        --i;
+    }
+
+    return i;
+}
+
+} // namespace
+
+
+thread_local VertexBufferManager* VertexBufferManager::current_ = nullptr;
+
+VertexBufferManager::VertexBufferManager() :
+    frame_(0),
+    uploadedBytes_(0)
+{
+
+}
+
+VertexBufferManager::~VertexBufferManager()
+{
+    if (current_ == this) {
+        current_ = nullptr;
+    }
+
+    clear();
+}
+
+void VertexBufferManager::beginFrame()
+{
+    ++frame_;
+    current_ = this;
+}
+
+void VertexBufferManager::endFrame()
+{
+    if (current_ == this) {
+        current_ = nullptr;
+    }
+
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (frame_ - it.value().lastFrame > keepFrames_) {
+            it.value().buffer.destroy();
+            it = entries_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void VertexBufferManager::clear()
+{
+    for (auto& entry : entries_) {
+        entry.buffer.destroy();
+    }
+    entries_.clear();
+}
+
+bool VertexBufferManager::bind(const void* key, const QVector<QVector3D>& data)
+{
+    if (data.isEmpty()) {
+        return false;
+    }
+
+    Entry& entry = entries_[key];
+    entry.lastFrame = frame_;
+
+    if (!entry.buffer.isCreated()) {
+        entry.buffer = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+        entry.buffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+        if (!entry.buffer.create()) {
+            entries_.remove(key);
+            return false;
+        }
+    }
+
+    entry.buffer.bind();
+    upload(entry, data);
+
+    return true;
+}
+
+qint64 VertexBufferManager::getUploadedBytes() const
+{
+    return uploadedBytes_;
+}
+
+int VertexBufferManager::getBuffersCount() const
+{
+    return entries_.size();
+}
+
+VertexBufferManager* VertexBufferManager::current()
+{
+    return current_;
+}
+
+void VertexBufferManager::setAttributeArray(QOpenGLShaderProgram* program, int location, const void* key, const QVector<QVector3D>& data)
+{
+    if (current_ && current_->bind(key, data)) {
+        program->setAttributeBuffer(location, GL_FLOAT, 0, 3, sizeof(QVector3D));
+        QOpenGLBuffer::release(QOpenGLBuffer::VertexBuffer); // the attribute keeps the buffer
+        return;
+    }
+
+    program->setAttributeArray(location, data.constData());
+}
+
+void VertexBufferManager::upload(Entry& entry, const QVector<QVector3D>& data)
+{
+    const int size = data.size();
+    const int uploadedSize = entry.uploaded.size();
+
+    if (size == uploadedSize && data.constData() == entry.uploaded.constData()) {
+        return;
+    }
+
+    if (size > entry.capacity) {
+        entry.capacity = std::max({ size, entry.capacity * 2, minCapacity_ });
+        entry.buffer.allocate(static_cast<int>(entry.capacity * sizeof(QVector3D)));
+        write(entry, data, 0, size);
+    }
+    else {
+        const int common = std::min(size, uploadedSize);
+        const int first = firstDifference(data.constData(), entry.uploaded.constData(), common);
+        const int last = lastDifference(data.constData(), entry.uploaded.constData(), first, common);
+
+        write(entry, data, first, last);
+        write(entry, data, uploadedSize, size); // appended
+    }
+
+    entry.uploaded = data;
+}
+
+void VertexBufferManager::write(Entry& entry, const QVector<QVector3D>& data, int from, int to)
+{
+    if (from >= to) {
+        return;
+    }
+
+    const int offset = static_cast<int>(from * sizeof(QVector3D));
+    const int count = static_cast<int>((to - from) * sizeof(QVector3D));
+    entry.buffer.write(offset, data.constData() + from, count);
+    uploadedBytes_ += count;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QHash>
+#include <QOpenGLBuffer>
+#include <QOpenGLShaderProgram>
+#include <QVector>
+#include <QVector3D>
+
+
+/*
+ * Keeps the vertex arrays of the scene in GPU buffers between frames. Every array is addressed by a key, the
+ * address of the container the render implementation draws from. On each frame the array is compared with
+ * the copy its buffer was last filled from and only the changed and the appended vertices are uploaded; an
+ * array that still shares storage with that copy cannot have changed (implicit sharing) and costs nothing.
+ * Lives on the render thread, the renderer makes it current for the duration of a frame.
+ */
+class VertexBufferManager
+{
+public:
+    /*methods*/
+    VertexBufferManager();
+    ~VertexBufferManager(); // the context of the buffers must be current
+
+    VertexBufferManager(const VertexBufferManager&) = delete;
+    VertexBufferManager& operator=(const VertexBufferManager&) = delete;
+
+    void beginFrame();
+    void endFrame(); // drops the buffers no key asked for during the last frames
+    void clear();
+
+    // leaves the buffer of the key bound to GL_ARRAY_BUFFER
+    bool bind(const void* key, const QVector<QVector3D>& data);
+    qint64 getUploadedBytes() const;
+    int getBuffersCount() const;
+
+    static VertexBufferManager* current();
+    // points the attribute at the vertices, from the buffer of the key when a manager is current, from client memory otherwise
+    static void setAttributeArray(QOpenGLShaderProgram* program, int location, const void* key, const QVector<QVector3D>& data);
+
+private:
+    /*structures*/
+    struct Entry {
+        QOpenGLBuffer buffer;
+        QVector<QVector3D> uploaded; // shares storage with what the buffer holds
+        int capacity = 0;            // vertices
+        quint64 lastFrame = 0;
+    };
+
+    /*methods*/
+    void upload(Entry& entry, const QVector<QVector3D>& data);
+    void write(Entry& entry, const QVector<QVector3D>& data, int from, int to);
+
+    /*data*/
+    static constexpr int minCapacity_ = 1024;
+    static constexpr quint64 keepFrames_ = 120;
+    static thread_local VertexBufferManager* current_;
+
+    QHash<const void*, Entry> entries_;
+    quint64 frame_;
+    qint64 uploadedBytes_;
+};
@@ -0,0 +1,464 @@
+#include "csv_export.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+
+namespace {
+
+// proleptic Gregorian date of a day count since 1970-01-01, the fields gmtime() gives without its static buffer
+void civilFromDays(qint64 days, int& year, int& month, int& day)
+{
+    days += 719468;
+    const qint64 era = (days >= 0 ? days : days - 146096) / 146097;
+    const qint64 doe = days - era * 146097;
+    const qint64 yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const qint64 doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const qint64 mp = (5 * doy + 2) / 153;
+
+    day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    year = static_cast<int>(yoe + era * 400 + (month <= 2 ? 1 : 0));
+}
+
+} // namespace
+
+
+CsvWriter::CsvWriter(QIODevice* dev, int flushSize) :
+    dev_(dev),
+    flushSize_(std::max(flushSize, maxFieldSize_)),
+    used_(0),
+    ok_(dev != nullptr)
+{
+    buffer_.resize(flushSize_ + maxFieldSize_);
+}
+
+void CsvWriter::addInt(qint64 value)
+{
+    char* out = reserve(24);
+    used_ += static_cast<int>(std::to_chars(out, out + 24, value).ptr - out);
+}
+
+void CsvWriter::addFixed(double value, int precision)
+{
+    if (std::isnan(value)) {
+        addText("nan");
+        return;
+    }
+
+    precision = std::clamp(precision, 0, 20);
+    char* out = reserve(maxFieldSize_);
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    used_ += static_cast<int>(std::to_chars(out, out + maxFieldSize_, value, std::chars_format::fixed, precision).ptr - out);
+#else
+    used_ += std::min(std::snprintf(out, maxFieldSize_, "%.*f", precision, value), maxFieldSize_ - 1);
+#endif
+}
+
+void CsvWriter::addGeneral(double value)
+{
+    if (std::isnan(value)) {
+        addText("nan");
+        return;
+    }
+
+    char* out = reserve(maxFieldSize_);
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    used_ += static_cast<int>(std::to_chars(out, out + maxFieldSize_, value, std::chars_format::general, 6).ptr - out);
+#else
+    used_ += std::min(std::snprintf(out, maxFieldSize_, "%g", value), maxFieldSize_ - 1);
+#endif
+}
+
+void CsvWriter::addText(const char* text)
+{
+    const int size = static_cast<int>(std::strlen(text));
+    if (size > maxFieldSize_) {
+        if (flush() && dev_->write(text, size) != size) {
+            ok_ = false;
+        }
+        return;
+    }
+
+    std::memcpy(reserve(size), text, size);
+    used_ += size;
+}
+
+void CsvWriter::addChar(char c)
+{
+    *reserve(1) = c;
+    ++used_;
+}
+
+void CsvWriter::endRow()
+{
+    addChar('\n');
+    if (used_ >= flushSize_) {
+        flush();
+    }
+}
+
+bool CsvWriter::flush()
+{
+    if (ok_ && used_ > 0 && dev_->write(buffer_.constData(), used_) != used_) {
+        ok_ = false;
+    }
+    used_ = 0;
+
+    return ok_;
+}
+
+bool CsvWriter::isOk() const
+{
+    return ok_;
+}
+
+char* CsvWriter::reserve(int size)
+{
+    if (used_ + size > buffer_.size()) {
+        flush();
+    }
+
+    return buffer_.data() + used_;
+}
+
+
+CsvExport::CsvExport(Dataset* datasetPtr, const std::atomic_bool* cancel) :
+    datasetPtr_(datasetPtr),
+    epochs_(std::make_shared<EpochSnapshot>(datasetPtr, cancel))
+{
+
+}
+
+CsvExport::PlotColumns CsvExport::plotColumns() const
+{
+    PlotColumns columns;
+    columns.externalLla = datasetPtr_->hasExternalLla();
+    columns.externalNed = datasetPtr_->hasExternalNed();
+
+    return columns;
+}
+
+bool CsvExport::writePlot(QIODevice* dev, const PlotColumns& columns, int channel, float decimation, const ProgressFunc& progress) const
+{
+    CsvWriter writer(dev);
+
+    if (columns.number) {
+        writer.addText("Number,");
+    }
+    if (columns.event) {
+        writer.addText("Event UNIX,Event timestamp,Event ID,");
+    }
+    if (columns.rangefinder) {
+        writer.addText("Rangefinder,");
+    }
+    if (columns.beamDistance) {
+        writer.addText("Beam distance,");
+    }
+    if (columns.position) {
+        writer.addText("Latitude,Longitude,");
+        if (columns.positionTime) {
+            writer.addText("GNSS UTC Date,GNSS UTC Time,");
+        }
+    }
+    if (columns.externalLla) {
+        writer.addText("ExtLatitude,ExtLongitude,ExtAltitude,");
+    }
+    if (columns.externalNed) {
+        writer.addText("ExtNorth,ExtEast,ExtHeight,");
+    }
+    if (columns.sonarHeight) {
+        writer.addText("SonarHeight,");
+    }
+    if (columns.bottomHeight) {
+        writer.addText("BottomHeight,");
+    }
+    writer.endRow();
+
+    int prevTimestamp = 0;
+    int prevUnix = 0;
+    int prevEventId = 0;
+    double prevLat = 0, prevLon = 0;
+
+    float decimationPath = 0;
+    LLARef llaRef;
+    NED lastPosNed;
+
+    const int rowCount = epochs_->size();
+    int lastPercent = -1;
+
+    for (int i = 0; i < rowCount; i++) {
+        if (!reportProgress(i, rowCount, lastPercent, progress)) {
+            return false;
+        }
+
+        Epoch* epoch = epochs_->epoch(i);
+        if (epoch == nullptr) {
+            continue;
+        }
+
+        if (decimation > 0) {
+            if (!epoch->isPosAvail()) {
+                continue;
+            }
+
+            Position pos = epoch->getPositionGNSS();
+            if (!pos.lla.isCoordinatesValid()) {
+                continue;
+            }
+
+            if (!llaRef.isInit) {
+                llaRef = LLARef(pos.lla);
+                pos.LLA2NED(&llaRef);
+                lastPosNed = pos.ned;
+            }
+            else {
+                pos.LLA2NED(&llaRef);
+                float difN = pos.ned.n - lastPosNed.n;
+                float difE = pos.ned.e - lastPosNed.e;
+                lastPosNed = pos.ned;
+                decimationPath += sqrtf(difN * difN + difE * difE);
+                if (decimationPath < decimation) {
+                    continue;
+                }
+                decimationPath -= decimation;
+            }
+        }
+
+        if (columns.number) {
+            writer.addInt(i);
+            writer.addChar(',');
+        }
+
+        if (columns.event) {
+            if (epoch->eventAvail()) {
+                prevTimestamp = epoch->eventTimestamp();
+                prevEventId = epoch->eventID();
+                prevUnix = epoch->eventUnix();
+            }
+            writer.addInt(prevUnix);
+            writer.addChar(',');
+            writer.addInt(prevTimestamp);
+            writer.addChar(',');
+            writer.addInt(prevEventId);
+            writer.addChar(',');
+        }
+
+        if (columns.rangefinder) {
+            if (epoch->distAvail()) {
+                writer.addGeneral(epoch->rangeFinder());
+            }
+            else {
+                writer.addChar('0');
+            }
+            writer.addChar(',');
+        }
+
+        if (columns.beamDistance) {
+            writer.addGeneral(static_cast<float>(epoch->distProccesing(channel)));
+            writer.addChar(',');
+        }
+
+        if (columns.position) {
+            if (epoch->isPosAvail()) {
+                prevLat = epoch->lat();
+                prevLon = epoch->lon();
+            }
+            writer.addFixed(prevLat, 8);
+            writer.addChar(',');
+            writer.addFixed(prevLon, 8);
+            writer.addChar(',');
+
+            if (columns.positionTime) {
+                if (epoch->isPosAvail() && epoch->positionTimeUnix() != 0) {
+                    const DateTime* dt = epoch->time();
+                    const qint64 sec = dt->sec > 0 ? dt->sec - 18 : dt->sec;
+                    const qint64 days = (sec >= 0 ? sec : sec - 86399) / 86400;
+                    const qint64 daySec = sec - days * 86400;
+
+                    int year = 0, month = 0, day = 0;
+                    civilFromDays(days, year, month, day);
+
+                    writer.addInt(year);
+                    writer.addChar('-');
+                    writer.addInt(month);
+                    writer.addChar('-');
+                    writer.addInt(day);
+                    writer.addChar(',');
+                    writer.addInt(daySec / 3600);
+                    writer.addChar(':');
+                    writer.addInt(daySec / 60 % 60);
+                    writer.addChar(':');
+                    writer.addGeneral(static_cast<double>(daySec % 60) + static_cast<double>(dt->nanoSec) / 1e9);
+                    writer.addChar(',');
+                }
+                else {
+                    writer.addText(",,");
+                }
+            }
+        }
+
+        if (columns.externalLla || columns.externalNed) {
+            Position position = epoch->getExternalPosition();
+
+            if (columns.externalLla) {
+                writer.addFixed(position.lla.latitude, 10);
+                writer.addChar(',');
+                writer.addFixed(position.lla.longitude, 10);
+                writer.addChar(',');
+                writer.addFixed(position.lla.altitude, 3);
+                writer.addChar(',');
+            }
+
+            if (columns.externalNed) {
+                writer.addFixed(position.ned.n, 10);
+                writer.addChar(',');
+                writer.addFixed(position.ned.e, 10);
+                writer.addChar(',');
+                writer.addFixed(-position.ned.d, 3);
+                writer.addChar(',');
+            }
+        }
+
+        const Epoch::Echogram* sensor = std::as_const(*epoch).chart(channel); // the const lookup does not detach the charts
+
+        if (columns.sonarHeight) {
+            if (sensor != nullptr && std::isfinite(sensor->sensorPosition.ned.d)) {
+                writer.addFixed(-sensor->sensorPosition.ned.d, 3);
+            }
+            else if (sensor != nullptr && std::isfinite(sensor->sensorPosition.lla.altitude)) {
+                writer.addFixed(sensor->sensorPosition.lla.altitude, 3);
+            }
+            writer.addChar(',');
+        }
+
+        if (columns.bottomHeight) {
+            if (sensor != nullptr && std::isfinite(sensor->bottomProcessing.bottomPoint.ned.d)) {
+                writer.addFixed(-sensor->bottomProcessing.bottomPoint.ned.d, 3);
+            }
+            else if (sensor != nullptr && std::isfinite(sensor->bottomProcessing.bottomPoint.lla.altitude)) {
+                writer.addFixed(sensor->bottomProcessing.bottomPoint.lla.altitude, 3);
+            }
+            writer.addChar(',');
+        }
+
+        writer.endRow();
+    }
+
+    return writer.flush();
+}
+
+bool CsvExport::writeComplex(QIODevice* dev, const ProgressFunc& progress) const
+{
+    CsvWriter writer(dev);
+
+    const int rowCount = epochs_->size();
+    int lastPercent = -1;
+
+    for (int i = 0; i < rowCount; i++) {
+        if (!reportProgress(i, rowCount, lastPercent, progress)) {
+            return false;
+        }
+
+        Epoch* epoch = epochs_->epoch(i);
+        if (epoch == nullptr || !epoch->isComplexSignalAvail()) {
+            continue;
+        }
+
+        const ComplexSignals sigs = epoch->complexSignals();
+        for (auto ch = sigs.cbegin(), end = sigs.cend(); ch != end; ++ch) {
+            const ComplexSignal& signal = ch.value();
+
+            writer.addInt(i);
+            writer.addChar(',');
+            writer.addInt(ch.key());
+            writer.addChar(',');
+            writer.addInt(signal.globalOffset);
+            writer.addChar(',');
+            writer.addGeneral(signal.sampleRate);
+
+            for (const ComplexF& sample : signal.data) {
+                writer.addChar(',');
+                writer.addGeneral(sample.real);
+                writer.addChar(',');
+                writer.addGeneral(sample.imag);
+            }
+
+            writer.endRow();
+        }
+    }
+
+    return writer.flush();
+}
+
+bool CsvExport::writeUsbl(QIODevice* dev, const ProgressFunc& progress) const
+{
+    CsvWriter writer(dev);
+    writer.addText("epoch,yaw,pitch,roll,north,east,ping_counter,carrier_counter,snr,azimuth_deg,elevation_deg,distance_m");
+    writer.endRow();
+
+    const int rowCount = epochs_->size();
+    int lastPercent = -1;
+
+    for (int i = 0; i < rowCount; i++) {
+        if (!reportProgress(i, rowCount, lastPercent, progress)) {
+            return false;
+        }
+
+        Epoch* epoch = epochs_->epoch(i);
+        if (epoch == nullptr || !epoch->isUsblSolutionAvailable()) {
+            continue;
+        }
+
+        const Position pos = epoch->getPositionGNSS();
+        const IDBinUsblSolution::UsblSolution solution = epoch->usblSolution();
+
+        writer.addInt(i);
+        writer.addChar(',');
+        writer.addGeneral(epoch->yaw());
+        writer.addChar(',');
+        writer.addGeneral(epoch->pitch());
+        writer.addChar(',');
+        writer.addGeneral(epoch->roll());
+        writer.addChar(',');
+        writer.addGeneral(pos.ned.n);
+        writer.addChar(',');
+        writer.addGeneral(pos.ned.e);
+        writer.addChar(',');
+        writer.addInt(solution.ping_counter);
+        writer.addChar(',');
+        writer.addInt(solution.carrier_counter);
+        writer.addChar(',');
+        writer.addGeneral(solution.snr);
+        writer.addChar(',');
+        writer.addGeneral(solution.azimuth_deg);
+        writer.addChar(',');
+        writer.addGeneral(solution.elevation_deg);
+        writer.addChar(',');
+        writer.addGeneral(solution.distance_m);
+        writer.endRow();
+    }
+
+    return writer.flush();
+}
+
+bool CsvExport::reportProgress(int index, int size, int& lastPercent, const ProgressFunc& progress) const
+{
+    if (!progress || size <= 0) {
+        return true;
+    }
+
+    const int percent = static_cast<int>(static_cast<qint64>(index) * 100 / size);
+    if (percent == lastPercent) {
+        return true;
+    }
+    lastPercent = percent;
+
+    return progress(percent);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <QByteArray>
+#include <QIODevice>
+#include "epoch_snapshot.h"
+#include "plotcash.h"
+
+
+/*
+ * Formats numbers straight into one large buffer and hands it to the device in blocks. Doubles are written
+ * with std::to_chars where the standard library has it and with snprintf otherwise, integers always with
+ * std::to_chars; the text is the same QString::arg and QString::number produce in the C locale.
+ */
+class CsvWriter
+{
+public:
+    /*methods*/
+    explicit CsvWriter(QIODevice* dev, int flushSize = 4 * 1024 * 1024);
+
+    void addInt(qint64 value);
+    void addFixed(double value, int precision); // as QString::number(value, 'f', precision)
+    void addGeneral(double value);              // as QString::arg(double), 6 significant digits
+    void addText(const char* text);
+    void addChar(char c);
+    void endRow();
+
+    bool flush();
+    bool isOk() const;
+
+private:
+    /*methods*/
+    char* reserve(int size);
+
+    /*data*/
+    static constexpr int maxFieldSize_ = 512; // fixed notation of the largest double with up to 20 decimals
+
+    QIODevice* dev_;
+    QByteArray buffer_;
+    int flushSize_;
+    int used_;
+    bool ok_;
+};
+
+
+/*
+ * Dataset exports to CSV. The columns are chosen before the first row is written, the rows are formatted by
+ * CsvWriter in one pass over the closed epochs. The epochs are read through an EpochSnapshot taken at
+ * construction, so a write may run on a worker thread while the dataset keeps filling and tracking.
+ */
+class CsvExport
+{
+public:
+    /*structures*/
+    using ProgressFunc = std::function<bool(int percent)>; // returning false stops the export
+
+    struct PlotColumns {
+        bool number = true;
+        bool event = true;
+        bool rangefinder = false;
+        bool beamDistance = true;
+        bool position = true;
+        bool positionTime = true;
+        bool externalLla = false;
+        bool externalNed = false;
+        bool sonarHeight = true;
+        bool bottomHeight = true;
+    };
+
+    /*methods*/
+    // on the thread of the dataset, cancel stops a write waiting for epochs
+    explicit CsvExport(Dataset* datasetPtr, const std::atomic_bool* cancel = nullptr);
+
+    PlotColumns plotColumns() const;
+
+    bool writePlot(QIODevice* dev, const PlotColumns& columns, int channel, float decimation, const ProgressFunc& progress) const;
+    bool writeComplex(QIODevice* dev, const ProgressFunc& progress) const;
+    bool writeUsbl(QIODevice* dev, const ProgressFunc& progress) const;
+
+private:
+    /*methods*/
+    bool reportProgress(int index, int size, int& lastPercent, const ProgressFunc& progress) const;
+
+    /*data*/
+    Dataset* datasetPtr_;
+    std::shared_ptr<EpochSnapshot> epochs_; // shared by the copies handed to the export thread
+};
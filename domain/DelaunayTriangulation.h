@@ -7,12 +7,12 @@
 #include <type_traits>
 #include <functional>
 #include <memory>
+#include <algorithm>
+#include <cstdint>
 
 #include "Triangle.h"
 #include "Point3D.h"
 
-#include <thread>
-
 template <typename T>
 class Delaunay
 {
@@ -34,6 +34,12 @@ public:
     T minEdgeLength() const {return mMinEdgeLength;};
 
     //! Triangulate input data
+    /*
+     * Incremental Bowyer-Watson over a triangle adjacency mesh. Points are inserted along a Hilbert curve, each one
+     * is located by walking from the triangle created last, and the cavity of triangles whose circum circle holds
+     * the point is grown from there through the neighbours. The super triangle is the same as before, so the
+     * result is the same triangulation, points repeating an inserted one are skipped.
+     */
     TrianglesPointer trinagulate(const std::vector <Point3D <T>>& points, T edgeLengthLimit = -1.0f)
     {
         if (points.empty())
@@ -41,109 +47,395 @@ public:
 
         mpTriangles->clear();
 
-        auto super = makeSuperTriangle(points);
+        clear();
+        insert(points);
 
-        mpTriangles->push_back(super);
+        mpTriangles->reserve(mFaces.size());
 
-        for (auto& point : points) {
+        for (int face = 0; face < facesCount(); ++face) {
+            if (hasTriangle(face, edgeLengthLimit))
+                mpTriangles->push_back(triangle(face));
+        }
 
-            std::vector <Edge <T>> polygon;
+        mChangedFaces.clear();
 
-            for (auto& triangle : *mpTriangles) {
-                if (triangle.circle().contains(point.toPoint2D())) {
-                    triangle.setWrong(true);
+        return mpTriangles;
+    }
 
-                    polygon.push_back(triangle.AB());
-                    polygon.push_back(triangle.AC());
-                    polygon.push_back(triangle.BC());
-                }
-            }
+    //! Drops the mesh, the next insert() starts a new one
+    void clear()
+    {
+        mPoints.clear();
+        mX.clear();
+        mY.clear();
+        mFaces.clear();
+        mMarks.clear();
+        mChangedFaces.clear();
+        mStamp = 0;
+        mLastFace = 0;
+    }
 
-            for (size_t i = 0; i < polygon.size(); i++) {
-                for (size_t j = 0; j < polygon.size(); j++) {
-                    if (i != j && polygon[i] == polygon[j]) {
-                        polygon[i].setWrong(true);
-                        break;
-                    }
-                }
+    //! Inserts points into the current mesh, the first call puts the super triangle around them.
+    //! Returns false and inserts nothing if a point lies outside the super triangle, the mesh has to be rebuilt then
+    bool insert(const std::vector <Point3D <T>>& points)
+    {
+        if (points.empty())
+            return true;
+
+        if (mFaces.empty()) {
+            const auto super = makeSuperTriangle(points);
+            mX = { super.A().x(), super.B().x(), super.C().x() };
+            mY = { super.A().y(), super.B().y(), super.C().y() };
+
+            Face superFace;
+            superFace.v[0] = 0;
+            superFace.v[1] = 1;
+            superFace.v[2] = 2;
+            if (orient(0, 1, 2) < 0)
+                std::swap(superFace.v[1], superFace.v[2]);
+            mFaces.push_back(superFace);
+            mMarks.push_back(0);
+            mChangedFaces.push_back(0);
+            mLastFace = 0;
+        }
+        else {
+            const T sign = orient(0, 1, 2) < 0 ? static_cast <T> (-1.0) : static_cast <T> (1.0);
+            for (const auto& point : points) {
+                if (!(sign * orientPoint(0, 1, point.x(), point.y()) > 0 &&
+                      sign * orientPoint(1, 2, point.x(), point.y()) > 0 &&
+                      sign * orientPoint(2, 0, point.x(), point.y()) > 0))
+                    return false;
             }
+        }
 
-            for (auto it = mpTriangles->begin(); it != mpTriangles->end();)
-            {
-                if (it->isWrong())
-                    it = mpTriangles->erase(it);
-                else ++it;
-            }
+        const int first = static_cast <int> (mX.size());
+        mPoints.insert(mPoints.end(), points.begin(), points.end());
+        mX.reserve(mX.size() + points.size());
+        mY.reserve(mY.size() + points.size());
+        for (const auto& point : points) {
+            mX.push_back(point.x());
+            mY.push_back(point.y());
+        }
+
+        mFaces.reserve(mFaces.size() + 2 * points.size());
+        mMarks.reserve(mFaces.capacity());
 
-            for (auto it = polygon.begin(); it != polygon.end();)
-            {
-                if (it->isWrong())
-                    it = polygon.erase(it);
-                else ++it;
+        for (int index : insertionOrder(points))
+            mLastFace = insertPoint(first + index, mLastFace);
+
+        return true;
+    }
+
+    //! Sets new heights of the inserted points starting from the input index, the mesh depends only on x and y,
+    //! so it stays and the triangles holding a changed point are reported as changed.
+    //! Returns false and changes nothing if a point is not inserted yet or has moved in the plane, the mesh has to be rebuilt then
+    bool updateHeights(int from, const std::vector <Point3D <T>>& points)
+    {
+        if (from < 0 || from + points.size() > mPoints.size())
+            return false;
+
+        for (size_t i = 0; i < points.size(); ++i) {
+            const Point3D <T>& point = mPoints[from + i];
+            if (point.x() != points[i].x() || point.y() != points[i].y())
+                return false;
+        }
+
+        std::vector <bool> raised(points.size(), false);
+        bool changed = false;
+        for (size_t i = 0; i < points.size(); ++i) {
+            Point3D <T>& point = mPoints[from + i];
+            if (point.z() != points[i].z()) {
+                point.setZ(points[i].z());
+                raised[i] = true;
+                changed = true;
             }
+        }
 
-            for (const auto& edge : polygon) {
-                Triangle <T> triangle(point, edge.p1(), edge.p2());
+        if (!changed)
+            return true;
 
-                mpTriangles->push_back(triangle);
+        const int first = superCount_ + from;
+        const int last = first + static_cast <int> (points.size());
+        for (int face = 0; face < facesCount(); ++face) {
+            for (int v : mFaces[face].v) {
+                if (v >= first && v < last && raised[v - first]) {
+                    mChangedFaces.push_back(face);
+                    break;
+                }
             }
         }
 
-        for (auto it = mpTriangles->begin(); it != mpTriangles->end();)
-        {   bool comp = it->contains(super.A()) || it->contains(super.B()) || it->contains(super.C());
+        return true;
+    }
+
+    //! Returns mesh slots created, rewritten or freed since the last call
+    std::vector <int> takeChangedFaces()
+    {
+        std::vector <int> changed;
+        changed.swap(mChangedFaces);
+        std::sort(changed.begin(), changed.end());
+        changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+        return changed;
+    }
+
+    //! Returns count of mesh slots, some of them may be free
+    int facesCount() const { return static_cast <int> (mFaces.size()); }
 
-            if(comp)
-                it = mpTriangles->erase(it);
-            else
-                it++;
+    //! Returns true if the mesh slot holds a triangle of input points with no edge over the limit
+    bool hasTriangle(int face, T edgeLengthLimit = -1.0f) const
+    {
+        const Face& f = mFaces[face];
+        if (f.v[0] < superCount_ || f.v[1] < superCount_ || f.v[2] < superCount_)
+            return false;
+
+        if (edgeLengthLimit == -1)
+            return true;
+
+        // planar length, as Edge measures it
+        for (int i = 0; i < 3; ++i) {
+            const int a = f.v[i];
+            const int b = f.v[(i + 1) % 3];
+            if (std::sqrt(std::pow(mX[b] - mX[a], 2) + std::pow(mY[b] - mY[a], 2)) > edgeLengthLimit)
+                return false;
         }
 
-        if(edgeLengthLimit != -1){
-            for (auto it = mpTriangles->begin(); it != mpTriangles->end();)
-            {
-                bool comp_2 = it->AB().length() > edgeLengthLimit || it->BC().length() > edgeLengthLimit || it->AC().length() > edgeLengthLimit;
+        return true;
+    }
+
+    //! Triangle of the mesh slot, valid only if hasTriangle() is true for it
+    Triangle <T> triangle(int face) const
+    {
+        const Face& f = mFaces[face];
+        return Triangle <T>(mPoints[f.v[0] - superCount_], mPoints[f.v[1] - superCount_], mPoints[f.v[2] - superCount_]);
+    }
+
+private:
+
+    //! Mesh triangle, counterclockwise; n[i] is the neighbour across the edge opposite v[i], -1 on the outer border
+    struct Face {
+        int v[3] = { -1, -1, -1 };
+        int n[3] = { -1, -1, -1 };
+    };
+
+    struct CavityEdge {
+        int a;
+        int b;
+        int outer;
+        int inner;
+    };
+
+    T orient(int a, int b, int c) const
+    {
+        return (mX[b] - mX[a]) * (mY[c] - mY[a]) - (mY[b] - mY[a]) * (mX[c] - mX[a]);
+    }
+
+    T orientPoint(int a, int b, T px, T py) const
+    {
+        return (mX[b] - mX[a]) * (py - mY[a]) - (mY[b] - mY[a]) * (px - mX[a]);
+    }
 
-                if (comp_2){
-                    it = mpTriangles->erase(it);
-                }else{
-                    ++it;
+    //! Positive if the point is inside the circum circle of the face, zero on it
+    T inCircle(const Face& face, T px, T py) const
+    {
+        const T adx = mX[face.v[0]] - px, ady = mY[face.v[0]] - py;
+        const T bdx = mX[face.v[1]] - px, bdy = mY[face.v[1]] - py;
+        const T cdx = mX[face.v[2]] - px, cdy = mY[face.v[2]] - py;
+
+        return (adx * adx + ady * ady) * (bdx * cdy - cdx * bdy) +
+               (bdx * bdx + bdy * bdy) * (cdx * ady - adx * cdy) +
+               (cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+    }
+
+    int locate(int start, T px, T py)
+    {
+        int f = start;
+        size_t steps = 0;
+
+        while (true) {
+            const Face& face = mFaces[f];
+            int next = -1;
+
+            for (int k = 0; k < 3; ++k) {
+                const int i = (k + static_cast <int> (steps)) % 3; // rotating the first edge keeps the walk from cycling
+                if (face.n[i] >= 0 && orientPoint(face.v[(i + 1) % 3], face.v[(i + 2) % 3], px, py) < 0) {
+                    next = face.n[i];
+                    break;
                 }
             }
+
+            if (next < 0)
+                return f;
+
+            f = next;
+
+            if (++steps > mFaces.size())
+                break;
         }
 
-        return mpTriangles;
+        for (size_t i = 0; i < mFaces.size(); ++i) {
+            const Face& face = mFaces[i];
+            if (face.v[0] >= 0 &&
+                orientPoint(face.v[0], face.v[1], px, py) >= 0 &&
+                orientPoint(face.v[1], face.v[2], px, py) >= 0 &&
+                orientPoint(face.v[2], face.v[0], px, py) >= 0)
+                return static_cast <int> (i);
+        }
+
+        return start;
     }
 
-    TrianglesPointer trinagulate_2(const std::vector <Point3D <T>>& points, T edgeLengthLimit = -1.0f)
+    //! Returns a triangle created for the point to start the next walk from
+    int insertPoint(int p, int hint)
     {
+        const T px = mX[p];
+        const T py = mY[p];
 
-        Q_UNUSED(edgeLengthLimit)
+        const int start = locate(hint, px, py);
 
-        mpTriangles->clear();
+        for (int i = 0; i < 3; ++i) {
+            const int v = mFaces[start].v[i];
+            if (mX[v] == px && mY[v] == py)
+                return start;
+        }
 
-        if(points.size() < 3){
-            return nullptr;
+        ++mStamp;
+        mCavity.clear();
+        mCavity.push_back(start);
+        mMarks[start] = mStamp;
+
+        for (size_t k = 0; k < mCavity.size(); ++k) {
+            const Face face = mFaces[mCavity[k]];
+            for (int i = 0; i < 3; ++i) {
+                const int nb = face.n[i];
+                if (nb < 0 || mMarks[nb] == mStamp)
+                    continue;
+
+                // a border edge the point does not see would break the star around it, that triangle goes too
+                if (inCircle(mFaces[nb], px, py) >= 0 ||
+                    orientPoint(face.v[(i + 1) % 3], face.v[(i + 2) % 3], px, py) <= 0) {
+                    mMarks[nb] = mStamp;
+                    mCavity.push_back(nb);
+                }
+            }
+        }
+
+        mBorder.clear();
+        for (int f : mCavity) {
+            const Face& face = mFaces[f];
+            for (int i = 0; i < 3; ++i) {
+                const int nb = face.n[i];
+                if (nb >= 0 && mMarks[nb] == mStamp)
+                    continue;
+                mBorder.push_back({ face.v[(i + 1) % 3], face.v[(i + 2) % 3], nb, f });
+            }
+        }
+
+        // cavity triangles are reused first, the border always has two edges more than the cavity has triangles
+        mCreated.clear();
+        for (size_t k = 0; k < mBorder.size(); ++k) {
+            int id;
+            if (k < mCavity.size()) {
+                id = mCavity[k];
+            }
+            else {
+                id = static_cast <int> (mFaces.size());
+                mFaces.push_back(Face());
+                mMarks.push_back(0);
+            }
+            mCreated.push_back(id);
+            mChangedFaces.push_back(id);
         }
 
-        // Сортируем точки вдоль оси x
+        for (size_t k = 0; k < mBorder.size(); ++k) {
+            const CavityEdge& edge = mBorder[k];
+            Face& face = mFaces[mCreated[k]];
+            face.v[0] = edge.a;
+            face.v[1] = edge.b;
+            face.v[2] = p;
+            face.n[0] = -1;
+            face.n[1] = -1;
+            face.n[2] = edge.outer;
+
+            if (edge.outer >= 0) {
+                Face& outer = mFaces[edge.outer];
+                for (int i = 0; i < 3; ++i) {
+                    if (outer.n[i] == edge.inner &&
+                        outer.v[(i + 1) % 3] == edge.b && outer.v[(i + 2) % 3] == edge.a) {
+                        outer.n[i] = mCreated[k];
+                        break;
+                    }
+                }
+            }
+        }
 
-        std::sort(points.begin(), points.end(),
-                  [](const Point3D <T>& p1, const Point3D <T>& p2){
-            return p1.x() < p2.x();
-        });
+        // the new triangles form a fan around the point: (a, b, p) meets (b, c, p) across b-p
+        mFanStarts.clear();
+        for (size_t k = 0; k < mBorder.size(); ++k)
+            mFanStarts.push_back({ mBorder[k].a, mCreated[k] });
+        std::sort(mFanStarts.begin(), mFanStarts.end());
+
+        for (size_t k = 0; k < mBorder.size(); ++k) {
+            const int b = mBorder[k].b;
+            auto it = std::lower_bound(mFanStarts.begin(), mFanStarts.end(), std::make_pair(b, std::numeric_limits <int>::min()));
+            if (it != mFanStarts.end() && it->first == b) {
+                mFaces[mCreated[k]].n[0] = it->second;
+                mFaces[it->second].n[1] = mCreated[k];
+            }
+        }
 
-        // Строим стартовый треугольник по первым трем точкам
-        Triangle <T> baseTriangle{points.at(0),points.at(1),points.at(2)};
+        for (size_t k = mBorder.size(); k < mCavity.size(); ++k) {
+            mFaces[mCavity[k]] = Face();
+            mChangedFaces.push_back(mCavity[k]);
+        }
 
-        return nullptr;
+        return mCreated.front();
     }
 
-private:
-
-    bool isCollinear(Point3D <T>& p1, Point3D <T>& p2, Point3D <T>& p3)
+    //! Hilbert curve order of the points, neighbouring insertions land in neighbouring triangles
+    std::vector <int> insertionOrder(const std::vector <Point3D <T>>& points) const
     {
-        auto s = 0.5 * abs((p2.x() - p1.x()) * (p3.y() - p1.y()) - (p3.x() - p1.x()) * (p2.y() - p1.y()));
-        return s == 0;
+        const int count = static_cast <int> (points.size());
+
+        T minX = points.front().x(), maxX = minX;
+        T minY = points.front().y(), maxY = minY;
+        for (const auto& point : points) {
+            minX = std::min(minX, point.x());
+            maxX = std::max(maxX, point.x());
+            minY = std::min(minY, point.y());
+            maxY = std::max(maxY, point.y());
+        }
+
+        const uint32_t side = 1u << 16;
+        const T span = std::max(std::max(maxX - minX, maxY - minY), std::numeric_limits <T>::min());
+        const T scale = static_cast <T> (side - 1) / span;
+
+        std::vector <std::pair <uint64_t, int>> keys(count);
+        for (int i = 0; i < count; ++i) {
+            uint32_t x = static_cast <uint32_t> ((points[i].x() - minX) * scale);
+            uint32_t y = static_cast <uint32_t> ((points[i].y() - minY) * scale);
+            uint64_t d = 0;
+            for (uint32_t s = side / 2; s > 0; s /= 2) {
+                const uint32_t rx = (x & s) > 0;
+                const uint32_t ry = (y & s) > 0;
+                d += static_cast <uint64_t> (s) * s * ((3 * rx) ^ ry);
+                if (ry == 0) {
+                    if (rx == 1) {
+                        x = side - 1 - x;
+                        y = side - 1 - y;
+                    }
+                    std::swap(x, y);
+                }
+            }
+            keys[i] = { d, i };
+        }
+
+        std::sort(keys.begin(), keys.end());
+
+        std::vector <int> order(count);
+        for (int i = 0; i < count; ++i)
+            order[i] = keys[i].second;
+
+        return order;
     }
 
     Triangle <T> makeSuperTriangle(const std::vector <Point3D<T>>& points) {
@@ -175,9 +467,23 @@ private:
         return { p1,p2,p3 };
     }
 
+    static constexpr int superCount_ = 3; ///< Super triangle vertices come first in mX, mY
+
     TrianglesPointer mpTriangles;
 
+    std::vector <Point3D <T>> mPoints;
+    std::vector <T> mX;
+    std::vector <T> mY;
+    std::vector <Face> mFaces;
+    std::vector <uint32_t> mMarks; ///< Insertion stamp of the cavity a face was added to
+    uint32_t mStamp = 0;
+    std::vector <int> mCavity;
+    std::vector <CavityEdge> mBorder;
+    std::vector <int> mCreated;
+    std::vector <std::pair <int, int>> mFanStarts;
+    std::vector <int> mChangedFaces;
+    int mLastFace = 0;
+
     T mMaxEdgeLength = static_cast <T> (0);
     T mMinEdgeLength = static_cast <T> (0);
 };
-
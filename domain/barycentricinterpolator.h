@@ -2,6 +2,7 @@
 #define BARYCENTRICINTERPOLATOR_H
 
 #include "Triangle.h"
+#include "trianglespatialindex.h"
 
 template <typename T>
 class BarycentricInterpolator
@@ -16,14 +17,13 @@ public:
     void process(std::vector <Triangle <T>>& triangles,
                  std::vector <Point3D <T>>& data)
     {
-        for (auto& p : data){
-            auto t = triangles.begin();
-            while (t != triangles.end() && !t->contains(p)){
-                t++;
-            }
+        TriangleSpatialIndex <T> index;
+        index.build(triangles);
 
-            if (t != triangles.end())
-                calculateZ(*t, p);
+        for (auto& p : data){
+            const int t = index.find(p);
+            if (t >= 0)
+                calculateZ(triangles[t], p);
         }
     }
 
@@ -39,6 +39,16 @@ public:
             calculateZ(*t, point);
     }
 
+    /**
+     * @brief Выполняет интерполяцию z - координаты точки по уже найденному треугольнику.
+     * @param triangle Треугольник, содержащий точку.
+     * @param point Интерполируемая точка.
+     */
+    void interpolate(Triangle <T>& triangle, Point3D <T>& point)
+    {
+        calculateZ(triangle, point);
+    }
+
 private:
 
     /**
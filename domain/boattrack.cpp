@@ -47,6 +47,34 @@ void BoatTrack::setSelectedIndices(const QHash<int, int> &selectedIndices)
     selectedIndices_ = selectedIndices;
 }
 
+void BoatTrack::updateData()
+{
+    if (!datasetPtr_) {
+        return;
+    }
+
+    const QVector<QVector3D>& track = datasetPtr_->boatTrack();
+    const auto& current = m_renderImpl->cdata();
+    int from = current.size();
+
+    // the dataset track only grows, a shorter or different one was rebuilt
+    if (track.size() < from || (from > 0 && track.at(from - 1) != current.at(from - 1))) {
+        from = 0;
+    }
+    if (from == track.size()) {
+        return;
+    }
+
+    auto r = RENDER_IMPL(BoatTrack);
+    if (from == 0) {
+        r->clearData();
+    }
+    r->appendData(track.constData() + from, track.size() - from, GL_LINE_STRIP);
+
+    Q_EMIT changed();
+    Q_EMIT boundsChanged();
+}
+
 void BoatTrack::setData(const QVector<QVector3D> &data, int primitiveType)
 {
     SceneObject::setData(data, primitiveType);
@@ -39,6 +39,8 @@ public:
     virtual bool eventFilter(QObject *watched, QEvent *event) override final;
     void setDatasetPtr(Dataset* datasetPtr);
     void setSelectedIndices(const QHash<int, int>& selectedIndices);
+    // appends the vertices the boat track of the dataset got since the last call
+    void updateData();
 
 public Q_SLOTS:
     virtual void setData(const QVector<QVector3D>& data, int primitiveType = GL_POINTS) override final;
@@ -3,14 +3,17 @@
 #include <epochevent.h>
 //#include <textrenderer.h> TODO
 #include <draw_utils.h>
+#include <vertex_buffer_manager.h>
 #include "boattrack.h"
 #include <QOpenGLFunctions>
 
 #include <QHash>
+#include <climits>
 
 BottomTrack::BottomTrack(GraphicsScene3dView* view, QObject* parent) :
     SceneObject(new BottomTrackRenderImplementation, view, parent),
-    datasetPtr_(nullptr)
+    datasetPtr_(nullptr),
+    rewrittenFrom_(0)
 {
 
 }
@@ -58,10 +61,20 @@ void BottomTrack::setDatasetPtr(Dataset* datasetPtr) {
     datasetPtr_ = datasetPtr;
 }
 
+int BottomTrack::rewrittenFrom() const
+{
+    return rewrittenFrom_;
+}
+
+void BottomTrack::resetRewrittenFrom()
+{
+    rewrittenFrom_ = INT_MAX;
+}
+
 void BottomTrack::actionEvent(ActionEvent actionEvent)
 {
     auto minMaxFunc = [this](bool isMin) -> void {
-        const auto indices{ RENDER_IMPL(BottomTrack)->selectedVertexIndices_ };
+        const auto indices{ RENDER_IMPL_CONST(BottomTrack)->selectedVertexIndices_ };
         if (!indices.isEmpty()) {
             QVector<int> sequenceVector;
             sequenceVector.reserve(indices.size());
@@ -97,9 +110,6 @@ void BottomTrack::actionEvent(ActionEvent actionEvent)
                     break;
                 }
             }
-
-            updateRenderData();
-            emit datasetPtr_->dataUpdate();
         }
     };
 
@@ -108,7 +118,7 @@ void BottomTrack::actionEvent(ActionEvent actionEvent)
         break;
     }
     case ActionEvent::ClearDistProc: {
-        const auto indices{ RENDER_IMPL(BottomTrack)->selectedVertexIndices_ };
+        const auto indices{ RENDER_IMPL_CONST(BottomTrack)->selectedVertexIndices_ };
 
         if (!indices.isEmpty()) {
             bool isSomethingDeleted{ false };
@@ -165,16 +175,20 @@ void BottomTrack::setData(const QVector<QVector3D> &data, int primitiveType)
         QVector <QVector3D> filteredData;
         m_filter->apply(data, filteredData);
         SceneObject::setData(filteredData, primitiveType);
+        rewrittenFrom_ = 0;
         return;
     }
 
     SceneObject::setData(data, primitiveType);
+    rewrittenFrom_ = 0;
 }
 
 void BottomTrack::clearData()
 {
     epochIndexMatchingMap_.clear();
+    verticeIndexMatchingMap_.clear();
     renderData_.clear();
+    rewrittenFrom_ = 0;
     visibleChannel_ = DatasetChannel();
 
     auto r = RENDER_IMPL(BottomTrack);
@@ -222,7 +236,7 @@ void BottomTrack::selectEpoch(int epochIndex, int channelId)
         return;
 
     auto* epoch = datasetPtr_->fromIndex(epochIndex);
-    auto indxFromMap = epochIndexMatchingMap_.key(epochIndex);
+    auto indxFromMap = verticeIndexMatchingMap_.value(epochIndex);
 
     if (!epoch ||
         !epoch->getPositionGNSS().ned.isCoordinatesValid() ||
@@ -284,8 +298,8 @@ void BottomTrack::mouseMoveEvent(Qt::MouseButtons buttons, qreal x, qreal y)
 
     if(m_view->m_mode == GraphicsScene3dView::BottomTrackVertexComboSelectionMode) {
         RENDER_IMPL(BottomTrack)->selectedVertexIndices_.clear();
-        for (int i = 0; i < RENDER_IMPL(BottomTrack)->m_data.size(); i++) {
-            auto p = RENDER_IMPL(BottomTrack)->m_data.at(i);
+        for (int i = 0; i < RENDER_IMPL_CONST(BottomTrack)->m_data.size(); i++) {
+            auto p = RENDER_IMPL_CONST(BottomTrack)->m_data.at(i);
             auto p_screen = p.project(m_view->camera().lock()->viewMatrix()*m_view->m_model,
                             m_view->m_projection,
                             m_view->boundingRect().toRect());
@@ -345,7 +359,7 @@ void BottomTrack::keyPressEvent(Qt::Key key)
         return;
 
     if (m_view->m_mode == GraphicsScene3dView::BottomTrackVertexSelectionMode && key == Qt::Key_Delete) {
-        const auto indices{ RENDER_IMPL(BottomTrack)->selectedVertexIndices_ };
+        const auto indices{ RENDER_IMPL_CONST(BottomTrack)->selectedVertexIndices_ };
         bool isSomethingDeleted{ false };
         for (const auto& verticeIndex : indices) {
             const auto epochIndx{ epochIndexMatchingMap_.value(verticeIndex) };
@@ -363,7 +377,7 @@ void BottomTrack::keyPressEvent(Qt::Key key)
     }
 
     if (key == Qt::Key_Delete) {
-        const auto indices{ RENDER_IMPL(BottomTrack)->selectedVertexIndices_ };
+        const auto indices{ RENDER_IMPL_CONST(BottomTrack)->selectedVertexIndices_ };
         if (!indices.isEmpty()) {
             bool isSomethingDeleted{ false };
             for (const auto& verticeIndex : indices) {
@@ -391,65 +405,74 @@ void BottomTrack::updateRenderData(int lEpoch, int rEpoch)
 
     RENDER_IMPL(BottomTrack)->selectedVertexIndices_.clear();
 
-    if (defMode) {
-        epochIndexMatchingMap_.clear();
-        renderData_.clear();
-    }
-
     bool beenUpdated{ false };
     auto appendData = [&, this](Position& pos, float distance, int i) ->void {
         renderData_.append(QVector3D(pos.ned.n, pos.ned.e, distance));
         epochIndexMatchingMap_.insert(renderData_.size() - 1, i);
+        verticeIndexMatchingMap_.insert(i, renderData_.size() - 1);
         beenUpdated = true;
     };
 
+    auto rebuildData = [&, this]() ->void {
+        epochIndexMatchingMap_.clear();
+        verticeIndexMatchingMap_.clear();
+        renderData_.clear();
+        rewrittenFrom_ = 0;
+        int currMax = datasetPtr_->getLastBottomTrackEpoch();
+        renderData_.reserve(currMax);
+        for (int i = 0; i < currMax; ++i) {
+            if (auto epoch = datasetPtr_->fromIndex(i); epoch) {
+                auto pos = epoch->getPositionGNSS();
+                if (pos.ned.isCoordinatesValid()) {
+                    float distance = -1.f * static_cast<float>(epoch->distProccesing(visibleChannel_.channel));
+                    appendData(pos, distance, i);
+                }
+            }
+        }
+    };
+
     if (visibleChannel_.channel > -1) {
-        int currMin = defMode ? 0 : lEpoch;
-        int currMax = defMode ? datasetPtr_->getLastBottomTrackEpoch() : rEpoch;
-        if (defMode)
-            renderData_.reserve(currMax);
-        for (int i = currMin; i < currMax; ++i) {
-            auto epoch = datasetPtr_->fromIndex(i);
-            if (!epoch)
-                continue;
-
-            auto pos = epoch->getPositionGNSS();
-
-            if (pos.ned.isCoordinatesValid()) {
+        if (defMode) {
+            rebuildData();
+        }
+        else {
+            // vertices follow the epoch order, so only epochs past the last vertex can be appended
+            int lastVerticeEpoch = renderData_.isEmpty() ? -1 : epochIndexMatchingMap_.value(renderData_.size() - 1, -1);
+            for (int i = lEpoch; i < rEpoch; ++i) {
+                auto epoch = datasetPtr_->fromIndex(i);
+                if (!epoch)
+                    continue;
+
+                auto pos = epoch->getPositionGNSS();
+                if (!pos.ned.isCoordinatesValid())
+                    continue;
+
                 float distance = -1.f * static_cast<float>(epoch->distProccesing(visibleChannel_.channel));
-                if (defMode) {
+                if (auto it = verticeIndexMatchingMap_.constFind(i); it != verticeIndexMatchingMap_.constEnd()) {
+                    const QVector3D vertice(pos.ned.n, pos.ned.e, distance);
+                    if (renderData_.at(it.value()) != vertice) {
+                        renderData_[it.value()] = vertice;
+                        rewrittenFrom_ = qMin(rewrittenFrom_, it.value());
+                        beenUpdated = true;
+                    }
+                }
+                else if (i > lastVerticeEpoch) {
                     appendData(pos, distance, i);
+                    lastVerticeEpoch = i;
                 }
-                else {
-                    for (int j = 0; j < renderData_.size(); ++j) { // first - find correct point by pos
-                        if (renderData_[j].x() == static_cast<float>(pos.ned.n) &&
-                            renderData_[j].y() == static_cast<float>(pos.ned.e)) {
-                            renderData_[j] = QVector3D(pos.ned.n, pos.ned.e, distance);
-                            epochIndexMatchingMap_[j] = i;
-                            beenUpdated = true;
-                            break;
-                        }
-                    }
-                    if (!beenUpdated) { // rewrite cause we have new undefined epoch (undef pos left, mid, right)
-                        epochIndexMatchingMap_.clear();
-                        renderData_.clear();
-                        int cCurrMin = 0;
-                        int cCurrMax = datasetPtr_->getLastBottomTrackEpoch();
-                        renderData_.reserve(cCurrMax);
-                        for (int k = cCurrMin; k < cCurrMax; ++k) {
-                            if (auto cEpoch = datasetPtr_->fromIndex(k); cEpoch) {
-                                auto cPos = cEpoch->getPositionGNSS();
-                                if (cPos.ned.isCoordinatesValid()) {
-                                    float cDistance = -1.f * static_cast<float>(cEpoch->distProccesing(visibleChannel_.channel));
-                                    appendData(cPos, cDistance, k);
-                                }
-                            }
-                        }
-                    }
+                else { // rewrite cause we have new undefined epoch between the vertices
+                    rebuildData();
+                    break;
                 }
             }
         }
     }
+    else if (defMode) {
+        epochIndexMatchingMap_.clear();
+        verticeIndexMatchingMap_.clear();
+        renderData_.clear();
+        rewrittenFrom_ = 0;
+    }
 
     if (beenUpdated && !renderData_.empty()) {
         SceneObject::setData(renderData_, GL_LINE_STRIP);
@@ -535,7 +558,7 @@ void BottomTrack::BottomTrackRenderImplementation::render(QOpenGLFunctions *ctx,
 
     shaderProgram->setUniformValue(matrixLoc, projection * view * model);
     shaderProgram->enableAttributeArray(posLoc);
-    shaderProgram->setAttributeArray(posLoc, m_data.constData());
+    VertexBufferManager::setAttributeArray(shaderProgram, posLoc, &m_data, m_data);
 
     ctx->glLineWidth(4.0);
     ctx->glDrawArrays(m_primitiveType, 0, m_data.size());
@@ -54,6 +54,8 @@ public:
     DatasetChannel visibleChannel() const;
     void setDatasetPtr(Dataset* datasetPtr);
     void actionEvent(ActionEvent actionEvent);
+    int rewrittenFrom() const; // lowest vertex changed in place since resetRewrittenFrom(), INT_MAX if none
+    void resetRewrittenFrom();
 
 public Q_SLOTS:
     virtual void setData(const QVector<QVector3D>& data, int primitiveType = GL_POINTS) override;
@@ -92,7 +94,9 @@ private:
     using EpochIndex = int;
     using VerticeIndex = int;
     QHash<VerticeIndex,EpochIndex> epochIndexMatchingMap_;
+    QHash<EpochIndex,VerticeIndex> verticeIndexMatchingMap_;
     DatasetChannel visibleChannel_;
     Dataset* datasetPtr_;
     QVector<QVector3D> renderData_;
+    int rewrittenFrom_;
 };
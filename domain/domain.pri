@@ -27,6 +27,7 @@ HEADERS += \
     $$PWD/polygonobject.h \
     $$PWD/surface.h \
     $$PWD/gridgenerator.h \
+    $$PWD/trianglespatialindex.h \
     $$PWD/surfacegrid.h \
     $$PWD/vertexeditingdecorator.h \
     $$PWD/navigation_arrow.h \
@@ -34,6 +35,7 @@ HEADERS += \
     $$PWD/side_scan_view.h \
     $$PWD/global_mesh.h \
     $$PWD/tile.h \
+    $$PWD/tile_store.h \
     $$PWD/image_view.h
 SOURCES += \
     $$PWD/boattrack.cpp \
@@ -55,4 +57,5 @@ SOURCES += \
     $$PWD/side_scan_view.cpp \
     $$PWD/global_mesh.cpp \
     $$PWD/tile.cpp \
+    $$PWD/tile_store.cpp \
     $$PWD/image_view.cpp
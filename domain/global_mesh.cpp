@@ -1,5 +1,6 @@
 #include "global_mesh.h"
 
+#include <algorithm>
 #include <cmath>
 #include "side_scan_view.h"
 
@@ -9,8 +10,12 @@ using namespace sscan;
 GlobalMesh::GlobalMesh(SideScanView* ssPtr, int tileSidePixelSize, int tileHeightMatrixRatio, float tileResolution) :
     ssPtr_(ssPtr),
     tileResolution_(tileResolution),
+    tileMemoryBudget_(defaultTileMemoryBudget_),
+    useCounter_(0),
     numWidthTiles_(0),
     numHeightTiles_(0),
+    columnsShift_(0),
+    rowsShift_(0),
     tileSidePixelSize_(tileSidePixelSize),
     tileHeightMatrixRatio_(tileHeightMatrixRatio),
     generateGridContour_(false)
@@ -19,7 +24,9 @@ GlobalMesh::GlobalMesh(SideScanView* ssPtr, int tileSidePixelSize, int tileHeigh
 }
 
 GlobalMesh::~GlobalMesh()
-{ }
+{
+    clear();
+}
 
 void GlobalMesh::reinit(int tileSidePixelSize, int tileHeightMatrixRatio, float tileResolution)
 {
@@ -38,7 +45,7 @@ bool GlobalMesh::concatenate(MatrixParams &actualMatParams)
         return false;
     }
 
-    if (tileMatrix_.empty()) {
+    if (numWidthTiles_ == 0) {
         int newNumWidthTiles = std::ceil(actualMatParams.width * 1.0f / tileSideMeterSize_);
         int newNumHeightTiles = std::ceil(actualMatParams.height * 1.0f / tileSideMeterSize_);
 
@@ -99,11 +106,11 @@ void GlobalMesh::printMatrix() const
     qDebug() << "origin:" << origin_;
     qDebug() << "tiles (WxH): " << numWidthTiles_ << "x" << numHeightTiles_;;
 
-    for (auto& itmI : tileMatrix_) {
+    for (int i = 0; i < numHeightTiles_; ++i) {
         QString rowOutput;
-        for (auto& itmJ : itmI) {
-            if (itmJ) {
-                auto tileOrigin = itmJ->getOrigin();
+        for (int j = 0; j < numWidthTiles_; ++j) {
+            if (auto* tilePtr = getTilePtr(j, i); tilePtr) {
+                auto tileOrigin = tilePtr->getOrigin();
                 rowOutput += QString("[" + QString::number(tileOrigin.x(), 'f', 0) +
                                      "x" +  QString::number(tileOrigin.y(), 'f', 0) + "]").rightJustified(10);
             }
@@ -119,14 +126,95 @@ void GlobalMesh::printMatrix() const
 void GlobalMesh::clear()
 {
     origin_ = QVector3D();
-    for (auto& itm: tiles_) {
+    for (auto* itm : std::as_const(tiles_)) {
         delete itm;
     }
     tiles_.clear();
-    tileMatrix_.clear();
+    tilesById_.clear();
+    residentTiles_.clear();
+    tileStore_.clear();
+    useCounter_ = 0;
 
     numWidthTiles_ = 0;
     numHeightTiles_ = 0;
+    columnsShift_ = 0;
+    rowsShift_ = 0;
+}
+
+Tile* GlobalMesh::createTilePtr(int meshIndxX, int meshIndxY)
+{
+    if (meshIndxX < 0 || meshIndxX >= numWidthTiles_ || meshIndxY < 0 || meshIndxY >= numHeightTiles_) {
+        return nullptr;
+    }
+
+    Tile*& tileRef = tiles_[getTileKey(meshIndxX, meshIndxY)];
+    if (!tileRef) {
+        tileRef = new Tile({ origin_.x() + meshIndxX * tileSideMeterSize_,
+                             origin_.y() + ((numHeightTiles_ - 1) - meshIndxY) * tileSideMeterSize_, 0.0f }, generateGridContour_);
+        tilesById_.insert(tileRef->getUuid(), tileRef);
+    }
+
+    return tileRef;
+}
+
+bool GlobalMesh::makeTileResident(Tile* tilePtr)
+{
+    if (!tilePtr || !tilePtr->getIsInited()) {
+        return false;
+    }
+
+    auto it = residentTiles_.find(tilePtr);
+    if (it != residentTiles_.end()) {
+        it.value() = ++useCounter_;
+        return true;
+    }
+
+    if (tileStore_.contains(tilePtr->getUuid()) && !tileStore_.read(tilePtr->getUuid(), tilePtr->getImageDataRef())) {
+        tilePtr->getImageDataRef().assign(tileSidePixelSize_ * tileSidePixelSize_, 0);
+    }
+    tilePtr->restoreLodImages();
+
+    residentTiles_.insert(tilePtr, ++useCounter_);
+
+    return true;
+}
+
+void GlobalMesh::trimResidentTiles(const QSet<Tile*>& keepTiles)
+{
+    // every tile keeps its lod images, a resident one its image as well
+    qint64 usedBytes = 0;
+    for (auto* tilePtr : std::as_const(tiles_)) {
+        usedBytes += static_cast<qint64>(tilePtr->getImageDataRef().size()) + tilePtr->getLodBytes();
+    }
+    if (usedBytes <= tileMemoryBudget_) {
+        return;
+    }
+
+    std::vector<std::pair<quint64, Tile*>> byLastUse;
+    byLastUse.reserve(residentTiles_.size());
+    for (auto it = residentTiles_.cbegin(); it != residentTiles_.cend(); ++it) {
+        if (!keepTiles.contains(it.key())) {
+            byLastUse.emplace_back(it.value(), it.key());
+        }
+    }
+    std::sort(byLastUse.begin(), byLastUse.end());
+
+    for (const auto& [lastUse, tilePtr] : byLastUse) {
+        if (usedBytes <= tileMemoryBudget_) {
+            break;
+        }
+
+        if (!tileStore_.write(tilePtr->getUuid(), tilePtr->getImageDataRef())) {
+            break; // keep the rest in memory
+        }
+
+        // a cold tile keeps the coarsest lod only, the finer ones are built from its image when it is read back
+        usedBytes -= static_cast<qint64>(tilePtr->getImageDataRef().size()) + tilePtr->getLodBytes();
+        std::vector<uint8_t>().swap(tilePtr->getImageDataRef());
+        tilePtr->releaseFineLodImages();
+        usedBytes += tilePtr->getLodBytes();
+        residentTiles_.remove(tilePtr);
+    }
 }
 
 void GlobalMesh::setGenerateGridContour(bool state)
@@ -134,19 +222,71 @@ void GlobalMesh::setGenerateGridContour(bool state)
     generateGridContour_ = state;
 }
 
-std::vector<std::vector<Tile *> > &GlobalMesh::getTileMatrixRef()
+void GlobalMesh::setTileMemoryBudget(qint64 bytes)
+{
+    tileMemoryBudget_ = std::max<qint64>(bytes, 0);
+
+    trimResidentTiles();
+}
+
+const QHash<QPoint, Tile*>& GlobalMesh::getTilesRef() const
+{
+    return tiles_;
+}
+
+std::vector<QPoint> GlobalMesh::getTilesMeshIndxs() const
+{
+    std::vector<QPoint> retVal;
+    retVal.reserve(tiles_.size());
+
+    for (auto it = tiles_.cbegin(); it != tiles_.cend(); ++it) {
+        retVal.emplace_back(it.key().x() + columnsShift_, (numHeightTiles_ - 1) - (it.key().y() + rowsShift_));
+    }
+
+    std::sort(retVal.begin(), retVal.end(), [](const QPoint& lhs, const QPoint& rhs) {
+        return lhs.y() != rhs.y() ? lhs.y() < rhs.y() : lhs.x() < rhs.x();
+    });
+
+    return retVal;
+}
+
+Tile* GlobalMesh::getTilePtr(int meshIndxX, int meshIndxY) const
 {
-    return tileMatrix_;
+    if (meshIndxX < 0 || meshIndxX >= numWidthTiles_ || meshIndxY < 0 || meshIndxY >= numHeightTiles_) {
+        return nullptr;
+    }
+
+    return tiles_.value(getTileKey(meshIndxX, meshIndxY), nullptr);
 }
 
-Tile* GlobalMesh::getTilePtrById(QUuid tileId)
+Tile* GlobalMesh::getTilePtrById(QUuid tileId) const
 {
-    for (auto& itm : tiles_) {
-        if (itm->getUuid() == tileId) {
-            return itm;
+    return tilesById_.value(tileId, nullptr);
+}
+
+std::vector<uint8_t> GlobalMesh::getTileImage(Tile* tilePtr, int level)
+{
+    std::vector<uint8_t> retVal;
+
+    if (!tilePtr || !tilePtr->getIsInited()) {
+        return retVal;
+    }
+
+    if (level > 0) {
+        level = std::min(level, tilePtr->getLodCount() - 1);
+        if (tilePtr->getLodImageRef(level).empty()) {
+            makeTileResident(tilePtr); // a released lod of a cold tile, the next trim spills the tile again
         }
+        retVal = tilePtr->getLodImageRef(level);
+    }
+    else if (residentTiles_.contains(tilePtr)) {
+        retVal = tilePtr->getImageDataRef();
     }
-    return nullptr;
+    else if (!tileStore_.read(tilePtr->getUuid(), retVal)) {
+        retVal.assign(tileSidePixelSize_ * tileSidePixelSize_, 0);
+    }
+
+    return retVal;
 }
 
 int GlobalMesh::getPixelWidth() const
@@ -181,109 +321,39 @@ int GlobalMesh::getStepSizeHeightMatrix() const
 
 bool GlobalMesh::getIsInited() const
 {
-    return !tiles_.empty();
+    return numWidthTiles_ > 0 && numHeightTiles_ > 0;
 }
 
 void GlobalMesh::initializeMatrix(int numWidthTiles, int numHeightTiles, const MatrixParams &matrixParams)
 {
     numWidthTiles_ = numWidthTiles;
     numHeightTiles_ = numHeightTiles;
+    columnsShift_ = 0;
+    rowsShift_ = 0;
 
     origin_ = QVector3D(matrixParams.originX, matrixParams.originY, 0);
-
-    tileMatrix_.resize(numHeightTiles_);
-    for (int i = 0; i < numHeightTiles_; ++i) {
-        tileMatrix_[i].resize(numWidthTiles_);
-    }
-
-    for (int i = 0; i < numHeightTiles_; ++i) {
-        for (int j = 0; j < numWidthTiles_; ++j) {
-
-            if (!tileMatrix_[i][j]) {
-                tiles_.push_back(new Tile( { origin_.x() + j * tileSideMeterSize_,
-                                           origin_.y() + ((numHeightTiles_ - 1) - i) * tileSideMeterSize_, 0.0f }, generateGridContour_));
-                tileMatrix_[i][j] = tiles_.back();
-            }
-        }
-    }
 }
 
+// tiles are created on first touch, resizing only moves the matrix bounds
 void GlobalMesh::resizeColumnsLeft(int columnsToAdd)
 {
-    for (int i = 0; i < static_cast<int>(tileMatrix_.size()); ++i) {
-        int oldSize = tileMatrix_[i].size();
-        tileMatrix_[i].resize(oldSize + columnsToAdd);
-
-        for (int j = oldSize - 1; j >= 0; --j) {
-            tileMatrix_[i][j + columnsToAdd] = tileMatrix_[i][j];
-        }
-
-        for (int j = 0; j < columnsToAdd; ++j) {
-            tiles_.push_back(new Tile({ origin_.x() + j * tileSideMeterSize_,
-                                       origin_.y() + ((numHeightTiles_ - 1) - i) * tileSideMeterSize_, 0.0f }, generateGridContour_));
-            tileMatrix_[i][j] = tiles_.back();
-        }
-    }
-
+    columnsShift_ += columnsToAdd;
     numWidthTiles_ += columnsToAdd;
 }
 
 void GlobalMesh::resizeRowsBottom(int rowsToAdd)
 {
-    int oldHeight = tileMatrix_.size();
-    tileMatrix_.resize(oldHeight + rowsToAdd);
-
-    int cnt = 0;
-    for (int i = oldHeight; i < static_cast<int>(tileMatrix_.size()); ++i) {
-        tileMatrix_[i].resize(numWidthTiles_);
-
-        for (int j = 0; j < numWidthTiles_; ++j) {
-            tiles_.push_back(new Tile({ origin_.x() + j * tileSideMeterSize_,
-                                       origin_.y() + (rowsToAdd - cnt - 1) * tileSideMeterSize_, 0.0f }, generateGridContour_));
-            tileMatrix_[i][j] = tiles_.back();
-        }
-        cnt++;
-    }
-
+    rowsShift_ += rowsToAdd;
     numHeightTiles_ += rowsToAdd;
 }
 
 void GlobalMesh::resizeColumnsRight(int columnsToAdd)
 {
-    int oldNumWidthTiles = numWidthTiles_;
-
-    for (int i = 0; i < static_cast<int>(tileMatrix_.size()); ++i) {
-        tileMatrix_[i].resize(oldNumWidthTiles + columnsToAdd);
-
-        for (int j = oldNumWidthTiles; j < oldNumWidthTiles + columnsToAdd; ++j) {
-            tiles_.push_back(new Tile({ origin_.x() + j * tileSideMeterSize_,
-                                       origin_.y() + ((numHeightTiles_ - 1) - i) * tileSideMeterSize_, 0.0f }, generateGridContour_));
-            tileMatrix_[i][j] = tiles_.back();
-        }
-    }
-
     numWidthTiles_ += columnsToAdd;
 }
 
 void GlobalMesh::resizeRowsTop(int rowsToAdd)
 {
-    tileMatrix_.resize(numHeightTiles_ + rowsToAdd);
-
-    for (int i = tileMatrix_.size() - 1; i >= rowsToAdd; --i) {
-        tileMatrix_[i] = tileMatrix_[i - rowsToAdd];
-    }
-
-    for (int i = 0; i < rowsToAdd; ++i) {
-
-        tileMatrix_[i].resize(numWidthTiles_);
-
-        for (int j = 0; j < numWidthTiles_; ++j) {
-            tiles_.push_back(new Tile({ origin_.x() + j * tileSideMeterSize_,
-                                       origin_.y() + ((numHeightTiles_ + rowsToAdd - 1) - i) * tileSideMeterSize_, 0.0f }, generateGridContour_));
-            tileMatrix_[i][j] = tiles_.back();
-        }
-    }
-
     numHeightTiles_ += rowsToAdd;
 }
 
@@ -296,3 +366,8 @@ float GlobalMesh::getHeightMeters() const
 {
     return numHeightTiles_ * tileSideMeterSize_;
 }
+
+QPoint GlobalMesh::getTileKey(int meshIndxX, int meshIndxY) const
+{
+    return QPoint(meshIndxX - columnsShift_, ((numHeightTiles_ - 1) - meshIndxY) - rowsShift_);
+}
@@ -1,9 +1,13 @@
 #pragma once
 
 #include <vector>
+#include <QHash>
+#include <QSet>
+#include <QPoint>
 #include <QVector3D>
 #include "draw_utils.h"
 #include "tile.h"
+#include "tile_store.h"
 
 
 using namespace sscan;
@@ -21,9 +25,17 @@ public:
     void printMatrix() const;
     void clear();
 
+    Tile* createTilePtr(int meshIndxX, int meshIndxY);
+    bool makeTileResident(Tile* tilePtr);
+    void trimResidentTiles(const QSet<Tile*>& keepTiles = QSet<Tile*>()); // keepTiles stay resident over the budget
+
     void setGenerateGridContour(bool state);
-    std::vector<std::vector<Tile*>>& getTileMatrixRef();
-    Tile*                            getTilePtrById(QUuid tileId);
+    void setTileMemoryBudget(qint64 bytes);
+    const QHash<QPoint, Tile*>&      getTilesRef() const;
+    std::vector<QPoint>              getTilesMeshIndxs() const;
+    Tile*                            getTilePtr(int meshIndxX, int meshIndxY) const;
+    Tile*                            getTilePtrById(QUuid tileId) const;
+    std::vector<uint8_t>             getTileImage(Tile* tilePtr, int level = 0);
     int                              getPixelWidth() const;
     int                              getPixelHeight() const;
     int                              getTileSidePixelSize() const;
@@ -41,16 +53,29 @@ private:
     void resizeRowsBottom(int rowsToAdd);    
     float getWidthMeters() const;
     float getHeightMeters() const;
+    QPoint getTileKey(int meshIndxX, int meshIndxY) const;
 
     /*data*/
+#if defined(Q_OS_ANDROID)
+    static constexpr qint64 defaultTileMemoryBudget_ = 64ll * 1024 * 1024;
+#else
+    static constexpr qint64 defaultTileMemoryBudget_ = 512ll * 1024 * 1024;
+#endif
+
     SideScanView* ssPtr_;
-    std::vector<Tile*> tiles_;
-    std::vector<std::vector<Tile*>> tileMatrix_;
+    QHash<QPoint, Tile*> tiles_; // only touched tiles, by column and row counted up from the first tile
+    QHash<QUuid, Tile*> tilesById_;
+    QHash<Tile*, quint64> residentTiles_; // tiles holding their image, by last use
+    TileStore tileStore_;
     QVector3D origin_;
     float tileResolution_;
     float tileSideMeterSize_;
+    qint64 tileMemoryBudget_;
+    quint64 useCounter_;
     int numWidthTiles_;
     int numHeightTiles_;
+    int columnsShift_; // columns added on the left of the first tile
+    int rowsShift_; // rows added below the first tile
     int tileSidePixelSize_;
     int tileHeightMatrixRatio_;
     bool generateGridContour_;
@@ -57,7 +57,7 @@ void PointGroup::append(std::shared_ptr <PointObject> point)
     QObject::connect(point.get(), &PointObject::changed, this, &PointGroup::pointObjectChanged);
 
     point->setParent(this);
-    point->m_indexInGroup = RENDER_IMPL(PointGroup)->m_pointRenderImplList.size();
+    point->m_indexInGroup = RENDER_IMPL_CONST(PointGroup)->m_pointRenderImplList.size();
 
     m_pointList.append(point);
 
@@ -1,5 +1,6 @@
 #include "pointobject.h"
 #include <draw_utils.h>
+#include <vertex_buffer_manager.h>
 
 PointObject::PointObject(QObject *parent)
     : SceneObject(new PointObjectRenderImplementation, parent)
@@ -14,22 +15,22 @@ SceneObject::SceneObjectType PointObject::type() const
 
 float PointObject::x() const
 {
-    return RENDER_IMPL(PointObject)->x();
+    return RENDER_IMPL_CONST(PointObject)->x();
 }
 
 float PointObject::y() const
 {
-    return RENDER_IMPL(PointObject)->y();
+    return RENDER_IMPL_CONST(PointObject)->y();
 }
 
 float PointObject::z() const
 {
-    return RENDER_IMPL(PointObject)->z();
+    return RENDER_IMPL_CONST(PointObject)->z();
 }
 
 QVector3D PointObject::position() const
 {
-    return RENDER_IMPL(PointObject)->position();
+    return RENDER_IMPL_CONST(PointObject)->position();
 }
 
 void PointObject::setPosition(float x, float y, float z)
@@ -94,7 +95,7 @@ void PointObject::PointObjectRenderImplementation::render(QOpenGLFunctions *ctx,
     shaderProgram->setUniformValue(matrixLoc, mvp);
     shaderProgram->setUniformValue(widthLoc, static_cast <float>(m_width));
     shaderProgram->enableAttributeArray(posLoc);
-    shaderProgram->setAttributeArray(posLoc, m_data.constData());
+    VertexBufferManager::setAttributeArray(shaderProgram.get(), posLoc, &m_data, m_data);
 
     ctx->glDrawArrays(m_primitiveType, 0, m_data.size());
 
@@ -34,7 +34,7 @@ void PolygonGroup::addPolygon(std::shared_ptr<PolygonObject> polygon)
     QObject::connect(polygon.get(), &PolygonObject::changed, this, &PolygonGroup::polygonObjectChanged);
 
     polygon->setParent(this);
-    polygon->m_indexInGroup = RENDER_IMPL(PolygonGroup)->m_polygonRenderImplList.size();
+    polygon->m_indexInGroup = RENDER_IMPL_CONST(PolygonGroup)->m_polygonRenderImplList.size();
     m_polygonList.append(polygon);
 
     RENDER_IMPL(PolygonGroup)->appendPolygonRenderImpl(
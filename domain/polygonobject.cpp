@@ -1,8 +1,10 @@
 #include "polygonobject.h"
 
+#include <algorithm>
 #include <QModelIndex>
 
 #include <draw_utils.h>
+#include <vertex_buffer_manager.h>
 #include <pointobject.h>
 
 PolygonObject::PolygonObject(QObject *parent)
@@ -54,14 +56,19 @@ void PolygonObject::PolygonObjectRenderImplementation::render(QOpenGLFunctions *
     for(const auto& renderImpl : m_pointRenderImplList)
         data.append(renderImpl.cdata().at(0));
 
+    // fan triangles in one draw, rebuilt every frame but uploaded only when the points moved
+    QVector <QVector3D> triangles;
+    triangles.reserve(std::max<qsizetype>(0, data.size() - 2) * 3);
+
     for (int i = 1; i < data.size() - 1; ++i) {
-        QVector<QVector3D> triangle;
-        triangle.append(data[0]);
-        triangle.append(data[i]);
-        triangle.append(data[i + 1]);
+        triangles.append(data[0]);
+        triangles.append(data[i]);
+        triangles.append(data[i + 1]);
+    }
 
-        shaderProgram->setAttributeArray(posLoc, triangle.constData());
-        ctx->glDrawArrays(GL_TRIANGLES, 0, triangle.size());
+    if (!triangles.isEmpty()) {
+        VertexBufferManager::setAttributeArray(shaderProgram.get(), posLoc, this, triangles);
+        ctx->glDrawArrays(GL_TRIANGLES, 0, triangles.size());
     }
 
     shaderProgram->disableAttributeArray(posLoc);
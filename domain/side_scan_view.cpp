@@ -1,5 +1,6 @@
 #include "side_scan_view.h"
 
+#include <algorithm>
 #include <QtMath>
 #include "graphicsscene3dview.h"
 #include <QtConcurrent/QtConcurrent>
@@ -34,10 +35,8 @@ SideScanView::SideScanView(QObject* parent) :
 
 SideScanView::~SideScanView()
 {
-    for (const auto &itmI : globalMesh_.getTileMatrixRef()) {
-        for (const auto& itmJ : itmI) {
-            tileTextureTasks_[itmJ->getUuid()] = std::vector<uint8_t>();
-        }
+    for (const auto* itm : globalMesh_.getTilesRef()) {
+        tileTextureTasks_[itm->getUuid()] = false;
     }
 }
 
@@ -66,6 +65,15 @@ bool SideScanView::updateChannelsIds()
 
 void SideScanView::startUpdateDataInThread(int endIndx, int endOffset)
 {
+    // the last epoch is still filled on this thread, the worker stops before it
+    if (datasetPtr_) {
+        const int closedCount = datasetPtr_->endIndex();
+        endIndx = endIndx == 0 ? closedCount : std::min(endIndx, closedCount);
+        if (endIndx <= 0) {
+            return;
+        }
+    }
+
     QThreadPool* threadPool = QThreadPool::globalInstance();
 
     QtConcurrent::run(threadPool, [this, endIndx, endOffset]() {
@@ -126,7 +134,7 @@ void SideScanView::updateData(int endIndx, int endOffset, bool backgroundThread)
     for (int i = lastAcceptedEpoch_; i < epochCount; ++i) {
         bool isAcceptedEpoch = false;
 
-        if (auto epoch = datasetPtr_->fromIndex(i); epoch) {
+        if (auto epoch = datasetPtr_->epochView(i); epoch) {
             auto pos = epoch->getInterpNED();
             auto yaw = epoch->getInterpYaw();
             if (isfinite(pos.n) && isfinite(pos.e) && isfinite(yaw)) {
@@ -192,10 +200,12 @@ void SideScanView::updateData(int endIndx, int endOffset, bool backgroundThread)
         // globalMesh_.printMatrix();
     }
 
-    auto gMeshWidthPixs = globalMesh_.getPixelWidth(); // for bypass
-    auto gMeshHeightPixs = globalMesh_.getPixelHeight();
-
     // processing
+    // pairs of neighbouring measurement lines are rasterized on the thread pool, then their strokes are drawn on the
+    // thread pool tile by tile; every tile gets its pixels in the order of the serial walk, so the mosaic is the same
+    std::vector<LinePair> linePairs;
+    linePairs.reserve(linePairBlockSize_);
+
     for (int i = 0; i < measLinesVertices.size(); i += 2) { // 2 - step for segment
         if (i + 5 > measLinesVertices.size() - 1) {
             break;
@@ -220,181 +230,26 @@ void SideScanView::updateData(int endIndx, int endOffset, bool backgroundThread)
             isOdds[segFIndx] != isOdds[segSIndx]) {
             continue;
         }
-        // epochs checking
-        auto segFEpochPtr = datasetPtr_->fromIndex(epochIndxs[segFIndx]);
-        auto segSEpochPtr = datasetPtr_->fromIndex(epochIndxs[segSIndx]);
-        if (!segFEpochPtr || !segSEpochPtr) {
-            continue;
-        }
-        Epoch segFEpoch = *segFEpochPtr; // _plot might be reallocated
-        Epoch segSEpoch = *segSEpochPtr;
-        // isOdd checking
-        bool segFIsOdd = isOdds[segFIndx] == '1';
-        bool segSIsOdd = isOdds[segSIndx] == '1';
-        if (segFIsOdd != segSIsOdd) {
-            continue;
-        }
-        // segments checking
-        auto segFCharts = segFEpoch.chart(segFIsOdd ? segSChannelId_ : segFChannelId_);
-        auto segSCharts = segSEpoch.chart(segSIsOdd ? segSChannelId_ : segFChannelId_);
-        if (!segFCharts || !segSCharts) {
-            continue;
-        }
-        // update compensated TODO: to proc
-        if (segFCharts->amplitude.size() != segFCharts->compensated.size()) {
-            segFCharts->updateCompesated();
-        }
-        if (segSCharts->amplitude.size() != segSCharts->compensated.size()) {
-            segSCharts->updateCompesated();
-        }
-        // dist procs checking
-        if (!isfinite(segFIsOdd ? segFEpoch.getInterpFirstChannelDist() : segFEpoch.getInterpSecondChannelDist()) ||
-            !isfinite(segSIsOdd ? segSEpoch.getInterpFirstChannelDist() : segSEpoch.getInterpSecondChannelDist())) {
-            continue;
-        }
 
-        // Bresenham
-        // first segment
-        QVector3D segFPhBegPnt = segFIsOdd ? measLinesVertices[segFBegVertIndx] : measLinesVertices[segFEndVertIndx]; // physics coordinates
-        QVector3D segFPhEndPnt = segFIsOdd ? measLinesVertices[segFEndVertIndx] : measLinesVertices[segFBegVertIndx];
-        auto segFBegPixPos = globalMesh_.convertPhToPixCoords(segFPhBegPnt);
-        auto segFEndPixPos = globalMesh_.convertPhToPixCoords(segFPhEndPnt);
-        int segFPixX1 = segFBegPixPos.x();
-        int segFPixY1 = segFBegPixPos.y();
-        int segFPixX2 = segFEndPixPos.x();
-        int segFPixY2 = segFEndPixPos.y();
-        float segFPixTotDist = std::sqrt(std::pow(segFPixX2 - segFPixX1, 2) + std::pow(segFPixY2 - segFPixY1, 2));
-        int segFPixDx = std::abs(segFPixX2 - segFPixX1);
-        int segFPixDy = std::abs(segFPixY2 - segFPixY1);
-        int segFPixSx = (segFPixX1 < segFPixX2) ? 1 : -1;
-        int segFPixSy = (segFPixY1 < segFPixY2) ? 1 : -1;
-        int segFPixErr = segFPixDx - segFPixDy;
-        // second segment
-        QVector3D segSPhBegPnt = segSIsOdd ? measLinesVertices[segSBegVertIndx] : measLinesVertices[segSEndVertIndx];
-        QVector3D segSPhEndPnt = segSIsOdd ? measLinesVertices[segSEndVertIndx] : measLinesVertices[segSBegVertIndx];
-        auto segSBegPixPos = globalMesh_.convertPhToPixCoords(segSPhBegPnt);
-        auto segSEndPixPos = globalMesh_.convertPhToPixCoords(segSPhEndPnt);
-        int segSPixX1 = segSBegPixPos.x();
-        int segSPixY1 = segSBegPixPos.y();
-        int segSPixX2 = segSEndPixPos.x();
-        int segSPixY2 = segSEndPixPos.y();
-        float segSPixTotDist = std::sqrt(std::pow(segSPixX2 - segSPixX1, 2) + std::pow(segSPixY2 - segSPixY1, 2));
-        int segSPixDx = std::abs(segSPixX2 - segSPixX1);
-        int segSPixDy = std::abs(segSPixY2 - segSPixY1);
-        int segSPixSx = (segSPixX1 < segSPixX2) ? 1 : -1;
-        int segSPixSy = (segSPixY1 < segSPixY2) ? 1 : -1;
-        int segSPixErr = segSPixDx - segSPixDy;
-
-        // pixel length checking
-        if (!checkLength(segFPixTotDist) ||
-            !checkLength(segSPixTotDist)) {
-            continue;
-        }
-
-        float segFDistProc = -1.0f * static_cast<float>(segFIsOdd ? segFEpoch.getInterpFirstChannelDist() : segFEpoch.getInterpSecondChannelDist());
-        float segSDistProc = -1.0f * static_cast<float>(segSIsOdd ? segSEpoch.getInterpFirstChannelDist() : segSEpoch.getInterpSecondChannelDist());
-        float segFPhDistX = segFPhEndPnt.x() - segFPhBegPnt.x();
-        float segFPhDistY = segFPhEndPnt.y() - segFPhBegPnt.y();
-        float segSPhDistX = segSPhEndPnt.x() - segSPhBegPnt.x();
-        float segSPhDistY = segSPhEndPnt.y() - segSPhBegPnt.y();
-
-        auto segFInterpNED = segFEpoch.getInterpNED();
-        auto segSInterpNED = segSEpoch.getInterpNED();
-        QVector3D segFBoatPos(segFInterpNED.n, segFInterpNED.e, 0.0f);
-        QVector3D segSBoatPos(segSInterpNED.n, segSInterpNED.e, 0.0f);
-
-        // follow the first segment
-        while (true) {
-            // first segment
-            float segFPixCurrDist = std::sqrt(std::pow(segFPixX1 - segFPixX2, 2) + std::pow(segFPixY1 - segFPixY2, 2));
-            float segFProgByPix = std::min(1.0f, segFPixCurrDist / segFPixTotDist);
-            QVector3D segFCurrPhPos(segFPhBegPnt.x() + segFProgByPix * segFPhDistX, segFPhBegPnt.y() + segFProgByPix * segFPhDistY, segFDistProc);
-            auto segFColorIndx = getColorIndx(segFCharts, static_cast<int>(std::floor(segFCurrPhPos.distanceToPoint(segFBoatPos) * amplitudeCoeff_)));
-            // second segment, calc corresponding progress using smoothed interpolation
-            float segSCorrProgByPix = std::min(1.0f, segFPixCurrDist / segFPixTotDist * segSPixTotDist / segFPixTotDist);
-            QVector3D segSCurrPhPos(segSPhBegPnt.x() + segSCorrProgByPix * segSPhDistX, segSPhBegPnt.y() + segSCorrProgByPix * segSPhDistY, segSDistProc);
-            auto segSColorIndx  = getColorIndx(segSCharts, static_cast<int>(std::floor(segSCurrPhPos.distanceToPoint(segSBoatPos) * amplitudeCoeff_)));
-
-            auto segFCurrPixPos = globalMesh_.convertPhToPixCoords(segFCurrPhPos);
-            auto segSCurrPixPos = globalMesh_.convertPhToPixCoords(segSCurrPhPos);
-
-            // color interpolation between two pixels
-            int interpPixX1 = segFCurrPixPos.x();
-            int interpPixY1 = segFCurrPixPos.y();
-            int interpPixX2 = segSCurrPixPos.x();
-            int interpPixY2 = segSCurrPixPos.y();
-            int interpPixDistX = interpPixX2 - interpPixX1;
-            int interpPixDistY = interpPixY2 - interpPixY1;
-            float interpPixTotDist = std::sqrt(std::pow(interpPixDistX, 2) + std::pow(interpPixDistY, 2));
-
-            // interpolate
-            if (checkLength(interpPixTotDist) && !(segSColorIndx == 0 && segSColorIndx == 0)) {
-                for (int step = 0; step <= interpPixTotDist; ++step) {
-                    float interpProgressByPixel = static_cast<float>(step) / interpPixTotDist;
-                    int interpX = interpPixX1 + interpProgressByPixel * interpPixDistX;
-                    int interpY = interpPixY1 + interpProgressByPixel * interpPixDistY;
-                    auto interpColorIndx = static_cast<uint8_t>((1 - interpProgressByPixel) * segFColorIndx + interpProgressByPixel * segSColorIndx);
-
-                    for (int offsetX = -interpLineWidth_; offsetX <= interpLineWidth_; ++offsetX) { // bypass
-                        for (int offsetY = -interpLineWidth_; offsetY <= interpLineWidth_; ++offsetY) {
-                            int bypassInterpX = std::min(gMeshWidthPixs - 1, std::max(0, interpX + offsetX)); // cause bypass
-                            int bypassInterpY = std::min(gMeshHeightPixs - 1, std::max(0, interpY + offsetY));
-
-                            int tileSidePixelSize = globalMesh_.getTileSidePixelSize();
-                            int meshIndxX = bypassInterpX / tileSidePixelSize;
-                            int meshIndxY = (globalMesh_.getNumHeightTiles() - 1) - bypassInterpY / tileSidePixelSize;
-                            int tileIndxX = bypassInterpX % tileSidePixelSize;
-                            int tileIndxY = bypassInterpY % tileSidePixelSize;
-
-                            auto& tileRef = globalMesh_.getTileMatrixRef()[meshIndxY][meshIndxX];
-                            if (!tileRef->getIsInited()) {
-                                tileRef->init(tileSidePixelSize_, tileHeightMatrixRatio_, tileResolution_);
-                            }
-
-                            // image
-                            auto& imageRef = tileRef->getImageDataRef();
-                            int bytesPerLine = std::sqrt(imageRef.size());
-                            *(imageRef.data() + tileIndxY * bytesPerLine + tileIndxX) = interpColorIndx;
-
-                            // height matrix
-                            int stepSizeHeightMatrix = globalMesh_.getStepSizeHeightMatrix();
-                            int numSteps = tileSidePixelSize / stepSizeHeightMatrix + 1;
-                            int hVIndx = (tileIndxY / stepSizeHeightMatrix) * numSteps + (tileIndxX / stepSizeHeightMatrix);
-                            tileRef->getHeightVerticesRef()[hVIndx][2] = segFCurrPhPos[2];
-                            tileRef->getHeightMarkVerticesRef()[hVIndx] = '1';
-                            tileRef->setIsUpdate(true);
-                        }
-                    }
-                }
-            }
-
-            // break at the end of the first segment
-            if (segFPixX1 == segFPixX2 && segFPixY1 == segFPixY2) {
-                break;
-            }
-
-            // Bresenham
-            int segFPixE2 = 2 * segFPixErr;
-            if (segFPixE2 > -segFPixDy) {
-                segFPixErr -= segFPixDy;
-                segFPixX1 += segFPixSx;
-            }
-            if (segFPixE2 < segFPixDx) {
-                segFPixErr += segFPixDx;
-                segFPixY1 += segFPixSy;
-            }
-            int segSPixE2 = 2 * segSPixErr;
-            if (segSPixE2 > -segSPixDy) {
-                segSPixErr -= segSPixDy;
-                segSPixX1 += segSPixSx;
-            }
-            if (segSPixE2 < segSPixDx) {
-                segSPixErr += segSPixDx;
-                segSPixY1 += segSPixSy;
-            }
+        LinePair linePair;
+        linePair.segFEpochIndx = epochIndxs[segFIndx];
+        linePair.segSEpochIndx = epochIndxs[segSIndx];
+        linePair.segFIsOdd = isOdds[segFIndx] == '1';
+        linePair.segSIsOdd = isOdds[segSIndx] == '1';
+        linePair.segFBegVertIndx = segFBegVertIndx;
+        linePair.segFEndVertIndx = segFEndVertIndx;
+        linePair.segSBegVertIndx = segSBegVertIndx;
+        linePair.segSEndVertIndx = segSEndVertIndx;
+        linePairs.push_back(std::move(linePair));
+
+        if (static_cast<int>(linePairs.size()) == linePairBlockSize_) {
+            drawLinePairs(linePairs, measLinesVertices);
+            linePairs.clear();
         }
     }
 
+    drawLinePairs(linePairs, measLinesVertices);
+
     lastMatParams_ = actualMatParams;
 
     postUpdate();
@@ -411,6 +266,281 @@ void SideScanView::updateData(int endIndx, int endOffset, bool backgroundThread)
     if (cleanFunc) cleanFunc();
 }
 
+void SideScanView::drawLinePairs(std::vector<LinePair>& linePairs, const QVector<QVector3D>& measLinesVertices)
+{
+    if (linePairs.empty()) {
+        return;
+    }
+
+    QtConcurrent::blockingMap(linePairs, [this, &measLinesVertices](LinePair& linePair) {
+        rasterizeLinePair(linePair, measLinesVertices);
+    });
+
+    // strokes of a tile are kept in the line pair order, tiles are created and loaded here, before the pool touches them
+    QHash<QPoint, int> tileTaskIndxs; // by mesh index, only the tiles of the block
+    std::vector<TileTask> tileTasks;
+    QSet<Tile*> blockTiles;
+
+    for (const auto& linePair : linePairs) {
+        for (const auto& tileStrokes : linePair.tiles) {
+            auto it = tileTaskIndxs.find(QPoint(tileStrokes.meshIndxX, tileStrokes.meshIndxY));
+            if (it == tileTaskIndxs.end()) {
+                auto* tilePtr = globalMesh_.createTilePtr(tileStrokes.meshIndxX, tileStrokes.meshIndxY);
+                if (!tilePtr->getIsInited()) {
+                    tilePtr->init(tileSidePixelSize_, tileHeightMatrixRatio_, tileResolution_);
+                }
+                globalMesh_.makeTileResident(tilePtr);
+                blockTiles.insert(tilePtr);
+
+                it = tileTaskIndxs.insert(QPoint(tileStrokes.meshIndxX, tileStrokes.meshIndxY), static_cast<int>(tileTasks.size()));
+                tileTasks.push_back({ tileStrokes.meshIndxX, tileStrokes.meshIndxY, tilePtr, {} });
+            }
+            tileTasks[it.value()].strokes.emplace_back(linePair.distProc, &tileStrokes.strokes);
+        }
+    }
+
+    QtConcurrent::blockingMap(tileTasks, [this](const TileTask& tileTask) {
+        drawTileTask(tileTask);
+    });
+
+    // resident images stay within the budget block by block, the tiles of this block are likely drawn by the next one
+    globalMesh_.trimResidentTiles(blockTiles);
+}
+
+void SideScanView::rasterizeLinePair(LinePair& linePair, const QVector<QVector3D>& measLinesVertices) const
+{
+    const int gMeshWidthPixs = globalMesh_.getPixelWidth(); // for bypass
+    const int gMeshHeightPixs = globalMesh_.getPixelHeight();
+    const int tileSidePixelSize = globalMesh_.getTileSidePixelSize();
+    const int numHeightTiles = globalMesh_.getNumHeightTiles();
+    size_t currTileIndx = 0;
+
+    // a stroke goes to every tile its bypass reaches
+    auto addStroke = [&](int interpX, int interpY, uint8_t colorIndx) {
+        int bypassBegX = std::min(gMeshWidthPixs - 1, std::max(0, interpX - interpLineWidth_));
+        int bypassEndX = std::min(gMeshWidthPixs - 1, std::max(0, interpX + interpLineWidth_));
+        int bypassBegY = std::min(gMeshHeightPixs - 1, std::max(0, interpY - interpLineWidth_));
+        int bypassEndY = std::min(gMeshHeightPixs - 1, std::max(0, interpY + interpLineWidth_));
+
+        for (int meshIndxX = bypassBegX / tileSidePixelSize; meshIndxX <= bypassEndX / tileSidePixelSize; ++meshIndxX) {
+            for (int pixTileY = bypassBegY / tileSidePixelSize; pixTileY <= bypassEndY / tileSidePixelSize; ++pixTileY) {
+                int meshIndxY = (numHeightTiles - 1) - pixTileY;
+
+                auto isCurrTile = [&]() {
+                    return linePair.tiles[currTileIndx].meshIndxX == meshIndxX && linePair.tiles[currTileIndx].meshIndxY == meshIndxY;
+                };
+                if (currTileIndx >= linePair.tiles.size() || !isCurrTile()) {
+                    for (currTileIndx = 0; currTileIndx < linePair.tiles.size(); ++currTileIndx) {
+                        if (isCurrTile()) {
+                            break;
+                        }
+                    }
+                    if (currTileIndx == linePair.tiles.size()) {
+                        linePair.tiles.push_back({ meshIndxX, meshIndxY, {} });
+                    }
+                }
+
+                linePair.tiles[currTileIndx].strokes.push_back({ interpX, interpY, colorIndx });
+            }
+        }
+    };
+
+    // epochs checking
+    const Epoch* segFEpochPtr = datasetPtr_->epochView(linePair.segFEpochIndx);
+    const Epoch* segSEpochPtr = datasetPtr_->epochView(linePair.segSEpochIndx);
+    if (!segFEpochPtr || !segSEpochPtr) {
+        return;
+    }
+    const Epoch& segFEpoch = *segFEpochPtr;
+    const Epoch& segSEpoch = *segSEpochPtr;
+    // isOdd checking
+    bool segFIsOdd = linePair.segFIsOdd;
+    bool segSIsOdd = linePair.segSIsOdd;
+    if (segFIsOdd != segSIsOdd) {
+        return;
+    }
+    // segments checking
+    auto segFCharts = segFEpoch.chart(segFIsOdd ? segSChannelId_ : segFChannelId_);
+    auto segSCharts = segSEpoch.chart(segSIsOdd ? segSChannelId_ : segFChannelId_);
+    if (!segFCharts || !segSCharts) {
+        return;
+    }
+    // dist procs checking
+    if (!isfinite(segFIsOdd ? segFEpoch.getInterpFirstChannelDist() : segFEpoch.getInterpSecondChannelDist()) ||
+        !isfinite(segSIsOdd ? segSEpoch.getInterpFirstChannelDist() : segSEpoch.getInterpSecondChannelDist())) {
+        return;
+    }
+    // closed epochs have the compensated amplitudes cached in the slab
+    const AmplitudeView segFCompensated = segFCharts->compensatedSamples();
+    const AmplitudeView segSCompensated = segSCharts->compensatedSamples();
+
+    // Bresenham
+    // first segment
+    QVector3D segFPhBegPnt = segFIsOdd ? measLinesVertices[linePair.segFBegVertIndx] : measLinesVertices[linePair.segFEndVertIndx]; // physics coordinates
+    QVector3D segFPhEndPnt = segFIsOdd ? measLinesVertices[linePair.segFEndVertIndx] : measLinesVertices[linePair.segFBegVertIndx];
+    auto segFBegPixPos = globalMesh_.convertPhToPixCoords(segFPhBegPnt);
+    auto segFEndPixPos = globalMesh_.convertPhToPixCoords(segFPhEndPnt);
+    int segFPixX1 = segFBegPixPos.x();
+    int segFPixY1 = segFBegPixPos.y();
+    int segFPixX2 = segFEndPixPos.x();
+    int segFPixY2 = segFEndPixPos.y();
+    float segFPixTotDist = std::sqrt(std::pow(segFPixX2 - segFPixX1, 2) + std::pow(segFPixY2 - segFPixY1, 2));
+    int segFPixDx = std::abs(segFPixX2 - segFPixX1);
+    int segFPixDy = std::abs(segFPixY2 - segFPixY1);
+    int segFPixSx = (segFPixX1 < segFPixX2) ? 1 : -1;
+    int segFPixSy = (segFPixY1 < segFPixY2) ? 1 : -1;
+    int segFPixErr = segFPixDx - segFPixDy;
+    // second segment
+    QVector3D segSPhBegPnt = segSIsOdd ? measLinesVertices[linePair.segSBegVertIndx] : measLinesVertices[linePair.segSEndVertIndx];
+    QVector3D segSPhEndPnt = segSIsOdd ? measLinesVertices[linePair.segSEndVertIndx] : measLinesVertices[linePair.segSBegVertIndx];
+    auto segSBegPixPos = globalMesh_.convertPhToPixCoords(segSPhBegPnt);
+    auto segSEndPixPos = globalMesh_.convertPhToPixCoords(segSPhEndPnt);
+    int segSPixX1 = segSBegPixPos.x();
+    int segSPixY1 = segSBegPixPos.y();
+    int segSPixX2 = segSEndPixPos.x();
+    int segSPixY2 = segSEndPixPos.y();
+    float segSPixTotDist = std::sqrt(std::pow(segSPixX2 - segSPixX1, 2) + std::pow(segSPixY2 - segSPixY1, 2));
+    int segSPixDx = std::abs(segSPixX2 - segSPixX1);
+    int segSPixDy = std::abs(segSPixY2 - segSPixY1);
+    int segSPixSx = (segSPixX1 < segSPixX2) ? 1 : -1;
+    int segSPixSy = (segSPixY1 < segSPixY2) ? 1 : -1;
+    int segSPixErr = segSPixDx - segSPixDy;
+
+    // pixel length checking
+    if (!checkLength(segFPixTotDist) ||
+        !checkLength(segSPixTotDist)) {
+        return;
+    }
+
+    float segFDistProc = -1.0f * static_cast<float>(segFIsOdd ? segFEpoch.getInterpFirstChannelDist() : segFEpoch.getInterpSecondChannelDist());
+    float segSDistProc = -1.0f * static_cast<float>(segSIsOdd ? segSEpoch.getInterpFirstChannelDist() : segSEpoch.getInterpSecondChannelDist());
+    float segFPhDistX = segFPhEndPnt.x() - segFPhBegPnt.x();
+    float segFPhDistY = segFPhEndPnt.y() - segFPhBegPnt.y();
+    float segSPhDistX = segSPhEndPnt.x() - segSPhBegPnt.x();
+    float segSPhDistY = segSPhEndPnt.y() - segSPhBegPnt.y();
+    linePair.distProc = segFDistProc;
+
+    auto segFInterpNED = segFEpoch.getInterpNED();
+    auto segSInterpNED = segSEpoch.getInterpNED();
+    QVector3D segFBoatPos(segFInterpNED.n, segFInterpNED.e, 0.0f);
+    QVector3D segSBoatPos(segSInterpNED.n, segSInterpNED.e, 0.0f);
+
+    // follow the first segment
+    while (true) {
+        // first segment
+        float segFPixCurrDist = std::sqrt(std::pow(segFPixX1 - segFPixX2, 2) + std::pow(segFPixY1 - segFPixY2, 2));
+        float segFProgByPix = std::min(1.0f, segFPixCurrDist / segFPixTotDist);
+        QVector3D segFCurrPhPos(segFPhBegPnt.x() + segFProgByPix * segFPhDistX, segFPhBegPnt.y() + segFProgByPix * segFPhDistY, segFDistProc);
+        auto segFColorIndx = getColorIndx(segFCompensated, static_cast<int>(std::floor(segFCurrPhPos.distanceToPoint(segFBoatPos) * amplitudeCoeff_)));
+        // second segment, calc corresponding progress using smoothed interpolation
+        float segSCorrProgByPix = std::min(1.0f, segFPixCurrDist / segFPixTotDist * segSPixTotDist / segFPixTotDist);
+        QVector3D segSCurrPhPos(segSPhBegPnt.x() + segSCorrProgByPix * segSPhDistX, segSPhBegPnt.y() + segSCorrProgByPix * segSPhDistY, segSDistProc);
+        auto segSColorIndx  = getColorIndx(segSCompensated, static_cast<int>(std::floor(segSCurrPhPos.distanceToPoint(segSBoatPos) * amplitudeCoeff_)));
+
+        auto segFCurrPixPos = globalMesh_.convertPhToPixCoords(segFCurrPhPos);
+        auto segSCurrPixPos = globalMesh_.convertPhToPixCoords(segSCurrPhPos);
+
+        // color interpolation between two pixels
+        int interpPixX1 = segFCurrPixPos.x();
+        int interpPixY1 = segFCurrPixPos.y();
+        int interpPixX2 = segSCurrPixPos.x();
+        int interpPixY2 = segSCurrPixPos.y();
+        int interpPixDistX = interpPixX2 - interpPixX1;
+        int interpPixDistY = interpPixY2 - interpPixY1;
+        float interpPixTotDist = std::sqrt(std::pow(interpPixDistX, 2) + std::pow(interpPixDistY, 2));
+
+        // interpolate
+        if (checkLength(interpPixTotDist) && !(segSColorIndx == 0 && segSColorIndx == 0)) {
+            for (int step = 0; step <= interpPixTotDist; ++step) {
+                float interpProgressByPixel = static_cast<float>(step) / interpPixTotDist;
+                int interpX = interpPixX1 + interpProgressByPixel * interpPixDistX;
+                int interpY = interpPixY1 + interpProgressByPixel * interpPixDistY;
+                auto interpColorIndx = static_cast<uint8_t>((1 - interpProgressByPixel) * segFColorIndx + interpProgressByPixel * segSColorIndx);
+                addStroke(interpX, interpY, interpColorIndx);
+            }
+        }
+
+        // break at the end of the first segment
+        if (segFPixX1 == segFPixX2 && segFPixY1 == segFPixY2) {
+            break;
+        }
+
+        // Bresenham
+        int segFPixE2 = 2 * segFPixErr;
+        if (segFPixE2 > -segFPixDy) {
+            segFPixErr -= segFPixDy;
+            segFPixX1 += segFPixSx;
+        }
+        if (segFPixE2 < segFPixDx) {
+            segFPixErr += segFPixDx;
+            segFPixY1 += segFPixSy;
+        }
+        int segSPixE2 = 2 * segSPixErr;
+        if (segSPixE2 > -segSPixDy) {
+            segSPixErr -= segSPixDy;
+            segSPixX1 += segSPixSx;
+        }
+        if (segSPixE2 < segSPixDx) {
+            segSPixErr += segSPixDx;
+            segSPixY1 += segSPixSy;
+        }
+    }
+}
+
+void SideScanView::drawTileTask(const TileTask& tileTask)
+{
+    const int gMeshWidthPixs = globalMesh_.getPixelWidth(); // for bypass
+    const int gMeshHeightPixs = globalMesh_.getPixelHeight();
+    const int tileSidePixelSize = globalMesh_.getTileSidePixelSize();
+
+    auto* tileRef = tileTask.tilePtr;
+
+    // tile constants
+    const int tileBegPixX = tileTask.meshIndxX * tileSidePixelSize;
+    const int tileBegPixY = ((globalMesh_.getNumHeightTiles() - 1) - tileTask.meshIndxY) * tileSidePixelSize;
+    auto& imageRef = tileRef->getImageDataRef();
+    const int bytesPerLine = std::sqrt(imageRef.size());
+    uint8_t* imageData = imageRef.data();
+    const int stepSizeHeightMatrix = globalMesh_.getStepSizeHeightMatrix();
+    const int numSteps = tileSidePixelSize / stepSizeHeightMatrix + 1;
+    QVector3D* heightVertices = tileRef->getHeightVerticesRef().data();
+    char* heightMarkVertices = tileRef->getHeightMarkVerticesRef().data();
+    int changedBegX = tileSidePixelSize, changedBegY = tileSidePixelSize, changedEndX = 0, changedEndY = 0;
+
+    for (const auto& [distProc, strokes] : tileTask.strokes) {
+        for (const auto& stroke : *strokes) {
+            for (int offsetX = -interpLineWidth_; offsetX <= interpLineWidth_; ++offsetX) { // bypass
+                int tileIndxX = std::min(gMeshWidthPixs - 1, std::max(0, stroke.x + offsetX)) - tileBegPixX; // cause bypass
+                if (tileIndxX < 0 || tileIndxX >= tileSidePixelSize) {
+                    continue;
+                }
+
+                for (int offsetY = -interpLineWidth_; offsetY <= interpLineWidth_; ++offsetY) {
+                    int tileIndxY = std::min(gMeshHeightPixs - 1, std::max(0, stroke.y + offsetY)) - tileBegPixY;
+                    if (tileIndxY < 0 || tileIndxY >= tileSidePixelSize) {
+                        continue;
+                    }
+
+                    // image
+                    *(imageData + tileIndxY * bytesPerLine + tileIndxX) = stroke.colorIndx;
+                    changedBegX = std::min(changedBegX, tileIndxX);
+                    changedBegY = std::min(changedBegY, tileIndxY);
+                    changedEndX = std::max(changedEndX, tileIndxX + 1);
+                    changedEndY = std::max(changedEndY, tileIndxY + 1);
+
+                    // height matrix
+                    int hVIndx = (tileIndxY / stepSizeHeightMatrix) * numSteps + (tileIndxX / stepSizeHeightMatrix);
+                    heightVertices[hVIndx][2] = distProc;
+                    heightMarkVertices[hVIndx] = '1';
+                }
+            }
+        }
+    }
+
+    tileRef->updateLodImages(changedBegX, changedBegY, changedEndX, changedEndY);
+    tileRef->setIsUpdate(true);
+}
+
 void SideScanView::resetTileSettings(int tileSidePixelSize, int tileHeightMatrixRatio, float tileResolution)
 {
     clear();
@@ -443,18 +573,53 @@ void SideScanView::clear()
     workMode_ = Mode::kUndefined;
     emit sendUpdatedWorkMode(workMode_);
 
+    for (const auto* itm : globalMesh_.getTilesRef()) {
+        tileTextureTasks_[itm->getUuid()] = false;
+    }
+
     globalMesh_.clear();
 
     renderImpl->tiles_.clear();
 
-    for (const auto &itmI : globalMesh_.getTileMatrixRef()) {
-        for (const auto& itmJ : itmI) {
-            tileTextureTasks_[itmJ->getUuid()] = std::vector<uint8_t>();
+    Q_EMIT changed();
+    Q_EMIT boundsChanged();
+}
+
+void SideScanView::updateTilesLod(const QVector3D& cameraPos, float viewHeightPixs, float fovDegrees)
+{
+    // called from the render thread, a running update keeps current levels until the next frame
+    if (!mutex_.tryLock()) {
+        return;
+    }
+
+    lastCameraPos_ = cameraPos;
+
+    if (globalMesh_.getIsInited() && viewHeightPixs > 0.0f) {
+        const float tileSideMeterSize = tileSidePixelSize_ * tileResolution_;
+        const float pixsPerMeterAtUnitDist = viewHeightPixs / (2.0f * std::tan(qDegreesToRadians(fovDegrees) / 2.0f));
+
+        for (auto* itm : globalMesh_.getTilesRef()) {
+            if (!itm->getIsInited()) {
+                continue;
+            }
+
+            const auto& heightVertices = itm->getHeightVerticesConstRef();
+            QVector3D tileCenter = itm->getOrigin() + QVector3D(tileSideMeterSize / 2.0f, tileSideMeterSize / 2.0f, 0.0f);
+            tileCenter.setZ(heightVertices[heightVertices.size() / 2].z());
+
+            // smallest level still giving a texel per screen pixel
+            const float dist = std::max(tileCenter.distanceToPoint(cameraPos), 1e-3f);
+            const float screenPixs = std::max(tileSideMeterSize * pixsPerMeterAtUnitDist / dist, 1.0f);
+            const int level = std::clamp(static_cast<int>(std::floor(std::log2(tileSidePixelSize_ / screenPixs))), 0, itm->getLodCount() - 1);
+
+            if (level != itm->getTextureLod()) {
+                itm->setTextureLod(level);
+                tileTextureTasks_[itm->getUuid()] = true;
+            }
         }
     }
 
-    Q_EMIT changed();
-    Q_EMIT boundsChanged();
+    mutex_.unlock();
 }
 
 void SideScanView::setView(GraphicsScene3dView *viewPtr)
@@ -489,7 +654,6 @@ void SideScanView::setGenerateGridContour(bool state)
 void SideScanView::setColorTableThemeById(int id)
 {
     colorTable_.setThemeById(id);
-    updateTilesTexture();
 
     colorTableTextureTask_ = colorTable_.getRgbaColors();
 
@@ -499,7 +663,6 @@ void SideScanView::setColorTableThemeById(int id)
 void SideScanView::setColorTableLevels(float lowVal, float highVal)
 {
     colorTable_.setLevels(lowVal, highVal);
-    updateTilesTexture();
 
     colorTableTextureTask_ = colorTable_.getRgbaColors();
 
@@ -509,7 +672,6 @@ void SideScanView::setColorTableLevels(float lowVal, float highVal)
 void SideScanView::setColorTableLowLevel(float val)
 {
     colorTable_.setLowLevel(val);
-    updateTilesTexture();
 
     colorTableTextureTask_ = colorTable_.getRgbaColors();
 
@@ -519,7 +681,6 @@ void SideScanView::setColorTableLowLevel(float val)
 void SideScanView::setColorTableHighLevel(float val)
 {
     colorTable_.setHighLevel(val);
-    updateTilesTexture();
 
     colorTableTextureTask_ = colorTable_.getRgbaColors();
 
@@ -558,6 +719,13 @@ void SideScanView::setTrackLastEpoch(bool state)
     trackLastEpoch_ = state;
 }
 
+void SideScanView::setTileMemoryBudget(int megabytes)
+{
+    QMutexLocker locker(&mutex_);
+
+    globalMesh_.setTileMemoryBudget(static_cast<qint64>(megabytes) * 1024 * 1024);
+}
+
 void SideScanView::setColorTableTextureId(GLuint value)
 {
     colorMapTextureId_ = value;
@@ -603,9 +771,10 @@ GLuint SideScanView::getTextureIdByTileId(QUuid tileId)
 
     // from render
     GLuint retVal = 0;
-    auto it = RENDER_IMPL(SideScanView)->tiles_.find(tileId);
+    auto renderImpl = RENDER_IMPL_CONST(SideScanView);
+    auto it = renderImpl->tiles_.constFind(tileId);
 
-    if (it != RENDER_IMPL(SideScanView)->tiles_.end()) {
+    if (it != renderImpl->tiles_.cend()) {
         retVal =  it.value().getTextureId();
     }
 
@@ -630,9 +799,55 @@ GLuint SideScanView::getColorTableTextureId() const
 
 QHash<QUuid, std::vector<uint8_t>> SideScanView::getTileTextureTasks()
 {
+    QHash<QUuid, std::vector<uint8_t>> retVal;
+
+    // called from the render thread, a running update keeps the tasks until the next frame
+    if (!mutex_.tryLock()) {
+        return retVal;
+    }
+
     QWriteLocker locker(&rWLocker_);
 
-    auto retVal = std::move(tileTextureTasks_);
+    // images are read only here, tiles nearest to the camera first, the rest waits for the next frames
+    std::vector<std::pair<float, Tile*>> uploads;
+    for (auto it = tileTextureTasks_.begin(); it != tileTextureTasks_.end();) {
+        Tile* tilePtr = it.value() ? globalMesh_.getTilePtrById(it.key()) : nullptr;
+        if (!tilePtr) {
+            if (!it.value()) {
+                retVal.insert(it.key(), std::vector<uint8_t>());
+            }
+            it = tileTextureTasks_.erase(it);
+            continue;
+        }
+
+        const float tileSideMeterSize = tileSidePixelSize_ * tileResolution_;
+        const QVector3D tileCenter = tilePtr->getOrigin() + QVector3D(tileSideMeterSize / 2.0f, tileSideMeterSize / 2.0f, 0.0f);
+        uploads.emplace_back(tileCenter.distanceToPoint(lastCameraPos_), tilePtr);
+        ++it;
+    }
+    std::sort(uploads.begin(), uploads.end());
+
+    qint64 bytes = 0;
+    for (const auto& [dist, tilePtr] : uploads) {
+        if (bytes >= textureUploadBudget_) {
+            break;
+        }
+
+        std::vector<uint8_t> image = globalMesh_.getTileImage(tilePtr, tilePtr->getTextureLod());
+        bytes += static_cast<qint64>(image.size());
+        tileTextureTasks_.remove(tilePtr->getUuid());
+        if (!image.empty()) {
+            retVal.insert(tilePtr->getUuid(), std::move(image));
+        }
+    }
+
+    const bool pending = !tileTextureTasks_.isEmpty();
+
+    mutex_.unlock();
+
+    if (pending) {
+        Q_EMIT changed();
+    }
 
     return retVal;
 }
@@ -703,12 +918,12 @@ void SideScanView::concatenateMatrixParameters(MatrixParams &srcDst, const Matri
     srcDst.height = static_cast<int>(std::ceil(maxY - srcDst.originY));
 }
 
-int SideScanView::getColorIndx(Epoch::Echogram* charts, int ampIndx) const
+int SideScanView::getColorIndx(const AmplitudeView& compensated, int ampIndx) const
 {
     int retVal{ 0 };
 
-    if (charts->compensated.size() > ampIndx) {
-        int cVal = charts->compensated[ampIndx] ;
+    if (compensated.size() > ampIndx) {
+        int cVal = compensated.constData()[ampIndx] ;
         cVal = std::min(colorTableSize_, cVal);
         retVal = cVal;
     }
@@ -734,67 +949,63 @@ void SideScanView::postUpdate()
             updateUnmarkedHeightVertices(tilePtr);
         }
         tilePtr->updateHeightIndices();
-        RENDER_IMPL(SideScanView)->tiles_.insert(tilePtr->getUuid(), *tilePtr); // copy data to render
-        tileTextureTasks_[tilePtr->getUuid()] = tilePtr->getImageDataRef();
+        RENDER_IMPL(SideScanView)->tiles_.insert(tilePtr->getUuid(), tilePtr->cloneWithoutImage()); // copy data to render
+        tileTextureTasks_[tilePtr->getUuid()] = true;
     };
 
-    int tileMatrixYSize = globalMesh_.getTileMatrixRef().size();
-    int tileMatrixXSize = globalMesh_.getTileMatrixRef().at(0).size();
-
-    for (int i = 0; i < tileMatrixYSize; ++i) {
-        for (int j = 0; j < tileMatrixXSize; ++j) {
-
-            auto& tileRef = globalMesh_.getTileMatrixRef()[i][j];
-            if (tileRef->getIsUpdate()) {
-                updateTextureInView(tileRef, false);
-                tileRef->setIsUpdate(false);
-
-                // fix height matrixs
-                auto& tileVertRef = tileRef->getHeightVerticesRef();
-                int numHeightVertBySide = std::sqrt(tileVertRef.size());
-
-                int yIndx = i + 1; // by row
-                if (tileMatrixYSize > yIndx) {
-                    auto& rowTileRef = globalMesh_.getTileMatrixRef()[yIndx][j];
-                    if (!rowTileRef->getIsInited()) {
-                        rowTileRef->init(tileSidePixelSize_, tileHeightMatrixRatio_, tileResolution_);
-                    }
+    auto getNeighbourTile = [this](int meshIndxX, int meshIndxY) -> Tile* {
+        auto* tilePtr = globalMesh_.createTilePtr(meshIndxX, meshIndxY);
+        if (tilePtr && !tilePtr->getIsInited()) {
+            tilePtr->init(tileSidePixelSize_, tileHeightMatrixRatio_, tileResolution_);
+            globalMesh_.makeTileResident(tilePtr);
+        }
+        return tilePtr;
+    };
 
-                    int topStartIndx = numHeightVertBySide * (numHeightVertBySide - 1);
-                    auto& topTileVertRef = rowTileRef->getHeightVerticesRef();
-                    auto& topTileMarkVertRef = rowTileRef->getHeightMarkVerticesRef();
-                    for (int k = 0; k < numHeightVertBySide; ++k) {
-                        int rowIndxTo = topStartIndx + k;
-                        int rowIndxFrom = k;
-                        if (qFuzzyIsNull(tileVertRef[rowIndxFrom][2])) {
-                            continue;
-                        }
-                        topTileVertRef[rowIndxTo][2] = tileVertRef[rowIndxFrom][2];
-                        topTileMarkVertRef[rowIndxTo] = '1';
+    for (const auto& meshIndx : globalMesh_.getTilesMeshIndxs()) {
+        const int i = meshIndx.y();
+        const int j = meshIndx.x();
+
+        auto* tileRef = globalMesh_.getTilePtr(j, i);
+        if (tileRef->getIsUpdate()) {
+            updateTextureInView(tileRef, false);
+            tileRef->setIsUpdate(false);
+
+            // fix height matrixs
+            auto& tileVertRef = tileRef->getHeightVerticesRef();
+            int numHeightVertBySide = std::sqrt(tileVertRef.size());
+
+            int yIndx = i + 1; // by row
+            if (auto* rowTileRef = getNeighbourTile(j, yIndx); rowTileRef) {
+                int topStartIndx = numHeightVertBySide * (numHeightVertBySide - 1);
+                auto& topTileVertRef = rowTileRef->getHeightVerticesRef();
+                auto& topTileMarkVertRef = rowTileRef->getHeightMarkVerticesRef();
+                for (int k = 0; k < numHeightVertBySide; ++k) {
+                    int rowIndxTo = topStartIndx + k;
+                    int rowIndxFrom = k;
+                    if (qFuzzyIsNull(tileVertRef[rowIndxFrom][2])) {
+                        continue;
                     }
-                    updateTextureInView(rowTileRef, true);
+                    topTileVertRef[rowIndxTo][2] = tileVertRef[rowIndxFrom][2];
+                    topTileMarkVertRef[rowIndxTo] = '1';
                 }
+                updateTextureInView(rowTileRef, true);
+            }
 
-                int xIndx = j - 1; // by column
-                if (xIndx > -1 && tileMatrixXSize > xIndx) {
-                    auto& colTileRef = globalMesh_.getTileMatrixRef()[i][xIndx];
-                    if (!colTileRef->getIsInited()) {
-                        colTileRef->init(tileSidePixelSize_, tileHeightMatrixRatio_, tileResolution_);
-                    }
-
-                    auto& leftTileVertRef = colTileRef->getHeightVerticesRef();
-                    auto& leftTileMarkVertRef = colTileRef->getHeightMarkVerticesRef();
-                    for (int k = 0; k < numHeightVertBySide; ++k) {
-                        int colIndxTo = ((k + 1) * numHeightVertBySide - 1);
-                        int colIndxFrom = (k == 0 ? 0 : k * numHeightVertBySide);
-                        if (qFuzzyIsNull(tileVertRef[colIndxFrom][2])) {
-                            continue;
-                        }
-                        leftTileVertRef[colIndxTo][2] = tileVertRef[colIndxFrom][2];
-                        leftTileMarkVertRef[colIndxTo] = '1';
+            int xIndx = j - 1; // by column
+            if (auto* colTileRef = getNeighbourTile(xIndx, i); colTileRef) {
+                auto& leftTileVertRef = colTileRef->getHeightVerticesRef();
+                auto& leftTileMarkVertRef = colTileRef->getHeightMarkVerticesRef();
+                for (int k = 0; k < numHeightVertBySide; ++k) {
+                    int colIndxTo = ((k + 1) * numHeightVertBySide - 1);
+                    int colIndxFrom = (k == 0 ? 0 : k * numHeightVertBySide);
+                    if (qFuzzyIsNull(tileVertRef[colIndxFrom][2])) {
+                        continue;
                     }
-                    updateTextureInView(colTileRef, true);
+                    leftTileVertRef[colIndxTo][2] = tileVertRef[colIndxFrom][2];
+                    leftTileMarkVertRef[colIndxTo] = '1';
                 }
+                updateTextureInView(colTileRef, true);
             }
         }
     }
@@ -807,9 +1018,9 @@ void SideScanView::updateTilesTexture()
     }
     QMutexLocker locker(&mutex_);
 
-    for (auto& itmI : globalMesh_.getTileMatrixRef()) {
-        for (auto& itmJ : itmI) {
-            tileTextureTasks_[itmJ->getUuid()] = itmJ->getImageDataRef();
+    for (auto* itm : globalMesh_.getTilesRef()) {
+        if (itm->getIsInited()) {
+            tileTextureTasks_[itm->getUuid()] = true;
         }
     }
 }
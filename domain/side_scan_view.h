@@ -59,6 +59,7 @@ public:
     void updateData(int endIndx, int endOffset = 0, bool backgroungThread = false);
     void resetTileSettings(int tileSidePixelSize, int tileHeightMatrixRatio, float tileResolution);
     void clear();
+    void updateTilesLod(const QVector3D& cameraPos, float viewHeightPixs, float fovDegrees);
 
     void setView(GraphicsScene3dView* viewPtr);
     void setDatasetPtr(Dataset* datasetPtr);
@@ -72,6 +73,7 @@ public:
     void setTextureIdByTileId(QUuid tileId, GLuint textureId);
     void setUseLinearFilter(bool state);
     void setTrackLastEpoch(bool state);
+    void setTileMemoryBudget(int megabytes);
     void setColorTableTextureId(GLuint value);
     void setWorkMode(Mode mode);
     void setLAngleOffset(float val);
@@ -90,23 +92,59 @@ signals:
     void sendUpdatedWorkMode(Mode);
 
 private:
+    /*structures*/
+    struct Stroke { // interpolated pixel, drawn with the bypass around it
+        int x;
+        int y;
+        uint8_t colorIndx;
+    };
+    struct TileStrokes {
+        int meshIndxX;
+        int meshIndxY;
+        std::vector<Stroke> strokes;
+    };
+    struct LinePair {
+        int segFEpochIndx = 0;
+        int segSEpochIndx = 0;
+        bool segFIsOdd = false;
+        bool segSIsOdd = false;
+        int segFBegVertIndx = 0;
+        int segFEndVertIndx = 0;
+        int segSBegVertIndx = 0;
+        int segSEndVertIndx = 0;
+        float distProc = 0.0f;
+        std::vector<TileStrokes> tiles;
+    };
+    struct TileTask {
+        int meshIndxX;
+        int meshIndxY;
+        Tile* tilePtr;
+        std::vector<std::pair<float, const std::vector<Stroke>*>> strokes; // distProc of the line pair, its strokes
+    };
+
     /*methods*/
     inline bool checkLength(float dist) const;
     MatrixParams getMatrixParams(const QVector<QVector3D> &vertices) const;
     void concatenateMatrixParameters(MatrixParams& srcDst, const MatrixParams& src) const;
-    inline int getColorIndx(Epoch::Echogram* charts, int ampIndx) const;
+    inline int getColorIndx(const AmplitudeView& compensated, int ampIndx) const;
     void postUpdate();
     void updateTilesTexture();
     void updateUnmarkedHeightVertices(Tile* tilePtr) const;
+    void drawLinePairs(std::vector<LinePair>& linePairs, const QVector<QVector3D>& measLinesVertices);
+    void rasterizeLinePair(LinePair& linePair, const QVector<QVector3D>& measLinesVertices) const;
+    void drawTileTask(const TileTask& tileTask);
     bool checkChannel(int val) const;
 
     /*data*/
     static constexpr float amplitudeCoeff_ = 100.0f;
     static constexpr int colorTableSize_ = 255;
     static constexpr int interpLineWidth_ = 1;
+    static constexpr int linePairBlockSize_ = 512;
+    static constexpr qint64 textureUploadBudget_ = 32ll * 1024 * 1024; // image bytes read for the renderer per frame
 
     std::vector<uint8_t> colorTableTextureTask_;
-    QHash<QUuid, std::vector<uint8_t>> tileTextureTasks_;
+    QHash<QUuid, bool> tileTextureTasks_; // true to upload the image of the tile, read when the renderer takes it; false to delete its texture
+    QVector3D lastCameraPos_;
     PlotColorTable colorTable_;
     MatrixParams lastMatParams_;
     Dataset* datasetPtr_;
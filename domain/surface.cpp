@@ -2,6 +2,7 @@
 #include <boundarydetector.h>
 #include <Triangle.h>
 #include <draw_utils.h>
+#include <vertex_buffer_manager.h>
 
 Surface::Surface(QObject* parent)
 : SceneObject(new SurfaceRenderImplementation, parent)
@@ -9,7 +10,13 @@ Surface::Surface(QObject* parent)
 , m_grid(std::make_shared <SurfaceGrid>())
 {
     QObject::connect(m_grid.get(), &SurfaceGrid::changed, [this](){
-        RENDER_IMPL(Surface)->m_gridRenderImpl = *m_grid->m_renderImpl;
+        auto impl = RENDER_IMPL(Surface);
+        impl->m_gridRenderImpl = *m_grid->m_renderImpl;
+        for (auto& tileGrid : impl->m_tileGrids) {
+            tileGrid.setColor(m_grid->color());
+            tileGrid.setWidth(m_grid->width());
+            tileGrid.setVisible(m_grid->isVisible());
+        }
         Q_EMIT changed();
     });
 
@@ -49,6 +56,8 @@ SurfaceProcessorTask Surface::processingTask() const
 
 void Surface::setData(const QVector<QVector3D>& data, int primitiveType)
 {
+    clearTiles();
+
     SceneObject::setData(data, primitiveType);
 
     updateGrid();
@@ -59,6 +68,8 @@ void Surface::setData(const QVector<QVector3D>& data, int primitiveType)
 
 void Surface::clearData()
 {
+    clearTiles();
+
     SceneObject::clearData();
 
     m_grid->clearData();
@@ -67,11 +78,53 @@ void Surface::clearData()
     Q_EMIT changed();
 }
 
+void Surface::updateTiles(const QHash<QPoint, QVector<QVector3D>>& tiles, bool reset)
+{
+    auto impl = RENDER_IMPL(Surface);
+
+    if (reset) {
+        clearTiles();
+        impl->setData(QVector<QVector3D>(), GL_TRIANGLES);
+        m_grid->clearData();
+    }
+
+    // the contour goes around the whole surface, it is rebuilt by full updates only
+    m_contour->clearData();
+
+    for (auto it = tiles.cbegin(); it != tiles.cend(); ++it) {
+        if (it.value().isEmpty()) {
+            impl->m_tiles.remove(it.key());
+            impl->m_tileGrids.remove(it.key());
+            continue;
+        }
+
+        impl->m_tiles[it.key()].setData(it.value(), GL_TRIANGLES);
+
+        auto& tileGrid = impl->m_tileGrids[it.key()];
+        tileGrid.setData(makeTriangleGridLines(it.value()), GL_LINES);
+        tileGrid.setColor(m_grid->color());
+        tileGrid.setWidth(m_grid->width());
+        tileGrid.setVisible(m_grid->isVisible());
+    }
+
+    impl->createBounds();
+
+    Q_EMIT changed();
+    Q_EMIT boundsChanged();
+}
+
+void Surface::clearTiles()
+{
+    auto impl = RENDER_IMPL(Surface);
+    impl->m_tiles.clear();
+    impl->m_tileGrids.clear();
+}
+
 void Surface::updateGrid()
 {
     m_grid->clearData();
 
-    switch(RENDER_IMPL(Surface)->primitiveType()){
+    switch(RENDER_IMPL_CONST(Surface)->primitiveType()){
     case GL_TRIANGLES:
         makeTriangleGrid();
         break;
@@ -107,12 +160,19 @@ void Surface::makeTriangleGrid()
     if (impl->cdata().size() < 3)
         return;
 
+    m_grid->setData(makeTriangleGridLines(impl->cdata()), GL_LINES);
+    impl->m_gridRenderImpl = *m_grid->m_renderImpl;
+}
+
+QVector<QVector3D> Surface::makeTriangleGridLines(const QVector<QVector3D>& triangles) const
+{
     QVector <QVector3D> grid;
+    grid.reserve(triangles.size() * 2);
 
-    for (int i = 0; i < impl->cdata().size()-3; i+=3){
-        QVector3D A = impl->cdata()[i];
-        QVector3D B = impl->cdata()[i+1];
-        QVector3D C = impl->cdata()[i+2];
+    for (int i = 0; i + 2 < triangles.size(); i+=3){
+        QVector3D A = triangles[i];
+        QVector3D B = triangles[i+1];
+        QVector3D C = triangles[i+2];
 
         A.setZ(A.z() + 0.03);
         B.setZ(B.z() + 0.03);
@@ -123,8 +183,7 @@ void Surface::makeTriangleGrid()
                      A, C});
     }
 
-    m_grid->setData(grid, GL_LINES);
-    impl->m_gridRenderImpl = *m_grid->m_renderImpl;
+    return grid;
 }
 
 void Surface::makeQuadGrid()
@@ -223,7 +282,7 @@ void Surface::updateContour()
 {
     m_contour->clearData();
 
-    switch(RENDER_IMPL(Surface)->primitiveType()){
+    switch(RENDER_IMPL_CONST(Surface)->primitiveType()){
     case GL_TRIANGLES:
         makeContourFromTriangles();
         break;
@@ -235,11 +294,30 @@ void Surface::updateContour()
     }
 }
 
+void Surface::SurfaceRenderImplementation::createBounds()
+{
+    SceneObject::RenderImplementation::createBounds();
+
+    bool isEmpty = m_data.isEmpty();
+    for (const auto& tile : m_tiles) {
+        if (isEmpty) {
+            m_bounds = tile.bounds();
+            isEmpty = false;
+        }
+        else {
+            m_bounds.merge(tile.bounds());
+        }
+    }
+}
+
 void Surface::SurfaceRenderImplementation::render(QOpenGLFunctions *ctx, const QMatrix4x4 &mvp, const QMap<QString, std::shared_ptr<QOpenGLShaderProgram>> &shaderProgramMap) const
 {
     m_gridRenderImpl.render(ctx, mvp, shaderProgramMap);
     m_contourRenderImpl.render(ctx, mvp, shaderProgramMap);
 
+    for (const auto& tileGrid : m_tileGrids)
+        tileGrid.render(ctx, mvp, shaderProgramMap);
+
     if(!m_isVisible)
         return;
 
@@ -265,18 +343,23 @@ void Surface::SurfaceRenderImplementation::render(QOpenGLFunctions *ctx, const Q
 
 #if defined (Q_OS_ANDROID)
     if (primitiveType() == GL_TRIANGLES) {
-        shaderProgram->setAttributeArray(posLoc, m_data.constData());
+        VertexBufferManager::setAttributeArray(shaderProgram.get(), posLoc, &m_data, m_data);
         ctx->glDrawArrays(m_primitiveType, 0, m_data.size());
     }
     else if (primitiveType() == GL_QUADS) {
-        shaderProgram->setAttributeArray(posLoc, quadSurfaceVertices_.constData());
+        VertexBufferManager::setAttributeArray(shaderProgram.get(), posLoc, &quadSurfaceVertices_, quadSurfaceVertices_);
         ctx->glDrawArrays(GL_TRIANGLES, 0, quadSurfaceVertices_.size());
     }
 #else
-    shaderProgram->setAttributeArray(posLoc, m_data.constData());
+    VertexBufferManager::setAttributeArray(shaderProgram.get(), posLoc, &m_data, m_data);
     ctx->glDrawArrays(m_primitiveType, 0, m_data.size());
 #endif
 
+    for (const auto& tile : m_tiles) {
+        VertexBufferManager::setAttributeArray(shaderProgram.get(), posLoc, &tile.cdata(), tile.cdata());
+        ctx->glDrawArrays(GL_TRIANGLES, 0, tile.cdata().size());
+    }
+
     shaderProgram->disableAttributeArray(posLoc);
     shaderProgram->release();
 }
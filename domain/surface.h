@@ -3,6 +3,9 @@
 
 #include <memory>
 
+#include <QHash>
+#include <QPoint>
+
 #include <sceneobject.h>
 #include <contour.h>
 #include <surfacegrid.h>
@@ -27,8 +30,13 @@ public:
 #if defined (Q_OS_ANDROID)
         QVector<QVector3D> quadSurfaceVertices_;
 #endif
+    protected:
+        virtual void createBounds() override;
+
     private:
         friend class Surface;
+        QHash<QPoint, SceneObject::RenderImplementation> m_tiles;
+        QHash<QPoint, SceneObject::RenderImplementation> m_tileGrids;
         SceneObject::RenderImplementation m_gridRenderImpl;
         SceneObject::RenderImplementation m_contourRenderImpl;
         float m_verticalScale = 1;
@@ -43,12 +51,15 @@ public:
     Contour* contour() const;
     SurfaceGrid* grid() const;
     SurfaceProcessorTask processingTask() const;
+    void updateTiles(const QHash<QPoint, QVector<QVector3D>>& tiles, bool reset);
 
 
 private:
     void updateContour();
     void updateGrid();
     void makeTriangleGrid();
+    QVector<QVector3D> makeTriangleGridLines(const QVector<QVector3D>& triangles) const;
+    void clearTiles();
     void makeQuadGrid();
     void makeContourFromTriangles();
     void makeContourFromQuads();
@@ -10,7 +10,7 @@ SurfaceGrid::~SurfaceGrid()
 
 bool SurfaceGrid::isTriangle() const
 {
-    return RENDER_IMPL()->primitiveType() == GL_TRIANGLES;
+    return RENDER_IMPL_CONST()->primitiveType() == GL_TRIANGLES;
 }
 
 bool SurfaceGrid::isQuad() const
@@ -18,7 +18,7 @@ bool SurfaceGrid::isQuad() const
     bool retVal{ false };
 
 #ifndef Q_OS_ANDROID
-    retVal = RENDER_IMPL()->primitiveType() == GL_QUADS;
+    retVal = RENDER_IMPL_CONST()->primitiveType() == GL_QUADS;
 #endif
 
     return retVal;
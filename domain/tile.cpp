@@ -5,6 +5,7 @@ Tile::Tile(QVector3D origin, bool generateGridContour) :
     id_(QUuid::createUuid()),
     origin_(origin),
     textureId_(0),
+    textureLod_(0),
     isUpdate_(false),
     isInited_(false),
     generateGridContour_(generateGridContour)
@@ -15,6 +16,12 @@ void Tile::init(int sidePixelSize, int heightMatrixRatio, float resolution)
     // image data
     imageData_.resize(sidePixelSize * sidePixelSize, 0);
 
+    // lod images
+    lodImages_.clear();
+    for (int lodSide = sidePixelSize / 2; lodSide >= minLodSidePixelSize_; lodSide /= 2) {
+        lodImages_.emplace_back(lodSide * lodSide, 0);
+    }
+
     // height vertices
     int heightMatSideSize = heightMatrixRatio + 1;
     float heightPixelStep = (sidePixelSize / heightMatrixRatio) * resolution;
@@ -112,11 +119,97 @@ void Tile::updateHeightIndices()
     }
 }
 
+void Tile::updateLodImages(int begX, int begY, int endX, int endY)
+{
+    // each level pixel is the mean of its non-empty 2x2 children, only the changed rect is recalculated
+    const uint8_t* srcData = imageData_.data();
+    int srcSide = std::sqrt(static_cast<int>(imageData_.size()));
+
+    for (auto& lodImage : lodImages_) {
+        if (srcData == nullptr || begX >= endX || begY >= endY) {
+            break;
+        }
+
+        const int dstSide = srcSide / 2;
+        begX /= 2;
+        begY /= 2;
+        endX = std::min((endX + 1) / 2, dstSide);
+        endY = std::min((endY + 1) / 2, dstSide);
+        uint8_t* dstData = lodImage.data();
+
+        for (int i = begY; i < endY; ++i) {
+            const uint8_t* srcRowF = srcData + (2 * i) * srcSide;
+            const uint8_t* srcRowS = srcRowF + srcSide;
+            for (int j = begX; j < endX; ++j) {
+                const uint8_t vals[4] = { srcRowF[2 * j], srcRowF[2 * j + 1], srcRowS[2 * j], srcRowS[2 * j + 1] };
+                int sum = 0;
+                int cnt = 0;
+                for (uint8_t val : vals) {
+                    if (val) {
+                        sum += val;
+                        ++cnt;
+                    }
+                }
+                dstData[i * dstSide + j] = cnt ? static_cast<uint8_t>((sum + cnt / 2) / cnt) : 0;
+            }
+        }
+
+        srcData = dstData;
+        srcSide = dstSide;
+    }
+}
+
+void Tile::releaseFineLodImages()
+{
+    for (size_t i = 0; i + 1 < lodImages_.size(); ++i) {
+        std::vector<uint8_t>().swap(lodImages_[i]);
+    }
+}
+
+void Tile::restoreLodImages()
+{
+    if (lodImages_.empty() || !lodImages_.front().empty() || imageData_.empty()) {
+        return;
+    }
+
+    const int sidePixelSize = std::sqrt(static_cast<int>(imageData_.size()));
+    int lodSide = sidePixelSize;
+    for (auto& lodImage : lodImages_) {
+        lodSide /= 2;
+        lodImage.resize(lodSide * lodSide, 0);
+    }
+
+    updateLodImages(0, 0, sidePixelSize, sidePixelSize);
+}
+
+Tile Tile::cloneWithoutImage() const
+{
+    Tile retVal(origin_, generateGridContour_);
+    retVal.id_ = id_;
+    retVal.heightVertices_ = heightVertices_;
+    retVal.heightMarkVertices_ = heightMarkVertices_;
+    retVal.heightIndices_ = heightIndices_;
+    retVal.textureVertices_ = textureVertices_;
+    retVal.gridRenderImpl_ = gridRenderImpl_;
+    retVal.contourRenderImpl_ = contourRenderImpl_;
+    retVal.textureId_ = textureId_;
+    retVal.textureLod_ = textureLod_;
+    retVal.isUpdate_ = isUpdate_;
+    retVal.isInited_ = isInited_;
+
+    return retVal;
+}
+
 void Tile::setTextureId(GLuint val)
 {
     textureId_ = val;
 }
 
+void Tile::setTextureLod(int level)
+{
+    textureLod_ = level;
+}
+
 void Tile::setIsUpdate(bool state)
 {
     isUpdate_ = state;
@@ -142,6 +235,31 @@ GLuint Tile::getTextureId() const
     return textureId_;
 }
 
+int Tile::getTextureLod() const
+{
+    return textureLod_;
+}
+
+int Tile::getLodCount() const
+{
+    return static_cast<int>(lodImages_.size()) + 1;
+}
+
+qint64 Tile::getLodBytes() const
+{
+    qint64 retVal = 0;
+    for (const auto& lodImage : lodImages_) {
+        retVal += static_cast<qint64>(lodImage.size());
+    }
+
+    return retVal;
+}
+
+const std::vector<uint8_t>& Tile::getLodImageRef(int level) const
+{
+    return level > 0 ? lodImages_[level - 1] : imageData_;
+}
+
 int Tile::getIsUpdate() const
 {
     return isUpdate_;
@@ -16,13 +16,22 @@ public:
     Tile(QVector3D origin, bool generateGridContour);
     void init(int sidePixelSize, int heightMatrixRatio, float resolution);
     void updateHeightIndices();
+    void updateLodImages(int begX, int begY, int endX, int endY);
+    void releaseFineLodImages();
+    void restoreLodImages();
+    Tile cloneWithoutImage() const;
 
     void setTextureId(GLuint val);
+    void setTextureLod(int level);
     void setIsUpdate(bool state);
     QUuid                                    getUuid() const;
     QVector3D                                getOrigin() const;
     bool                                     getIsInited() const;
     GLuint                                   getTextureId() const;
+    int                                      getTextureLod() const;
+    int                                      getLodCount() const;
+    qint64                                   getLodBytes() const;
+    const std::vector<uint8_t>&              getLodImageRef(int level) const;
     int                                      getIsUpdate() const;
     std::vector<uint8_t>&                    getImageDataRef();
     QVector<QVector3D>&                      getHeightVerticesRef();
@@ -38,9 +47,12 @@ private:
     bool checkVerticesDepth(int topLeft, int topRight, int bottomLeft, int bottomRight) const;
 
     /*data*/
+    static constexpr int minLodSidePixelSize_ = 16;
+
     QUuid id_;
     QVector3D origin_;
     std::vector<uint8_t> imageData_;
+    std::vector<std::vector<uint8_t>> lodImages_; // 2x, 4x, 8x... downsampled image, only the coarsest one stays with a spilled image
     QVector<QVector3D> heightVertices_;
     QVector<char> heightMarkVertices_;
     QVector<int> heightIndices_;
@@ -48,6 +60,7 @@ private:
     SceneObject::RenderImplementation gridRenderImpl_;
     SceneObject::RenderImplementation contourRenderImpl_;
     GLuint textureId_;
+    int textureLod_;
     bool isUpdate_;
     bool isInited_;
     bool generateGridContour_;
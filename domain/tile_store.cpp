@@ -0,0 +1,152 @@
+#include "tile_store.h"
+
+#include <QDir>
+#include <QDebug>
+
+
+TileStore::TileStore() :
+    file_(QDir::tempPath() + QStringLiteral("/kogger_tiles_XXXXXX.bin")),
+    fileEnd_(0)
+{ }
+
+TileStore::~TileStore()
+{ }
+
+bool TileStore::write(const QUuid& tileId, const std::vector<uint8_t>& imageData)
+{
+    if (!open()) {
+        return false;
+    }
+
+    QByteArray compressed = qCompress(imageData.data(), static_cast<qsizetype>(imageData.size()), compressionLevel_);
+
+    auto it = records_.find(tileId);
+    if (it == records_.end() || it->capacity < compressed.size()) {
+        if (it != records_.end()) {
+            release(it->offset, it->capacity);
+        }
+
+        Record record;
+        record.capacity = (compressed.size() + pageSize_ - 1) / pageSize_ * pageSize_;
+        record.offset = allocate(record.capacity);
+        it = records_.insert(tileId, record);
+    }
+
+    if (!file_.seek(it->offset) || file_.write(compressed) != compressed.size()) {
+        qWarning() << "TileStore: writing tile failed:" << file_.errorString();
+        release(it->offset, it->capacity);
+        records_.erase(it);
+        return false;
+    }
+
+    it->size = compressed.size();
+
+    return true;
+}
+
+bool TileStore::read(const QUuid& tileId, std::vector<uint8_t>& imageData)
+{
+    auto it = records_.constFind(tileId);
+    if (it == records_.cend() || !file_.isOpen()) {
+        return false;
+    }
+
+    if (!file_.seek(it->offset)) {
+        return false;
+    }
+
+    QByteArray image = qUncompress(file_.read(it->size));
+    if (image.isEmpty()) {
+        qWarning() << "TileStore: reading tile failed:" << file_.errorString();
+        return false;
+    }
+
+    imageData.assign(image.cbegin(), image.cend());
+
+    return true;
+}
+
+bool TileStore::contains(const QUuid& tileId) const
+{
+    return records_.contains(tileId);
+}
+
+void TileStore::clear()
+{
+    records_.clear();
+    freeSpans_.clear();
+    fileEnd_ = 0;
+
+    if (file_.isOpen()) {
+        file_.resize(0);
+    }
+}
+
+qint64 TileStore::getFileSize() const
+{
+    return fileEnd_;
+}
+
+bool TileStore::open()
+{
+    if (file_.isOpen()) {
+        return true;
+    }
+
+    if (!file_.open()) {
+        qWarning() << "TileStore: can't open tile file:" << file_.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+qint64 TileStore::allocate(int capacity)
+{
+    for (auto it = freeSpans_.begin(); it != freeSpans_.end(); ++it) { // first fit, the list stays short
+        if (it->second < capacity) {
+            continue;
+        }
+
+        const qint64 offset = it->first;
+        const qint64 rest = it->second - capacity;
+        freeSpans_.erase(it);
+        if (rest > 0) {
+            freeSpans_.emplace(offset + capacity, rest);
+        }
+
+        return offset;
+    }
+
+    const qint64 offset = fileEnd_;
+    fileEnd_ += capacity;
+
+    return offset;
+}
+
+void TileStore::release(qint64 offset, int capacity)
+{
+    auto next = freeSpans_.lower_bound(offset);
+    qint64 size = capacity;
+
+    if (next != freeSpans_.end() && offset + size == next->first) {
+        size += next->second;
+        next = freeSpans_.erase(next);
+    }
+    if (next != freeSpans_.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            offset = prev->first;
+            size += prev->second;
+            freeSpans_.erase(prev);
+        }
+    }
+
+    if (offset + size == fileEnd_) {
+        fileEnd_ = offset;
+        file_.resize(fileEnd_);
+        return;
+    }
+
+    freeSpans_.emplace(offset, size);
+}
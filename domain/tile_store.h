@@ -0,0 +1,49 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <cstdint>
+#include <QHash>
+#include <QUuid>
+#include <QTemporaryFile>
+
+
+/*
+ * Tile images spilled out of memory. Images are kept compressed in one temporary file in records rounded up to
+ * pages, a tile written again reuses its record if the new image fits there. Records left by grown images go to a
+ * free list that later records are cut from, free space at the end of the file is truncated.
+ */
+class TileStore {
+public:
+    /*methods*/
+    TileStore();
+    ~TileStore();
+
+    bool write(const QUuid& tileId, const std::vector<uint8_t>& imageData);
+    bool read(const QUuid& tileId, std::vector<uint8_t>& imageData);
+    bool contains(const QUuid& tileId) const;
+    void clear();
+    qint64 getFileSize() const;
+
+private:
+    /*structures*/
+    struct Record {
+        qint64 offset = 0;
+        int size = 0;
+        int capacity = 0;
+    };
+
+    /*methods*/
+    bool open();
+    qint64 allocate(int capacity);
+    void release(qint64 offset, int capacity);
+
+    /*data*/
+    static constexpr int compressionLevel_ = 1;
+    static constexpr int pageSize_ = 4096;
+
+    QTemporaryFile file_;
+    QHash<QUuid, Record> records_;
+    std::map<qint64, qint64> freeSpans_; // offset, size; adjacent spans are merged
+    qint64 fileEnd_;
+};
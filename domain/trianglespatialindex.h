@@ -0,0 +1,174 @@
+#ifndef TRIANGLESPATIALINDEX_H
+#define TRIANGLESPATIALINDEX_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Triangle.h"
+
+/**
+ * @brief Uniform bucket grid over the bounding boxes of a triangle set.
+ * Point queries and lattice rasterization answer with the lowest index of a triangle holding the point, the
+ * same triangle a linear scan with Triangle::contains() stops at, so results do not depend on the index.
+ */
+template <typename T>
+class TriangleSpatialIndex
+{
+public:
+
+    /**
+    * @brief Builds the buckets, about two triangles fall into a bucket.
+    * @param triangles Triangles to index, the index keeps only their vertices.
+    */
+    void build(const std::vector <Triangle <T>>& triangles)
+    {
+        mCorners.clear();
+        mCellStart.clear();
+        mItems.clear();
+        mCols = 0;
+        mRows = 0;
+
+        if (triangles.empty())
+            return;
+
+        mCorners.reserve(triangles.size());
+        for (const auto& t : triangles)
+            mCorners.push_back({ t.A().x(), t.A().y(), t.B().x(), t.B().y(), t.C().x(), t.C().y() });
+
+        mMinX = mMaxX = mCorners.front().ax;
+        mMinY = mMaxY = mCorners.front().ay;
+        for (const auto& c : mCorners) {
+            mMinX = std::min({ mMinX, c.ax, c.bx, c.cx });
+            mMaxX = std::max({ mMaxX, c.ax, c.bx, c.cx });
+            mMinY = std::min({ mMinY, c.ay, c.by, c.cy });
+            mMaxY = std::max({ mMaxY, c.ay, c.by, c.cy });
+        }
+
+        const T area = std::max((mMaxX - mMinX) * (mMaxY - mMinY), std::numeric_limits <T>::min());
+        mCellSize = std::sqrt(area * static_cast <T> (2.0) / static_cast <T> (mCorners.size()));
+        if (!(mCellSize > static_cast <T> (0.0)))
+            mCellSize = static_cast <T> (1.0);
+
+        mCols = std::clamp(static_cast <int> ((mMaxX - mMinX) / mCellSize) + 1, 1, maxCells_);
+        mRows = std::clamp(static_cast <int> ((mMaxY - mMinY) / mCellSize) + 1, 1, maxCells_);
+        mCellSize = std::max((mMaxX - mMinX) / mCols, (mMaxY - mMinY) / mRows) * static_cast <T> (1.0001);
+        if (!(mCellSize > static_cast <T> (0.0)))
+            mCellSize = static_cast <T> (1.0);
+
+        // two passes, counts then items, triangles stay in ascending order inside every bucket
+        mCellStart.assign(static_cast <size_t> (mCols) * mRows + 1, 0);
+        forEachCell([this](int, size_t cell) { ++mCellStart[cell + 1]; });
+        for (size_t i = 1; i < mCellStart.size(); ++i)
+            mCellStart[i] += mCellStart[i - 1];
+
+        mItems.resize(mCellStart.back());
+        std::vector <int> fill(mCellStart.begin(), mCellStart.end() - 1);
+        forEachCell([this, &fill](int index, size_t cell) { mItems[fill[cell]++] = index; });
+    }
+
+    /**
+    * @brief Returns index of the first triangle holding the point, -1 if there is none.
+    */
+    int find(const Point3D <T>& p) const
+    {
+        if (mItems.empty())
+            return -1;
+
+        const int col = static_cast <int> (std::floor((p.x() - mMinX) / mCellSize));
+        const int row = static_cast <int> (std::floor((p.y() - mMinY) / mCellSize));
+        if (col < 0 || col >= mCols || row < 0 || row >= mRows)
+            return -1;
+
+        const size_t cell = static_cast <size_t> (row) * mCols + col;
+        for (int i = mCellStart[cell]; i < mCellStart[cell + 1]; ++i) {
+            if (contains(mCorners[mItems[i]], p.x(), p.y()))
+                return mItems[i];
+        }
+
+        return -1;
+    }
+
+    /**
+    * @brief Rasterizes the triangles into the lattice origin + (col, row) * step, the way
+    * GridGenerator::generateQuadGrid places quad corners.
+    * @return Row-major cols x rows node map with the first triangle holding every node, -1 for uncovered nodes.
+    */
+    std::vector <int> rasterize(const Point3D <T>& origin, T step, int cols, int rows) const
+    {
+        std::vector <int> nodes(static_cast <size_t> (std::max(cols, 0)) * std::max(rows, 0), -1);
+        if (cols <= 0 || rows <= 0 || !(step > static_cast <T> (0.0)))
+            return nodes;
+
+        for (int index = 0; index < static_cast <int> (mCorners.size()); ++index) {
+            const Corners& c = mCorners[index];
+
+            // one node of margin on every side, the exact test below decides
+            const int colFrom = std::max(0, static_cast <int> (std::floor((std::min({ c.ax, c.bx, c.cx }) - origin.x()) / step)) - 1);
+            const int colTo = std::min(cols - 1, static_cast <int> (std::floor((std::max({ c.ax, c.bx, c.cx }) - origin.x()) / step)) + 1);
+            const int rowFrom = std::max(0, static_cast <int> (std::floor((std::min({ c.ay, c.by, c.cy }) - origin.y()) / step)) - 1);
+            const int rowTo = std::min(rows - 1, static_cast <int> (std::floor((std::max({ c.ay, c.by, c.cy }) - origin.y()) / step)) + 1);
+
+            for (int row = rowFrom; row <= rowTo; ++row) {
+                const T y = origin.y() + row * step;
+                for (int col = colFrom; col <= colTo; ++col) {
+                    int& node = nodes[static_cast <size_t> (row) * cols + col];
+                    if (node < 0 && contains(c, origin.x() + col * step, y))
+                        node = index;
+                }
+            }
+        }
+
+        return nodes;
+    }
+
+private:
+
+    struct Corners {
+        T ax, ay, bx, by, cx, cy;
+    };
+
+    //! Same arithmetic as Triangle::contains(), points on an edge belong to the triangle
+    static bool contains(const Corners& c, T px, T py)
+    {
+        const T b = (c.ax - px) * (c.by - c.ay) - (c.ay - py) * (c.bx - c.ax);
+        const T q = (c.bx - px) * (c.cy - c.by) - (c.by - py) * (c.cx - c.bx);
+        const T r = (c.cx - px) * (c.ay - c.cy) - (c.cy - py) * (c.ax - c.cx);
+
+        return (b <= 0.0 && q <= 0.0 && r <= 0.0) || (b >= 0.0 && q >= 0.0 && r >= 0.0);
+    }
+
+    template <typename Func>
+    void forEachCell(Func&& func) const
+    {
+        for (int index = 0; index < static_cast <int> (mCorners.size()); ++index) {
+            const Corners& c = mCorners[index];
+            const int colFrom = cellOf(std::min({ c.ax, c.bx, c.cx }), mMinX, mCols);
+            const int colTo = cellOf(std::max({ c.ax, c.bx, c.cx }), mMinX, mCols);
+            const int rowFrom = cellOf(std::min({ c.ay, c.by, c.cy }), mMinY, mRows);
+            const int rowTo = cellOf(std::max({ c.ay, c.by, c.cy }), mMinY, mRows);
+
+            for (int row = rowFrom; row <= rowTo; ++row)
+                for (int col = colFrom; col <= colTo; ++col)
+                    func(index, static_cast <size_t> (row) * mCols + col);
+        }
+    }
+
+    int cellOf(T value, T min, int count) const
+    {
+        return std::clamp(static_cast <int> (std::floor((value - min) / mCellSize)), 0, count - 1);
+    }
+
+    static constexpr int maxCells_ = 4096;
+
+    std::vector <Corners> mCorners;
+    std::vector <int> mCellStart; ///< Bucket i holds mItems[mCellStart[i], mCellStart[i + 1])
+    std::vector <int> mItems;
+    T mMinX = 0, mMinY = 0, mMaxX = 0, mMaxY = 0;
+    T mCellSize = 1;
+    int mCols = 0;
+    int mRows = 0;
+};
+
+#endif // TRIANGLESPATIALINDEX_H
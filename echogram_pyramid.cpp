@@ -0,0 +1,182 @@
+#include "echogram_pyramid.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+EchogramPyramid::EchogramPyramid() :
+    stat_(Stat::Max),
+    builds_(0)
+{
+
+}
+
+void EchogramPyramid::setSource(SourceFunc source)
+{
+    source_ = std::move(source);
+}
+
+void EchogramPyramid::setStat(Stat stat)
+{
+    if (stat_ == stat) {
+        return;
+    }
+
+    stat_ = stat;
+    for (auto& channel : channels_) {
+        channel.levels.clear();
+    }
+}
+
+void EchogramPyramid::update(int channel, int epochIndx)
+{
+    if (epochIndx < 0 || !source_) {
+        return;
+    }
+
+    Channel& chan = channels_[channel];
+    chan.epochsEnd = std::max(chan.epochsEnd, epochIndx + 1);
+
+    if (chan.levels.isEmpty()) { // not read zoomed out yet
+        return;
+    }
+
+    for (int level = 1; level <= maxLevel; ++level) {
+        auto& rows = chan.levels[level - 1];
+        const int rowIndx = epochIndx >> level;
+        if (rows.size() <= rowIndx) {
+            rows.resize(rowIndx + 1);
+        }
+
+        rows[rowIndx].isDirty = true;
+    }
+}
+
+void EchogramPyramid::clear()
+{
+    channels_.clear();
+}
+
+const EchogramPyramid::Row* EchogramPyramid::row(int channel, int level, int epochIndx)
+{
+    auto it = channels_.find(channel);
+    if (it == channels_.end() || level < 1 || level > maxLevel || epochIndx < 0 || epochIndx >= it->epochsEnd) {
+        return nullptr;
+    }
+
+    Levels& levels = it->levels;
+    if (levels.isEmpty()) { // the first zoomed out read, every row waits to be built
+        levels.resize(maxLevel);
+        for (int l = 1; l <= maxLevel; ++l) {
+            levels[l - 1].resize(((it->epochsEnd - 1) >> l) + 1);
+        }
+    }
+
+    auto& rows = levels[level - 1];
+    const int rowIndx = epochIndx >> level;
+
+    if (rows[rowIndx].isDirty) {
+        build(levels, channel, level, rowIndx);
+    }
+
+    return rows[rowIndx].count > 0 ? &rows[rowIndx] : nullptr;
+}
+
+int EchogramPyramid::firstChannel() const
+{
+    return channels_.isEmpty() ? -1 : channels_.firstKey();
+}
+
+EchogramPyramid::Stat EchogramPyramid::stat() const
+{
+    return stat_;
+}
+
+void EchogramPyramid::build(Levels& levels, int channel, int level, int rowIndx)
+{
+    Span children[2];
+
+    for (int i = 0; i < 2; ++i) {
+        const int childIndx = rowIndx * 2 + i;
+
+        if (level == 1) {
+            const Source source = source_(channel, childIndx);
+            if (source.data != nullptr && source.size > 0 && source.resolution > 0) {
+                children[i] = { source.data, source.size, source.resolution, source.offset, 1 };
+            }
+        }
+        else {
+            auto& childRows = levels[level - 2];
+            if (childIndx < childRows.size()) {
+                if (childRows[childIndx].isDirty) {
+                    build(levels, channel, level - 1, childIndx);
+                }
+
+                const Row& child = childRows[childIndx];
+                children[i] = { child.data.constData(), child.data.size(), child.resolution, child.offset, child.count };
+            }
+        }
+    }
+
+    Row& row = levels[level - 1][rowIndx];
+    combine(children[0], children[1], row);
+    row.stamp = ++builds_;
+    row.isDirty = false;
+}
+
+void EchogramPyramid::combine(const Span& first, const Span& second, Row& row) const
+{
+    const Span& grid = first.count > 0 ? first : second; // the row takes the grid of its first chart
+    const Span& other = first.count > 0 ? second : first;
+
+    row.resolution = grid.resolution;
+    row.offset = grid.offset;
+    row.count = first.count + second.count;
+
+    if (grid.count == 0) {
+        row.data.clear();
+        return;
+    }
+
+    const bool isSameGrid = other.count == 0 || (other.resolution == grid.resolution && other.offset == grid.offset);
+    int size = grid.size;
+    if (other.count > 0) {
+        if (isSameGrid) {
+            size = std::max(size, other.size);
+        }
+        else {
+            const float otherEnd = (other.offset + other.size * other.resolution - grid.offset) / grid.resolution;
+            size = std::max(size, static_cast<int>(std::ceil(otherEnd)));
+        }
+    }
+
+    row.data.resize(size);
+    uint8_t* dst = row.data.data();
+    const bool isMax = stat_ == Stat::Max;
+
+    for (int i = 0; i < size; ++i) {
+        int maxVal = 0;
+        int sum = 0;
+        int weight = 0;
+
+        if (i < grid.size) {
+            maxVal = grid.data[i];
+            sum = grid.data[i] * grid.count;
+            weight = grid.count;
+        }
+
+        int j = i;
+        if (!isSameGrid) { // nearest sample of the other grid
+            const float pos = (grid.offset + i * grid.resolution - other.offset) / other.resolution;
+            j = pos < 0 ? -1 : static_cast<int>(pos);
+        }
+
+        if (other.count > 0 && j >= 0 && j < other.size) {
+            maxVal = std::max<int>(maxVal, other.data[j]);
+            sum += other.data[j] * other.count;
+            weight += other.count;
+        }
+
+        dst[i] = static_cast<uint8_t>(isMax ? maxVal : (weight > 0 ? (sum + weight / 2) / weight : 0));
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <functional>
+#include <QMap>
+#include <QVector>
+
+
+/*
+ * Aggregation of the echogram over epochs for the zoomed out views. Level L holds one row per 2^L consecutive
+ * epochs of a channel with the per-sample maximum or mean of their charts, on the sample grid of the first
+ * chart in the row. Nothing is built until a zoomed out view reads a row; a read row is built from its children,
+ * down to the charts, and rows that got epochs or a replaced chart since are rebuilt when read again. Only the
+ * selected statistic is kept, changing it drops the rows. Rows under the viewed ones take at most the memory
+ * of the charts.
+ */
+class EchogramPyramid
+{
+public:
+    /*structures*/
+    enum class Stat {
+        Max,
+        Mean
+    };
+
+    struct Source { // the chart of one epoch
+        const uint8_t* data = nullptr;
+        int size = 0;
+        float resolution = 0; // m
+        float offset = 0;     // m
+    };
+
+    struct Row {
+        QVector<uint8_t> data; // of the selected statistic
+        float resolution = 0; // m
+        float offset = 0;     // m
+        int count = 0;        // epochs with a chart
+        quint64 stamp = 0;    // unique to each build of the row
+        bool isDirty = true;
+    };
+
+    using SourceFunc = std::function<Source(int channel, int epochIndx)>;
+
+    static constexpr int maxLevel = 16;
+
+    /*methods*/
+    EchogramPyramid();
+
+    void setSource(SourceFunc source);
+    void setStat(Stat stat);
+    void update(int channel, int epochIndx); // the chart of the epoch was set or replaced
+    void clear();
+
+    // the row of the level that covers the epoch, nullptr if none of its epochs has a chart
+    const Row* row(int channel, int level, int epochIndx);
+    int firstChannel() const;
+    Stat stat() const;
+
+private:
+    /*structures*/
+    using Levels = QVector<QVector<Row>>; // [level - 1][row], empty until the channel is read zoomed out
+
+    struct Channel {
+        Levels levels;
+        int epochsEnd = 0; // past the last epoch with a chart
+    };
+
+    struct Span {
+        const uint8_t* data = nullptr;
+        int size = 0;
+        float resolution = 0;
+        float offset = 0;
+        int count = 0;
+    };
+
+    /*methods*/
+    void build(Levels& levels, int channel, int level, int rowIndx);
+    void combine(const Span& first, const Span& second, Row& row) const;
+
+    /*data*/
+    SourceFunc source_;
+    QMap<int, Channel> channels_;
+    Stat stat_;
+    quint64 builds_;
+};
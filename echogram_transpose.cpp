@@ -0,0 +1,218 @@
+#include "echogram_transpose.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ECHOGRAM_TRANSPOSE_X86
+#include <immintrin.h>
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#elif defined(__aarch64__)
+#define ECHOGRAM_TRANSPOSE_NEON
+#include <arm_neon.h>
+#endif
+
+
+namespace {
+
+constexpr int tileColumns = 64; // image bytes of one row in a tile, a cache line
+
+inline uint8_t saturate(int16_t val)
+{
+    return val < 0 ? 0 : (val > 255 ? 255 : static_cast<uint8_t>(val));
+}
+
+void writeBlockScalar(const int16_t* columns, int height, int fromColumn, int toColumn, int fromRow, int toRow, uint8_t* image, int stride)
+{
+    for (int row = fromRow; row < toRow; ++row) {
+        uint8_t* dst = image + static_cast<ptrdiff_t>(row) * stride;
+        const int16_t* src = columns + row;
+        for (int column = fromColumn; column < toColumn; ++column) {
+            dst[column] = saturate(src[static_cast<ptrdiff_t>(column) * height]);
+        }
+    }
+}
+
+void writeScalar(const int16_t* columns, int height, int from, int to, uint8_t* image, int stride)
+{
+    for (int tile = from; tile < to; tile += tileColumns) {
+        writeBlockScalar(columns, height, tile, std::min(to, tile + tileColumns), 0, height, image, stride);
+    }
+}
+
+#ifdef ECHOGRAM_TRANSPOSE_X86
+// r[i] holds 8 rows of column i on entry and 8 columns of row i on exit
+TARGET_SSE2 inline void transpose8x8Sse2(__m128i* r)
+{
+    const __m128i t0 = _mm_unpacklo_epi16(r[0], r[1]);
+    const __m128i t1 = _mm_unpackhi_epi16(r[0], r[1]);
+    const __m128i t2 = _mm_unpacklo_epi16(r[2], r[3]);
+    const __m128i t3 = _mm_unpackhi_epi16(r[2], r[3]);
+    const __m128i t4 = _mm_unpacklo_epi16(r[4], r[5]);
+    const __m128i t5 = _mm_unpackhi_epi16(r[4], r[5]);
+    const __m128i t6 = _mm_unpacklo_epi16(r[6], r[7]);
+    const __m128i t7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+    const __m128i u0 = _mm_unpacklo_epi32(t0, t2);
+    const __m128i u1 = _mm_unpackhi_epi32(t0, t2);
+    const __m128i u2 = _mm_unpacklo_epi32(t1, t3);
+    const __m128i u3 = _mm_unpackhi_epi32(t1, t3);
+    const __m128i u4 = _mm_unpacklo_epi32(t4, t6);
+    const __m128i u5 = _mm_unpackhi_epi32(t4, t6);
+    const __m128i u6 = _mm_unpacklo_epi32(t5, t7);
+    const __m128i u7 = _mm_unpackhi_epi32(t5, t7);
+
+    r[0] = _mm_unpacklo_epi64(u0, u4);
+    r[1] = _mm_unpackhi_epi64(u0, u4);
+    r[2] = _mm_unpacklo_epi64(u1, u5);
+    r[3] = _mm_unpackhi_epi64(u1, u5);
+    r[4] = _mm_unpacklo_epi64(u2, u6);
+    r[5] = _mm_unpackhi_epi64(u2, u6);
+    r[6] = _mm_unpacklo_epi64(u3, u7);
+    r[7] = _mm_unpackhi_epi64(u3, u7);
+}
+
+TARGET_SSE2 void writeSse2(const int16_t* columns, int height, int from, int to, uint8_t* image, int stride)
+{
+    const int rows = height & ~7;
+
+    for (int tile = from; tile < to; tile += tileColumns) {
+        const int tileEnd = std::min(to, tile + tileColumns);
+        const int blockEnd = tile + ((tileEnd - tile) & ~15);
+
+        for (int row = 0; row < rows; row += 8) {
+            for (int column = tile; column < blockEnd; column += 16) {
+                __m128i lo[8];
+                __m128i hi[8];
+                for (int i = 0; i < 8; ++i) {
+                    lo[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columns + static_cast<ptrdiff_t>(column + i) * height + row));
+                    hi[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columns + static_cast<ptrdiff_t>(column + 8 + i) * height + row));
+                }
+
+                transpose8x8Sse2(lo);
+                transpose8x8Sse2(hi);
+
+                for (int i = 0; i < 8; ++i) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(image + static_cast<ptrdiff_t>(row + i) * stride + column), _mm_packus_epi16(lo[i], hi[i]));
+                }
+            }
+        }
+
+        writeBlockScalar(columns, height, blockEnd, tileEnd, 0, height, image, stride);
+        writeBlockScalar(columns, height, tile, blockEnd, rows, height, image, stride);
+    }
+}
+#endif
+
+#ifdef ECHOGRAM_TRANSPOSE_NEON
+// r[i] holds 8 rows of column i on entry and 8 columns of row i on exit
+inline void transpose8x8Neon(int16x8_t* r)
+{
+    const int16x8x2_t t01 = vtrnq_s16(r[0], r[1]);
+    const int16x8x2_t t23 = vtrnq_s16(r[2], r[3]);
+    const int16x8x2_t t45 = vtrnq_s16(r[4], r[5]);
+    const int16x8x2_t t67 = vtrnq_s16(r[6], r[7]);
+
+    const int32x4x2_t u02 = vtrnq_s32(vreinterpretq_s32_s16(t01.val[0]), vreinterpretq_s32_s16(t23.val[0]));
+    const int32x4x2_t u13 = vtrnq_s32(vreinterpretq_s32_s16(t01.val[1]), vreinterpretq_s32_s16(t23.val[1]));
+    const int32x4x2_t u46 = vtrnq_s32(vreinterpretq_s32_s16(t45.val[0]), vreinterpretq_s32_s16(t67.val[0]));
+    const int32x4x2_t u57 = vtrnq_s32(vreinterpretq_s32_s16(t45.val[1]), vreinterpretq_s32_s16(t67.val[1]));
+
+    r[0] = vreinterpretq_s16_s32(vcombine_s32(vget_low_s32(u02.val[0]), vget_low_s32(u46.val[0])));
+    r[1] = vreinterpretq_s16_s32(vcombine_s32(vget_low_s32(u13.val[0]), vget_low_s32(u57.val[0])));
+    r[2] = vreinterpretq_s16_s32(vcombine_s32(vget_low_s32(u02.val[1]), vget_low_s32(u46.val[1])));
+    r[3] = vreinterpretq_s16_s32(vcombine_s32(vget_low_s32(u13.val[1]), vget_low_s32(u57.val[1])));
+    r[4] = vreinterpretq_s16_s32(vcombine_s32(vget_high_s32(u02.val[0]), vget_high_s32(u46.val[0])));
+    r[5] = vreinterpretq_s16_s32(vcombine_s32(vget_high_s32(u13.val[0]), vget_high_s32(u57.val[0])));
+    r[6] = vreinterpretq_s16_s32(vcombine_s32(vget_high_s32(u02.val[1]), vget_high_s32(u46.val[1])));
+    r[7] = vreinterpretq_s16_s32(vcombine_s32(vget_high_s32(u13.val[1]), vget_high_s32(u57.val[1])));
+}
+
+void writeNeon(const int16_t* columns, int height, int from, int to, uint8_t* image, int stride)
+{
+    const int rows = height & ~7;
+
+    for (int tile = from; tile < to; tile += tileColumns) {
+        const int tileEnd = std::min(to, tile + tileColumns);
+        const int blockEnd = tile + ((tileEnd - tile) & ~15);
+
+        for (int row = 0; row < rows; row += 8) {
+            for (int column = tile; column < blockEnd; column += 16) {
+                int16x8_t lo[8];
+                int16x8_t hi[8];
+                for (int i = 0; i < 8; ++i) {
+                    lo[i] = vld1q_s16(columns + static_cast<ptrdiff_t>(column + i) * height + row);
+                    hi[i] = vld1q_s16(columns + static_cast<ptrdiff_t>(column + 8 + i) * height + row);
+                }
+
+                transpose8x8Neon(lo);
+                transpose8x8Neon(hi);
+
+                for (int i = 0; i < 8; ++i) {
+                    vst1q_u8(image + static_cast<ptrdiff_t>(row + i) * stride + column, vcombine_u8(vqmovun_s16(lo[i]), vqmovun_s16(hi[i])));
+                }
+            }
+        }
+
+        writeBlockScalar(columns, height, blockEnd, tileEnd, 0, height, image, stride);
+        writeBlockScalar(columns, height, tile, blockEnd, rows, height, image, stride);
+    }
+}
+#endif
+
+} // namespace
+
+
+EchogramTranspose::EchogramTranspose() :
+    isa_(bestIsa())
+{
+
+}
+
+EchogramTranspose::Isa EchogramTranspose::bestIsa()
+{
+#if defined(ECHOGRAM_TRANSPOSE_X86)
+    if (__builtin_cpu_supports("sse2")) {
+        return Isa::Sse2;
+    }
+#elif defined(ECHOGRAM_TRANSPOSE_NEON)
+    return Isa::Neon;
+#endif
+    return Isa::Scalar;
+}
+
+void EchogramTranspose::setIsa(Isa isa)
+{
+    bool isSupported = isa == Isa::Scalar;
+
+#if defined(ECHOGRAM_TRANSPOSE_X86)
+    isSupported |= isa == Isa::Sse2 && __builtin_cpu_supports("sse2");
+#elif defined(ECHOGRAM_TRANSPOSE_NEON)
+    isSupported |= isa == Isa::Neon;
+#endif
+
+    isa_ = isSupported ? isa : bestIsa();
+}
+
+EchogramTranspose::Isa EchogramTranspose::isa() const
+{
+    return isa_;
+}
+
+void EchogramTranspose::write(const int16_t* columns, int height, int from, int to, uint8_t* image, int stride) const
+{
+    if (columns == nullptr || image == nullptr || height <= 0 || from >= to) {
+        return;
+    }
+
+    switch (isa_) {
+#if defined(ECHOGRAM_TRANSPOSE_X86)
+    case Isa::Sse2: writeSse2(columns, height, from, to, image, stride); return;
+#elif defined(ECHOGRAM_TRANSPOSE_NEON)
+    case Isa::Neon: writeNeon(columns, height, from, to, image, stride); return;
+#endif
+    default: break;
+    }
+
+    writeScalar(columns, height, from, to, image, stride);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+
+/*
+ * Moves echogram columns from the column-major back buffer of Plot2DEchogram into the rows of its 8-bit
+ * image. The columns are walked in tiles one cache line of image row wide, inside a tile 8x16 blocks are
+ * transposed in registers and written as whole row segments instead of one byte per scanline stride.
+ * Values are saturated to 0..255. Vector paths (SSE2, NEON) are picked at runtime and give the same bytes
+ * as the scalar one.
+ */
+class EchogramTranspose
+{
+public:
+    /*structures*/
+    enum class Isa {
+        Scalar,
+        Sse2,
+        Neon
+    };
+
+    /*methods*/
+    EchogramTranspose();
+
+    static Isa bestIsa();
+    void setIsa(Isa isa); // an unsupported set falls back to bestIsa()
+    Isa isa() const;
+
+    // columns [from, to) of the buffer, column c holds height values at columns + c*height, into image columns [from, to)
+    void write(const int16_t* columns, int height, int from, int to, uint8_t* image, int stride) const;
+
+private:
+    /*data*/
+    Isa isa_;
+};
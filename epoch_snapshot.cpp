@@ -0,0 +1,84 @@
+#include "epoch_snapshot.h"
+
+#include <algorithm>
+#include <memory>
+#include <QThread>
+
+
+EpochSnapshot::EpochSnapshot(Dataset* datasetPtr, const std::atomic_bool* cancel) :
+    datasetPtr_(datasetPtr),
+    cancel_(cancel),
+    from_(0),
+    size_(datasetPtr != nullptr ? std::max(datasetPtr->endIndex(), 0) : 0)
+{
+
+}
+
+int EpochSnapshot::size() const
+{
+    return size_;
+}
+
+Epoch* EpochSnapshot::epoch(int index)
+{
+    if (index < 0 || index >= size_) {
+        return nullptr;
+    }
+
+    if (index < from_ || index >= from_ + static_cast<int>(epochs_.size())) {
+        if (!load(index)) {
+            return nullptr;
+        }
+    }
+
+    const int offset = index - from_;
+
+    return offset < static_cast<int>(epochs_.size()) ? &epochs_[offset] : nullptr; // fewer after a reset
+}
+
+void EpochSnapshot::copyEpochs(const Dataset* datasetPtr, int from, int to, std::vector<Epoch>& epochs)
+{
+    to = std::min(to, datasetPtr->endIndex());
+    epochs.reserve(std::max(to - from, 0));
+
+    for (int i = from; i < to; ++i) {
+        epochs.push_back(*datasetPtr->epochView(i));
+        epochs.back().bindColumns(nullptr, -1); // the copy does not write through to the dataset
+    }
+}
+
+bool EpochSnapshot::load(int from)
+{
+    const int to = std::min(from + chunkSize, size_);
+    from_ = from;
+    epochs_.clear();
+
+    if (QThread::currentThread() == datasetPtr_->thread()) {
+        copyEpochs(datasetPtr_, from, to, epochs_);
+        return true;
+    }
+
+    auto chunk = std::make_shared<Chunk>();
+    const Dataset* datasetPtr = datasetPtr_;
+    QMetaObject::invokeMethod(datasetPtr_, [datasetPtr, chunk, from, to]() {
+        std::vector<Epoch> epochs;
+        copyEpochs(datasetPtr, from, to, epochs);
+
+        QMutexLocker locker(&chunk->mutex);
+        chunk->epochs = std::move(epochs);
+        chunk->isFilled = true;
+        chunk->filled.wakeAll();
+    }, Qt::QueuedConnection);
+
+    // the dataset thread may be the one waiting for this reader to stop, so the wait checks cancel
+    QMutexLocker locker(&chunk->mutex);
+    while (!chunk->isFilled) {
+        if (cancel_ != nullptr && *cancel_) {
+            return false;
+        }
+        chunk->filled.wait(&chunk->mutex, cancelCheckMs_);
+    }
+    epochs_ = std::move(chunk->epochs);
+
+    return true;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <QMutex>
+#include <QWaitCondition>
+#include "plotcash.h"
+
+
+/*
+ * Copies of the closed epochs of a dataset for a reader on another thread. The epochs before endIndex() at
+ * construction are read, the open one is left out. The reader walks them chunk by chunk, every chunk is copied
+ * on the thread of the dataset between its own writes, so no epoch is copied while it is being updated. The
+ * copies share the chart samples with the slab of the dataset, it must not be reset while they are read.
+ */
+class EpochSnapshot
+{
+public:
+    static constexpr int chunkSize = 1024;
+
+    /*methods*/
+    // on the thread of the dataset; a reader waiting for a chunk gives up once cancel is set
+    explicit EpochSnapshot(Dataset* datasetPtr, const std::atomic_bool* cancel = nullptr);
+
+    int size() const;
+    // the copy of the epoch, valid until the next chunk is read; nullptr out of range or once canceled
+    Epoch* epoch(int index);
+
+private:
+    /*structures*/
+    struct Chunk { // filled on the thread of the dataset, shared so a reader that gave up leaves it behind safely
+        QMutex mutex;
+        QWaitCondition filled;
+        std::vector<Epoch> epochs;
+        bool isFilled = false;
+    };
+
+    /*methods*/
+    static void copyEpochs(const Dataset* datasetPtr, int from, int to, std::vector<Epoch>& epochs);
+    bool load(int from);
+
+    /*data*/
+    static constexpr int cancelCheckMs_ = 20;
+
+    Dataset* datasetPtr_;
+    const std::atomic_bool* cancel_;
+    std::vector<Epoch> epochs_; // copies of the epochs from from_ on
+    int from_;
+    int size_;
+};
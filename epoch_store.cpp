@@ -0,0 +1,183 @@
+#include "epoch_store.h"
+
+#include <cmath>
+#include <cstring>
+
+
+AmplitudeSlab::AmplitudeSlab() :
+    blockUsed_(0),
+    blockCapacity_(0),
+    usedBytes_(0)
+{
+
+}
+
+const uint8_t* AmplitudeSlab::append(const uint8_t* data, int size)
+{
+    if (data == nullptr) {
+        return nullptr;
+    }
+
+    uint8_t* dst = allocate(size);
+    if (dst != nullptr) {
+        std::memcpy(dst, data, size);
+    }
+
+    return dst;
+}
+
+uint8_t* AmplitudeSlab::allocate(int size)
+{
+    if (size <= 0) {
+        return nullptr;
+    }
+
+    if (blocks_.empty() || blockCapacity_ - blockUsed_ < size) {
+        blockCapacity_ = std::max(blockSize, size); // a chart never spans two blocks
+        blocks_.emplace_back(new uint8_t[blockCapacity_]);
+        blockUsed_ = 0;
+    }
+
+    uint8_t* dst = blocks_.back().get() + blockUsed_;
+    blockUsed_ += size;
+    usedBytes_ += size;
+
+    return dst;
+}
+
+void AmplitudeSlab::clear()
+{
+    blocks_.clear();
+    blockUsed_ = 0;
+    blockCapacity_ = 0;
+    usedBytes_ = 0;
+}
+
+qint64 AmplitudeSlab::getUsedBytes() const
+{
+    return usedBytes_;
+}
+
+
+namespace {
+
+template <typename T>
+void appendValue(ChunkedStore<T>& column, const T& value)
+{
+    if (T* cell = column.append(); cell) {
+        *cell = value;
+    }
+}
+
+void appendChannelRow(EpochColumns::Channel& channel)
+{
+    appendValue<const uint8_t*>(channel.samples, nullptr);
+    appendValue<const uint8_t*>(channel.compensated, nullptr);
+    appendValue(channel.sampleCount, 0);
+    appendValue(channel.resolution, 0.0f);
+    appendValue(channel.dist, static_cast<float>(NAN));
+    appendValue(channel.distMin, static_cast<float>(NAN));
+    appendValue(channel.distMax, static_cast<float>(NAN));
+}
+
+} // namespace
+
+
+EpochColumns::EpochColumns()
+{
+
+}
+
+int EpochColumns::append()
+{
+    const int row = size();
+
+    appendValue(timeNs_, qint64(0));
+    appendValue(north_, static_cast<double>(NAN));
+    appendValue(east_, static_cast<double>(NAN));
+    appendValue(down_, static_cast<double>(NAN));
+    appendValue(yaw_, static_cast<float>(NAN));
+
+    for (auto& channel : channels_) {
+        appendChannelRow(*channel.second);
+    }
+
+    return row;
+}
+
+void EpochColumns::clear()
+{
+    timeNs_.clear();
+    north_.clear();
+    east_.clear();
+    down_.clear();
+    yaw_.clear();
+    channels_.clear();
+    slab_.clear();
+}
+
+void EpochColumns::setNed(int row, double n, double e, double d)
+{
+    north_[row] = n;
+    east_[row] = e;
+    down_[row] = d;
+}
+
+void EpochColumns::setChart(int16_t channel, int row, const uint8_t* samples, int count, float resolution)
+{
+    Channel& columns = channelColumns(channel);
+    columns.samples[row] = samples;
+    columns.compensated[row] = nullptr;
+    columns.sampleCount[row] = count;
+    columns.resolution[row] = resolution;
+}
+
+void EpochColumns::setCompensated(int16_t channel, int row, const uint8_t* samples)
+{
+    channelColumns(channel).compensated[row] = samples;
+}
+
+void EpochColumns::setDist(int16_t channel, int row, float dist, float min, float max)
+{
+    Channel& columns = channelColumns(channel);
+    columns.dist[row] = dist;
+    columns.distMin[row] = min;
+    columns.distMax[row] = max;
+}
+
+const EpochColumns::Channel* EpochColumns::channel(int16_t channel) const
+{
+    auto it = channels_.find(channel);
+    return it != channels_.end() ? it->second.get() : nullptr;
+}
+
+float EpochColumns::dist(int16_t channel, int row) const
+{
+    const Channel* columns = this->channel(channel);
+    return columns != nullptr ? columns->dist[row] : NAN;
+}
+
+float EpochColumns::firstDist(int row) const
+{
+    for (const auto& channel : channels_) {
+        const float dist = channel.second->dist[row];
+        if (std::isfinite(dist)) {
+            return dist;
+        }
+    }
+
+    return NAN;
+}
+
+EpochColumns::Channel& EpochColumns::channelColumns(int16_t channel)
+{
+    std::unique_ptr<Channel>& columns = channels_[channel];
+    if (!columns) {
+        columns.reset(new Channel);
+        for (int i = 0; i < size(); ++i) { // the rows of the epochs before the first chart of the channel
+            appendChannelRow(*columns);
+        }
+    }
+
+    return *columns;
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+#include <QVector>
+
+
+/*
+ * Append-only storage split into fixed-size chunks. Elements are constructed in place and never
+ * relocated, so pointers returned by operator[]/append() stay valid until clear(). When the chunk
+ * directory fills up a twice larger copy is published and the old one is kept until clear(), so
+ * readers on other threads can index any element below size() while the owner keeps appending.
+ */
+template <typename T>
+class ChunkedStore
+{
+public:
+    static constexpr int chunkShift = 12;
+    static constexpr int chunkSize = 1 << chunkShift; // elements per chunk
+    static constexpr int chunkMask = chunkSize - 1;
+    static constexpr int initialChunks = 64;
+    static constexpr int maxChunks = 1 << (31 - chunkShift); // the int index limit
+
+    /*methods*/
+    ChunkedStore() :
+        chunks_(nullptr),
+        size_(0),
+        numChunks_(0),
+        capacity_(0)
+    {
+        grow(initialChunks);
+    }
+
+    ~ChunkedStore()
+    {
+        clear();
+    }
+
+    ChunkedStore(const ChunkedStore&) = delete;
+    ChunkedStore& operator=(const ChunkedStore&) = delete;
+
+    inline int size() const
+    {
+        return size_.load(std::memory_order_acquire);
+    }
+
+    inline bool isEmpty() const
+    {
+        return size() == 0;
+    }
+
+    inline T& operator[](int index)
+    {
+        return chunks_.load(std::memory_order_acquire)[index >> chunkShift]->at(index & chunkMask);
+    }
+
+    inline const T& operator[](int index) const
+    {
+        return chunks_.load(std::memory_order_acquire)[index >> chunkShift]->at(index & chunkMask);
+    }
+
+    // nullptr only when the int index range is exhausted
+    T* append()
+    {
+        const int index = size_.load(std::memory_order_relaxed);
+        const int chunkIndx = index >> chunkShift;
+
+        if (chunkIndx >= maxChunks) {
+            return nullptr;
+        }
+
+        if (chunkIndx >= numChunks_) {
+            if (numChunks_ == capacity_) {
+                grow(std::min(maxChunks, capacity_ * 2));
+            }
+            chunks_.load(std::memory_order_relaxed)[chunkIndx] = new Chunk;
+            ++numChunks_;
+        }
+
+        T* retVal = chunks_.load(std::memory_order_relaxed)[chunkIndx]->construct(index & chunkMask);
+        size_.store(index + 1, std::memory_order_release);
+
+        return retVal;
+    }
+
+    void clear()
+    {
+        const int sz = size_.load(std::memory_order_relaxed);
+        size_.store(0, std::memory_order_release);
+
+        Chunk** chunks = chunks_.load(std::memory_order_relaxed);
+        for (int i = 0; i < numChunks_; ++i) {
+            const int inChunk = std::min(chunkSize, sz - i * chunkSize);
+            chunks[i]->destroy(inChunk);
+            delete chunks[i];
+            chunks[i] = nullptr;
+        }
+
+        numChunks_ = 0;
+
+        if (directories_.size() > 1) { // no reader holds an older directory once the store is empty
+            directories_.erase(directories_.begin(), directories_.end() - 1);
+        }
+    }
+
+    // calls func(index, T&) for [from, to), walking each chunk as one contiguous block
+    template <typename Func>
+    void forEach(int from, int to, Func&& func)
+    {
+        from = std::max(0, from);
+        to = std::min(size(), to);
+
+        Chunk** chunks = chunks_.load(std::memory_order_acquire);
+        while (from < to) {
+            const int chunkIndx = from >> chunkShift;
+            const int chunkEnd = std::min(to, (chunkIndx + 1) << chunkShift);
+            T* data = &chunks[chunkIndx]->at(0);
+
+            for (int i = from; i < chunkEnd; ++i) {
+                func(i, data[i & chunkMask]);
+            }
+
+            from = chunkEnd;
+        }
+    }
+
+private:
+    /*structures*/
+    struct Chunk {
+        alignas(T) unsigned char storage[sizeof(T) * chunkSize];
+
+        inline T& at(int indx)
+        {
+            return *std::launder(reinterpret_cast<T*>(storage) + indx);
+        }
+
+        inline const T& at(int indx) const
+        {
+            return *std::launder(reinterpret_cast<const T*>(storage) + indx);
+        }
+
+        T* construct(int indx)
+        {
+            return new (reinterpret_cast<T*>(storage) + indx) T();
+        }
+
+        void destroy(int count)
+        {
+            for (int i = 0; i < count; ++i) {
+                at(i).~T();
+            }
+        }
+    };
+
+    /*methods*/
+    void grow(int capacity)
+    {
+        std::unique_ptr<Chunk*[]> directory(new Chunk*[capacity]());
+        Chunk** old = chunks_.load(std::memory_order_relaxed);
+        if (old != nullptr) {
+            std::copy(old, old + numChunks_, directory.get());
+        }
+
+        chunks_.store(directory.get(), std::memory_order_release);
+        directories_.push_back(std::move(directory));
+        capacity_ = capacity;
+    }
+
+    /*data*/
+    std::atomic<Chunk**> chunks_;
+    std::vector<std::unique_ptr<Chunk*[]>> directories_; // the last one is current
+    std::atomic<int> size_;
+    int numChunks_;
+    int capacity_;
+};
+
+
+/*
+ * Samples of one chart: either a range of the AmplitudeSlab of the dataset or, for an epoch outside a
+ * dataset, its own vector. Copies share the samples.
+ */
+class AmplitudeView
+{
+public:
+    AmplitudeView() : data_(nullptr), size_(0) { }
+    AmplitudeView(const uint8_t* data, int size) : data_(data), size_(size) { }
+    explicit AmplitudeView(const QVector<uint8_t>& owned) : owned_(owned), data_(owned_.constData()), size_(owned_.size()) { }
+
+    AmplitudeView(const AmplitudeView& other) { *this = other; }
+    AmplitudeView& operator=(const AmplitudeView& other)
+    {
+        owned_ = other.owned_;
+        data_ = owned_.isEmpty() ? other.data_ : owned_.constData();
+        size_ = other.size_;
+        return *this;
+    }
+
+    inline const uint8_t* constData() const { return data_; }
+    inline int size() const { return size_; }
+    inline bool isEmpty() const { return size_ == 0; }
+
+    QVector<uint8_t> toVector() const
+    {
+        return owned_.isEmpty() ? QVector<uint8_t>(data_, data_ + size_) : owned_;
+    }
+
+private:
+    QVector<uint8_t> owned_;
+    const uint8_t* data_;
+    int size_;
+};
+
+
+/*
+ * Append-only byte storage for the chart samples of a dataset. Charts are packed one after another into
+ * large blocks in arrival order, so a pass over consecutive epochs reads contiguous memory. Returned
+ * pointers stay valid until clear(); a replaced chart leaves its old samples in place.
+ */
+class AmplitudeSlab
+{
+public:
+    static constexpr int blockSize = 4 << 20;
+
+    /*methods*/
+    AmplitudeSlab();
+
+    const uint8_t* append(const uint8_t* data, int size);
+    uint8_t* allocate(int size); // room for samples written by the caller
+    void clear();
+    qint64 getUsedBytes() const;
+
+private:
+    /*data*/
+    std::vector<std::unique_ptr<uint8_t[]>> blocks_;
+    int blockUsed_;
+    int blockCapacity_;
+    qint64 usedBytes_;
+};
+
+
+/*
+ * Per-field columns of the scalar epoch data, one row per epoch of the pool, kept up to date by the Epoch
+ * setters (write-through). Passes that only need time, position, yaw or the bottom track of a channel
+ * (interpolation, bottom tracking) read these arrays instead of walking Epoch objects. Rows are only
+ * appended on the owner thread.
+ */
+class EpochColumns
+{
+public:
+    /*structures*/
+    struct Channel { // per chart channel
+        ChunkedStore<const uint8_t*> samples; // into the slab, nullptr without a chart
+        ChunkedStore<const uint8_t*> compensated; // into the slab, nullptr until the epoch is closed
+        ChunkedStore<int> sampleCount;
+        ChunkedStore<float> resolution;
+        ChunkedStore<float> dist;
+        ChunkedStore<float> distMin;
+        ChunkedStore<float> distMax;
+    };
+
+    /*methods*/
+    EpochColumns();
+
+    int append(); // the row of a new epoch
+    void clear();
+    inline int size() const { return timeNs_.size(); }
+
+    void setTime(int row, qint64 timeNs) { timeNs_[row] = timeNs; }
+    void setNed(int row, double n, double e, double d);
+    void setYaw(int row, float yaw) { yaw_[row] = yaw; }
+    void setChart(int16_t channel, int row, const uint8_t* samples, int count, float resolution);
+    void setCompensated(int16_t channel, int row, const uint8_t* samples);
+    void setDist(int16_t channel, int row, float dist, float min, float max);
+
+    const uint8_t* appendAmplitude(const uint8_t* data, int size) { return slab_.append(data, size); }
+    uint8_t* allocateAmplitude(int size) { return slab_.allocate(size); }
+    const AmplitudeSlab& slab() const { return slab_; }
+
+    const ChunkedStore<qint64>& timeNs() const { return timeNs_; } // GNSS time
+    const ChunkedStore<double>& north() const { return north_; }
+    const ChunkedStore<double>& east() const { return east_; }
+    const ChunkedStore<double>& down() const { return down_; }
+    const ChunkedStore<float>& yaw() const { return yaw_; }
+    const Channel* channel(int16_t channel) const; // nullptr if no epoch has a chart of it
+    float dist(int16_t channel, int row) const; // NAN without a chart of the channel
+    float firstDist(int row) const; // the first finite distance over the channels
+
+private:
+    /*methods*/
+    Channel& channelColumns(int16_t channel);
+
+    /*data*/
+    ChunkedStore<qint64> timeNs_;
+    ChunkedStore<double> north_;
+    ChunkedStore<double> east_;
+    ChunkedStore<double> down_;
+    ChunkedStore<float> yaw_;
+    std::map<int16_t, std::unique_ptr<Channel>> channels_;
+    AmplitudeSlab slab_;
+};
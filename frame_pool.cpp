@@ -0,0 +1,149 @@
+#include "frame_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+struct FrameSlot {
+    uint8_t data[1024]; // as the frame buffer of FrameParser, only size bytes are copied
+    int size = 0;
+    bool isNested = false;
+    std::atomic_int refs{ 0 };
+    FrameSlot* next = nullptr;
+};
+
+namespace {
+
+class FramePool
+{
+public:
+    static FramePool& instance() {
+        static FramePool* pool = new FramePool; // never destroyed, queued handles may outlive static destruction
+        return *pool;
+    }
+
+    FrameSlot* acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (!free_) {
+            blocks_.emplace_back(new FrameSlot[blockSize_]);
+            FrameSlot* block = blocks_.back().get();
+            for (int i = 0; i < blockSize_; ++i) {
+                block[i].next = free_;
+                free_ = &block[i];
+            }
+        }
+
+        FrameSlot* slot = free_;
+        free_ = slot->next;
+        slot->next = nullptr;
+        return slot;
+    }
+
+    void release(FrameSlot* slot) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slot->next = free_;
+        free_ = slot;
+    }
+
+private:
+    static constexpr int blockSize_ = 64;
+
+    std::mutex mutex_;
+    FrameSlot* free_ = nullptr;
+    std::vector<std::unique_ptr<FrameSlot[]>> blocks_;
+};
+
+} // namespace
+
+
+FrameHandle::FrameHandle() :
+    slot_(nullptr)
+{
+
+}
+
+FrameHandle::FrameHandle(FrameParser &frame) :
+    slot_(FramePool::instance().acquire())
+{
+    slot_->size = std::min<int>(frame.frameLen(), sizeof(slot_->data));
+    std::memcpy(slot_->data, frame.frame(), slot_->size);
+    slot_->isNested = frame.isNested();
+    slot_->refs.store(1, std::memory_order_relaxed);
+}
+
+FrameHandle::FrameHandle(const FrameHandle &other) :
+    slot_(other.slot_)
+{
+    if (slot_) {
+        slot_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FrameHandle::FrameHandle(FrameHandle &&other) noexcept :
+    slot_(other.slot_)
+{
+    other.slot_ = nullptr;
+}
+
+FrameHandle::~FrameHandle()
+{
+    release();
+}
+
+FrameHandle &FrameHandle::operator=(const FrameHandle &other)
+{
+    if (slot_ != other.slot_) {
+        release();
+        slot_ = other.slot_;
+        if (slot_) {
+            slot_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    return *this;
+}
+
+FrameHandle &FrameHandle::operator=(FrameHandle &&other) noexcept
+{
+    if (this != &other) {
+        release();
+        slot_ = other.slot_;
+        other.slot_ = nullptr;
+    }
+
+    return *this;
+}
+
+bool FrameHandle::isNull() const
+{
+    return slot_ == nullptr;
+}
+
+const uint8_t *FrameHandle::data() const
+{
+    return slot_->data;
+}
+
+int FrameHandle::size() const
+{
+    return slot_->size;
+}
+
+bool FrameHandle::isNested() const
+{
+    return slot_->isNested;
+}
+
+void FrameHandle::release()
+{
+    if (slot_ && slot_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        FramePool::instance().release(slot_);
+    }
+
+    slot_ = nullptr;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QMetaType>
+#include "ProtoBinnary.h"
+
+using namespace Parsers;
+
+struct FrameSlot;
+
+
+/*
+ * Reference-counted handle to the bytes of a completed frame kept in a process-wide pool. The link copies
+ * only the frameLen() bytes of a frame into a pool slot, handing the handle through signals (queued ones
+ * included) only touches the counter, and the slot goes back to the pool with the last handle. The bytes
+ * are immutable once the handle is created, so any thread may read them; a consumer that decodes the frame
+ * parses the bytes again into a parser of its own.
+ */
+class FrameHandle
+{
+public:
+    /*methods*/
+    FrameHandle();
+    explicit FrameHandle(FrameParser& frame);
+    FrameHandle(const FrameHandle& other);
+    FrameHandle(FrameHandle&& other) noexcept;
+    ~FrameHandle();
+
+    FrameHandle& operator=(const FrameHandle& other);
+    FrameHandle& operator=(FrameHandle&& other) noexcept;
+
+    bool           isNull() const;
+    const uint8_t* data() const;
+    int            size() const;
+    bool           isNested() const; // parsed out of the payload of the previous, proxy frame
+
+private:
+    /*methods*/
+    void release();
+
+    /*data*/
+    FrameSlot* slot_;
+};
+
+Q_DECLARE_METATYPE(FrameHandle)
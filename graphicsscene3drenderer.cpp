@@ -83,7 +83,9 @@ void GraphicsScene3dRenderer::render()
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // back color
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    vertexBuffers_.beginFrame();
     drawObjects();
+    vertexBuffers_.endFrame();
 
     //TextRenderer::instance(); TODO
 }
@@ -13,6 +13,7 @@
 // #include <geometryengine.h>
 #include "navigation_arrow.h"
 #include "usbl_view.h"
+#include "vertex_buffer_manager.h"
 
 #include <QMatrix4x4>
 #include "qsystemdetection.h"
@@ -73,6 +74,7 @@ private:
     BoatTrack::BoatTrackRenderImplementation m_boatTrackRenderImpl;
     NavigationArrow::NavigationArrowRenderImplementation navigationArrowRenderImpl_;
     UsblView::UsblViewRenderImplementation usblViewRenderImpl_;
+    VertexBufferManager vertexBuffers_; // keyed by the arrays of the implementations above
 
     QMatrix4x4 m_model;
     QMatrix4x4 m_projection;
@@ -11,6 +11,20 @@
 #include <QVector3D>
 
 
+namespace {
+
+// the copy keeps the version, an unchanged implementation is skipped without touching its data
+template <typename Impl>
+void syncRenderImpl(Impl& dst, SceneObject::RenderImplementation* src)
+{
+    if (auto* impl = dynamic_cast<Impl*>(src); impl && impl->version() != dst.version()) {
+        dst = *impl;
+    }
+}
+
+} // namespace
+
+
 GraphicsScene3dView::GraphicsScene3dView() :
     QQuickFramebufferObject(),
     m_camera(std::make_shared<Camera>()),
@@ -504,7 +518,7 @@ void GraphicsScene3dView::setDataset(Dataset *dataset)
 
     QObject::connect(m_dataset, &Dataset::boatTrackUpdated,
                       this,     [this]() -> void {
-                                    m_boatTrack->setData(m_dataset->boatTrack(), GL_LINE_STRIP);
+                                    m_boatTrack->updateData(); // appends the new vertices only
                                     if (navigationArrowState_) {
                                         const Position pos = m_dataset->getLastPosition();
                                         m_navigationArrow->setPositionAndAngle(
@@ -626,6 +640,10 @@ void GraphicsScene3dView::InFboRenderer::synchronize(QQuickFramebufferObject * f
         return;
     }
 
+    // side-scan tile detail by camera distance
+    view->sideScanView_->updateTilesLod((view->m_camera->viewMatrix() * view->m_model).inverted().map(QVector3D()),
+                                        view->height(), view->m_camera->fov());
+
     // process textures
     processColorTableTexture(view);
     processTileTexture(view);
@@ -635,18 +653,19 @@ void GraphicsScene3dView::InFboRenderer::synchronize(QQuickFramebufferObject * f
     view->m_model = m_renderer->m_model;
     view->m_projection = m_renderer->m_projection;
 
-    // write to renderer
-    m_renderer->m_coordAxesRenderImpl       = *(dynamic_cast<CoordinateAxes::CoordinateAxesRenderImplementation*>(view->m_coordAxes->m_renderImpl));
-    m_renderer->m_planeGridRenderImpl       = *(dynamic_cast<PlaneGrid::PlaneGridRenderImplementation*>(view->m_planeGrid->m_renderImpl));
-    m_renderer->m_boatTrackRenderImpl       = *(dynamic_cast<BoatTrack::BoatTrackRenderImplementation*>(view->m_boatTrack->m_renderImpl));
-    m_renderer->m_bottomTrackRenderImpl     = *(dynamic_cast<BottomTrack::BottomTrackRenderImplementation*>(view->m_bottomTrack->m_renderImpl));
-    m_renderer->m_surfaceRenderImpl         = *(dynamic_cast<Surface::SurfaceRenderImplementation*>(view->m_surface->m_renderImpl));
-    m_renderer->sideScanViewRenderImpl_     = *(dynamic_cast<SideScanView::SideScanViewRenderImplementation*>(view->sideScanView_->m_renderImpl));
-    m_renderer->imageViewRenderImpl_        = *(dynamic_cast<ImageView::ImageViewRenderImplementation*>(view->imageView_->m_renderImpl));
-    m_renderer->m_polygonGroupRenderImpl    = *(dynamic_cast<PolygonGroup::PolygonGroupRenderImplementation*>(view->m_polygonGroup->m_renderImpl));
-    m_renderer->m_pointGroupRenderImpl      = *(dynamic_cast<PointGroup::PointGroupRenderImplementation*>(view->m_pointGroup->m_renderImpl));
-    m_renderer->navigationArrowRenderImpl_  = *(dynamic_cast<NavigationArrow::NavigationArrowRenderImplementation*>(view->m_navigationArrow->m_renderImpl));
-    m_renderer->usblViewRenderImpl_         = *(dynamic_cast<UsblView::UsblViewRenderImplementation*>(view->usblView_->m_renderImpl));
+    // write to renderer, only the implementations changed since the last frame are copied
+    syncRenderImpl(m_renderer->m_coordAxesRenderImpl,      view->m_coordAxes->m_renderImpl);
+    syncRenderImpl(m_renderer->m_planeGridRenderImpl,      view->m_planeGrid->m_renderImpl);
+    syncRenderImpl(m_renderer->m_boatTrackRenderImpl,      view->m_boatTrack->m_renderImpl);
+    syncRenderImpl(m_renderer->m_bottomTrackRenderImpl,    view->m_bottomTrack->m_renderImpl);
+    syncRenderImpl(m_renderer->m_surfaceRenderImpl,        view->m_surface->m_renderImpl);
+    syncRenderImpl(m_renderer->sideScanViewRenderImpl_,    view->sideScanView_->m_renderImpl);
+    syncRenderImpl(m_renderer->imageViewRenderImpl_,       view->imageView_->m_renderImpl);
+    syncRenderImpl(m_renderer->m_polygonGroupRenderImpl,   view->m_polygonGroup->m_renderImpl);
+    syncRenderImpl(m_renderer->m_pointGroupRenderImpl,     view->m_pointGroup->m_renderImpl);
+    syncRenderImpl(m_renderer->navigationArrowRenderImpl_, view->m_navigationArrow->m_renderImpl);
+    syncRenderImpl(m_renderer->usblViewRenderImpl_,        view->usblView_->m_renderImpl);
+
     m_renderer->m_viewSize                  = view->size();
     m_renderer->m_camera                    = *view->m_camera;
     m_renderer->m_axesThumbnailCamera       = *view->m_axesThumbnailCamera;
@@ -727,13 +746,15 @@ void GraphicsScene3dView::InFboRenderer::processTileTexture(GraphicsScene3dView*
             continue;
         }
 
+        const int imageSide = static_cast<int>(std::sqrt(image.size())); // side depends on the tile level
+
         if (textureId) {
             glBindTexture(GL_TEXTURE_2D, textureId);
 
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, viewPtr->getSideScanViewPtr()->getUseLinearFilter() ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_NEAREST); // may be changed
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, viewPtr->getSideScanViewPtr()->getUseLinearFilter() ? GL_LINEAR : GL_NEAREST);
 
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 256, 256, GL_RED, GL_UNSIGNED_BYTE, image.data());
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, imageSide, imageSide, 0, GL_RED, GL_UNSIGNED_BYTE, image.data());
         }
         else {
             glGenTextures(1, &textureId);
@@ -745,7 +766,7 @@ void GraphicsScene3dView::InFboRenderer::processTileTexture(GraphicsScene3dView*
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, 256, 256, 0, GL_RED, GL_UNSIGNED_BYTE, image.data());
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, imageSide, imageSide, 0, GL_RED, GL_UNSIGNED_BYTE, image.data());
 
             sideScanPtr->setTextureIdByTileId(tileId, textureId);
         }
@@ -0,0 +1,173 @@
+#include "klf_ingest.h"
+
+#include <algorithm>
+#include <deque>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+
+
+KlfIngest::KlfIngest(const uchar* data, qint64 size) :
+    data_(data),
+    size_(data ? size : 0),
+    chunkSize_(4 * 1024 * 1024),
+    threadCount_(std::max(1, QThread::idealThreadCount()))
+{
+
+}
+
+void KlfIngest::setChunkSize(qint64 chunkSize)
+{
+    chunkSize_ = std::max<qint64>(1, chunkSize);
+}
+
+void KlfIngest::setThreadCount(int threadCount)
+{
+    threadCount_ = std::max(1, threadCount);
+}
+
+qint64 KlfIngest::run(const FrameCallback& func)
+{
+    if (size_ <= 0) {
+        return 0;
+    }
+
+    struct Pending {
+        QFuture<std::shared_ptr<Batch>> future;
+        qint64 to = 0;
+    };
+
+    const qint64 chunksCount = (size_ + chunkSize_ - 1) / chunkSize_;
+    const size_t maxInFlight = static_cast<size_t>(threadCount_) * 2; // bounds the spans held by finished workers
+
+    std::atomic_bool stop(false);
+    QThreadPool pool; // declared after stop, its destructor waits for the workers still using it
+    pool.setMaxThreadCount(threadCount_);
+
+    std::deque<Pending> inFlight;
+    qint64 nextChunk = 0;
+
+    auto launch = [&]() {
+        Pending pending;
+        pending.to = std::min(size_, (nextChunk + 1) * chunkSize_);
+        const qint64 from = nextChunk == 0 ? 0 : findSync(data_, size_, nextChunk * chunkSize_, pending.to);
+        const uchar* data = data_;
+        const qint64 size = size_;
+        const qint64 to = pending.to;
+        pending.future = QtConcurrent::run(&pool, [data, size, from, to, &stop]() {
+            return std::make_shared<Batch>(parseChunk(data, size, from, to, &stop));
+        });
+        inFlight.push_back(std::move(pending));
+        ++nextChunk;
+    };
+
+    qint64 syncPos = 0; // the sequential parser would be synchronized here
+    FrameParser parser;
+
+    while (!inFlight.empty() || nextChunk < chunksCount) {
+        while (nextChunk < chunksCount && inFlight.size() < maxInFlight) {
+            launch();
+        }
+
+        Pending pending = std::move(inFlight.front());
+        inFlight.pop_front();
+        std::shared_ptr<Batch> batch = pending.future.result();
+
+        if (syncPos >= batch->exit) {
+            continue; // the previous chunk ran over this one
+        }
+
+        if (!std::binary_search(batch->syncPoints.cbegin(), batch->syncPoints.cend(), syncPos)) {
+            batch = std::make_shared<Batch>(parseChunk(data_, size_, syncPos, pending.to));
+        }
+
+        for (const auto& span : batch->spans) {
+            if (span.to <= syncPos) {
+                continue;
+            }
+            if (!replaySpan(data_, span, parser, func)) {
+                stop = true;
+                return span.to;
+            }
+        }
+
+        syncPos = batch->exit;
+    }
+
+    return syncPos;
+}
+
+KlfIngest::Batch KlfIngest::parseChunk(const uchar* data, qint64 size, qint64 from, qint64 to, const std::atomic_bool* stop)
+{
+    Batch batch;
+    batch.from = from;
+    batch.exit = size;
+
+    FrameParser parser;
+    qint64 pos = from;
+    qint64 spanFrom = from;
+
+    while (pos < size) {
+        if (stop && *stop) {
+            break;
+        }
+
+        const int len = static_cast<int>(std::min<qint64>(sliceSize_, size - pos));
+        parser.setContext(const_cast<uchar*>(data + pos), len);
+
+        while (parser.availContext() > 0) {
+            if (parser.isSynchronized()) {
+                const qint64 offset = pos + len - parser.availContext();
+                batch.syncPoints.push_back(offset);
+                spanFrom = offset;
+                if (offset >= to) {
+                    batch.exit = offset;
+                    return batch;
+                }
+            }
+
+            parser.process();
+            if (parser.isComplete()) {
+                const qint64 end = pos + len - parser.outerContextLen();
+                if (batch.spans.empty() || batch.spans.back().to != end) { // nested frames end with their outer frame
+                    Span span;
+                    span.from = spanFrom;
+                    span.to = end;
+                    batch.spans.push_back(span);
+                }
+            }
+        }
+
+        pos += len;
+    }
+
+    return batch;
+}
+
+qint64 KlfIngest::findSync(const uchar* data, qint64 size, qint64 from, qint64 to)
+{
+    to = std::min(to, size - 1);
+
+    for (qint64 i = from; i < to; ++i) {
+        if ((data[i] == 0xBB || data[i] == 0xCC) && data[i + 1] == 0x55) {
+            return i;
+        }
+    }
+
+    return from;
+}
+
+bool KlfIngest::replaySpan(const uchar* data, const Span& span, FrameParser& parser, const FrameCallback& func)
+{
+    parser.setContext(const_cast<uchar*>(data + span.from), static_cast<uint32_t>(span.to - span.from));
+
+    while (parser.availContext() > 0) {
+        parser.process();
+        if (parser.isComplete() && func && !func(parser, span.to)) {
+            parser.resetContext();
+            return false;
+        }
+    }
+
+    return true;
+}
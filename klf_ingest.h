@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <QtGlobal>
+#include "ProtoBinnary.h"
+
+using namespace Parsers;
+
+
+/*
+ * Frames a log held in memory on several threads. The buffer is cut into chunks at sync bytes, every chunk
+ * is scanned by a pool worker starting from a fresh parser, and the results are handed out in file order.
+ * A chunk is accepted only if its worker passed the synchronized position where the previous chunk stopped,
+ * from that position both parsers are in the same state; otherwise the chunk is scanned again from that
+ * position on the calling thread. The frame sequence is therefore the same as with one parser running over
+ * the whole buffer.
+ *
+ * Workers keep only the spans of the buffer that hold a frame, the calling thread parses each span again into
+ * its own parser, so the memory in flight is a few bytes per frame and the noise, resyncs and cut frames
+ * between the spans are skipped there.
+ */
+class KlfIngest
+{
+public:
+    /*structures*/
+    using FrameCallback = std::function<bool(FrameParser& frame, qint64 endOffset)>;
+
+    struct Span {        // parses from a fresh parser into one outer frame and the frames nested in it
+        qint64 from = 0; // synchronized position, the bytes up to the frame are skipped by the parser
+        qint64 to = 0;   // end offset of the outer frame
+    };
+
+    struct Batch {
+        qint64 from = 0;                 // where the worker started
+        qint64 exit = 0;                 // synchronized position where the worker stopped, or the buffer end
+        std::vector<Span> spans;
+        std::vector<qint64> syncPoints;  // ascending positions where the parser was synchronized
+    };
+
+    /*methods*/
+    KlfIngest(const uchar* data, qint64 size);
+
+    void setChunkSize(qint64 chunkSize);
+    void setThreadCount(int threadCount);
+
+    // calls func for every frame in file order, returns the offset reached
+    qint64 run(const FrameCallback& func);
+
+    static Batch parseChunk(const uchar* data, qint64 size, qint64 from, qint64 to, const std::atomic_bool* stop = nullptr);
+    static qint64 findSync(const uchar* data, qint64 size, qint64 from, qint64 to);
+    // calls func for the frames of span, returns false if func stopped
+    static bool replaySpan(const uchar* data, const Span& span, FrameParser& parser, const FrameCallback& func);
+
+private:
+    /*data*/
+    static constexpr int sliceSize_ = 1024 * 1024;
+
+    const uchar* data_;
+    qint64 size_;
+    qint64 chunkSize_;
+    int threadCount_;
+};
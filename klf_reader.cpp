@@ -0,0 +1,130 @@
+#include "klf_reader.h"
+
+#include <algorithm>
+#include "klf_ingest.h"
+
+
+KlfReader::KlfReader() :
+    mapped_(nullptr),
+    size_(0)
+{
+
+}
+
+KlfReader::~KlfReader()
+{
+    close();
+}
+
+bool KlfReader::open(const QString &filePath)
+{
+    close();
+
+    file_.setFileName(filePath);
+    if (!file_.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    size_ = file_.size();
+    if (size_ > 0) {
+        mapped_ = file_.map(0, size_); // nullptr -> buffered reads
+    }
+
+    return true;
+}
+
+void KlfReader::close()
+{
+    if (mapped_) {
+        file_.unmap(mapped_);
+        mapped_ = nullptr;
+    }
+    if (file_.isOpen()) {
+        file_.close();
+    }
+
+    buffer_.clear();
+    size_ = 0;
+}
+
+qint64 KlfReader::readFrames(qint64 from, qint64 to, FrameParser &parser, const FrameCallback &func)
+{
+    from = std::clamp<qint64>(from, 0, size_);
+    to = std::clamp<qint64>(to, from, size_);
+
+    qint64 pos = from;
+
+    while (pos < to) {
+        const int len = static_cast<int>(std::min<qint64>(sliceSize_, to - pos));
+        const uchar* data = slice(pos, len);
+        if (!data) {
+            break;
+        }
+
+        parser.setContext(const_cast<uchar*>(data), len);
+
+        while (parser.availContext() > 0) {
+            parser.process();
+            if (!parser.isComplete()) {
+                continue;
+            }
+
+            const qint64 endOffset = pos + len - parser.outerContextLen();
+
+            if (func && !func(parser, endOffset)) {
+                parser.resetContext();
+                return endOffset;
+            }
+        }
+
+        pos += len;
+    }
+
+    return pos;
+}
+
+qint64 KlfReader::ingestFrames(const FrameCallback &func)
+{
+    if (!mapped_) {
+        FrameParser parser;
+        return readFrames(0, size_, parser, func);
+    }
+
+    KlfIngest ingest(mapped_, size_);
+    return ingest.run([&](FrameParser& frame, qint64 endOffset) -> bool {
+        return !func || func(frame, endOffset);
+    });
+}
+
+bool KlfReader::isOpen() const
+{
+    return file_.isOpen();
+}
+
+bool KlfReader::isMapped() const
+{
+    return mapped_ != nullptr;
+}
+
+qint64 KlfReader::size() const
+{
+    return size_;
+}
+
+const uchar *KlfReader::slice(qint64 offset, int len)
+{
+    if (mapped_) {
+        return mapped_ + offset;
+    }
+
+    if (!file_.seek(offset)) {
+        return nullptr;
+    }
+
+    buffer_ = file_.read(len);
+    if (buffer_.size() != len) {
+        return nullptr;
+    }
+
+    return reinterpret_cast<const uchar*>(buffer_.constData());
+}
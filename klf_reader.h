@@ -0,0 +1,48 @@
+#pragma once
+
+#include <functional>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include "ProtoBinnary.h"
+
+using namespace Parsers;
+
+
+/*
+ * Reads .klf logs through a memory mapping (falls back to buffered reads if mapping fails).
+ */
+class KlfReader
+{
+public:
+    /*structures*/
+    // called for every complete frame, endOffset - file offset right after the outer frame;
+    // returning false stops reading
+    using FrameCallback = std::function<bool(FrameParser& frame, qint64 endOffset)>;
+
+    /*methods*/
+    KlfReader();
+    ~KlfReader();
+
+    bool open(const QString& filePath);
+    void close();
+    qint64 readFrames(qint64 from, qint64 to, FrameParser& parser, const FrameCallback& func);
+    // reads the whole file, framing runs on a thread pool when the file is mapped; func is called in file order
+    qint64 ingestFrames(const FrameCallback& func);
+
+    bool   isOpen() const;
+    bool   isMapped() const;
+    qint64 size() const;
+
+private:
+    /*methods*/
+    const uchar* slice(qint64 offset, int len);
+
+    /*data*/
+    static constexpr int sliceSize_ = 1024 * 1024;
+
+    QFile file_;
+    QByteArray buffer_;
+    uchar* mapped_;
+    qint64 size_;
+};
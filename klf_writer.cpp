@@ -0,0 +1,250 @@
+#include "klf_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#ifdef Q_OS_WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+
+KlfWriter::KlfWriter() :
+    ringSize_(0),
+    blockSize_(1),
+    head_(0),
+    tail_(0),
+    stopping_(false),
+    running_(false),
+    droppedFrames_(0),
+    droppedBytes_(0),
+    lastWriteUs_(0),
+    maxWriteUs_(0),
+    writeFailed_(false)
+{
+
+}
+
+KlfWriter::~KlfWriter()
+{
+    stop();
+}
+
+void KlfWriter::setPolicy(const Policy& policy)
+{
+    policy_ = policy;
+}
+
+KlfWriter::Policy KlfWriter::getPolicy() const
+{
+    return policy_;
+}
+
+bool KlfWriter::start(const QString& fileName)
+{
+    stop();
+
+    file_.setFileName(fileName);
+    if (!file_.open(QIODevice::WriteOnly | QIODevice::Unbuffered)) { // the ring already batches the writes
+        return false;
+    }
+
+    activePolicy_ = policy_;
+    const quint64 blockSize = static_cast<quint64>(std::max(4096, activePolicy_.blockSize));
+    const quint64 ringSize = std::max<quint64>(2, (static_cast<quint64>(std::max(0, activePolicy_.ringSize)) + blockSize - 1) / blockSize) * blockSize;
+    if (!ring_ || ringSize != ringSize_) {
+        ring_.reset(new char[ringSize]);
+    }
+    ringSize_ = ringSize;
+    blockSize_ = blockSize;
+
+    head_ = 0;
+    tail_ = 0;
+    stopping_ = false;
+    droppedFrames_ = 0;
+    droppedBytes_ = 0;
+    lastWriteUs_ = 0;
+    maxWriteUs_ = 0;
+    writeFailed_ = false;
+
+    thread_.reset(QThread::create([this]() -> void {
+        run();
+    }));
+    thread_->start();
+
+    QMutexLocker lock(&stateMutex_);
+    running_ = true;
+
+    return true;
+}
+
+void KlfWriter::stop()
+{
+    {
+        QMutexLocker lock(&stateMutex_); // waits for a push in flight, later ones are refused
+        running_ = false;
+    }
+
+    if (thread_) {
+        {
+            QMutexLocker lock(&wakeMutex_);
+            stopping_ = true;
+            wakeCondition_.wakeAll();
+        }
+        thread_->wait();
+        thread_.reset();
+    }
+
+    file_.close();
+}
+
+bool KlfWriter::isOpen() const
+{
+    return running_;
+}
+
+QString KlfWriter::fileName() const
+{
+    return file_.fileName();
+}
+
+bool KlfWriter::push(const char* data, qint64 size)
+{
+    if (data == nullptr || size <= 0) {
+        return false;
+    }
+
+    QMutexLocker stateLock(&stateMutex_); // uncontended but for start() and stop(), the ring itself stays lock-free
+    if (!running_) {
+        return false;
+    }
+
+    const quint64 head = head_.load(std::memory_order_relaxed);
+    const quint64 tail = tail_.load(std::memory_order_acquire);
+    if (static_cast<quint64>(size) > ringSize_ - (head - tail)) {
+        droppedFrames_.fetch_add(1, std::memory_order_relaxed);
+        droppedBytes_.fetch_add(size, std::memory_order_relaxed);
+        return false;
+    }
+
+    const quint64 pos = head % ringSize_;
+    const quint64 first = std::min<quint64>(size, ringSize_ - pos);
+    std::memcpy(ring_.get() + pos, data, first);
+    std::memcpy(ring_.get(), data + first, size - first);
+    head_.store(head + size, std::memory_order_release);
+
+    if ((head + size) / blockSize_ != head / blockSize_) { // a block got complete
+        QMutexLocker lock(&wakeMutex_);
+        wakeCondition_.wakeOne();
+    }
+
+    return true;
+}
+
+KlfWriter::Stats KlfWriter::getStats() const
+{
+    Stats stats;
+    const quint64 tail = tail_.load(std::memory_order_acquire);
+    stats.queuedBytes = static_cast<qint64>(head_.load(std::memory_order_acquire) - tail);
+    stats.writtenBytes = static_cast<qint64>(tail);
+    stats.droppedFrames = droppedFrames_;
+    stats.droppedBytes = droppedBytes_;
+    stats.lastWriteUs = lastWriteUs_;
+    stats.maxWriteUs = maxWriteUs_;
+    stats.writeFailed = writeFailed_;
+
+    return stats;
+}
+
+void KlfWriter::run()
+{
+    QElapsedTimer flushTimer;
+    QElapsedTimer syncTimer;
+    flushTimer.start();
+    syncTimer.start();
+    bool isSynced = true;
+
+    while (true) {
+        const bool stopping = stopping_.load(std::memory_order_acquire); // before head_, the last pass sees every push
+        const bool flushDue = stopping || flushTimer.elapsed() >= activePolicy_.flushIntervalMs;
+        const quint64 tail = tail_.load(std::memory_order_relaxed);
+        const quint64 head = head_.load(std::memory_order_acquire);
+        const quint64 to = flushDue ? head : head - head % blockSize_; // tail_ is the file offset
+
+        if (to > tail) {
+            writeRange(tail, to);
+            tail_.store(to, std::memory_order_release);
+            isSynced = false;
+        }
+        if (flushDue) {
+            flushTimer.restart();
+        }
+
+        if (!isSynced && activePolicy_.syncIntervalMs > 0 && (stopping || syncTimer.elapsed() >= activePolicy_.syncIntervalMs)) {
+            sync();
+            syncTimer.restart();
+            isSynced = true;
+        }
+
+        if (stopping) {
+            break;
+        }
+
+        QMutexLocker lock(&wakeMutex_);
+        const quint64 queuedHead = head_.load(std::memory_order_acquire);
+        if (!stopping_ && queuedHead - queuedHead % blockSize_ <= to) {
+            const qint64 waitMs = std::max<qint64>(1, activePolicy_.flushIntervalMs - flushTimer.elapsed());
+            wakeCondition_.wait(&wakeMutex_, static_cast<unsigned long>(waitMs));
+        }
+    }
+}
+
+bool KlfWriter::writeRange(quint64 from, quint64 to)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    bool isOk = !writeFailed_;
+    while (from < to) {
+        const quint64 pos = from % ringSize_;
+        const qint64 size = static_cast<qint64>(std::min(to - from, ringSize_ - pos));
+        if (isOk) {
+            isOk = file_.write(ring_.get() + pos, size) == size;
+        }
+        from += size;
+    }
+
+    if (!isOk) {
+        writeFailed_ = true; // the ring keeps draining, the producer must not stall on a dead file
+    }
+    addLatency(timer.nsecsElapsed() / 1000);
+
+    return isOk;
+}
+
+void KlfWriter::sync()
+{
+    const int fd = file_.handle();
+    if (fd < 0) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+#ifdef Q_OS_WINDOWS
+    _commit(fd);
+#else
+    ::fsync(fd);
+#endif
+    addLatency(timer.nsecsElapsed() / 1000);
+}
+
+void KlfWriter::addLatency(qint64 us)
+{
+    lastWriteUs_ = us;
+    if (us > maxWriteUs_) {
+        maxWriteUs_ = us;
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+
+/*
+ * Writes a .klf log on its own thread. Frames are copied into a lock-free single-producer ring, the writer
+ * thread drains it in whole blocks that end on a block boundary of the file, so a slow card or share stalls
+ * only the writer. The tail under a block is written once the flush interval passes. A frame that does not
+ * fit into the free part of the ring is dropped whole and counted, the producer never waits for the disk.
+ */
+class KlfWriter
+{
+public:
+    /*structures*/
+    struct Policy {
+        int ringSize = 16 * 1024 * 1024;  // rounded up to whole blocks
+        int blockSize = 256 * 1024;       // bytes handed to the file at once
+        int flushIntervalMs = 500;        // the tail under a block waits at most this long
+        int syncIntervalMs = 0;           // fsync period, 0 leaves syncing to the OS
+    };
+
+    struct Stats {
+        qint64 queuedBytes = 0;
+        qint64 writtenBytes = 0;
+        qint64 droppedFrames = 0;
+        qint64 droppedBytes = 0;
+        qint64 lastWriteUs = 0;  // duration of the last write, the sync included
+        qint64 maxWriteUs = 0;
+        bool writeFailed = false;
+    };
+
+    /*methods*/
+    KlfWriter();
+    ~KlfWriter();
+
+    KlfWriter(const KlfWriter&) = delete;
+    KlfWriter& operator=(const KlfWriter&) = delete;
+
+    void setPolicy(const Policy& policy); // applies to the next start()
+    Policy getPolicy() const;
+
+    bool start(const QString& fileName);
+    void stop(); // writes out everything queued
+    bool isOpen() const;
+    QString fileName() const;
+
+    // producer side, only one thread may push; may run on another thread than start() and stop()
+    bool push(const char* data, qint64 size);
+
+    Stats getStats() const;
+
+private:
+    /*methods*/
+    void run();
+    bool writeRange(quint64 from, quint64 to);
+    void sync();
+    void addLatency(qint64 us);
+
+    /*data*/
+    Policy policy_;
+    Policy activePolicy_; // policy_ as of start(), read by the writer thread
+    QFile file_;
+    std::unique_ptr<QThread> thread_; // touched by start() and stop() only
+    QMutex stateMutex_; // a push is never in flight while start() or stop() change the state
+    std::atomic_bool running_; // pushes are taken, set and cleared under stateMutex_
+    std::unique_ptr<char[]> ring_;
+    quint64 ringSize_;
+    quint64 blockSize_;
+
+    std::atomic<quint64> head_;  // bytes pushed since start(), written by the producer
+    std::atomic<quint64> tail_;  // bytes taken by the writer, also the file offset
+    std::atomic_bool stopping_;
+    QMutex wakeMutex_;
+    QWaitCondition wakeCondition_;
+
+    std::atomic<qint64> droppedFrames_;
+    std::atomic<qint64> droppedBytes_;
+    std::atomic<qint64> lastWriteUs_;
+    std::atomic<qint64> maxWriteUs_;
+    std::atomic_bool writeFailed_;
+};
@@ -9,11 +9,9 @@ extern Core core;
 
 
 Logger::Logger() :
-    klfLogFile_(std::make_unique<QFile>(this)),
     csvLogFile_(std::make_unique<QFile>(this)),
     exportFile_(std::make_unique<QFile>(this)),
-    datasetPtr_(nullptr),
-    klfCurrentIteration_(0)
+    datasetPtr_(nullptr)
 {
 
 }
@@ -26,6 +24,21 @@ void Logger::setDatasetPtr(Dataset *datasetPtr)
     datasetPtr_ = datasetPtr;
 }
 
+void Logger::setKlfWritePolicy(const KlfWriter::Policy& policy)
+{
+    klfWriter_.setPolicy(policy);
+}
+
+KlfWriter::Policy Logger::getKlfWritePolicy() const
+{
+    return klfWriter_.getPolicy();
+}
+
+KlfWriter::Stats Logger::getKlfStats() const
+{
+    return klfWriter_.getStats();
+}
+
 bool Logger::startNewKlfLog()
 {
     stopKlfLogging();
@@ -45,15 +58,14 @@ bool Logger::startNewKlfLog()
         QString fileName = QDateTime::currentDateTime().toString("yyyy.MM.dd_hh:mm:ss") + ".klf";
         fileName.replace(':', '.');
 
-        klfLogFile_->setFileName(logPath + "/" + fileName);
-        isOpen = klfLogFile_->open(QIODevice::WriteOnly);
+        isOpen = klfWriter_.start(logPath + "/" + fileName);
 
         if (isOpen) {
             core.consoleInfo("Logger dir: " + dir.path());
-            core.consoleInfo("Logger make file: " + klfLogFile_->fileName());
+            core.consoleInfo("Logger make file: " + klfWriter_.fileName());
         }
         else {
-            core.consoleInfo("Logger can't make file: " + klfLogFile_->fileName());
+            core.consoleInfo("Logger can't make file: " + klfWriter_.fileName());
         }
     }
     else {
@@ -65,46 +77,41 @@ bool Logger::startNewKlfLog()
 
 bool Logger::stopKlfLogging()
 {
-    if (isOpenKlf()) {
+    const bool isOpen = isOpenKlf();
+    klfWriter_.stop();
+
+    if (isOpen) {
+        const KlfWriter::Stats stats = klfWriter_.getStats();
+        if (stats.droppedFrames > 0 || stats.writeFailed) {
+            core.consoleInfo(QString("Logger klf lost %1 frames (%2 bytes)%3, the slowest write took %4 ms")
+                             .arg(stats.droppedFrames).arg(stats.droppedBytes).arg(stats.writeFailed ? ", the file write failed" : "").arg(stats.maxWriteUs / 1000));
+        }
         core.consoleInfo("Logger klf stoped");
     }
 
-    klfLogFile_->close();
-    klfCurrentIteration_ = 0;
-
     return true;
 }
 
 void Logger::loggingKlfStream(const QByteArray &data)
 {
-    if (isOpenKlf()) {
-        klfLogFile_->write(data);
-
-        if (klfCurrentIteration_ > klfFlushInterval_) {
-            klfLogFile_->flush();
-            klfCurrentIteration_ = 0;
-        }
-        else {
-            ++klfCurrentIteration_;
-        }
-    }
+    klfWriter_.push(data.constData(), data.size());
 }
 
 bool Logger::isOpenKlf()
 {
-    return klfLogFile_->isOpen();
+    return klfWriter_.isOpen();
 }
 
-void Logger::onFrameParserReceiveKlf(QUuid uuid, Link* linkPtr, FrameParser frame)
+void Logger::onFrameParserReceiveKlf(QUuid uuid, Link* linkPtr, FrameHandle frame)
 {
     Q_UNUSED(uuid);
     Q_UNUSED(linkPtr);
 
-    if (frame.isNested()) {
+    if (frame.isNull() || frame.isNested()) {
         return;
     }
 
-    loggingKlfStream(QByteArray((const char*)frame.frame(), frame.frameLen()));
+    klfWriter_.push(reinterpret_cast<const char*>(frame.data()), frame.size()); // copied straight into the writer ring
 }
 
 bool Logger::startNewCsvLog()
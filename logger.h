@@ -9,6 +9,8 @@
 #include "plotcash.h"
 #include "Link.h"
 #include "ProtoBinnary.h"
+#include "frame_pool.h"
+#include "klf_writer.h"
 
 
 class Logger : public QObject
@@ -18,6 +20,9 @@ class Logger : public QObject
 public:
     Logger();
     void setDatasetPtr(Dataset* datasetPtr);
+    void setKlfWritePolicy(const KlfWriter::Policy& policy); // applies to the next .klf log
+    KlfWriter::Policy getKlfWritePolicy() const;
+    KlfWriter::Stats getKlfStats() const;
 
 public slots:
     // .klf
@@ -25,7 +30,7 @@ public slots:
     bool stopKlfLogging();
     void loggingKlfStream(const QByteArray &data);
     bool isOpenKlf();
-    void onFrameParserReceiveKlf(QUuid uuid, Link* link, FrameParser frame);
+    void onFrameParserReceiveKlf(QUuid uuid, Link* link, FrameHandle frame);
 
     // .csv
     bool startNewCsvLog();
@@ -61,10 +66,8 @@ private:
 
     } csvData_;
 
-    static const int klfFlushInterval_ = 100; // num frames
-    std::unique_ptr<QFile> klfLogFile_;
+    KlfWriter klfWriter_;
     std::unique_ptr<QFile> csvLogFile_;
     std::unique_ptr<QFile> exportFile_;
     Dataset* datasetPtr_;
-    int klfCurrentIteration_;
 };
@@ -0,0 +1,81 @@
+#include "plot_columns.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+PlotColumns::PlotColumns() :
+    width_(0),
+    groups_(0),
+    allocations_(0)
+{
+
+}
+
+void PlotColumns::begin(int width, int groups)
+{
+    width_ = std::max(width, 0);
+    groups_ = groups;
+
+    for (int i = 0; i < FieldCount; ++i) {
+        if ((groupOf(static_cast<Field>(i)) & groups) == 0) {
+            continue;
+        }
+
+        QVector<float>& field = fields_[i];
+        if (width_ > field.capacity()) {
+            ++allocations_;
+        }
+        field.resize(width_);
+        field.fill(NAN);
+    }
+}
+
+PlotColumns::Group PlotColumns::groupOf(Field field)
+{
+    if (field <= Roll) {
+        return GroupAttitude;
+    }
+    if (field <= Encoder3) {
+        return GroupEncoder;
+    }
+    if (field < VelocityX) {
+        return GroupDVLBeam;
+    }
+    if (field <= DVLDistance) {
+        return GroupDVLSolution;
+    }
+    if (field <= UsblDistance) {
+        return GroupUsbl;
+    }
+    if (field == GnssHSpeed) {
+        return GroupGnss;
+    }
+    if (field <= BottomDistance2) {
+        return GroupBottom;
+    }
+
+    return GroupRangeFinder;
+}
+
+void PlotColumns::mapY(const QVector<float>& data, float from, float to, float height, QVector<float>& dst)
+{
+    dst.resize(data.size());
+
+    const float scale = height / (to - from);
+    for (int i = 0; i < data.size(); ++i) {
+        float y = (data[i] - from) * scale;
+        if (y < 0) {
+            y = 0;
+        }
+        else if (y > height) {
+            y = height;
+        }
+        dst[i] = y;
+    }
+}
+
+qint64 PlotColumns::getAllocations() const
+{
+    return allocations_;
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <QVector>
+
+
+/*
+ * Per-frame snapshot of the scalar epoch fields drawn by the line layers of Plot2D, one float per canvas
+ * column and field in separate arrays, NAN where the epoch has no value. Plot2D walks the cursor once per
+ * frame and fills the groups of the visible layers, the layers only map the arrays onto the canvas. The
+ * arrays keep their storage between frames, a frame allocates only when the canvas gets wider.
+ *
+ * gather() reads the epochs from a source with the Dataset interface: fromIndex(index) gives an epoch
+ * pointer or nullptr, the epoch has the getters of Epoch.
+ */
+class PlotColumns
+{
+public:
+    /*structures*/
+    enum Field {
+        Yaw,
+        Pitch,
+        Roll,
+        Encoder1,
+        Encoder2,
+        Encoder3,
+        BeamVelocity,                    // + beam, 4 beams
+        BeamMode = BeamVelocity + 4,     // + beam
+        BeamDistance = BeamMode + 4,     // + beam
+        VelocityX = BeamDistance + 4,
+        VelocityY,
+        VelocityZ,
+        VelocityAbs,
+        DVLDistance,
+        UsblAzimuth,
+        UsblElevation,
+        UsblDistance,
+        GnssHSpeed,
+        BottomDistance1,
+        BottomDistance2,
+        RangeFinder,
+        FieldCount
+    };
+
+    enum Group { // fields filled together, one group per line layer
+        GroupAttitude = 1 << 0,
+        GroupEncoder = 1 << 1,
+        GroupDVLBeam = 1 << 2,
+        GroupDVLSolution = 1 << 3,
+        GroupUsbl = 1 << 4,
+        GroupGnss = 1 << 5,
+        GroupBottom = 1 << 6,
+        GroupRangeFinder = 1 << 7
+    };
+
+    /*methods*/
+    PlotColumns();
+
+    // starts a frame: the fields of the groups get width columns of NAN, the other fields are left as they are
+    void begin(int width, int groups);
+
+    // starts a frame and fills the groups from the epochs of the columns (-1 for none), the bottom of channel2 only if isDoubled
+    template <typename EpochSource>
+    void gather(EpochSource& source, const std::vector<int>& indexes, int width, int groups, int channel1, int channel2, bool isDoubled);
+
+    static Group groupOf(Field field);
+    // canvas y of each value from..to over 0..height, clamped to the canvas
+    static void mapY(const QVector<float>& data, float from, float to, float height, QVector<float>& dst);
+    bool isFilled(int groups) const { return (groups_ & groups) == groups; }
+    int width() const { return width_; }
+
+    float* data(Field field) { return fields_[field].data(); }
+    const QVector<float>& at(Field field) const { return fields_[field]; }
+
+    qint64 getAllocations() const; // field storage growths since construction
+
+private:
+    /*data*/
+    QVector<float> fields_[FieldCount];
+    int width_;
+    int groups_;
+    qint64 allocations_;
+};
+
+
+template <typename EpochSource>
+void PlotColumns::gather(EpochSource& source, const std::vector<int>& indexes, int width, int groups, int channel1, int channel2, bool isDoubled)
+{
+    begin(width, groups);
+    if (groups == 0) {
+        return;
+    }
+
+    float* col[FieldCount];
+    for (int f = 0; f < FieldCount; ++f) {
+        col[f] = (groups & groupOf(static_cast<Field>(f))) ? data(static_cast<Field>(f)) : nullptr;
+    }
+
+    const int columns = static_cast<int>(indexes.size());
+
+    // one epoch lookup per column for all layers
+    for (int i = 0; i < width_; ++i) {
+        auto* epoch = source.fromIndex(i < columns ? indexes[i] : -1);
+        if (epoch == nullptr) {
+            continue;
+        }
+
+        if ((groups & GroupAttitude) && epoch->isAttAvail()) {
+            col[Yaw][i] = epoch->yaw();
+            col[Pitch][i] = epoch->pitch();
+            col[Roll][i] = epoch->roll();
+        }
+
+        if ((groups & GroupEncoder) && epoch->isEncodersSeted()) {
+            col[Encoder1][i] = epoch->encoder1();
+            col[Encoder2][i] = epoch->encoder2();
+            col[Encoder3][i] = epoch->encoder3();
+        }
+
+        if (groups & GroupDVLBeam) {
+            for (int beam = 0; beam < 4; ++beam) {
+                if (!epoch->isDopplerBeamAvail(beam)) {
+                    continue;
+                }
+                const auto solution = epoch->dopplerBeam(beam);
+                col[BeamVelocity + beam][i] = solution.velocity;
+                col[BeamMode + beam][i] = (solution.mode * 6 + beam) * 2;
+                col[BeamDistance + beam][i] = solution.distance;
+            }
+        }
+
+        if ((groups & GroupDVLSolution) && epoch->isDVLSolutionAvail()) {
+            const auto solution = epoch->dvlSolution();
+            col[VelocityX][i] = solution.velocity.x;
+            col[VelocityY][i] = solution.velocity.y;
+            col[VelocityZ][i] = solution.velocity.z;
+            col[VelocityAbs][i] = std::sqrt(solution.velocity.x * solution.velocity.x + solution.velocity.y * solution.velocity.y +
+                                            solution.velocity.z * solution.velocity.z);
+            col[DVLDistance][i] = solution.distance.z;
+        }
+
+        if ((groups & GroupUsbl) && epoch->isUsblSolutionAvailable()) {
+            const auto solution = epoch->usblSolution();
+            col[UsblAzimuth][i] = solution.azimuth_deg;
+            col[UsblElevation][i] = solution.elevation_deg;
+            col[UsblDistance][i] = solution.distance_m;
+        }
+
+        if (groups & GroupGnss) {
+            col[GnssHSpeed][i] = epoch->gnssHSpeed();
+        }
+
+        if (groups & GroupBottom) {
+            if (isDoubled) {
+                col[BottomDistance1][i] = -epoch->distProccesing(channel1);
+                col[BottomDistance2][i] = epoch->distProccesing(channel2);
+            }
+            else {
+                col[BottomDistance1][i] = epoch->distProccesing(channel1);
+            }
+        }
+
+        if (groups & GroupRangeFinder) {
+            col[RangeFinder][i] = epoch->rangeFinder();
+        }
+    }
+}
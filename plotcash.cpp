@@ -1,5 +1,9 @@
 #include "plotcash.h"
 #include <QPainterPath>
+#include <QFutureWatcher>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+#include "bottom_track_kernel.h"
 
 #include <core.h>
 extern Core core;
@@ -18,10 +22,38 @@ void Epoch::setEvent(int timestamp, int id, int unixt) {
 }
 
 void Epoch::setChart(int16_t channel, QVector<uint8_t> data, float resolution, float offset) {
-    _charts[channel].amplitude = data;
+    if(columns_ != nullptr) {
+        const uint8_t* samples = columns_->appendAmplitude(data.constData(), data.size());
+        _charts[channel].amplitude = AmplitudeView(samples, data.size());
+        columns_->setChart(channel, row_, samples, data.size(), resolution);
+    } else {
+        _charts[channel].amplitude = AmplitudeView(data);
+    }
+    _charts[channel].compensated.clear(); // computed on the first compensated read
+    _charts[channel].compensatedView = AmplitudeView();
     _charts[channel].resolution = resolution;
     _charts[channel].offset = offset;
     _charts[channel].type = 1;
+    syncDist(channel);
+}
+
+void Epoch::closeCharts() {
+    if(columns_ == nullptr) {
+        return;
+    }
+
+    for(auto it = _charts.begin(); it != _charts.end(); ++it) {
+        Echogram& chart = it.value();
+        if(!chart.compensatedView.isEmpty() || chart.amplitude.isEmpty()) {
+            continue;
+        }
+
+        uint8_t* samples = columns_->allocateAmplitude(chart.amplitude.size());
+        Echogram::compensate(chart.amplitude.constData(), samples, chart.amplitude.size(), chart.resolution);
+        chart.compensatedView = AmplitudeView(samples, chart.amplitude.size());
+        chart.compensated.clear(); // a copy made while the epoch was open
+        columns_->setCompensated(it.key(), row_, samples);
+    }
 }
 
 // void Epoch::setComplexSignal16(int channel, QVector<Complex16> data) {
@@ -31,6 +63,9 @@ void Epoch::setChart(int16_t channel, QVector<uint8_t> data, float resolution, f
 
 void Epoch::setComplexF(int channel, ComplexSignal signal) {
     _complex[channel] = signal;
+    if(!_complexUnconverted.contains(channel)) {
+        _complexUnconverted.append(channel);
+    }
 }
 void Epoch::setDist(int dist) {
     _rangeFinders[0] = dist*0.001;
@@ -62,11 +97,13 @@ void Epoch::setPositionLLA(double lat, double lon, LLARef* ref, uint32_t unix_ti
     _positionGNSS.lla.longitude = lon;
 
     flags.posAvail = true;
+    syncPosition();
 }
 
 void Epoch::setPositionLLA(Position position) {
     _positionGNSS = position;
     flags.posAvail = true;
+    syncPosition();
 }
 
 void Epoch::setExternalPosition(Position position) {
@@ -76,6 +113,7 @@ void Epoch::setExternalPosition(Position position) {
 void Epoch::setPositionRef(LLARef* ref) {
     if(ref != NULL && ref->isInit) {
         _positionGNSS.LLA2NED(ref);
+        syncPosition();
     }
 }
 
@@ -114,16 +152,42 @@ void Epoch::setAtt(float yaw, float pitch, float roll) {
     _attitude.yaw = yaw;
     _attitude.pitch = pitch;
     _attitude.roll = roll;
+
+    if(columns_ != nullptr) {
+        columns_->setYaw(row_, yaw);
+    }
 }
 
 void Epoch::setGNSSSec(time_t sec)
 {
     _positionGNSS.time.sec = sec;
+    syncPosition();
 }
 
 void Epoch::setGNSSNanoSec(int nanoSec)
 {
     _positionGNSS.time.nanoSec = nanoSec;
+    syncPosition();
+}
+
+void Epoch::syncPosition()
+{
+    if(columns_ == nullptr) { return; }
+
+    const NED& ned = _positionGNSS.ned;
+    columns_->setTime(row_, static_cast<qint64>(_positionGNSS.time.sec)*1000000000 + _positionGNSS.time.nanoSec);
+    columns_->setNed(row_, ned.n, ned.e, ned.d);
+}
+
+void Epoch::syncDist(int16_t channel)
+{
+    if(columns_ == nullptr) { return; }
+
+    auto it = _charts.find(channel);
+    if(it == _charts.end()) { return; }
+
+    DistProcessing& dist = it.value().bottomProcessing;
+    columns_->setDist(channel, row_, dist.getDistance(), dist.getMin(), dist.getMax());
 }
 
 void Epoch::doBottomTrack2D(Echogram &chart, bool is_update_dist) {
@@ -137,8 +201,13 @@ void Epoch::doBottomTrackSideScan(Echogram &chart, bool is_update_dist) {
 }
 
 void Epoch::moveComplexToEchogram(float offset_m, float levels_offset_db) {
-    for (auto i = _complex.cbegin(), end = _complex.cend(); i != end; ++i) {
-        // cout << qPrintable(i.key()) << ": " << i.value() << endl;
+    // every chart goes into the slab again, so only the signals that arrived since are converted
+    for (int channel : qAsConst(_complexUnconverted)) {
+        auto i = _complex.constFind(channel);
+        if (i == _complex.cend()) {
+            continue;
+        }
+
         QVector<ComplexF> data = i.value().data;
 
 
@@ -161,6 +230,8 @@ void Epoch::moveComplexToEchogram(float offset_m, float levels_offset_db) {
 
         setChart(i.key(), chart, 1500.0f/i.value().sampleRate, offset_m);
     }
+
+    _complexUnconverted.clear();
 }
 
 void Epoch::setInterpNED(NED ned)
@@ -207,33 +278,53 @@ Dataset::Dataset() :
     interpolator_(this),
     lastBoatTrackEpoch_(0),
     lastBottomTrackEpoch_(0),
-    boatTrackValidPosCounter_(0)
+    boatTrackValidPosCounter_(0),
+    bottomTrackBusy_(false),
+    bottomTrackCancel_(false),
+    spatialDirtyFrom_(0),
+    spatialDirtyTo_(0),
+    spatialProcessedTo_(0)
 {
+    echogramPyramid_.setSource([this](int channel, int epochIndx) -> EchogramPyramid::Source {
+        EchogramPyramid::Source source;
+        const Epoch* epoch = epochView(epochIndx);
+        const Epoch::Echogram* chart = epoch != NULL ? epoch->chart(channel) : NULL;
+        if (chart != NULL) {
+            source.data = chart->amplitude.constData();
+            source.size = chart->amplitude.size();
+            source.resolution = chart->resolution;
+            source.offset = chart->offset;
+        }
+        return source;
+    });
+
+    connect(&bottomTrackWatcher_, &QFutureWatcherBase::finished, this, &Dataset::finishBottomTrack);
+    connect(&bottomTrackWatcher_, &QFutureWatcherBase::progressValueChanged, this, [this](int value) {
+        const int blocks_count = std::max(1, bottomTrackWatcher_.progressMaximum());
+        emit bottomTrackProgressChanged(value*100/blocks_count);
+    });
+
     resetDataset();
 }
 
 void Dataset::getMaxDistanceRange(float *from, float *to, int channel1, int channel2) {
-    const int sz = size();
     float channel1_max = 0;
     float channel2_max = 0;
-    for(int iepoch = 0; iepoch < sz; iepoch++) {
-        Epoch* epoch = fromIndex(iepoch);
-        if(epoch != NULL) {
-            if(epoch->chartAvail(channel1)) {
-                float range = epoch->chart(channel1)->range();
-                if(channel1_max < range) {
-                    channel1_max = range;
-                }
+    _pool.forEach(0, size(), [&](int, Epoch& epoch) {
+        if(epoch.chartAvail(channel1)) {
+            float range = epoch.chart(channel1)->range();
+            if(channel1_max < range) {
+                channel1_max = range;
             }
+        }
 
-            if(epoch->chartAvail(channel2)) {
-                float range = epoch->chart(channel2)->range();
-                if(channel2_max < range) {
-                    channel2_max = range;
-                }
+        if(epoch.chartAvail(channel2)) {
+            float range = epoch.chart(channel2)->range();
+            if(channel2_max < range) {
+                channel2_max = range;
             }
         }
-    }
+    });
 
     if(channel1_max > 0) {
         if(channel2_max > 0) {
@@ -250,7 +341,7 @@ void Dataset::getMaxDistanceRange(float *from, float *to, int channel1, int chan
     }
 }
 
-QVector<QVector3D> Dataset::boatTrack() const
+const QVector<QVector3D>& Dataset::boatTrack() const
 {
     return _boatTrack;
 }
@@ -305,6 +396,7 @@ void Dataset::addChart(int16_t channel, QVector<uint8_t> data, float resolution,
     }
 
     _pool[endIndex()].setChart(channel, data, resolution, offset);
+    echogramPyramid_.update(channel, endIndex());
 
     validateChannelList(channel);
 
@@ -331,6 +423,9 @@ void Dataset::rawDataRecieved(RawData raw_data) {
         offset_db = -86;
 
         last_epoch->moveComplexToEchogram(offset_m, offset_db);
+        for (int16_t channel : last_epoch->chartChannels()) {
+            echogramPyramid_.update(channel, endIndex());
+        }
 
         if(header.channelGroup == 0) {
             last_epoch = addNewEpoch();
@@ -638,17 +733,28 @@ void Dataset::mergeGnssTrack(QList<Position> track) {
             if(min_ind > 0) {
                 track_pos_save = min_ind;
                 epoch->setExternalPosition(track[min_ind]);
+                hasExternalLla_ |= track[min_ind].lla.isValid();
+                hasExternalNed_ |= track[min_ind].ned.isValid();
                 sync_count++;
             }
         }
     }
+    markSpatialDirty(0, psize);
     emit dataUpdate();
 }
 
 
 void Dataset::resetDataset() {
+    cancelBottomTrackProcessing();
+    bottomTrackFuture_.waitForFinished(); // workers read the charts of the pool
+    bottomTrackBusy_ = false; // its finished() only emits the progress end now
+    bottomTrackPendingRuns_.clear();
     _pool.clear();
+    columns_.clear();
+    echogramPyramid_.clear();
+    spatialDirtyFrom_ = spatialDirtyTo_ = spatialProcessedTo_ = 0;
     _llaRef.isInit = false;
+    hasExternalLla_ = hasExternalNed_ = false;
     _channelsSetup.clear();
     lastBottomTrackEpoch_ = 0;
     resetDistProcessing();
@@ -666,150 +772,100 @@ void Dataset::resetDistProcessing() {
     }
 }
 
-void Dataset::bottomTrackProcessing(int channel1, int channel2)
+namespace {
+
+struct BottomTrackSetup {
+    BottomTrackKernel::Params kernel;
+    float t1 = 1.07f;
+    int windowSize = 1;
+    float verticalGap = 0;
+    float minDistance = 0;
+    float maxDistance = 1000;
+    int32_t threshold = 0;
+    int epochMinIndex = 0;
+};
+
+// one chart of the tracked channel, taken from the epoch columns of the dataset
+struct BottomTrackColumn {
+    const uint8_t* data = nullptr;
+    int dataSize = 0;
+    float resolution = 0;
+    float min = NAN, max = NAN;
+    int epochIndx = 0;
+    int summSize = 0; // size of the window sum before this column is added
+};
+
+struct BottomTrackBlock {
+    int from = 0;
+    int to = 0;
+};
+
+// Tracking over columns [block.from, block.to). The window is first refilled with the columns before block.from,
+// so from there on the sums are those of a single pass over all columns and the distances written are the same.
+QVector<QPair<int, float>> trackBottomBlock(const BottomTrackSetup& setup, const QVector<BottomTrackColumn>& columns,
+                                            const BottomTrackBlock& block, const std::atomic_bool& cancel)
 {
-    if(bottomTrackParam_.indexFrom < 0 || bottomTrackParam_.indexTo < 0) { return; }
-
-    int epoch_min_index = bottomTrackParam_.indexFrom - bottomTrackParam_.windowSize/2;
-
-    if(epoch_min_index < 0) {
-        epoch_min_index = 0;
-    }
-
-    int epoch_max_index = bottomTrackParam_.indexTo + bottomTrackParam_.windowSize/2;
-    if(epoch_max_index >= size()) {
-        epoch_max_index = size();
-    }
-
-    QVector<int32_t> summ;
-
-    float gain_slope = bottomTrackParam_.gainSlope;
-    float threshold = bottomTrackParam_.threshold;
-
-    int istart = 4;
-    int init_win = 6;
-    int scale_win = 20;
-
-    int16_t c1 = -6, c2 = 6, c3 = 4, c4 = 2, c5 = 0;
-    float s2 = 1.04f, s3 = 1.06f, s4 = 1.10f, s5 = 1.15f;
-    float t1 = 1.07;
-
-
-
-    if(bottomTrackParam_.preset == BottomTrackPreset::BottomTrackOneBeamNarrow) {
-        istart = 4;
-        init_win = 6;
-        scale_win = 35;
-
-        c1 = -3, c2 = 8, c3 = 5, c4 = -1, c5 = -1;
-        s2 = 1.015f, s3 = 1.035f, s4 = 1.08f, s5 = 1.12f;
-        t1 = 1.04;
-    }
-
-
-    if(bottomTrackParam_.preset == BottomTrackPreset::BottomTrackSideScan) {
-        istart = 4;
-        init_win = 6;
-        scale_win = 12;
-
-        c1 = -3, c2 = -3, c3 = 4, c4 = 2, c5 = 1;
-        s2 = 1.1f, s3 = 1.2f, s4 = 1.3f, s5 = 1.4f;
-        t1 = 1.2;
-    }
-
-    const int gain_slope_inv = 1000/(gain_slope);
-    const int threshold_int = 10*gain_slope_inv*1000*threshold;
-
     typedef  struct {
         float min = NAN, max = NAN;
     } EpochConstrants;
 
-    QVector<QVector<int32_t>> cash(bottomTrackParam_.windowSize);
-    QVector<EpochConstrants> constr(bottomTrackParam_.windowSize);
+    const int window_size = setup.windowSize;
+    const int istart = setup.kernel.istart;
+    const int init_win = setup.kernel.initWin;
+    const float t1 = setup.t1;
 
-    QVector<float> bottom_track(epoch_max_index - epoch_min_index);
-    bottom_track.fill(NAN);
+    BottomTrackKernel kernel(setup.kernel);
 
-    int epoch_counter = 0;
+    QVector<QVector<int32_t>> cash(window_size);
+    QVector<EpochConstrants> constr(window_size);
 
-    for(int iepoch = epoch_min_index; iepoch < epoch_max_index; iepoch++) {
-        Epoch* epoch = fromIndex(iepoch);
-        if(epoch == NULL || !epoch->chartAvail(channel1)) { continue; }
+    const int warm_from = std::max(0, block.from - window_size);
+    QVector<int32_t> summ(columns[warm_from].summSize);
 
-        epoch_counter++;
+    QVector<QPair<int, float>> distances;
+    distances.reserve(block.to - block.from);
 
-        Epoch::Echogram* chart = epoch->chart(channel1);
+    for(int icol = warm_from; icol < block.to; icol++) {
+        if(cancel) { return {}; }
 
-        uint8_t* data = (uint8_t*)chart->amplitude.constData();
-        const int data_size = chart->amplitude.size();
+        const int epoch_counter = icol + 1;
+        const BottomTrackColumn& column = columns[icol];
 
-        int cash_ind = (epoch_counter-1)%bottomTrackParam_.windowSize;
+        const uint8_t* data = column.data;
+        const int data_size = column.dataSize;
 
-        int back_cash_ind = ((epoch_counter)%bottomTrackParam_.windowSize);
-        int32_t* back_cash_data = (int32_t*)cash[back_cash_ind].constData();
-        const int back_cash_size = cash[back_cash_ind].size();
+        int cash_ind = (epoch_counter-1)%window_size;
 
-        int32_t* summ_data = (int32_t*)summ.constData();
+        int back_cash_ind = ((epoch_counter)%window_size);
+        const int32_t* back_cash_data = cash[back_cash_ind].constData();
+        const int back_cash_size = cash[back_cash_ind].size();
 
-        if(epoch_counter >= bottomTrackParam_.windowSize) {
-            for(int i = istart; i < back_cash_size; i++) { summ_data[i] -= back_cash_data[i]; }
+        if(epoch_counter >= window_size) {
+            kernel.subtract(summ.data(), back_cash_data, istart, back_cash_size);
         }
 
         if(cash[cash_ind].size() != data_size) {
             cash[cash_ind].resize(data_size);
         }
 
-        int32_t* cash_data = (int32_t*)cash[cash_ind].constData();
-
+        int32_t* cash_data = cash[cash_ind].data();
 
-        uint8_t* data_from = &data[istart];
-        uint8_t* data_to = &data[(istart+init_win)];
-
-        int data_acc = 0;
-        for(int idata = istart; idata < (istart+init_win); idata++) {
-            data_acc += data[idata];
-        }
-
-        int avrg_range = init_win;
-        for(int idata = istart; (idata + avrg_range) < data_size; idata++) {
-            data_acc -= *data_from; data_from++;
-            data_acc += *data_to; data_to++;
-            while((idata+(init_win*scale_win)) >= ((avrg_range = data_to - data_from)*scale_win)) {
-                data_acc += *data_to; data_to++;
-            }
-            cash_data[idata] = 10*data_acc / (avrg_range);
-        }
-
-        const int data_conv_size = data_size - avrg_range;
-        for(int idata = istart; ; idata++) {
-            const float fidata = idata + init_win+1;
-            int di1 =  idata;
-            int di2 =  fidata*s2;
-            int di3 =  fidata*s3;
-            int di4 =  fidata*s4;
-            int di5 =  fidata*s5;
-
-            if(di5 >= data_conv_size) { break; }
-
-            int calc = (c1*cash_data[di1] + c2*cash_data[di2] + c3*cash_data[di3] + c4*cash_data[di4] + c5*cash_data[di5]);
-            calc = calc*gain_slope_inv + calc*(idata);
-
-            cash_data[idata] = calc;
-        }
+        kernel.filterColumn(data, data_size, cash_data);
 
         const int col_size = cash[cash_ind].size();
         if(summ.size() < col_size) { summ.resize(col_size); }
-        summ_data = (int32_t*)summ.constData();
-        for(int i = istart; i < col_size; i++) { summ_data[i] += cash_data[i]; }
+        const int32_t* summ_data = summ.constData();
+        kernel.add(summ.data(), cash_data, istart, col_size);
 
+        constr[cash_ind].min = column.min;
+        constr[cash_ind].max = column.max;
 
-        constr[cash_ind].min = chart->bottomProcessing.getMin();
-        constr[cash_ind].max = chart->bottomProcessing.getMax();
+        if(icol < block.from) { continue; }
 
-        const int win_center_index = (epoch_counter - 1 + bottomTrackParam_.windowSize/2)%bottomTrackParam_.windowSize;
+        const int win_center_index = (epoch_counter - 1 + window_size/2)%window_size;
 
-        float search_from_distance = bottomTrackParam_.minDistance;
-        float search_to_distance = bottomTrackParam_.maxDistance;
+        float search_from_distance = setup.minDistance;
+        float search_to_distance = setup.maxDistance;
 
         if(search_from_distance < constr[win_center_index].min) {
             search_from_distance = constr[win_center_index].min;
@@ -819,8 +875,8 @@ void Dataset::bottomTrackProcessing(int channel1, int channel2)
             search_to_distance = constr[win_center_index].max;
         }
 
-        int start_search_index = search_from_distance/t1/chart->resolution;
-        int end_search_index = search_to_distance/t1/chart->resolution;
+        int start_search_index = search_from_distance/t1/column.resolution;
+        int end_search_index = search_to_distance/t1/column.resolution;
 
         if(start_search_index < 0) { start_search_index = 0; }
         if(start_search_index > summ.size()) { start_search_index = summ.size(); }
@@ -828,26 +884,19 @@ void Dataset::bottomTrackProcessing(int channel1, int channel2)
         if(end_search_index < 0) { end_search_index = 0; }
         if(end_search_index > summ.size()) { end_search_index = summ.size(); }
 
-
-        int max_val = threshold_int*bottomTrackParam_.windowSize;
-        int max_ind = -1;
-        for(int i = start_search_index; i < end_search_index ; i++) {
-            if(max_val < summ_data[i]) {
-                max_val = summ_data[i];
-                max_ind = i;
-            }
-        }
+        const int max_ind = kernel.argmax(summ_data, start_search_index, end_search_index, setup.threshold*window_size);
 
         if(max_ind > 0) {
-            float distance = ((max_ind+init_win+1)*t1)*chart->resolution;
+            const int iepoch = columns[icol].epochIndx;
+            float distance = ((max_ind+init_win+1)*t1)*column.resolution;
 
-            if(epoch_counter >= bottomTrackParam_.windowSize) {
-                if(bottomTrackParam_.verticalGap > 0) {
-                    int32_t* center_cash_data = (int32_t*)cash[win_center_index].constData();
+            if(epoch_counter >= window_size) {
+                if(setup.verticalGap > 0) {
+                    const int32_t* center_cash_data = cash[win_center_index].constData();
                     const int center_cash_size = cash[win_center_index].size();
 
-                    int start_gap_index = max_ind*(1.0f-bottomTrackParam_.verticalGap);
-                    int end_gap_index = max_ind*(1.0f+bottomTrackParam_.verticalGap);
+                    int start_gap_index = max_ind*(1.0f-setup.verticalGap);
+                    int end_gap_index = max_ind*(1.0f+setup.verticalGap);
 
                     if(start_gap_index < start_search_index) { start_gap_index = start_search_index; }
                     if(start_gap_index > center_cash_size) { start_gap_index = center_cash_size; }
@@ -856,36 +905,229 @@ void Dataset::bottomTrackProcessing(int channel1, int channel2)
                     if(end_gap_index > center_cash_size) { end_gap_index = center_cash_size; }
                     if(end_gap_index > end_search_index) { end_gap_index = end_search_index; }
 
-                    int max_gap_val = 0;
-                    int max_gap_ind = -1;
-                    for(int i = start_gap_index; i < end_gap_index ; i++) {
-                        if(max_gap_val < center_cash_data[i]) {
-                            max_gap_val = center_cash_data[i];
-                            max_gap_ind = i;
-                        }
-                    }
-
+                    const int max_gap_ind = kernel.argmax(center_cash_data, start_gap_index, end_gap_index, 0);
 
                     if(max_gap_ind > 0) {
-                        distance = ((max_gap_ind+init_win+1)*t1)*chart->resolution;
+                        distance = ((max_gap_ind+init_win+1)*t1)*column.resolution;
                     }
                 }
 
-                bottom_track[iepoch - epoch_min_index - bottomTrackParam_.windowSize/2] = distance;
+                distances.append(qMakePair(iepoch - setup.epochMinIndex - window_size/2, distance));
             } else {
-                bottom_track[iepoch - epoch_min_index - epoch_counter/2] = distance;
-            }
+                distances.append(qMakePair(iepoch - setup.epochMinIndex - epoch_counter/2, distance));
             }
+        }
     }
 
+    return distances;
+}
+
+} // namespace
+
+void Dataset::bottomTrackProcessing(int channel1, int channel2)
+{
+    if(bottomTrackParam_.indexFrom < 0 || bottomTrackParam_.indexTo < 0) { return; }
 
-    int epoch_start_index = bottomTrackParam_.indexFrom;
+    BottomTrackRun run;
+    run.channel1 = channel1;
+    run.channel2 = channel2;
+    run.indexFrom = bottomTrackParam_.indexFrom;
+    run.indexTo = bottomTrackParam_.indexTo;
+
+    if(bottomTrackBusy_) {
+        queueBottomTrack(run);
+        return;
+    }
+
+    startBottomTrack(run);
+}
+
+void Dataset::queueBottomTrack(const BottomTrackRun& request)
+{
+    BottomTrackRun run = request;
+
+    // only runs of the same channels that overlap or touch become one, epochs between separate ranges stay untouched
+    for(int i = 0; i < bottomTrackPendingRuns_.size();) {
+        const BottomTrackRun& pending = bottomTrackPendingRuns_[i];
+        const bool is_same_channels = pending.channel1 == run.channel1 && pending.channel2 == run.channel2;
+        if(is_same_channels && pending.indexFrom <= run.indexTo && run.indexFrom <= pending.indexTo) {
+            run.indexFrom = std::min(run.indexFrom, pending.indexFrom);
+            run.indexTo = std::max(run.indexTo, pending.indexTo);
+            bottomTrackPendingRuns_.removeAt(i);
+        } else {
+            i++;
+        }
+    }
+
+    bottomTrackPendingRuns_.append(run);
+}
+
+void Dataset::startBottomTrack(const BottomTrackRun& request)
+{
+    BottomTrackRun run = request;
+    const int channel1 = run.channel1;
+
+    int epoch_min_index = run.indexFrom - bottomTrackParam_.windowSize/2;
+
+    if(epoch_min_index < 0) {
+        epoch_min_index = 0;
+    }
+
+    int epoch_max_index = run.indexTo + bottomTrackParam_.windowSize/2;
+    if(epoch_max_index >= size()) {
+        epoch_max_index = size();
+    }
+
+    float gain_slope = bottomTrackParam_.gainSlope;
+    float threshold = bottomTrackParam_.threshold;
+
+    int istart = 4;
+    int init_win = 6;
+    int scale_win = 20;
+
+    int16_t c1 = -6, c2 = 6, c3 = 4, c4 = 2, c5 = 0;
+    float s2 = 1.04f, s3 = 1.06f, s4 = 1.10f, s5 = 1.15f;
+    float t1 = 1.07;
+
+
+
+    if(bottomTrackParam_.preset == BottomTrackPreset::BottomTrackOneBeamNarrow) {
+        istart = 4;
+        init_win = 6;
+        scale_win = 35;
+
+        c1 = -3, c2 = 8, c3 = 5, c4 = -1, c5 = -1;
+        s2 = 1.015f, s3 = 1.035f, s4 = 1.08f, s5 = 1.12f;
+        t1 = 1.04;
+    }
+
+
+    if(bottomTrackParam_.preset == BottomTrackPreset::BottomTrackSideScan) {
+        istart = 4;
+        init_win = 6;
+        scale_win = 12;
+
+        c1 = -3, c2 = -3, c3 = 4, c4 = 2, c5 = 1;
+        s2 = 1.1f, s3 = 1.2f, s4 = 1.3f, s5 = 1.4f;
+        t1 = 1.2;
+    }
+
+    const int gain_slope_inv = 1000/(gain_slope);
+    const int threshold_int = 10*gain_slope_inv*1000*threshold;
+
+    auto setup = std::make_shared<BottomTrackSetup>();
+    setup->kernel.istart = istart;
+    setup->kernel.initWin = init_win;
+    setup->kernel.scaleWin = scale_win;
+    setup->kernel.c1 = c1, setup->kernel.c2 = c2, setup->kernel.c3 = c3, setup->kernel.c4 = c4, setup->kernel.c5 = c5;
+    setup->kernel.s2 = s2, setup->kernel.s3 = s3, setup->kernel.s4 = s4, setup->kernel.s5 = s5;
+    setup->kernel.gainSlopeInv = gain_slope_inv;
+    setup->t1 = t1;
+    setup->windowSize = bottomTrackParam_.windowSize;
+    setup->verticalGap = bottomTrackParam_.verticalGap;
+    setup->minDistance = bottomTrackParam_.minDistance;
+    setup->maxDistance = bottomTrackParam_.maxDistance;
+    setup->threshold = threshold_int;
+    setup->epochMinIndex = epoch_min_index;
+
+    auto columns = std::make_shared<QVector<BottomTrackColumn>>();
+    columns->reserve(epoch_max_index - epoch_min_index);
+    int summ_size = 0;
+
+    if(const EpochColumns::Channel* channel_columns = columns_.channel(channel1)) {
+        const int columns_max_index = std::min(epoch_max_index, channel_columns->sampleCount.size());
+        for(int iepoch = epoch_min_index; iepoch < columns_max_index; iepoch++) {
+            const int data_size = channel_columns->sampleCount[iepoch];
+            if(data_size <= 0) { continue; }
+
+            BottomTrackColumn column;
+            column.data = channel_columns->samples[iepoch];
+            column.dataSize = data_size;
+            column.resolution = channel_columns->resolution[iepoch];
+            column.min = channel_columns->distMin[iepoch];
+            column.max = channel_columns->distMax[iepoch];
+            column.epochIndx = iepoch;
+            column.summSize = summ_size;
+            columns->append(column);
+
+            summ_size = std::max(summ_size, data_size);
+        }
+    }
+
+    // neighbouring blocks overlap by the window size, the overlap only refills the window of the next block
+    const int block_size = std::max(bottomTrackBlockSize_, 4*bottomTrackParam_.windowSize);
+    QVector<BottomTrackBlock> blocks;
+    for(int from = 0; from < columns->size(); from += block_size) {
+        BottomTrackBlock block;
+        block.from = from;
+        block.to = std::min(from + block_size, static_cast<int>(columns->size()));
+        blocks.append(block);
+    }
+
+    run.epochMinIndex = epoch_min_index;
+    run.epochMaxIndex = epoch_max_index;
+    bottomTrackRun_ = run;
+
+    bottomTrackBusy_ = true;
+    bottomTrackCancel_ = false;
+    emit bottomTrackProgressChanged(0);
+
+    // the columns point into the amplitude slab, which stays in place while the dataset grows
+    QFuture<QVector<QPair<int, float>>> future = QtConcurrent::mapped(blocks, [this, setup, columns](const BottomTrackBlock& block) {
+        return trackBottomBlock(*setup, *columns, block, bottomTrackCancel_);
+    });
+
+    bottomTrackFuture_ = future;
+
+    if(QThread::currentThread() == thread()) {
+        bottomTrackWatcher_.setFuture(future); // finishBottomTrack() runs from the event loop
+    } else {
+        future.waitForFinished();
+        finishBottomTrack();
+    }
+}
+
+void Dataset::finishBottomTrack()
+{
+    if(!bottomTrackBusy_) {
+        emit bottomTrackProgressChanged(-1);
+        return;
+    }
+    bottomTrackBusy_ = false;
+
+    const BottomTrackRun run = bottomTrackRun_;
+    const int channel1 = run.channel1;
+    const int channel2 = run.channel2;
+    const int epoch_min_index = run.epochMinIndex;
+    const int epoch_max_index = run.epochMaxIndex;
+
+    const QFuture<QVector<QPair<int, float>>> future = bottomTrackFuture_;
+    bottomTrackFuture_ = QFuture<QVector<QPair<int, float>>>();
+
+    if(bottomTrackCancel_ || future.isCanceled()) {
+        bottomTrackPendingRuns_.clear();
+        emit bottomTrackProgressChanged(-1);
+        return;
+    }
+
+    QVector<float> bottom_track(epoch_max_index - epoch_min_index);
+    bottom_track.fill(NAN);
+
+    // blocks are applied in order, a later column overwrites a distance the same way as in a single pass
+    const QList<QVector<QPair<int, float>>> block_distances = future.results();
+    for(const auto& distances : block_distances) {
+        for(const auto& distance : distances) {
+            bottom_track[distance.first] = distance.second;
+        }
+    }
+
+    int epoch_start_index = run.indexFrom;
 
     if(epoch_start_index < 0) {
         epoch_start_index = 0;
     }
 
-    int epoch_stop_index = bottomTrackParam_.indexTo;
+    int epoch_stop_index = run.indexTo;
     if(epoch_stop_index >= size()) {
         epoch_stop_index = size();
     }
@@ -899,7 +1141,7 @@ void Dataset::bottomTrackProcessing(int channel1, int channel2)
             Epoch::Echogram* chart = epoch->chart(channel1);
             if(chart->bottomProcessing.source < Epoch::DistProcessing::DistanceSourceDirectHand) {
                 float dist = bottom_track[iepoch - epoch_min_index];
-                chart->bottomProcessing.setDistance(dist, Epoch::DistProcessing::DistanceSourceProcessing);
+                epoch->setDistProcessing(channel1, dist, Epoch::DistProcessing::DistanceSourceProcessing);
             }
         }
 
@@ -907,55 +1149,89 @@ void Dataset::bottomTrackProcessing(int channel1, int channel2)
             Epoch::Echogram* chart = epoch->chart(channel2);
             if(chart->bottomProcessing.source < Epoch::DistProcessing::DistanceSourceDirectHand) {
                 float dist = bottom_track[iepoch - epoch_min_index];
-                chart->bottomProcessing.setDistance(dist, Epoch::DistProcessing::DistanceSourceProcessing);
+                epoch->setDistProcessing(channel2, dist, Epoch::DistProcessing::DistanceSourceProcessing);
             }
         }
     }
 
+    markSpatialDirty(epoch_start_index, epoch_stop_index);
     setChannelOffset(channel1, bottomTrackParam_.offset.x, bottomTrackParam_.offset.y, bottomTrackParam_.offset.z);
     spatialProcessing();
     emit dataUpdate();
     lastBottomTrackEpoch_ = size();
     emit bottomTrackUpdated(epoch_min_index, epoch_max_index);
+
+    if(!bottomTrackPendingRuns_.isEmpty()) {
+        startBottomTrack(bottomTrackPendingRuns_.takeFirst());
+        return;
+    }
+
+    emit bottomTrackProgressChanged(-1);
+}
+
+void Dataset::cancelBottomTrackProcessing()
+{
+    bottomTrackCancel_ = true;
+    bottomTrackPendingRuns_.clear();
+    bottomTrackFuture_.cancel();
+}
+
+void Dataset::markSpatialDirty(int from, int to) {
+    from = std::max(from, 0);
+    to = std::min(to, size());
+    if(from >= to) { return; }
+
+    if(spatialDirtyFrom_ >= spatialDirtyTo_) {
+        spatialDirtyFrom_ = from;
+        spatialDirtyTo_ = to;
+    } else {
+        spatialDirtyFrom_ = std::min(spatialDirtyFrom_, from);
+        spatialDirtyTo_ = std::max(spatialDirtyTo_, to);
+    }
 }
 
 void Dataset::spatialProcessing() {
+    markSpatialDirty(spatialProcessedTo_ - 1, size());
+
+    const int from = spatialDirtyFrom_;
+    const int to = spatialDirtyTo_;
+    spatialDirtyFrom_ = spatialDirtyTo_ = 0;
+    spatialProcessedTo_ = size();
+
+    if(from >= to) { return; }
+
     QList<DatasetChannel> ch_list = channelsList().values();
     for (const auto& channel : ch_list) {
         int ich = channel.channel;
 
-        for(int iepoch = 0; iepoch < size(); iepoch++) {
-            Epoch* epoch = fromIndex(iepoch);
-            if(epoch == NULL) { continue; }
-
-            Position ext_pos = epoch->getExternalPosition();
+        _pool.forEach(from, to, [&](int, Epoch& epoch) {
+            if(!epoch.chartAvail(ich)) { return; }
 
-            if(epoch->chartAvail(ich)) {
-                Epoch::Echogram* data = epoch->chart(ich);
+            Epoch::Echogram* data = epoch.chart(ich);
+            if(data == NULL) { return; }
 
-                if(data == NULL) { continue; }
-
-                if(ext_pos.ned.isValid()) {
-                    ext_pos.ned.d += channel.localPosition.z;
-                }
+            Position ext_pos = epoch.getExternalPosition();
 
-                if(ext_pos.lla.isValid()) {
-                    ext_pos.lla.altitude -= channel.localPosition.z;
-                }
+            if(ext_pos.ned.isValid()) {
+                ext_pos.ned.d += channel.localPosition.z;
+            }
 
-                data->sensorPosition = ext_pos;
+            if(ext_pos.lla.isValid()) {
+                ext_pos.lla.altitude -= channel.localPosition.z;
+            }
 
-                if(ext_pos.ned.isValid()) {
-                    ext_pos.ned.d += data->bottomProcessing.getDistance();
-                }
+            data->sensorPosition = ext_pos;
 
-                if(ext_pos.lla.isValid()) {
-                    ext_pos.lla.altitude -= data->bottomProcessing.getDistance();
-                }
+            if(ext_pos.ned.isValid()) {
+                ext_pos.ned.d += data->bottomProcessing.getDistance();
+            }
 
-                data->bottomProcessing.bottomPoint = ext_pos;
+            if(ext_pos.lla.isValid()) {
+                ext_pos.lla.altitude -= data->bottomProcessing.getDistance();
             }
-        }
+
+            data->bottomProcessing.bottomPoint = ext_pos;
+        });
     }
 
     emit dataUpdate();
@@ -1133,27 +1409,25 @@ void Dataset::Interpolator::interpolateData(bool fromStart)
         return;
     }
 
+    const EpochColumns& columns = datasetPtr_->columns_;
+    auto channelDist = [&columns](int16_t channel, int row) -> float {
+        return channel == CHANNEL_FIRST ? columns.firstDist(row) : columns.dist(channel, row);
+    };
+    // the anchors are found on the columns, Epoch objects are only touched where something is written
+    auto isAnchor = [&columns, &channelDist, this](int row) -> bool {
+        return std::isfinite(columns.north()[row]) && std::isfinite(columns.east()[row]) && std::isfinite(columns.yaw()[row]) &&
+               (std::isfinite(channelDist(firstChannelId_, row)) || std::isfinite(channelDist(secondChannelId_, row)));
+    };
+
     bool somethingInterp{ false };
     int firstValidIndex{ startEpochIndx };
 
     while (firstValidIndex < endEpochIndx) {
-        while (firstValidIndex <= endEpochIndx) {
-            auto* fEp = datasetPtr_->fromIndex(firstValidIndex);
-            if (fEp->getPositionGNSS().ned.isCoordinatesValid() && isfinite(fEp->yaw()) &&
-                (isfinite(fEp->distProccesing(firstChannelId_)) ||
-                isfinite(fEp->distProccesing(secondChannelId_))) ) {
-                break;
-            }
+        while (firstValidIndex <= endEpochIndx && !isAnchor(firstValidIndex)) {
             ++firstValidIndex;
         }
         int secondValidIndex = firstValidIndex + 1;
-        while (secondValidIndex <= endEpochIndx) {
-            auto* sEp = datasetPtr_->fromIndex(secondValidIndex);
-            if (sEp->getPositionGNSS().ned.isCoordinatesValid() && isfinite(sEp->yaw()) &&
-                (isfinite(sEp->distProccesing(firstChannelId_)) ||
-                isfinite(sEp->distProccesing(secondChannelId_))) ) {
-                break;
-            }
+        while (secondValidIndex <= endEpochIndx && !isAnchor(secondValidIndex)) {
             ++secondValidIndex;
         }
         if (secondValidIndex > endEpochIndx) {
@@ -1170,23 +1444,26 @@ void Dataset::Interpolator::interpolateData(bool fromStart)
 
         auto* startEpoch = datasetPtr_->fromIndex(firstValidIndex);
         auto* endEpoch = datasetPtr_->fromIndex(secondValidIndex);
-        auto startPos = startEpoch->getPositionGNSS();
-        auto endPos = endEpoch->getPositionGNSS();
-        auto startYaw = startEpoch->yaw();
-        auto endYaw = endEpoch->yaw();
-        auto startFirstChannelDist = startEpoch->distProccesing(firstChannelId_);
-        auto endFirstChannelDist = endEpoch->distProccesing(firstChannelId_);
-        auto startSecondChannelDist = startEpoch->distProccesing(secondChannelId_);
-        auto endSecondChannelDist = endEpoch->distProccesing(secondChannelId_);
-        auto timeDiffNano = calcTimeDiffInNanoSecs(startEpoch->getPositionGNSS().time.sec,
-                                                   startEpoch->getPositionGNSS().time.nanoSec,
-                                                   endEpoch->getPositionGNSS().time.sec,
-                                                   endEpoch->getPositionGNSS().time.nanoSec);
+        NED startNed;
+        startNed.n = columns.north()[firstValidIndex];
+        startNed.e = columns.east()[firstValidIndex];
+        startNed.d = columns.down()[firstValidIndex];
+        NED endNed;
+        endNed.n = columns.north()[secondValidIndex];
+        endNed.e = columns.east()[secondValidIndex];
+        endNed.d = columns.down()[secondValidIndex];
+        auto startYaw = columns.yaw()[firstValidIndex];
+        auto endYaw = columns.yaw()[secondValidIndex];
+        auto startFirstChannelDist = channelDist(firstChannelId_, firstValidIndex);
+        auto endFirstChannelDist = channelDist(firstChannelId_, secondValidIndex);
+        auto startSecondChannelDist = channelDist(secondChannelId_, firstValidIndex);
+        auto endSecondChannelDist = channelDist(secondChannelId_, secondValidIndex);
+        auto startTime = columns.timeNs()[firstValidIndex];
+        auto timeDiffNano = columns.timeNs()[secondValidIndex] - startTime;
         auto timeOnStep = static_cast<quint64>(timeDiffNano * 1.0f / static_cast<float>(numInterpIndx));
 
         // time
         int cnt{ 1 };
-        auto startTime = convertToNanosecs(startEpoch->getPositionGNSS().time.sec, startEpoch->getPositionGNSS().time.nanoSec);
         for (int j = fromIndx; j < toIndx; ++j) {
             auto pTime = convertFromNanosecs(startTime + cnt++ * timeOnStep);
             auto* interpEpoch = datasetPtr_->fromIndex(j);
@@ -1196,9 +1473,9 @@ void Dataset::Interpolator::interpolateData(bool fromStart)
         // data
         for (int j = fromIndx; j < toIndx; ++j) {
             auto* interpEpoch = datasetPtr_->fromIndex(j);
-            auto currentTime = convertToNanosecs(interpEpoch->getPositionGNSS().time.sec, interpEpoch->getPositionGNSS().time.nanoSec);
+            auto currentTime = columns.timeNs()[j];
             float progress = (currentTime - startTime) * 1.0f / static_cast<float>(timeDiffNano);
-            interpEpoch->setInterpNED(interpNED(startPos.ned, endPos.ned, progress));
+            interpEpoch->setInterpNED(interpNED(startNed, endNed, progress));
             interpEpoch->setInterpYaw(interpYaw(startYaw, endYaw, progress));
 
             float correctDist = 0.0f; //
@@ -1210,12 +1487,12 @@ void Dataset::Interpolator::interpolateData(bool fromStart)
         }
 
         // "interp" data to anchor epochs
-        startEpoch->setInterpNED(startPos.ned);
+        startEpoch->setInterpNED(startNed);
         startEpoch->setInterpYaw(startYaw);
         float correctDist = isfinite(startFirstChannelDist) ? startFirstChannelDist : startSecondChannelDist;
         startEpoch->setInterpFirstChannelDist(correctDist);
         startEpoch->setInterpSecondChannelDist(correctDist);
-        endEpoch->setInterpNED(endPos.ned);
+        endEpoch->setInterpNED(endNed);
         endEpoch->setInterpYaw(endYaw);
         correctDist = isfinite(endFirstChannelDist) ? endFirstChannelDist : endSecondChannelDist;
         endEpoch->setInterpFirstChannelDist(correctDist);
@@ -1295,19 +1572,6 @@ float Dataset::Interpolator::interpDist(float start, float end, float progress)
     return (1.0 - progress) * start + progress * end;
 }
 
-qint64 Dataset::Interpolator::calcTimeDiffInNanoSecs(time_t startSecs, int startNanoSecs, time_t endSecs, int endNanoSecs) const
-{
-    qint64 startTimeInNanoseconds = static_cast<qint64>(startSecs) * 1000000000 + startNanoSecs;
-    qint64 endTimeInNanoseconds = static_cast<qint64>(endSecs) * 1000000000 + endNanoSecs;
-
-    return endTimeInNanoseconds - startTimeInNanoseconds;
-}
-
-qint64 Dataset::Interpolator::convertToNanosecs(time_t secs, int nanoSecs) const
-{
-    return static_cast<qint64>(secs) * 1000000000 + nanoSecs;
-}
-
 std::pair<time_t, int> Dataset::Interpolator::convertFromNanosecs(qint64 totalNanoSecs) const
 {
     time_t seconds = static_cast<time_t>(totalNanoSecs / 1000000000);
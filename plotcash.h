@@ -12,6 +12,9 @@
 #include <qvector3d.h>
 #include <QQmlEngine>
 #include <QMutex>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <atomic>
 
 #include <DSP.h>
 
@@ -21,6 +24,8 @@
 #include "time.h"
 
 #include "usbl_view.h"
+#include "epoch_store.h"
+#include "echogram_pyramid.h"
 
 #if defined(Q_OS_ANDROID) || (defined Q_OS_LINUX)
 #define MAKETIME(t) mktime(t)
@@ -300,12 +305,24 @@ public:
     } DistProcessing;
 
     typedef struct {
-        QVector<uint8_t> amplitude;
+        AmplitudeView amplitude; // in the slab of the dataset
         float resolution = 0; // m
         float offset = 0; // m
         int type = 0;
 
-        QVector<uint8_t> compensated;
+        QVector<uint8_t> compensated; // computed on the first compensated read of an open epoch
+        AmplitudeView compensatedView; // in the slab, cached when the epoch is closed
+
+        // the cached samples, computed into a copy while the epoch is open, so readers off the owner thread can use it
+        AmplitudeView compensatedSamples() const {
+            if(!compensatedView.isEmpty() || amplitude.isEmpty()) {
+                return compensatedView;
+            }
+
+            QVector<uint8_t> samples(amplitude.size());
+            compensate(amplitude.constData(), samples.data(), samples.size(), resolution);
+            return AmplitudeView(samples);
+        }
 
         void updateCompesated() {
             int raw_size = amplitude.size();
@@ -313,11 +330,10 @@ public:
                 compensated.resize(raw_size);
             }
 
-            const uint8_t* src = amplitude.constData();
-            uint8_t* procData = compensated.data();
-
-            const float resol = resolution;
+            compensate(amplitude.constData(), compensated.data(), raw_size, resolution);
+        }
 
+        static void compensate(const uint8_t* src, uint8_t* procData, int raw_size, float resol) {
             float avrg = 255;
             for(int i = 0; i < raw_size; i ++) {
                 float val = src[i];
@@ -332,10 +348,60 @@ public:
             }
         }
 
+        // resamples [start, end) m of a row on the grid (resolution, offset) into len cells
+        static void sampleTo(const uint8_t* src, int raw_size, float resolution, float offset, float start, float end, int16_t* dst, int len, bool reverse = false) {
+            start -= offset;
+            end -= offset;
+
+            float raw_range_f = raw_size*resolution;
+            float target_range_f = (float)(end - start);
+            float scale_factor = ((float)raw_size/(float)len)*(target_range_f/raw_range_f);
+            int src_offset = start/resolution;
+
+            int src_start = src_offset;
+            int dir = reverse ? -1 : 1;
+            int off = reverse ? (len-1) : 0;
+            if(scale_factor >= 0.8f) {
+                for(int i_to = 0; i_to < len; i_to++) {
+                    int src_end = (float)(i_to + 1)*scale_factor + src_offset;
+
+                    int32_t val = 0;
+                    if(src_start >= 0 && src_start < raw_size) {
+                        if(src_end > raw_size) { src_end = raw_size; }
+
+                        val = src[src_start];
+                        for(int i = src_start; i < src_end; i++) {
+                            val += src[i];
+                        }
+                        val /= 1 + (src_end - src_start);
+                    }
+
+                    src_start = src_end;
+                    dst[off + dir*i_to] = val;
+                }
+            } else {
+                for(int i_to = 0; i_to < len; i_to++) {
+                    float cell_offset = (float)(i_to)*scale_factor + (float)src_offset + 0.5f;
+                    int src_start = int(cell_offset);
+                    int src_end = src_start + 1;
+
+                    int32_t val = 0;
+                    if(src_start >= 0 && src_start < raw_size) {
+                        if(src_end >= raw_size) { src_end = raw_size-1; }
+
+                        float coef = cell_offset - floorf(cell_offset);
+                        val = (float)src[src_start]*(1 - coef) + (float)src[src_end]*coef;
+                    }
+
+                    dst[off + dir*i_to] = val;
+                }
+            }
+        }
+
         DistProcessing bottomProcessing;
         Position sensorPosition;
 
-        float range() {
+        float range() const {
             return amplitude.size()*(resolution);
         }
 
@@ -358,6 +424,11 @@ public:
     void setExternalPosition(Position position);
     void setPositionRef(LLARef* ref);
 
+    // the columns of the dataset this epoch is row of, the setters write through to them
+    void bindColumns(EpochColumns* columns, int row) { columns_ = columns; row_ = row; }
+    // caches the compensated samples of the charts in the slab, on the owner thread once the next epoch is added
+    void closeCharts();
+
     void setComplexF(int channel, ComplexSignal signal);
     ComplexSignals complexSignals() { return _complex; }
     ComplexSignal complexSignal(int channel) { return _complex[channel]; }
@@ -379,27 +450,31 @@ public:
     float encoder2() { return _encoder.e2; }
     float encoder3() { return _encoder.e3; }
 
-    void setDistProcessing(int16_t channel, float dist) {
+    void setDistProcessing(int16_t channel, float dist, DistProcessing::DistanceSource source = DistProcessing::DistanceSourceDirectHand) {
         if(_charts.contains(channel)) {
-            _charts[channel].bottomProcessing.setDistance(dist, DistProcessing::DistanceSourceDirectHand);
+            _charts[channel].bottomProcessing.setDistance(dist, source);
+            syncDist(channel);
         }
     }
 
     void clearDistProcessing(int16_t channel) {
         if(_charts.contains(channel)) {
             _charts[channel].bottomProcessing.clearDistance(DistProcessing::DistanceSourceDirectHand);
+            syncDist(channel);
         }
     }
 
     void setMinDistProc(int16_t channel, float dist) {
         if(_charts.contains(channel)) {
             _charts[channel].bottomProcessing.setMin(dist, DistProcessing::DistanceSourceConstrainHand);
+            syncDist(channel);
         }
     }
 
     void setMaxDistProc(int16_t channel, float dist) {
         if(_charts.contains(channel)) {
             _charts[channel].bottomProcessing.setMax(dist, DistProcessing::DistanceSourceConstrainHand);
+            syncDist(channel);
         }
     }
 
@@ -416,6 +491,7 @@ public:
                 _charts[channel].bottomProcessing.setMin(minsave);
                 _charts[channel].bottomProcessing.setMax(maxsave);
             }
+            syncDist(channel);
         }
     }
 
@@ -429,7 +505,7 @@ public:
 
     QVector<uint8_t> chartData(int16_t channel = 0) {
         if(chartAvail(channel)) {
-            return _charts[channel].amplitude;
+            return _charts[channel].amplitude.toVector();
         }
         return QVector<uint8_t>();
     }
@@ -450,6 +526,15 @@ public:
         return NULL;
     }
 
+    const Echogram* chart(int16_t channel = 0) const {
+        auto it = _charts.constFind(channel);
+        if(it != _charts.cend()) {
+            return &it.value();
+        }
+
+        return NULL;
+    }
+
     QList<int16_t> chartChannels() {
         return _charts.keys();
     }
@@ -568,7 +653,7 @@ public:
 
     uint32_t positionTimeUnix() { return _positionGNSS.time.sec; }
     uint32_t positionTimeNano() { return _positionGNSS.time.nanoSec; }
-    DateTime* positionTime() {return &_positionGNSS.time; }
+    const DateTime* positionTime() const { return &_positionGNSS.time; } // set through setGNSSSec/setGNSSNanoSec, they write through
 
     void setGNSSSec(time_t sec);
     void setGNSSNanoSec(int nanoSec);
@@ -608,71 +693,26 @@ public:
             return false;
         }
 
-        uint8_t* src = _charts[channel].amplitude.data();
+        const uint8_t* src = _charts[channel].amplitude.constData();
+        float resolution = _charts[channel].resolution;
 
         if(image_type == 1) {
-            if(_charts[channel].compensated.size() == 0) {
-                _charts[channel].updateCompesated();
-            }
-            src = _charts[channel].compensated.data();
-        }
-
-        if(raw_size == 0) {
-            for(int i_to = 0; i_to < len; i_to++) {
-                dst[i_to] = 0;
-            }
-        }
-
-        start -= _charts[channel].offset;
-        end -= _charts[channel].offset;
-
-        float raw_range_f = _charts[channel].range();
-        float target_range_f = (float)(end - start);
-        float scale_factor = ((float)raw_size/(float)len)*(target_range_f/raw_range_f);
-        int offset = start/_charts[channel].resolution;
-
-        int src_start = offset;
-        int dir = reverse ? -1 : 1;
-        int off = reverse ? (len-1) : 0;
-        if(scale_factor >= 0.8f) {
-            for(int i_to = 0; i_to < len; i_to++) {
-                int src_end = (float)(i_to + 1)*scale_factor + offset;
-
-                int32_t val = 0;
-                if(src_start >= 0 && src_start < raw_size) {
-                    if(src_end > raw_size) { src_end = raw_size; }
-
-                    val = src[src_start];
-                    for(int i = src_start; i < src_end; i++) {
-                        val += src[i];
-                    }
-                    val /= 1 + (src_end - src_start);
-                }
-
-                src_start = src_end;
-                dst[off + dir*i_to] = val;
-            }
-        } else {
-            for(int i_to = 0; i_to < len; i_to++) {
-                float cell_offset = (float)(i_to)*scale_factor + (float)offset + 0.5f;
-                int src_start = int(cell_offset);
-                int src_end = src_start + 1;
-
-                int32_t val = 0;
-                if(src_start >= 0 && src_start < raw_size) {
-                    if(src_end >= raw_size) { src_end = raw_size-1; }
-
-                    float coef = cell_offset - floorf(cell_offset);
-                    val = (float)src[src_start]*(1 - coef) + (float)src[src_end]*coef;
+            if(!_charts[channel].compensatedView.isEmpty()) {
+                src = _charts[channel].compensatedView.constData();
+            } else {
+                if(_charts[channel].compensated.size() == 0) {
+                    _charts[channel].updateCompesated();
                 }
-
-                dst[off + dir*i_to] = val;
+                src = _charts[channel].compensated.constData();
             }
         }
 
+        Echogram::sampleTo(src, raw_size, resolution, _charts[channel].offset, start, end, dst, len, reverse);
+
         return true;
     }
 
+    // charts from the complex signals set since the last call, a converted signal is not converted again
     void moveComplexToEchogram(float offset_m, float levels_offset_db);
 
     void setInterpNED(NED ned);
@@ -703,6 +743,7 @@ protected:
     } _attitude;
 
     ComplexSignals _complex;
+    QList<int> _complexUnconverted; // channels set since the last moveComplexToEchogram
 
     IDBinDVL::BeamSolution _dopplerBeams[4];
     uint16_t _dopplerBeamCount = 0;
@@ -752,6 +793,12 @@ protected:
     } flags;
 
 private:
+    EpochColumns* columns_ = nullptr;
+    int row_ = -1;
+
+    void syncPosition();
+    void syncDist(int16_t channel);
+
     struct {
         NED ned;
         float yaw = NAN;
@@ -774,9 +821,7 @@ public:
     Dataset();
 
     inline int size() const {
-
         return _pool.size();
-
     }
 
     Epoch* fromIndex(int index_offset = 0) {
@@ -788,6 +833,15 @@ public:
         return NULL;
     }
 
+    // read-only access for background readers, the pool never relocates epochs so no copy is needed
+    const Epoch* epochView(int index) const {
+        if(index >= 0 && index < size()) {
+            return &_pool[index];
+        }
+
+        return NULL;
+    }
+
     Epoch* last() {
         if(size() > 0) {
             return fromIndex(endIndex());
@@ -802,7 +856,7 @@ public:
         return NULL;
     }
 
-    int endIndex() {
+    int endIndex() const {
         return size() - 1;
     }
 
@@ -819,7 +873,7 @@ public:
         return _channelsSetup;
     }
 
-    QVector<QVector3D> boatTrack() const;
+    const QVector<QVector3D>& boatTrack() const;
     const QHash<int, int>& getSelectedIndicesBoatTrack() const;
     int getLastBottomTrackEpoch() const;
 
@@ -835,6 +889,10 @@ public:
         return &bottomTrackParam_;
     }
 
+    EchogramPyramid* echogramPyramid() {
+        return &echogramPyramid_;
+    }
+
 public slots:
     void addEvent(int timestamp, int id, int unixt = 0);
     void addEncoder(float angle1_deg, float angle2_deg = NAN, float angle3_deg = NAN);
@@ -855,19 +913,30 @@ public slots:
     void addTemp(float temp_c);
 
     void mergeGnssTrack(QList<Position> track);
+    // some epoch got an external position with valid coordinates
+    bool hasExternalLla() const { return hasExternalLla_; }
+    bool hasExternalNed() const { return hasExternalNed_; }
 
     void resetDataset();
     void resetDistProcessing();
 
     void setChannelOffset(int channal, float x, float y, float z) {
         if(_channelsSetup.contains(channal)) {
+            if(_channelsSetup[channal].localPosition.z != z) {
+                markSpatialDirty(0, size());
+            }
             _channelsSetup[channal].localPosition.x = x;
             _channelsSetup[channal].localPosition.y = y;
             _channelsSetup[channal].localPosition.z = z;
         }
     }
 
+    // tracks the epochs [indexFrom, indexTo) of the bottom track params on the pool and returns right away,
+    // requests made while it runs are merged and run after it
     void bottomTrackProcessing(int channel1, int channel2);
+    void cancelBottomTrackProcessing();
+    // epochs [from, to) got new distances or positions, the next spatialProcessing() recomputes them
+    void markSpatialDirty(int from, int to);
     void spatialProcessing();
     void emitPositionsUpdated() {
         emit bottomTrackUpdated(0, endIndex());
@@ -905,6 +974,7 @@ signals:
     void channelsListUpdates(QList<DatasetChannel> channels);
     void dataUpdate();
     void bottomTrackUpdated(int lEpoch, int rEpoch);
+    void bottomTrackProgressChanged(int progress); // percent of the running processing, -1 when it is not running
     void boatTrackUpdated();
     void updatedInterpolatedData(int indx);
 
@@ -939,16 +1009,28 @@ protected:
     } _autoRange = AutoRangeLast;
 
 
-    QVector<Epoch> _pool;
+    ChunkedStore<Epoch> _pool;
+    EpochColumns columns_; // row i belongs to _pool[i]
 
     float lastTemperature = 0;
 
+    bool hasExternalLla_ = false;
+    bool hasExternalNed_ = false;
+
     float _lastYaw = 0, _lastPitch = 0, _lastRoll = 0;
     Position _lastPositionGNSS;
 
     Epoch* addNewEpoch() {
-        _pool.resize(_pool.size() + 1);
-        return last();
+        if(size() > 0) {
+            _pool[endIndex()].closeCharts(); // before the next epoch is published to the readers
+        }
+
+        Epoch* epoch = _pool.append(); // the pool grows until the int index range is used up
+        if (epoch == nullptr) {
+            qFatal("Dataset: epoch index range is exhausted");
+        }
+        epoch->bindColumns(&columns_, columns_.append());
+        return epoch;
     }
 
     GraphicsScene3dView* scene3dViewPtr_ = nullptr;
@@ -966,8 +1048,6 @@ private:
         float interpYaw(float start, float end, float progress) const;
         NED interpNED(const NED& start, const NED& end, float progress) const;
         float interpDist(float start, float end, float progress) const;
-        qint64 calcTimeDiffInNanoSecs(time_t startSecs, int startNanoSecs, time_t endSecs, int endNanoSecs) const;
-        qint64 convertToNanosecs(time_t secs, int nanoSecs) const;
         std::pair<time_t, int> convertFromNanosecs(qint64 totalNanoSecs) const; // first - secs, second - nanosecs
 
         Dataset* datasetPtr_;
@@ -976,11 +1056,36 @@ private:
         int secondChannelId_;
     };
 
+    struct BottomTrackRun {
+        int channel1 = CHANNEL_NONE;
+        int channel2 = CHANNEL_NONE;
+        int indexFrom = 0; // requested epochs [indexFrom, indexTo)
+        int indexTo = 0;
+        int epochMinIndex = 0; // first epoch of the tracked columns, the window reaches before indexFrom
+        int epochMaxIndex = 0;
+    };
+
+    void queueBottomTrack(const BottomTrackRun& run);
+    void startBottomTrack(const BottomTrackRun& run);
+    void finishBottomTrack();
+
     Interpolator interpolator_;
+    EchogramPyramid echogramPyramid_;
     int lastBoatTrackEpoch_;
     int lastBottomTrackEpoch_;
     BottomTrackParam bottomTrackParam_;
     uint64_t boatTrackValidPosCounter_;
+
+    static constexpr int bottomTrackBlockSize_ = 512; // epochs tracked by one pool task
+    bool bottomTrackBusy_;
+    std::atomic_bool bottomTrackCancel_;
+    BottomTrackRun bottomTrackRun_;
+    QList<BottomTrackRun> bottomTrackPendingRuns_; // requests made while busy, run in order after the current one
+    QFuture<QVector<QPair<int, float>>> bottomTrackFuture_; // (bottom track index, distance) found by every block
+    QFutureWatcher<QVector<QPair<int, float>>> bottomTrackWatcher_;
+    int spatialDirtyFrom_;
+    int spatialDirtyTo_;
+    int spatialProcessedTo_; // epochs from here on were not processed yet, the one before may still be filling
 };
 
 #endif // PLOT_CASH_H
@@ -2,14 +2,19 @@
 
 #include <set>
 #include <memory>
+#include <limits>
+#include <cmath>
 
 #include <Point3D.h>
 #include <DelaunayTriangulation.h>
 #include <gridgenerator.h>
 #include <barycentricinterpolator.h>
+#include <trianglespatialindex.h>
 #include <bottomtrack.h>
 
 const QString UnderlyingThreadName = "SurfaceProcessorThread";
+const double SurfaceTileSize = 50.0; // meters, incremental runs send the surface by tiles of this size
+const QPoint NoTile(std::numeric_limits<int>::min(), std::numeric_limits<int>::min());
 
 SurfaceProcessor::SurfaceProcessor(QObject *parent)
     : QObject{parent}
@@ -34,10 +39,10 @@ bool SurfaceProcessor::setTask(const SurfaceProcessorTask& task)
 
 bool SurfaceProcessor::startInThread()
 {
-    if(m_isBusy.load())
+    if (parent())
         return false;
 
-    if (parent())
+    if(m_isBusy.exchange(true))
         return false;
 
     auto currentThread = thread();
@@ -48,6 +53,9 @@ bool SurfaceProcessor::startInThread()
         QObject::connect(currentThread, &QThread::started, this, &SurfaceProcessor::process);
         moveToThread(currentThread);
     }
+    else if (currentThread->isRunning()) { // previous task is done, its thread is quitting
+        currentThread->wait();
+    }
 
     currentThread->start();
     return true;
@@ -90,18 +98,19 @@ const SurfaceProcessorTask &SurfaceProcessor::ctask() const
 
 void SurfaceProcessor::process()
 {
-    if(m_isBusy.load())
-        return;
+    const bool incremental = m_task.m_incremental && !m_task.m_gridInterpEnabled && !m_task.m_bottomTrackDataFilter;
 
-    if(m_task.bottomTrack()->cdata().isEmpty()){
+    if(incremental ? m_task.m_bottomTrackData.isEmpty() : m_task.bottomTrack()->cdata().isEmpty()){
+        m_isBusy.store(false);
         stopInThread();
         return;
     }
 
-    m_isBusy.store(true);
-
     m_result.data.clear();
     m_result.primitiveType = GL_TRIANGLES;
+    m_result.tiles.clear();
+    m_result.incremental = false;
+    m_result.resetTiles = false;
 
     Q_EMIT taskStarted();
 
@@ -109,6 +118,19 @@ void SurfaceProcessor::process()
     std::vector <Point3D <double>> input;
 
 
+    if (incremental) {
+        processIncremental(m_task.m_bottomTrackData, m_task.m_rewrittenFrom);
+
+        m_isBusy.store(false);
+
+        Q_EMIT taskFinished(m_result);
+
+        stopInThread();
+        return;
+    }
+
+    resetMesh();
+
     QVector<QVector3D> data = m_task.bottomTrack()->data();
 
     if(m_task.m_bottomTrackDataFilter){
@@ -139,59 +161,44 @@ void SurfaceProcessor::process()
     if (m_task.m_gridInterpEnabled) {
         m_result.primitiveType = GL_QUADS;
 
-        std::vector <Point3D <double>> trimmedGrid;
-
         Cube bounds = m_task.m_bottomTrack.lock()->bounds();
-        auto fullGrid = GridGenerator <double>::generateQuadGrid(Point3D <double>(
-                                                                bounds.minimumX(),
-                                                                bounds.minimumY(),
-                                                                bounds.minimumZ()
-                                                            ),
-                                                            bounds.width(),
-                                                            bounds.length(),
-                                                            m_task.m_interpGridCellSize);
-
-        auto q = fullGrid->begin();
-
-        while (q != fullGrid->end()){
-            auto quad = *q;
-
-            bool surfaceContainsA = false;
-            bool surfaceContainsB = false;
-            bool surfaceContainsC = false;
-            bool surfaceContainsD = false;
-
-            auto t = triangles->begin();
-            while (t != triangles->end() && (!surfaceContainsA ||
-                                             !surfaceContainsB ||
-                                             !surfaceContainsC ||
-                                             !surfaceContainsD))
-            {
-                if (!surfaceContainsA) surfaceContainsA = t->contains(quad.A());
-                if (!surfaceContainsB) surfaceContainsB = t->contains(quad.B());
-                if (!surfaceContainsC) surfaceContainsC = t->contains(quad.C());
-                if (!surfaceContainsD) surfaceContainsD = t->contains(quad.D());
-                t++;
-            }
+        const Point3D <double> topLeft(bounds.minimumX(), bounds.minimumY(), bounds.minimumZ());
+        const double cellSize = m_task.m_interpGridCellSize;
+        const float width = bounds.width();
+        const float length = bounds.length();
 
-            if (t != triangles->end()){
-                trimmedGrid.push_back(quad.A());
-                trimmedGrid.push_back(quad.B());
-                trimmedGrid.push_back(quad.C());
-                trimmedGrid.push_back(quad.D());
-            }
-            q++;
-        }
-
-        BarycentricInterpolator <double> interpolator;
+        // the lattice of GridGenerator::generateQuadGrid, its rows are counted over the width
+        const int rowsCount = std::ceil(width / cellSize);
+        const int colsCount = std::ceil(length / cellSize);
+        const int nodeCols = colsCount + 1;
 
-        auto trianglesTemp = *triangles;
+        // every triangle marks the grid nodes it holds, a quad stays if all of its corners are marked
+        TriangleSpatialIndex <double> index;
+        index.build(*triangles);
+        const auto nodes = index.rasterize(topLeft, cellSize, nodeCols, rowsCount + 1);
 
-        interpolator.process(trianglesTemp, trimmedGrid);
+        BarycentricInterpolator <double> interpolator;
 
-        for(const auto& point : trimmedGrid)
+        auto appendNode = [&](int col, int row) -> void {
+            Point3D <double> point(topLeft.x() + col * cellSize, topLeft.y() + row * cellSize, topLeft.z());
+            interpolator.interpolate((*triangles)[nodes[static_cast <size_t> (row) * nodeCols + col]], point);
             m_result.data.append(point.toQVector3D());
-
+        };
+
+        for (int row = 0; row < rowsCount; row++) {
+            for (int col = 0; col < colsCount; col++) {
+                if (nodes[static_cast <size_t> (row) * nodeCols + col] < 0 ||
+                    nodes[static_cast <size_t> (row) * nodeCols + col + 1] < 0 ||
+                    nodes[static_cast <size_t> (row + 1) * nodeCols + col + 1] < 0 ||
+                    nodes[static_cast <size_t> (row + 1) * nodeCols + col] < 0)
+                    continue;
+
+                appendNode(col, row);
+                appendNode(col + 1, row);
+                appendNode(col + 1, row + 1);
+                appendNode(col, row + 1);
+            }
+        }
     }
     else {
         for (const auto& t : *triangles) {
@@ -208,6 +215,89 @@ void SurfaceProcessor::process()
     stopInThread();
 }
 
+void SurfaceProcessor::processIncremental(const QVector<QVector3D>& data, int rewrittenFrom)
+{
+    m_result.incremental = true;
+
+    auto makeInput = [&data](int from, int to) -> std::vector <Point3D <double>> {
+        std::vector <Point3D <double>> input;
+        input.reserve(to - from);
+        for (int i = from; i < to; ++i)
+            input.emplace_back(data.at(i).x(), data.at(i).y(), data.at(i).z(), i);
+        return input;
+    };
+
+    // points are added at the end, rewritten ones keep the mesh while only their heights change
+    bool rebuild = !m_mesh || data.size() < m_meshInputSize || m_meshEdgeLengthLimit != m_task.m_edgeLengthLimit;
+    if (!rebuild && rewrittenFrom < m_meshInputSize)
+        rebuild = !m_mesh->updateHeights(rewrittenFrom, makeInput(rewrittenFrom, m_meshInputSize));
+
+    if (rebuild)
+        resetMesh();
+
+    if (!m_mesh->insert(makeInput(m_meshInputSize, data.size()))) { // outside of the super triangle of the first points
+        resetMesh();
+        m_mesh->insert(makeInput(0, data.size()));
+    }
+
+    m_result.resetTiles = m_meshInputSize == 0;
+    m_meshInputSize = data.size();
+    m_meshEdgeLengthLimit = m_task.m_edgeLengthLimit;
+
+    // every changed mesh slot leaves its old tile and joins the tile of its centroid
+    QSet <QPoint> dirtyTiles;
+    m_faceTile.resize(m_mesh->facesCount(), NoTile);
+
+    for (int face : m_mesh->takeChangedFaces()) {
+        QPoint& tile = m_faceTile[face];
+        if (tile != NoTile) {
+            m_tileFaces[tile].remove(face);
+            dirtyTiles.insert(tile);
+            tile = NoTile;
+        }
+
+        if (!m_mesh->hasTriangle(face, m_meshEdgeLengthLimit))
+            continue;
+
+        const auto triangle = m_mesh->triangle(face);
+        const double x = (triangle.A().x() + triangle.B().x() + triangle.C().x()) / 3.0;
+        const double y = (triangle.A().y() + triangle.B().y() + triangle.C().y()) / 3.0;
+        tile = QPoint(static_cast<int>(std::floor(x / SurfaceTileSize)), static_cast<int>(std::floor(y / SurfaceTileSize)));
+
+        m_tileFaces[tile].insert(face);
+        dirtyTiles.insert(tile);
+    }
+
+    for (const auto& tile : qAsConst(dirtyTiles)) {
+        QVector<QVector3D>& vertices = m_result.tiles[tile];
+
+        auto it = m_tileFaces.find(tile);
+        if (it == m_tileFaces.end())
+            continue;
+
+        if (it->isEmpty()) {
+            m_tileFaces.erase(it);
+            continue;
+        }
+
+        vertices.reserve(it->size() * 3);
+        for (int face : qAsConst(*it)) {
+            const auto triangle = m_mesh->triangle(face);
+            vertices.append(triangle.A().toQVector3D());
+            vertices.append(triangle.B().toQVector3D());
+            vertices.append(triangle.C().toQVector3D());
+        }
+    }
+}
+
+void SurfaceProcessor::resetMesh()
+{
+    m_mesh = std::make_unique <Delaunay <double>>();
+    m_meshInputSize = 0;
+    m_faceTile.clear();
+    m_tileFaces.clear();
+}
+
 bool SurfaceProcessor::isBusy() const
 {
     return m_isBusy.load();
@@ -267,3 +357,20 @@ AbstractEntityDataFilter *SurfaceProcessorTask::bottomTrackDataFilter() const
 {
     return m_bottomTrackDataFilter.get();
 }
+
+void SurfaceProcessorTask::setIncremental(bool incremental)
+{
+    if(m_incremental != incremental)
+        m_incremental = incremental;
+}
+
+void SurfaceProcessorTask::setBottomTrackData(const QVector<QVector3D>& data, int rewrittenFrom)
+{
+    m_bottomTrackData = data;
+    m_rewrittenFrom = rewrittenFrom;
+}
+
+bool SurfaceProcessorTask::incremental() const
+{
+    return m_incremental;
+}
@@ -18,11 +18,15 @@
 #include <QVector>
 #include <QVector3D>
 #include <QThread>
+#include <QHash>
+#include <QSet>
+#include <QPoint>
 
 #include <cube.h>
 #include <abstractentitydatafilter.h>
 
 class BottomTrack;
+template <typename T> class Delaunay;
 
 #ifndef OPAQUE_BottomTrack
 #define OPAQUE_BottomTrack
@@ -36,6 +40,7 @@ class SurfaceProcessorTask{
     Q_PROPERTY(qreal                     interpGridCellSize    READ interpGridCellSize    CONSTANT)
     Q_PROPERTY(qreal                     edgeLengthLimit       READ edgeLengthLimit       CONSTANT)
     Q_PROPERTY(AbstractEntityDataFilter* bottomTrackDataFilter READ bottomTrackDataFilter CONSTANT)
+    Q_PROPERTY(bool                      incremental           READ incremental           CONSTANT)
 
 public:
     void setBottomTrack(std::weak_ptr<BottomTrack> bottomTrack);
@@ -43,17 +48,23 @@ public:
     void setInterpGridCellSize(qreal size);
     void setEdgeLengthLimit(qreal limit);
     void setBottomTrackDataFilter(std::shared_ptr<AbstractEntityDataFilter> filter);
+    void setIncremental(bool incremental);
+    void setBottomTrackData(const QVector<QVector3D>& data, int rewrittenFrom);
     BottomTrack* bottomTrack() const;
     bool gridInterpEnabled() const;
     qreal interpGridCellSize() const;
     qreal edgeLengthLimit() const;
     AbstractEntityDataFilter *bottomTrackDataFilter() const;
+    bool incremental() const;
 
 private:
     friend class SurfaceProcessor;
     bool m_gridInterpEnabled = false;
     qreal m_interpGridCellSize = 5.0f;
     qreal m_edgeLengthLimit = -1.0f;
+    bool m_incremental = false;
+    QVector<QVector3D> m_bottomTrackData; ///< Incremental run: bottom track vertices taken on the thread of the bottom track
+    int m_rewrittenFrom = 0; ///< Incremental run: vertices from this index on may differ from the previous run
     std::shared_ptr<AbstractEntityDataFilter> m_bottomTrackDataFilter;
     std::weak_ptr<BottomTrack> m_bottomTrack;
 };
@@ -67,6 +78,9 @@ public:
     struct Result{
         QVector <QVector3D> data;
         int primitiveType = GL_TRIANGLES;
+        QHash <QPoint, QVector <QVector3D>> tiles; ///< Incremental run: triangles of every changed tile, empty for a tile gone
+        bool incremental = false;
+        bool resetTiles = false; ///< Incremental run started a new mesh, tiles not in the result are gone
     };
 
     explicit SurfaceProcessor(QObject *parent = nullptr);
@@ -90,9 +104,19 @@ Q_SIGNALS:
     void taskFinished(Result result);
 
 private:
+    void processIncremental(const QVector<QVector3D>& data, int rewrittenFrom);
+    void resetMesh();
+
     SurfaceProcessorTask m_task;
     Result m_result;
     std::atomic_bool m_isBusy{false};
+
+    // kept between incremental runs, new bottom track points go into the same mesh
+    std::unique_ptr <Delaunay <double>> m_mesh;
+    int m_meshInputSize = 0;
+    qreal m_meshEdgeLengthLimit = -1.0f;
+    std::vector <QPoint> m_faceTile;
+    QHash <QPoint, QSet <int>> m_tileFaces;
 };
 
 #endif // SURFACEPROCESSOR_H
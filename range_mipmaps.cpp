@@ -0,0 +1,119 @@
+#include "range_mipmaps.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+
+RangeMipmaps::RangeMipmaps() :
+    useCounter_(0),
+    usedBytes_(0),
+    budget_(defaultBudget)
+{
+
+}
+
+const QVector<uint8_t>* RangeMipmaps::find(quint64 key, quint64 stamp, int level)
+{
+    auto it = entries_.find(key);
+    if (it == entries_.end() || it->stamp != stamp || level < 1 || it->levels.isEmpty()) {
+        return nullptr;
+    }
+
+    it->lastUse = ++useCounter_;
+
+    if (it->levels.size() >= level) {
+        return &it->levels[level - 1];
+    }
+
+    const QVector<uint8_t>& last = it->levels.last(); // levels past the cached ones come from the last of them
+    const QVector<uint8_t>& retVal = extend(*it, level, last.constData(), last.size());
+    trim(key);
+
+    return &retVal;
+}
+
+const QVector<uint8_t>& RangeMipmaps::build(quint64 key, quint64 stamp, int level, const uint8_t* src, int size)
+{
+    Entry& entry = entries_[key];
+    usedBytes_ -= entry.bytes;
+
+    entry.levels.clear();
+    entry.stamp = stamp;
+    entry.lastUse = ++useCounter_;
+    entry.bytes = 0;
+
+    const QVector<uint8_t>& retVal = extend(entry, std::max(level, 1), src, size);
+    trim(key);
+
+    return retVal;
+}
+
+void RangeMipmaps::clear()
+{
+    entries_.clear();
+    usedBytes_ = 0;
+}
+
+void RangeMipmaps::setBudget(qint64 bytes)
+{
+    budget_ = bytes;
+    trim(~quint64(0));
+}
+
+qint64 RangeMipmaps::getUsedBytes() const
+{
+    return usedBytes_;
+}
+
+const QVector<uint8_t>& RangeMipmaps::extend(Entry& entry, int level, const uint8_t* src, int size)
+{
+    // src is the last level, or the row itself for an empty entry
+    while (entry.levels.size() < level) {
+        QVector<uint8_t> mip((size + 1) / 2);
+        uint8_t* dst = mip.data();
+        for (int i = 0; i < size / 2; ++i) {
+            dst[i] = (src[2 * i] + src[2 * i + 1] + 1) >> 1;
+        }
+        if (size & 1) {
+            dst[size / 2] = src[size - 1];
+        }
+
+        entry.bytes += mip.size();
+        usedBytes_ += mip.size();
+        entry.levels.append(std::move(mip));
+
+        src = entry.levels.last().constData();
+        size = entry.levels.last().size();
+    }
+
+    return entry.levels[level - 1];
+}
+
+void RangeMipmaps::trim(quint64 keepKey)
+{
+    if (usedBytes_ <= budget_) {
+        return;
+    }
+
+    // down to 3/4 of the budget, so a full cache does not sort on every build
+    std::vector<std::pair<quint64, quint64>> byUse; // last use, key
+    byUse.reserve(entries_.size());
+    for (auto it = entries_.cbegin(); it != entries_.cend(); ++it) {
+        if (it.key() != keepKey) {
+            byUse.emplace_back(it->lastUse, it.key());
+        }
+    }
+    std::sort(byUse.begin(), byUse.end());
+
+    const qint64 target = budget_ / 4 * 3;
+    for (const auto& use : byUse) {
+        if (usedBytes_ <= target) {
+            break;
+        }
+
+        auto it = entries_.find(use.second);
+        usedBytes_ -= it->bytes;
+        entries_.erase(it);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QHash>
+#include <QVector>
+
+
+/*
+ * Range mipmaps of the echogram rows drawn by one view, level k averages 2^k consecutive samples. A column
+ * zoomed out in range resamples the level that leaves under two samples per cell instead of every raw sample.
+ * A row is identified by a key and a stamp that changes with its samples; a row read with another stamp is
+ * built again. Rows are built on the first read and kept within a byte budget, the least recently read rows
+ * are dropped first.
+ */
+class RangeMipmaps
+{
+public:
+    static constexpr qint64 defaultBudget = 32ll << 20;
+
+    /*methods*/
+    RangeMipmaps();
+
+    // the level of a cached row, nullptr if the row is not cached with this stamp
+    const QVector<uint8_t>* find(quint64 key, quint64 stamp, int level);
+    // caches the row from its samples and returns the level
+    const QVector<uint8_t>& build(quint64 key, quint64 stamp, int level, const uint8_t* src, int size);
+    void clear();
+
+    void setBudget(qint64 bytes);
+    qint64 getUsedBytes() const;
+
+private:
+    /*structures*/
+    struct Entry {
+        QVector<QVector<uint8_t>> levels; // [level - 1]
+        quint64 stamp = 0;
+        quint64 lastUse = 0;
+        qint64 bytes = 0;
+    };
+
+    /*methods*/
+    const QVector<uint8_t>& extend(Entry& entry, int level, const uint8_t* src, int size);
+    void trim(quint64 keepKey);
+
+    /*data*/
+    QHash<quint64, Entry> entries_;
+    quint64 useCounter_;
+    qint64 usedBytes_;
+    qint64 budget_;
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <utility>
+#include <vector>
+
+
+/*
+ * Maximum of the epoch ranges over the on-screen columns for AutoRangeMaxOnScreen. Column epochs enter at the
+ * back and leave at the front as the view follows live data, a monotonic deque keeps the maximum of what is
+ * left, so a new ping costs one epoch instead of a walk over the canvas width. The last epoch of the dataset
+ * may still get charts and is looked at on every update instead of entering the deque. Any other move of the
+ * window rebuilds it.
+ *
+ * The epochs come from a source with the Dataset interface: endIndex() and fromIndex(index), an epoch pointer
+ * or nullptr, whose getMaxRnage(channel) is the range.
+ */
+class RangeWindowMax
+{
+public:
+    /*methods*/
+    void reset()
+    {
+        window_.clear();
+        firstIndex_ = -1;
+        pushedIndex_ = -1;
+    }
+
+    // the maximum over the columns of indexes (epoch per column, -1 for none), NAN if no column has a range
+    template <typename EpochSource>
+    float update(EpochSource& source, const std::vector<int>& indexes, int channel, int zoomLevel)
+    {
+        const int columns = static_cast<int>(indexes.size());
+
+        // valid column epochs are contiguous and increasing
+        int firstCol = 0;
+        while (firstCol < columns && indexes[firstCol] < 0) {
+            ++firstCol;
+        }
+        int lastCol = columns - 1;
+        while (lastCol >= firstCol && indexes[lastCol] < 0) {
+            --lastCol;
+        }
+
+        if (firstCol > lastCol) {
+            reset();
+            return NAN;
+        }
+
+        const int firstIndex = indexes[firstCol];
+        const int openIndex = source.endIndex(); // the last epoch is still filling
+
+        const bool isMovedBack = firstIndex < firstIndex_ || indexes[lastCol] < pushedIndex_;
+        if (channel != channel_ || zoomLevel != zoomLevel_ || isMovedBack || pushedIndex_ >= openIndex) {
+            reset();
+            channel_ = channel;
+            zoomLevel_ = zoomLevel;
+        }
+        firstIndex_ = firstIndex;
+
+        while (!window_.empty() && window_.front().first < firstIndex) {
+            window_.pop_front();
+        }
+
+        int col = lastCol;
+        while (col >= firstCol && indexes[col] > pushedIndex_) {
+            --col;
+        }
+
+        float maxRange = NAN;
+        for (++col; col <= lastCol; ++col) {
+            const int epochIndex = indexes[col];
+            auto* epoch = source.fromIndex(epochIndex);
+            const float epochRange = epoch != nullptr ? epoch->getMaxRnage(channel_) : NAN;
+
+            if (epochIndex >= openIndex) {
+                if (std::isfinite(epochRange) && !(maxRange >= epochRange)) {
+                    maxRange = epochRange;
+                }
+                continue;
+            }
+
+            if (std::isfinite(epochRange)) {
+                while (!window_.empty() && window_.back().second <= epochRange) {
+                    window_.pop_back();
+                }
+                window_.emplace_back(epochIndex, epochRange);
+            }
+            pushedIndex_ = epochIndex;
+        }
+
+        if (!window_.empty() && !(maxRange >= window_.front().second)) {
+            maxRange = window_.front().second;
+        }
+
+        return maxRange;
+    }
+
+private:
+    /*data*/
+    std::deque<std::pair<int, float>> window_; // (epoch, range), ranges decrease from the front
+    int firstIndex_ = -1;  // epoch of the first column
+    int pushedIndex_ = -1; // last epoch in the window
+    int channel_ = std::numeric_limits<int>::min(); // none before the first update
+    int zoomLevel_ = 0;
+};
@@ -1,5 +1,5 @@
 CONFIG += testcase
-QT += testlib core gui
+QT += testlib core gui concurrent
 
 TARGET = tst_basic
 
@@ -7,7 +7,11 @@ HEADERS += \
     tst_basic.h
 
 SOURCES += \
-    tst_basic.cpp
+    tst_basic.cpp \
+    $$TOP_PWD/KoggerApp/frame_pool.cpp \
+    $$TOP_PWD/KoggerApp/klf_ingest.cpp
+
+INCLUDEPATH += $$TOP_PWD/KoggerApp
 
 RESOURCES += \
     tst_basic.qrc
@@ -70,6 +70,164 @@ void TestBasic::generateZeroCellSizeQuadGridTestCase()
     }
 }
 
+void TestBasic::parallelIngestMatchesSequentialTestCase()
+{
+    // valid frames mixed with noise and cut frames, payloads full of sync bytes to mislead the chunk split
+    QByteArray log;
+    quint32 seed = 1;
+    auto rand = [&seed]() { seed = seed * 1103515245 + 12345; return (seed >> 16) & 0x7FFF; };
+
+    for (int i = 0; i < 20000; ++i) {
+        ProtoBinOut frame;
+        frame.create(CONTENT, v0, ID_TIMESTAMP, 0);
+        const int payloadLen = rand() % 60;
+        for (int j = 0; j < payloadLen; ++j) {
+            frame.write<uint8_t>(rand() % 3 == 0 ? 0xBB : 0x55);
+        }
+        frame.end();
+
+        const int kind = rand() % 10;
+        const int len = kind == 0 ? rand() % frame.frameLen() : frame.frameLen();
+        log.append(reinterpret_cast<const char*>(frame.frame()), len);
+        if (kind == 1) {
+            log.append(static_cast<char>(rand()));
+        }
+    }
+
+    const uchar* data = reinterpret_cast<const uchar*>(log.constData());
+
+    // one parser over the whole log
+    QVector<QByteArray> sequential;
+    QVector<qint64> sequentialEnds;
+    FrameParser parser;
+    parser.setContext(const_cast<uchar*>(data), log.size());
+    while (parser.availContext() > 0) {
+        parser.process();
+        if (parser.isComplete()) {
+            sequential.append(QByteArray(reinterpret_cast<const char*>(parser.frame()), parser.frameLen()));
+            sequentialEnds.append(log.size() - parser.outerContextLen());
+        }
+    }
+    QVERIFY(sequential.size() > 10000);
+
+    KlfIngest ingest(data, log.size());
+    ingest.setChunkSize(4096);
+    ingest.setThreadCount(4);
+
+    qsizetype indx = 0;
+    const qint64 reached = ingest.run([&](FrameParser& frame, qint64 endOffset) -> bool {
+        if (indx >= sequential.size()) {
+            return false;
+        }
+        const bool same = endOffset == sequentialEnds[indx] &&
+                          QByteArray(reinterpret_cast<const char*>(frame.frame()), frame.frameLen()) == sequential[indx];
+        ++indx;
+        return same;
+    });
+
+    QCOMPARE(reached, static_cast<qint64>(log.size()));
+    QCOMPARE(indx, sequential.size());
+}
+
+void TestBasic::frameHandleRoundTripTestCase()
+{
+    ProtoBinOut out;
+    out.create(CONTENT, v0, ID_TIMESTAMP, 0);
+    out.write<uint8_t>(7);
+    out.write<uint8_t>(9);
+    out.end();
+
+    FrameParser parser;
+    parser.setContext(out.frame(), out.frameLen());
+    parser.process();
+    QVERIFY(parser.isComplete());
+
+    const FrameHandle handle(parser);
+    const FrameHandle copy = handle; // shares the slot
+    QVERIFY(!copy.isNull());
+    QVERIFY(!copy.isNested());
+    QCOMPARE(copy.data(), handle.data());
+    QCOMPARE(QByteArray(reinterpret_cast<const char*>(copy.data()), copy.size()),
+             QByteArray(reinterpret_cast<const char*>(out.frame()), out.frameLen()));
+
+    // the pooled bytes parse into the same frame again
+    FrameParser again;
+    again.setContext(const_cast<uint8_t*>(copy.data()), copy.size());
+    again.process();
+    QVERIFY(again.isComplete());
+    QCOMPARE(again.frameLen(), parser.frameLen());
+}
+
+void TestBasic::rangeWindowMaxMatchesBruteForceTestCase()
+{
+    // epochs with the Dataset interface RangeWindowMax reads, the last epoch still gets ranges
+    struct FakeEpoch {
+        float ranges[2] = { NAN, NAN };
+        float getMaxRnage(int channel) const { return ranges[channel]; }
+    };
+
+    struct FakeDataset {
+        std::vector<FakeEpoch> epochs;
+        int endIndex() const { return static_cast<int>(epochs.size()) - 1; }
+        FakeEpoch* fromIndex(int index) {
+            if (index >= static_cast<int>(epochs.size())) {
+                index = endIndex();
+            }
+            return index >= 0 ? &epochs[index] : nullptr;
+        }
+    };
+
+    quint32 seed = 1;
+    auto rand = [&seed]() { seed = seed * 1103515245 + 12345; return static_cast<int>((seed >> 16) & 0x7FFF); };
+    auto randRange = [&rand]() { return rand() % 4 == 0 ? NAN : static_cast<float>(rand() % 500) * 0.1f; };
+
+    FakeDataset dataset;
+    RangeWindowMax window;
+    const int width = 64;
+    int channel = 0;
+    int zoomLevel = 0;
+    int scrollBack = 0; // epochs between the last column and the end of the dataset
+
+    for (int step = 0; step < 20000; ++step) {
+        const int action = rand() % 100;
+        if (action < 40) {
+            dataset.epochs.emplace_back();
+        } else if (action < 70 && !dataset.epochs.empty()) {
+            dataset.epochs.back().ranges[rand() % 2] = randRange();
+        } else if (action < 75) {
+            scrollBack = rand() % 3 == 0 ? rand() % 200 : 0;
+        } else if (action < 78) {
+            zoomLevel = rand() % 3;
+        } else if (action < 80) {
+            channel = rand() % 2;
+        } else if (action == 80) {
+            dataset.epochs.resize(dataset.epochs.size() / 2 + rand() % 2);
+        }
+
+        // columns as DatasetCursor sets them: 2^zoomLevel epochs each, -1 before the first epoch
+        std::vector<int> indexes(width);
+        const int lastIndex = ((std::max(dataset.endIndex() - scrollBack, 0)) >> zoomLevel) << zoomLevel;
+        for (int col = 0; col < width; ++col) {
+            const int index = lastIndex - ((width - 1 - col) << zoomLevel);
+            indexes[col] = dataset.epochs.empty() || index < 0 ? -1 : index;
+        }
+
+        float expected = NAN;
+        for (int index : indexes) {
+            const float range = index >= 0 ? dataset.fromIndex(index)->getMaxRnage(channel) : NAN;
+            if (std::isfinite(range) && !(expected >= range)) {
+                expected = range;
+            }
+        }
+
+        const float actual = window.update(dataset, indexes, channel, zoomLevel);
+        QVERIFY2(std::isfinite(actual) == std::isfinite(expected), qPrintable(QString("step %1").arg(step)));
+        if (std::isfinite(expected)) {
+            QCOMPARE(actual, expected);
+        }
+    }
+}
+
 void TestBasic::cleanupTestCase()
 {
 
@@ -5,6 +5,9 @@
 
 #include "tinsplitsmoothsurfaceprocessor.hpp"
 #include "gridgenerator.h"
+#include "frame_pool.h"
+#include "klf_ingest.h"
+#include "range_window_max.h"
 
 class TestBasic : public QObject
 {
@@ -22,6 +25,11 @@ private Q_SLOTS:
     void generateZeroSizeQuadGridTestCase();
     void generateZeroCellSizeQuadGridTestCase();
 
+    void parallelIngestMatchesSequentialTestCase();
+    void frameHandleRoundTripTestCase();
+
+    void rangeWindowMaxMatchesBruteForceTestCase();
+
     void cleanupTestCase();
 };
 
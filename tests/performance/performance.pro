@@ -1,13 +1,18 @@
 CONFIG += testcase
-QT += testlib
-QT -= gui
+QT += testlib gui opengl
 
 TARGET = tst_performance
 
+INCLUDEPATH += $$TOP_PWD/KoggerApp \
+    $$TOP_PWD/KoggerApp/core \
+    $$TOP_PWD/KoggerApp/domain
+
 SOURCES += \
-    tst_performance.cpp
+    tst_performance.cpp \
+    $$TOP_PWD/KoggerApp/bottom_track_kernel.cpp \
+    $$TOP_PWD/KoggerApp/echogram_transpose.cpp \
+    $$TOP_PWD/KoggerApp/plot_columns.cpp \
+    $$TOP_PWD/KoggerApp/core/vertex_buffer_manager.cpp
 
 HEADERS += \
     tst_perfomance.h
-
-
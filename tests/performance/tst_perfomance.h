@@ -2,6 +2,7 @@
 #define TST_PERFOMANCE_H
 
 #include <QtTest>
+#include <QVector>
 
 class TestPerformance : public QObject
 {
@@ -10,8 +11,35 @@ class TestPerformance : public QObject
 public:
     TestPerformance();
 
+private:
+    QVector<QVector<uint8_t>> echogram_;
+
 private Q_SLOTS:
     void initTestCase();
+
+    void bottomTrackKernelMatchesReference();
+    void bottomTrackReferenceBenchmark();
+    void bottomTrackKernelBenchmark_data();
+    void bottomTrackKernelBenchmark();
+
+    void delaunayIsEmptyCircle();
+    void delaunayBenchmark_data();
+    void delaunayBenchmark();
+
+    void echogramTransposeMatchesReference();
+    void echogramImageBenchmark_data();
+    void echogramImageBenchmark();
+
+    void vertexBufferUploadsOnlyChanges();
+    void vertexBufferBenchmark_data();
+    void vertexBufferBenchmark();
+
+    void plotColumnsReuseStorage();
+    void lineLayersAllocations_data();
+    void lineLayersAllocations();
+    void lineLayersFrameBenchmark_data();
+    void lineLayersFrameBenchmark();
+
     void cleanupTestCase();
 };
 
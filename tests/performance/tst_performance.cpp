@@ -1,5 +1,425 @@
 #include "tst_perfomance.h"
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <QLineF>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include "bottom_track_kernel.h"
+#include "DelaunayTriangulation.h"
+#include "echogram_transpose.h"
+#include "plot_columns.h"
+#include "vertex_buffer_manager.h"
+
+namespace {
+
+// column stages of Dataset::bottomTrackProcessing as they were before BottomTrackKernel
+void referenceFilterColumn(const BottomTrackKernel::Params& p, const uint8_t* data, int data_size, int32_t* cash_data)
+{
+    const int istart = p.istart, init_win = p.initWin, scale_win = p.scaleWin;
+
+    const uint8_t* data_from = &data[istart];
+    const uint8_t* data_to = &data[(istart+init_win)];
+
+    int data_acc = 0;
+    for(int idata = istart; idata < (istart+init_win); idata++) {
+        data_acc += data[idata];
+    }
+
+    int avrg_range = init_win;
+    for(int idata = istart; (idata + avrg_range) < data_size; idata++) {
+        data_acc -= *data_from; data_from++;
+        data_acc += *data_to; data_to++;
+        while((idata+(init_win*scale_win)) >= ((avrg_range = data_to - data_from)*scale_win)) {
+            data_acc += *data_to; data_to++;
+        }
+        cash_data[idata] = 10*data_acc / (avrg_range);
+    }
+
+    const int data_conv_size = data_size - avrg_range;
+    for(int idata = istart; ; idata++) {
+        const float fidata = idata + init_win+1;
+        int di1 =  idata;
+        int di2 =  fidata*p.s2;
+        int di3 =  fidata*p.s3;
+        int di4 =  fidata*p.s4;
+        int di5 =  fidata*p.s5;
+
+        if(di5 >= data_conv_size) { break; }
+
+        int calc = (p.c1*cash_data[di1] + p.c2*cash_data[di2] + p.c3*cash_data[di3] + p.c4*cash_data[di4] + p.c5*cash_data[di5]);
+        calc = calc*p.gainSlopeInv + calc*(idata);
+
+        cash_data[idata] = calc;
+    }
+}
+
+int referenceArgmax(const int32_t* data, int from, int to, int32_t floor)
+{
+    int max_val = floor;
+    int max_ind = -1;
+    for(int i = from; i < to ; i++) {
+        if(max_val < data[i]) {
+            max_val = data[i];
+            max_ind = i;
+        }
+    }
+    return max_ind;
+}
+
+std::vector<Point3D<double>> randomSurveyPoints(int count)
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> along(0.0, count * 0.5);
+    std::uniform_real_distribution<double> across(0.0, 500.0);
+
+    std::vector<Point3D<double>> points;
+    points.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        points.emplace_back(along(rng), across(rng), across(rng) * 0.01, i);
+    }
+    return points;
+}
+
+// column by column with a scanline stride per sample, as Plot2DEchogram wrote its image before EchogramTranspose
+void referenceWriteColumns(const int16_t* columns, int height, int from, int to, uint8_t* image, int stride)
+{
+    for (int column = from; column < to; ++column) {
+        const int16_t* cash_data = columns + static_cast<ptrdiff_t>(column) * height;
+        uint8_t* img_data = image + column;
+        for (int image_row = 0; image_row < height; image_row++) {
+            *img_data = *cash_data;
+            img_data += stride;
+            cash_data++;
+        }
+    }
+}
+
+QVector<QVector3D> surveyTrack(int count)
+{
+    QVector<QVector3D> track;
+    track.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        track.append(QVector3D(i * 0.001f, std::sin(i * 0.0005f), -10.0f - std::cos(i * 0.0003f)));
+    }
+    return track;
+}
+
+// headless target for the vertex buffer tests, software Mesa: QT_QPA_PLATFORM=offscreen LIBGL_ALWAYS_SOFTWARE=1
+class OffscreenGl
+{
+public:
+    bool create()
+    {
+        surface_.create();
+        if (!context_.create() || !context_.makeCurrent(&surface_)) {
+            return false;
+        }
+
+        fbo_.reset(new QOpenGLFramebufferObject(512, 512));
+        fbo_->bind();
+
+        const bool isLinked =
+            program_.addShaderFromSourceCode(QOpenGLShader::Vertex,
+                                             "#version 140\n"
+                                             "in vec3 position;\n"
+                                             "uniform mat4 matrix;\n"
+                                             "void main() { gl_Position = matrix * vec4(position, 1.0); }\n") &&
+            program_.addShaderFromSourceCode(QOpenGLShader::Fragment,
+                                             "#version 140\n"
+                                             "void main() { gl_FragColor = vec4(1.0, 0.5, 0.0, 1.0); }\n") &&
+            program_.link();
+
+        return isLinked;
+    }
+
+    void drawLineStrip(const QVector<QVector3D>& vertices)
+    {
+        auto* gl = context_.functions();
+        gl->glClear(GL_COLOR_BUFFER_BIT);
+
+        QMatrix4x4 matrix;
+        matrix.ortho(0.0f, 1000.0f, -2.0f, 2.0f, 0.0f, 20.0f);
+
+        program_.bind();
+        program_.setUniformValue("matrix", matrix);
+        const int location = program_.attributeLocation("position");
+        program_.enableAttributeArray(location);
+        VertexBufferManager::setAttributeArray(&program_, location, &vertices, vertices);
+        gl->glDrawArrays(GL_LINE_STRIP, 0, vertices.size());
+        program_.disableAttributeArray(location);
+        program_.release();
+
+        gl->glFinish(); // the frame is over once the GPU is done with it
+    }
+
+    ~OffscreenGl()
+    {
+        if (QOpenGLContext::currentContext() == &context_) {
+            fbo_.reset();
+            program_.removeAllShaders();
+            context_.doneCurrent();
+        }
+    }
+
+private:
+    QOffscreenSurface surface_;
+    QOpenGLContext context_;
+    std::unique_ptr<QOpenGLFramebufferObject> fbo_;
+    QOpenGLShaderProgram program_;
+};
+
+// the epoch fields read by the Plot2D line layers
+struct LineEpoch {
+    bool isAttitude = false;
+    float yaw = 0, pitch = 0, roll = 0;
+    bool isEncoders = false;
+    float encoder[3] = {};
+    int beamCount = 0;
+    float beamVelocity[4] = {}, beamMode[4] = {}, beamDistance[4] = {};
+    bool isDvl = false;
+    float velocity[3] = {};
+    float dvlDistance = 0;
+    bool isUsbl = false;
+    float azimuth = 0, elevation = 0, usblDistance = 0;
+    float hSpeed = 0;
+    float distance = 0;
+    float rangeFinder = 0;
+};
+
+QVector<LineEpoch> lineEpochs(int count)
+{
+    QVector<LineEpoch> epochs(count);
+    for (int i = 0; i < count; ++i) {
+        LineEpoch& e = epochs[i];
+        e.isAttitude = i % 5 != 0;
+        e.yaw = std::fmod(i * 0.3f, 360.0f) - 180.0f;
+        e.pitch = 10.0f * std::sin(i * 0.01f);
+        e.roll = 5.0f * std::cos(i * 0.02f);
+        e.isEncoders = i % 3 == 0;
+        e.encoder[0] = e.encoder[1] = e.encoder[2] = (i % 720) * 0.5f;
+        e.beamCount = i % 7 < 4 ? 4 : i % 3;
+        for (int b = 0; b < 4; ++b) {
+            e.beamVelocity[b] = 0.5f * std::sin(i * 0.01f + b);
+            e.beamMode[b] = static_cast<float>((i + b) % 3);
+            e.beamDistance[b] = 10.0f + b;
+        }
+        e.isDvl = i % 2 == 0;
+        e.velocity[0] = 0.4f * std::sin(i * 0.003f);
+        e.velocity[1] = 0.4f * std::cos(i * 0.003f);
+        e.velocity[2] = 0.01f;
+        e.dvlDistance = 12.0f + std::sin(i * 0.001f);
+        e.isUsbl = i % 11 == 0;
+        e.azimuth = static_cast<float>(i % 360) - 180.0f;
+        e.elevation = 30.0f;
+        e.usblDistance = 50.0f;
+        e.hSpeed = 1.0f + 0.1f * std::sin(i * 0.002f);
+        e.distance = 11.0f + std::cos(i * 0.001f);
+        e.rangeFinder = 11.5f;
+    }
+    return epochs;
+}
+
+const LineEpoch* lineEpochAt(const QVector<LineEpoch>& epochs, int index)
+{
+    return index >= 0 && index < epochs.size() ? &epochs[index] : nullptr;
+}
+
+// a LineEpoch behind the getters of Epoch that PlotColumns::gather reads
+struct LineEpochGetters {
+    struct Vector { float x, y, z; };
+    struct Beam { float velocity, mode, distance; };
+    struct DVLSolution { Vector velocity, distance; };
+    struct UsblSolution { float azimuth_deg, elevation_deg, distance_m; };
+
+    const LineEpoch* e = nullptr;
+
+    bool isAttAvail() const { return e->isAttitude; }
+    float yaw() const { return e->yaw; }
+    float pitch() const { return e->pitch; }
+    float roll() const { return e->roll; }
+    bool isEncodersSeted() const { return e->isEncoders; }
+    float encoder1() const { return e->encoder[0]; }
+    float encoder2() const { return e->encoder[1]; }
+    float encoder3() const { return e->encoder[2]; }
+    bool isDopplerBeamAvail(int beam) const { return e->beamCount > beam; }
+    Beam dopplerBeam(int beam) const { return { e->beamVelocity[beam], e->beamMode[beam], e->beamDistance[beam] }; }
+    bool isDVLSolutionAvail() const { return e->isDvl; }
+    DVLSolution dvlSolution() const { return { { e->velocity[0], e->velocity[1], e->velocity[2] }, { 0, 0, e->dvlDistance } }; }
+    bool isUsblSolutionAvailable() const { return e->isUsbl; }
+    UsblSolution usblSolution() const { return { e->azimuth, e->elevation, e->usblDistance }; }
+    float gnssHSpeed() const { return e->hSpeed; }
+    float distProccesing(int channel) const { Q_UNUSED(channel); return e->distance; }
+    float rangeFinder() const { return e->rangeFinder; }
+};
+
+// the epochs with the Dataset interface of PlotColumns::gather
+struct LineDataset {
+    std::vector<LineEpochGetters> epochs;
+
+    explicit LineDataset(const QVector<LineEpoch>& source) : epochs(source.size())
+    {
+        for (int i = 0; i < source.size(); ++i) {
+            epochs[i].e = &source[i];
+        }
+    }
+
+    LineEpochGetters* fromIndex(int index)
+    {
+        return index >= 0 && index < static_cast<int>(epochs.size()) ? &epochs[index] : nullptr;
+    }
+};
+
+// the lines Canvas::drawY hands to the painter, summed into sink instead
+void drawLines(const QVector<float>& mapped, QVector<QLineF>& lines, double& sink)
+{
+    lines.resize(mapped.isEmpty() ? 0 : mapped.size() - 1);
+    for (int i = 0; i < lines.size(); ++i) {
+        lines[i] = QLineF(i, mapped[i], i + 1, mapped[i + 1]);
+    }
+    for (const QLineF& line : lines) { // NAN columns stay NAN, as the painter gets them
+        if (std::isfinite(line.y1())) {
+            sink += line.y1();
+        }
+    }
+}
+
+// Plot2DLine::drawY as it mapped before PlotColumns::mapY, then Canvas::drawY
+void mapLine(const QVector<float>& data, float from, float to, int height, QVector<float>& mapped, QVector<QLineF>& lines, double& sink)
+{
+    mapped.resize(data.size());
+    const float scale = height / (to - from);
+    for (int i = 0; i < data.size(); ++i) {
+        mapped[i] = std::clamp((data[i] - from) * scale, 0.0f, static_cast<float>(height));
+    }
+
+    drawLines(mapped, lines, sink);
+}
+
+// a frame of the line layers as they drew before PlotColumns: own arrays and epoch lookups per layer, new buffers per line
+int referenceLineFrame(const QVector<LineEpoch>& epochs, const std::vector<int>& indexes, int height, double& sink)
+{
+    const int width = static_cast<int>(indexes.size());
+    int allocations = 0;
+    auto field = [&]() { ++allocations; return QVector<float>(width, NAN); };
+    auto draw = [&](const QVector<float>& data, float from, float to) {
+        QVector<float> mapped;
+        QVector<QLineF> lines;
+        allocations += 2;
+        mapLine(data, from, to, height, mapped, lines, sink);
+    };
+
+    { // attitude
+        auto yaw = field(), pitch = field(), roll = field();
+        for (int i = 0; i < width; ++i) {
+            const LineEpoch* e = lineEpochAt(epochs, indexes[i]);
+            if (e != nullptr && e->isAttitude) { yaw[i] = e->yaw; pitch[i] = e->pitch; roll[i] = e->roll; }
+        }
+        draw(yaw, -180, 180); draw(pitch, -180, 180); draw(roll, -180, 180);
+    }
+    { // encoder
+        auto e1 = field(), e2 = field(), e3 = field();
+        for (int i = 0; i < width; ++i) {
+            const LineEpoch* e = lineEpochAt(epochs, indexes[i]);
+            if (e != nullptr && e->isEncoders) { e1[i] = e->encoder[0]; e2[i] = e->encoder[1]; e3[i] = e->encoder[2]; }
+        }
+        draw(e1, -180, 180); draw(e2, -180, 180);
+    }
+    { // DVL beams
+        auto velocity = field(), amp = field(), mode = field(), coh = field(), dist = field();
+        for (int b = 0; b < 4; ++b) {
+            for (int i = 0; i < width; ++i) {
+                const LineEpoch* e = lineEpochAt(epochs, indexes[i]);
+                if (e != nullptr && e->beamCount > b) {
+                    velocity[i] = e->beamVelocity[b]; amp[i] = 0; mode[i] = (e->beamMode[b] * 6 + b) * 2; coh[i] = 0; dist[i] = e->beamDistance[b];
+                }
+            }
+            draw(velocity, -1, 1); draw(mode, height, 0); draw(dist, 0, 20);
+        }
+    }
+    { // DVL solution
+        auto vx = field(), vy = field(), vz = field(), va = field(), dist = field();
+        for (int i = 0; i < width; ++i) {
+            const LineEpoch* e = lineEpochAt(epochs, indexes[i]);
+            if (e != nullptr && e->isDvl) {
+                vx[i] = e->velocity[0]; vy[i] = e->velocity[1]; vz[i] = e->velocity[2];
+                va[i] = std::sqrt(vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i]); dist[i] = e->dvlDistance;
+            }
+        }
+        draw(vx, -1, 1); draw(vy, -1, 1); draw(vz, -1, 1); draw(va, -1, 1); draw(dist, 0, 20);
+    }
+    { // USBL
+        auto azimuth = field(), elevation = field(), dist = field();
+        for (int i = 0; i < width; ++i) {
+            const LineEpoch* e = lineEpochAt(epochs, indexes[i]);
+            if (e != nullptr && e->isUsbl) { azimuth[i] = e->azimuth; elevation[i] = e->elevation; dist[i] = e->usblDistance; }
+        }
+        draw(azimuth, -180, 180); draw(elevation, -180, 180); draw(dist, 0, 20);
+    }
+    { // GNSS, bottom, rangefinder
+        auto speed = field(), bottom = field(), bottom2 = field(), range = field();
+        for (int i = 0; i < width; ++i) {
+            const LineEpoch* e = lineEpochAt(epochs, indexes[i]);
+            if (e != nullptr) { speed[i] = e->hSpeed; }
+        }
+        for (int i = 0; i < width; ++i) {
+            const LineEpoch* e = lineEpochAt(epochs, indexes[i]);
+            if (e != nullptr) { bottom[i] = e->distance; }
+        }
+        for (int i = 0; i < width; ++i) {
+            const LineEpoch* e = lineEpochAt(epochs, indexes[i]);
+            if (e != nullptr) { range[i] = e->rangeFinder; }
+        }
+        draw(speed, -1, 1); draw(bottom, 0, 20); draw(range, 0, 20);
+    }
+    for (int i = 0; i < 8; ++i) { // quadrature, allocated and never drawn
+        field();
+    }
+
+    return allocations;
+}
+
+// the same frame as Plot2D draws it: PlotColumns::gather over the epochs, PlotColumns::mapY per line, the line buffers kept
+void snapshotLineFrame(LineDataset& dataset, const std::vector<int>& indexes, int height, PlotColumns& columns,
+                       QVector<float>& mapped, QVector<QLineF>& lines, double& sink)
+{
+    const int all = PlotColumns::GroupAttitude | PlotColumns::GroupEncoder | PlotColumns::GroupDVLBeam | PlotColumns::GroupDVLSolution |
+                    PlotColumns::GroupUsbl | PlotColumns::GroupGnss | PlotColumns::GroupBottom | PlotColumns::GroupRangeFinder;
+    columns.gather(dataset, indexes, static_cast<int>(indexes.size()), all, 0, 0, false);
+
+    auto draw = [&](PlotColumns::Field field, float from, float to) {
+        PlotColumns::mapY(columns.at(field), from, to, height, mapped);
+        drawLines(mapped, lines, sink);
+    };
+    draw(PlotColumns::Yaw, -180, 180); draw(PlotColumns::Pitch, -180, 180); draw(PlotColumns::Roll, -180, 180);
+    draw(PlotColumns::Encoder1, -180, 180); draw(PlotColumns::Encoder2, -180, 180);
+    for (int b = 0; b < 4; ++b) {
+        draw(static_cast<PlotColumns::Field>(PlotColumns::BeamVelocity + b), -1, 1);
+        draw(static_cast<PlotColumns::Field>(PlotColumns::BeamMode + b), height, 0);
+        draw(static_cast<PlotColumns::Field>(PlotColumns::BeamDistance + b), 0, 20);
+    }
+    draw(PlotColumns::VelocityX, -1, 1); draw(PlotColumns::VelocityY, -1, 1); draw(PlotColumns::VelocityZ, -1, 1);
+    draw(PlotColumns::VelocityAbs, -1, 1); draw(PlotColumns::DVLDistance, 0, 20);
+    draw(PlotColumns::UsblAzimuth, -180, 180); draw(PlotColumns::UsblElevation, -180, 180); draw(PlotColumns::UsblDistance, 0, 20);
+    draw(PlotColumns::GnssHSpeed, -1, 1); draw(PlotColumns::BottomDistance1, 0, 20); draw(PlotColumns::RangeFinder, 0, 20);
+}
+
+std::vector<int> screenIndexes(int width, int datasetSize)
+{
+    std::vector<int> indexes(width);
+    for (int i = 0; i < width; ++i) {
+        indexes[i] = datasetSize - width + i; // the live edge, the leftmost columns may be before the first epoch
+    }
+    return indexes;
+}
+
+} // namespace
+
+
 TestPerformance::TestPerformance()
 {
 
@@ -7,7 +427,393 @@ TestPerformance::TestPerformance()
 
 void TestPerformance::initTestCase()
 {
+    // decaying noise with a bottom echo wandering around sample 1500
+    quint32 seed = 7;
+    auto rand = [&seed]() { seed = seed * 1103515245 + 12345; return (seed >> 16) & 0x7FFF; };
+
+    echogram_.resize(2000);
+    for (int i = 0; i < echogram_.size(); ++i) {
+        auto& column = echogram_[i];
+        column.resize(4000 + i % 8 + 1); // the reference smoothing may read one byte past the end, keep it zero
+        const int bottom = 1500 + (i % 200) - 100;
+        for (int j = 0; j < column.size() - 1; ++j) {
+            const int echo = std::abs(j - bottom) < 20 ? 180 : 0;
+            column[j] = static_cast<uint8_t>(std::min<int>(255, echo + 4000 / (j + 40) + rand() % 24));
+        }
+        column.last() = 0;
+    }
+}
+
+void TestPerformance::bottomTrackKernelMatchesReference()
+{
+    BottomTrackKernel::Params params;
+    BottomTrackKernel scalar(params);
+    BottomTrackKernel vector(params);
+    scalar.setIsa(BottomTrackKernel::Isa::Scalar);
+
+    for (const auto& column : echogram_) {
+        const int size = column.size() - 1;
+        QVector<int32_t> expected(size), actualScalar(size), actualVector(size);
+
+        referenceFilterColumn(params, column.constData(), size, expected.data());
+        scalar.filterColumn(column.constData(), size, actualScalar.data());
+        vector.filterColumn(column.constData(), size, actualVector.data());
+
+        QCOMPARE(actualScalar, expected);
+        QCOMPARE(actualVector, expected);
+        QCOMPARE(vector.argmax(actualVector.constData(), 0, size, 0), referenceArgmax(expected.constData(), 0, size, 0));
+    }
+}
+
+void TestPerformance::bottomTrackReferenceBenchmark()
+{
+    BottomTrackKernel::Params params;
+    QVector<int32_t> column(4008);
+    QVector<int32_t> summ(column.size());
+
+    QBENCHMARK {
+        for (const auto& data : echogram_) {
+            const int size = data.size() - 1;
+            referenceFilterColumn(params, data.constData(), size, column.data());
+            for (int i = params.istart; i < size; i++) { summ[i] += column[i]; }
+            referenceArgmax(summ.constData(), 0, size, 0);
+        }
+    }
+}
+
+void TestPerformance::bottomTrackKernelBenchmark_data()
+{
+    QTest::addColumn<int>("isa");
+
+    QTest::newRow("scalar") << static_cast<int>(BottomTrackKernel::Isa::Scalar);
+    QTest::newRow("best") << static_cast<int>(BottomTrackKernel::bestIsa());
+}
+
+void TestPerformance::bottomTrackKernelBenchmark()
+{
+    QFETCH(int, isa);
+
+    BottomTrackKernel::Params params;
+    BottomTrackKernel kernel(params);
+    kernel.setIsa(static_cast<BottomTrackKernel::Isa>(isa));
+    QVector<int32_t> column(4008);
+    QVector<int32_t> summ(column.size());
+
+    QBENCHMARK {
+        for (const auto& data : echogram_) {
+            const int size = data.size() - 1;
+            kernel.filterColumn(data.constData(), size, column.data());
+            kernel.add(summ.data(), column.constData(), params.istart, size);
+            kernel.argmax(summ.constData(), 0, size, 0);
+        }
+    }
+}
+
+void TestPerformance::delaunayIsEmptyCircle()
+{
+    const auto points = randomSurveyPoints(2000);
+
+    Delaunay<double> delaunay;
+    const auto triangles = delaunay.trinagulate(points);
+
+    // a triangulation of n points in general position has 2n - 2 - h triangles, h of them on the hull
+    QVERIFY(triangles->size() > 2 * points.size() - 2 - 200);
+    QVERIFY(triangles->size() <= 2 * points.size() - 5);
+
+    for (const auto& triangle : *triangles) {
+        const double ax = triangle.A().x(), ay = triangle.A().y();
+        const double bx = triangle.B().x(), by = triangle.B().y();
+        const double cx = triangle.C().x(), cy = triangle.C().y();
+        const double orient = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+
+        for (const auto& p : points) {
+            const double adx = ax - p.x(), ady = ay - p.y();
+            const double bdx = bx - p.x(), bdy = by - p.y();
+            const double cdx = cx - p.x(), cdy = cy - p.y();
+            const double det = (adx * adx + ady * ady) * (bdx * cdy - cdx * bdy) +
+                               (bdx * bdx + bdy * bdy) * (cdx * ady - adx * cdy) +
+                               (cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+            QVERIFY((orient > 0 ? det : -det) <= 1e-6);
+        }
+    }
+}
+
+void TestPerformance::delaunayBenchmark_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void TestPerformance::delaunayBenchmark()
+{
+    QFETCH(int, count);
+
+    const auto points = randomSurveyPoints(count);
+    Delaunay<double> delaunay;
+
+    QBENCHMARK {
+        delaunay.trinagulate(points, 20.0);
+    }
+}
+
+void TestPerformance::echogramTransposeMatchesReference()
+{
+    std::mt19937 rng(11);
+
+    for (int trial = 0; trial < 100; ++trial) {
+        const int width = 1 + rng() % 300;
+        const int height = 1 + rng() % 200;
+        const int stride = (width + 3) & ~3;
+        const int from = rng() % width;
+        const int to = from + rng() % (width - from + 1);
+
+        QVector<int16_t> columns(width * height);
+        for (auto& val : columns) {
+            val = static_cast<int16_t>(rng() % 256);
+        }
+
+        QVector<uint8_t> expected(stride * height, 7);
+        referenceWriteColumns(columns.constData(), height, from, to, expected.data(), stride);
+
+        for (auto isa : { EchogramTranspose::Isa::Scalar, EchogramTranspose::bestIsa() }) {
+            EchogramTranspose transpose;
+            transpose.setIsa(isa);
+            QVector<uint8_t> actual(stride * height, 7);
+            transpose.write(columns.constData(), height, from, to, actual.data(), stride);
+            QCOMPARE(actual, expected);
+        }
+    }
+}
+
+void TestPerformance::echogramImageBenchmark_data()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("height");
+    QTest::addColumn<int>("columns"); // written per frame, the full width is a redraw
+    QTest::addColumn<int>("isa");     // -1 for the reference
+
+    const QList<QPair<int, int>> resolutions = { { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 } };
+    const QList<QPair<const char*, int>> isas = { { "reference", -1 },
+                                                  { "scalar", static_cast<int>(EchogramTranspose::Isa::Scalar) },
+                                                  { "best", static_cast<int>(EchogramTranspose::bestIsa()) } };
+
+    for (const auto& resolution : resolutions) {
+        for (const auto& isa : isas) {
+            QTest::addRow("%dp redraw %s", resolution.second, isa.first) << resolution.first << resolution.second << resolution.first << isa.second;
+            QTest::addRow("%dp scroll %s", resolution.second, isa.first) << resolution.first << resolution.second << 4 << isa.second;
+        }
+    }
+}
+
+void TestPerformance::echogramImageBenchmark()
+{
+    QFETCH(int, width);
+    QFETCH(int, height);
+    QFETCH(int, columns);
+    QFETCH(int, isa);
+
+    QVector<int16_t> buffer(width * height);
+    for (int i = 0; i < buffer.size(); ++i) {
+        buffer[i] = static_cast<int16_t>((i * 7 + i / height) & 0xFF);
+    }
+    QVector<uint8_t> image(width * height);
+
+    EchogramTranspose transpose;
+    if (isa >= 0) {
+        transpose.setIsa(static_cast<EchogramTranspose::Isa>(isa));
+    }
+
+    int from = 0;
+    QBENCHMARK {
+        const int to = std::min(width, from + columns);
+        if (isa < 0) {
+            referenceWriteColumns(buffer.constData(), height, from, to, image.data(), width);
+        } else {
+            transpose.write(buffer.constData(), height, from, to, image.data(), width);
+        }
+        from = to < width ? to : 0; // scrolling wraps around the ring of columns
+    }
+}
+
+void TestPerformance::vertexBufferUploadsOnlyChanges()
+{
+    OffscreenGl gl;
+    if (!gl.create()) {
+        QSKIP("no OpenGL context");
+    }
+
+    auto track = surveyTrack(1000);
+    const qint64 vertexSize = sizeof(QVector3D);
+    qint64 uploaded = 0;
+    VertexBufferManager buffers;
+    auto drawFrame = [&]() -> qint64 {
+        buffers.beginFrame();
+        gl.drawLineStrip(track);
+        buffers.endFrame();
+        const qint64 bytes = buffers.getUploadedBytes() - uploaded;
+        uploaded = buffers.getUploadedBytes();
+        return bytes;
+    };
+
+    QCOMPARE(drawFrame(), track.size() * vertexSize);
+    QCOMPARE(drawFrame(), qint64(0)); // same storage
+
+    track.append(surveyTrack(20).mid(10)); // still within the first allocation
+    QCOMPARE(drawFrame(), 10 * vertexSize);
+
+    track[500] = QVector3D(500.0f, 1.0f, -10.0f);
+    track[510] = QVector3D(510.0f, 1.0f, -10.0f);
+    QCOMPARE(drawFrame(), 11 * vertexSize);
+
+    track.detach(); // equal copy, nothing to send
+    QCOMPARE(drawFrame(), qint64(0));
+
+    track.append(surveyTrack(100)); // over the capacity, the buffer is reallocated
+    QCOMPARE(drawFrame(), track.size() * vertexSize);
+    QCOMPARE(buffers.getBuffersCount(), 1);
+}
+
+void TestPerformance::vertexBufferBenchmark_data()
+{
+    QTest::addColumn<bool>("isBuffered");
+
+    QTest::newRow("client arrays") << false;
+    QTest::newRow("buffers") << true;
+}
+
+void TestPerformance::vertexBufferBenchmark()
+{
+    QFETCH(bool, isBuffered);
+
+    OffscreenGl gl;
+    if (!gl.create()) {
+        QSKIP("no OpenGL context");
+    }
+
+    // a 1M vertex track growing by a second of positions per frame, as during a survey
+    auto track = surveyTrack(1000000);
+    const auto appended = surveyTrack(10);
+    VertexBufferManager buffers;
+
+    QBENCHMARK {
+        track.append(appended);
+        if (isBuffered) {
+            buffers.beginFrame();
+        }
+        gl.drawLineStrip(track);
+        if (isBuffered) {
+            buffers.endFrame();
+        }
+    }
+}
+
+void TestPerformance::plotColumnsReuseStorage()
+{
+    const int all = PlotColumns::GroupAttitude | PlotColumns::GroupEncoder | PlotColumns::GroupDVLBeam | PlotColumns::GroupDVLSolution |
+                    PlotColumns::GroupUsbl | PlotColumns::GroupGnss | PlotColumns::GroupBottom | PlotColumns::GroupRangeFinder;
+
+    PlotColumns columns;
+    columns.begin(1920, PlotColumns::GroupAttitude);
+    QCOMPARE(columns.getAllocations(), qint64(3));
+    QVERIFY(columns.isFilled(PlotColumns::GroupAttitude));
+    QVERIFY(!columns.isFilled(PlotColumns::GroupAttitude | PlotColumns::GroupGnss));
+    QVERIFY(columns.at(PlotColumns::GnssHSpeed).isEmpty()); // not asked for
+
+    columns.data(PlotColumns::Yaw)[10] = 1.0f;
+    const float* yaw = columns.at(PlotColumns::Yaw).constData();
+    columns.begin(1920, all);
+    const qint64 allocations = columns.getAllocations();
+    QCOMPARE(allocations, qint64(PlotColumns::FieldCount));
+    QCOMPARE(columns.at(PlotColumns::Yaw).constData(), yaw);
+    QVERIFY(std::isnan(columns.at(PlotColumns::Yaw)[10])); // every frame starts from NAN
+
+    for (int frame = 0; frame < 100; ++frame) {
+        columns.begin(1920 - frame, all);
+    }
+    QCOMPARE(columns.getAllocations(), allocations);
+    QCOMPARE(int(columns.at(PlotColumns::RangeFinder).size()), 1821);
+
+    columns.begin(3840, all); // wider canvas
+    QCOMPARE(columns.getAllocations(), allocations + PlotColumns::FieldCount);
+}
+
+void TestPerformance::lineLayersAllocations_data()
+{
+    QTest::addColumn<bool>("isSnapshot");
+
+    QTest::newRow("per layer") << false;
+    QTest::newRow("snapshot") << true;
+}
+
+void TestPerformance::lineLayersAllocations()
+{
+    QFETCH(bool, isSnapshot);
+
+    const auto epochs = lineEpochs(10000);
+    LineDataset dataset(epochs);
+    const auto indexes = screenIndexes(1920, epochs.size());
+    double sink = 0;
+
+    PlotColumns columns;
+    QVector<float> mapped;
+    QVector<QLineF> lines;
+    int allocations = 0;
+    for (int frame = 0; frame < 2; ++frame) { // the second frame is the steady state
+        if (isSnapshot) {
+            const qint64 before = columns.getAllocations();
+            const auto mappedCapacity = mapped.capacity();
+            const auto linesCapacity = lines.capacity();
+            snapshotLineFrame(dataset, indexes, 1080, columns, mapped, lines, sink);
+            allocations = static_cast<int>(columns.getAllocations() - before) + (mapped.capacity() != mappedCapacity) + (lines.capacity() != linesCapacity);
+        } else {
+            allocations = referenceLineFrame(epochs, indexes, 1080, sink);
+        }
+    }
+
+    QVERIFY(sink > 0);
+    QTest::setBenchmarkResult(allocations, QTest::Events); // buffer allocations per frame
+}
+
+void TestPerformance::lineLayersFrameBenchmark_data()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("height");
+    QTest::addColumn<bool>("isSnapshot");
+
+    const QList<QPair<int, int>> resolutions = { { 1920, 1080 }, { 3840, 2160 } };
+    for (const auto& resolution : resolutions) {
+        QTest::addRow("%dp per layer", resolution.second) << resolution.first << resolution.second << false;
+        QTest::addRow("%dp snapshot", resolution.second) << resolution.first << resolution.second << true;
+    }
+}
+
+void TestPerformance::lineLayersFrameBenchmark()
+{
+    QFETCH(int, width);
+    QFETCH(int, height);
+    QFETCH(bool, isSnapshot);
+
+    const auto epochs = lineEpochs(100000);
+    LineDataset dataset(epochs);
+    const auto indexes = screenIndexes(width, epochs.size());
+    double sink = 0;
+
+    PlotColumns columns;
+    QVector<float> mapped;
+    QVector<QLineF> lines;
+
+    QBENCHMARK {
+        if (isSnapshot) {
+            snapshotLineFrame(dataset, indexes, height, columns, mapped, lines, sink);
+        } else {
+            referenceLineFrame(epochs, indexes, height, sink);
+        }
+    }
 
+    QVERIFY(sink > 0);
 }
 
 void TestPerformance::cleanupTestCase()
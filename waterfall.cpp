@@ -136,6 +136,14 @@ void qPlot2D::verScrollEvent(int delta) {
     scrollDistance(delta);
 }
 
+void qPlot2D::horZoomEvent(int delta) {
+    if(delta > 0) {
+        setHorizontalZoom(horizontalZoom() + 1);
+    } else if(delta < 0) {
+        setHorizontalZoom(horizontalZoom() - 1);
+    }
+}
+
 void qPlot2D::plotMouseTool(int mode) {
     setMouseTool((MouseTool)mode);
 }
@@ -43,13 +43,19 @@ signals:
 
 protected slots:
     void timerUpdater();
-    void dataUpdate() { plotUpdate(); }
+    void dataUpdate() {
+        if(_dataset != nullptr && _dataset->size() < _cursor.last_dataset_size) {
+            resetCash(); // the dataset was reset, cached epochs are gone
+        }
+        plotUpdate();
+    }
 
 public slots:
     void updater();
     void horScrollEvent(int delta);
     void verZoomEvent(int delta);
     void verScrollEvent(int delta);
+    void horZoomEvent(int delta);
     Q_INVOKABLE void plotMousePosition(int x, int y);
     Q_INVOKABLE void plotMouseTool(int mode);
 
@@ -60,6 +66,7 @@ public slots:
     void plotEchogramVisible(bool visible) { setEchogramVisible(visible); }
     Q_INVOKABLE void plotEchogramTheme(int theme_id) { setEchogramTheme(theme_id); }
     Q_INVOKABLE void plotEchogramCompensation(int compensation_id) { setEchogramCompensation(compensation_id); }
+    Q_INVOKABLE void plotEchogramAggregation(int stat) { setEchogramAggregation(stat); }
     void plotBottomTrackVisible(bool visible) { setBottomTrackVisible(visible); }
     void plotBottomTrackTheme(int theme_id) { setBottomTrackTheme(theme_id); }
 